@@ -1,4 +1,6 @@
 #include <cctype>
+#include <cmath>
+#include <ctime>
 #include "Arena.h"
 #include "RobotBase.h"
 #include <filesystem>
@@ -6,10 +8,12 @@
 #include <string>
 #include <iostream>
 #include <unistd.h>
+#include <sys/ioctl.h>
 #include <dlfcn.h> // For dynamic library loading
 #include <ostream>
 #include <fstream>
 #include <sstream>
+#include <memory>
 
 
 // Define the unique characters for robots
@@ -27,32 +31,140 @@ Arena::Arena(int row_in, int col_in)
     // Defaults when not using a config file
     m_max_rounds = 100000;
     m_obstacle_density = ObstacleDensity::Medium;
+    set_seed(static_cast<uint64_t>(std::time(nullptr)));
+    m_replay = nullptr;
+    m_replay_keyframe_every = 1000;
+    m_last_move_direction = 0;
+    m_last_move_distance = 0;
 
     m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
     m_live = false;
+    m_live_speed = 1;
+    m_live_view = nullptr;
+    m_log = nullptr;
+    m_text_sink = LogWriter::Both;
+    m_quiet = false;
+    m_silent = false;
+    m_board_dirty = true;
+    m_start_round = 0;
+    m_checkpoint_every = 10000;
+    m_zobrist = 0;
+    m_repeat_limit = 0;
+    m_repeat_window = 1000;
+    m_stalemate_every = 0;
+    m_trace_sample_every = 1;
+    m_trace_buffer_events = 1 << 18;
+    m_robot_timing_mode = RobotTimingMode::Wall;
+    m_turn_timing = nullptr;
+    m_phase_profile = nullptr;
+    m_memory_cap = 0;
+    m_call_budget_ns = 0;
+    m_profile_hz = 1000;
+    m_profile_report = true;
+    m_crash_path = "RobotWarz_crash.txt";
+    m_stats = nullptr;
+    m_stats_merge = true;
+    m_shooter = nullptr;
+    m_round = 0;
+    m_round_counter = nullptr;
+    m_turn_memory = 0;
+    m_board_log_every = 1;
+    m_board_log_on_change = false;
+    m_changed = true;
+    m_view_mode = ViewMode::Full;
+    m_view_follow = "action";
+    m_view_rows = 0;
+    m_view_cols = 0;
+    m_action_row = -1;
+    m_action_col = -1;
 }
 
 // Constructor that loads settings from a config file
 Arena::Arena(const std::string& config_path)
+    : Arena(ArenaConfig(config_path))
+{
+}
+
+// Constructor with the settings of a config file that was already read
+Arena::Arena(const ArenaConfig& config)
 {
     // Sensible defaults before reading config
     m_size_row = 20;
     m_size_col = 20;
     m_max_rounds = 100000;
     m_obstacle_density = ObstacleDensity::Medium;
+    set_seed(static_cast<uint64_t>(std::time(nullptr)));
+    m_replay = nullptr;
+    m_replay_keyframe_every = 1000;
+    m_last_move_direction = 0;
+    m_last_move_distance = 0;
     m_live = false;
-
-    if (!load_config(config_path))
+    m_live_speed = 1;
+    m_live_view = nullptr;
+    m_log = nullptr;
+    m_text_sink = LogWriter::Both;
+    m_quiet = false;
+    m_silent = false;
+    m_board_dirty = true;
+    m_start_round = 0;
+    m_checkpoint_every = 10000;
+    m_zobrist = 0;
+    m_repeat_limit = 0;
+    m_repeat_window = 1000;
+    m_stalemate_every = 0;
+    m_trace_sample_every = 1;
+    m_trace_buffer_events = 1 << 18;
+    m_robot_timing_mode = RobotTimingMode::Wall;
+    m_turn_timing = nullptr;
+    m_phase_profile = nullptr;
+    m_memory_cap = 0;
+    m_call_budget_ns = 0;
+    m_profile_hz = 1000;
+    m_profile_report = true;
+    m_crash_path = "RobotWarz_crash.txt";
+    m_stats = nullptr;
+    m_stats_merge = true;
+    m_shooter = nullptr;
+    m_round = 0;
+    m_round_counter = nullptr;
+    m_turn_memory = 0;
+    m_board_log_every = 1;
+    m_board_log_on_change = false;
+    m_changed = true;
+    m_view_mode = ViewMode::Full;
+    m_view_follow = "action";
+    m_view_rows = 0;
+    m_view_cols = 0;
+    m_action_row = -1;
+    m_action_col = -1;
+
+    if (config.loaded)
+    {
+        apply_config(config);
+    }
+    else
     {
         std::cerr << "Warning: Could not load config file '"
-                  << config_path << "'. Using defaults.\n";
+                  << config.path << "'. Using defaults.\n";
     }
 
     m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
 }
 
-bool Arena::load_config(const std::string& config_path)
+static void trim(std::string& s)
+{
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+        s.erase(s.begin());
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+        s.pop_back();
+}
+
+bool ArenaConfig::read(const std::string& config_path)
 {
+    path = config_path;
+    settings.clear();
+    loaded = false;
+
     std::ifstream in(config_path);
     if (!in)
     {
@@ -62,13 +174,6 @@ bool Arena::load_config(const std::string& config_path)
 
     std::string line;
 
-    auto trim = [](std::string& s) {
-        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
-            s.erase(s.begin());
-        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
-            s.pop_back();
-    };
-
     while (std::getline(in, line))
     {
         // Skip empty lines and comment lines starting with '#'
@@ -83,6 +188,29 @@ bool Arena::load_config(const std::string& config_path)
         std::string value = line.substr(eq_pos + 1);
         trim(key);
         trim(value);
+        settings.emplace_back(key, value);
+    }
+
+    loaded = true;
+    return true;
+}
+
+bool Arena::load_config(const std::string& config_path)
+{
+    ArenaConfig config;
+    if (!config.read(config_path))
+    {
+        return false;
+    }
+    apply_config(config);
+    return true;
+}
+
+// the settings in file order, so a key given twice takes the last value
+void Arena::apply_config(const ArenaConfig& config)
+{
+    for (const auto& [key, value] : config.settings)
+    {
 
         if (key == "GameMode")
         {
@@ -96,6 +224,16 @@ bool Arena::load_config(const std::string& config_path)
                 m_live = false;
         }
 
+        if (key == "LiveSpeed")
+        {
+            // ticks per second in live mode
+            int speed = std::stoi(value);
+            if (speed > 0)
+            {
+                m_live_speed = speed;
+            }
+        }
+
         if (key == "ArenaSize")
         {
             // Expect "rows,cols"
@@ -137,16 +275,204 @@ bool Arena::load_config(const std::string& config_path)
             else
                 m_obstacle_density = ObstacleDensity::Medium;
         }
+        else if (key == "BoardLogEvery")
+        {
+            // only log every Nth board frame
+            int every = std::stoi(value);
+            if (every > 0)
+            {
+                m_board_log_every = every;
+            }
+        }
+        else if (key == "BoardLogOnChange")
+        {
+            // only log frames where something moved or took damage
+            std::string v = value;
+            std::transform(v.begin(), v.end(), v.begin(),
+                           [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+
+            m_board_log_on_change = (v == "true" || v == "yes" || v == "on" || v == "1");
+        }
+        else if (key == "Seed")
+        {
+            // a fixed seed makes the map and the damage rolls repeatable
+            set_seed(std::stoull(value));
+        }
+        else if (key == "ReplayFile")
+        {
+            // empty means no replay
+            m_replay_path = value;
+        }
+        else if (key == "ReplayKeyframeEvery")
+        {
+            int every = std::stoi(value);
+            if (every > 0)
+            {
+                m_replay_keyframe_every = every;
+            }
+        }
+        else if (key == "RepetitionDraw")
+        {
+            // how many times the same state ends the game, 0 for never
+            m_repeat_limit = std::max(0, std::stoi(value));
+        }
+        else if (key == "RepetitionWindow")
+        {
+            int window = std::stoi(value);
+            if (window > 0)
+            {
+                m_repeat_window = window;
+            }
+        }
+        else if (key == "StalemateCheckEvery")
+        {
+            // rounds between checks for robots that can never reach each other, 0 for never
+            m_stalemate_every = std::max(0, std::stoi(value));
+        }
+        else if (key == "TraceFile")
+        {
+            // empty means no trace
+            m_trace_path = value;
+        }
+        else if (key == "TraceSampleEvery")
+        {
+            m_trace_sample_every = std::max(1, std::stoi(value));
+        }
+        else if (key == "TraceBufferEvents")
+        {
+            m_trace_buffer_events = std::max(1024, std::stoi(value));
+        }
+        else if (key == "RobotTiming")
+        {
+            // off, wall (latency only) or cpu (and CPU time, which costs more)
+            std::string v = value;
+            std::transform(v.begin(), v.end(), v.begin(),
+                           [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+
+            if (v == "off")
+                m_robot_timing_mode = RobotTimingMode::Off;
+            else if (v == "cpu")
+                m_robot_timing_mode = RobotTimingMode::Cpu;
+            else
+                m_robot_timing_mode = RobotTimingMode::Wall;
+        }
+        else if (key == "RobotMemoryCapMB")
+        {
+            // heap a robot may hold before it is disqualified, 0 for no cap
+            m_memory_cap = std::max<int64_t>(0, std::stoll(value)) * 1024 * 1024;
+        }
+        else if (key == "RobotCallBudgetMs")
+        {
+            // the longest a single robot call should take, 0 for no budget
+            m_call_budget_ns = static_cast<uint64_t>(std::max(0.0, std::stod(value)) * 1000000);
+        }
+        else if (key == "RobotProfileFile")
+        {
+            // folded stacks of the robots' code, empty for no profiling
+            m_profile_path = value;
+        }
+        else if (key == "RobotProfileHz")
+        {
+            m_profile_hz = std::clamp(std::stoi(value), 1, 10000);
+        }
+        else if (key == "CrashFile")
+        {
+            // empty means no crash report
+            m_crash_path = value;
+        }
+        else if (key == "StatsFile")
+        {
+            // empty means no heatmaps or weapon stats
+            m_stats_path = value;
+        }
+        else if (key == "ResultsFile")
+        {
+            // every game's result and the ratings, empty for none
+            m_results_path = value;
+        }
+        else if (key == "CheckpointFile")
+        {
+            // empty means no checkpoints
+            m_checkpoint_path = value;
+        }
+        else if (key == "CheckpointEvery")
+        {
+            int every = std::stoi(value);
+            if (every > 0)
+            {
+                m_checkpoint_every = every;
+            }
+        }
+        else if (key == "ViewMode")
+        {
+            std::string v = value;
+            std::transform(v.begin(), v.end(), v.begin(),
+                           [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+
+            if (v == "viewport")
+                m_view_mode = ViewMode::Viewport;
+            else if (v == "minimap")
+                m_view_mode = ViewMode::Minimap;
+            else
+                m_view_mode = ViewMode::Full;
+        }
+        else if (key == "ViewFollow")
+        {
+            // a robot name, or "action" for wherever the robots are bunched up
+            m_view_follow = value;
+        }
+        else if (key == "ViewSize")
+        {
+            // Expect "rows,cols" in cells
+            std::size_t comma_pos = value.find(',');
+            if (comma_pos != std::string::npos)
+            {
+                std::string rows_str = value.substr(0, comma_pos);
+                std::string cols_str = value.substr(comma_pos + 1);
+                trim(rows_str);
+                trim(cols_str);
+
+                m_view_rows = std::max(0, std::stoi(rows_str));
+                m_view_cols = std::max(0, std::stoi(cols_str));
+            }
+        }
     }
+}
 
-    return true;
+void Arena::set_batch_game()
+{
+    m_live = false;
+    m_replay_path.clear();
+    m_checkpoint_path.clear();
+    m_trace_path.clear();
+    m_profile_report = false;
+}
+
+void Arena::set_seed(uint64_t seed)
+{
+    m_seed = seed;
+    m_rng.seed(seed);
 }
 
 bool Arena::load_robots() 
 {
-    namespace fs = std::filesystem;
     std::cout << "Loading Robots..." << std::endl;
 
+    std::vector<RobotEntry> entries;
+    if (!compile_robots(entries))
+    {
+        return false;
+    }
+    return add_robots(entries);
+}
+
+// compile every robots/Robot_<name>.cpp into lib<name>.so and load it. the
+// libraries stay loaded, so the factories can make robots for as many games
+// as needed.
+bool Arena::compile_robots(std::vector<RobotEntry>& entries)
+{
+    namespace fs = std::filesystem;
+
     try 
     {
         // Scan the robots/ directory for Robot_<name>.cpp files
@@ -175,7 +501,7 @@ bool Arena::load_robots()
 
                 // Compile the file into a shared library
                 std::string compile_cmd =
-                    "g++ -shared -fPIC -std=c++20 -I. "
+                    "g++ -shared -fPIC -std=c++20 -fno-omit-frame-pointer -I. "
                     " -o " + shared_lib +
                     " " + source_path +
                     " RobotBase.o";
@@ -191,7 +517,7 @@ bool Arena::load_robots()
                 }
 
                 // Load the shared library dynamically
-                void* handle = dlopen(shared_lib.c_str(), RTLD_LAZY);
+                void* handle = dlopen(("./" + shared_lib).c_str(), RTLD_LAZY);
                 if (!handle) 
                 {
                     std::cerr << "Failed to load " << shared_lib
@@ -209,33 +535,7 @@ bool Arena::load_robots()
                     continue;
                 }
 
-                // Instantiate the robot and add it to the m_robots list
-                RobotBase* robot = create_robot();
-                if (robot) 
-                {
-                    robot->m_name = robot_name;
-                    robot->set_boundaries(m_size_row, m_size_col);
-                    std::cout << "boundaries: " << m_size_row << ", " << m_size_col << std::endl;
-
-                    int row, col;
-                    do 
-                    {
-                        row = std::rand() % m_size_row;
-                        col = std::rand() % m_size_col;
-                    } while (m_board[row][col] != '.');
-
-                    robot->move_to(row, col);
-                    m_board[row][col] = 'R';
-                    m_robots.push_back(robot);
-
-                    std::cout << "Loaded robot: " << robot_name
-                              << " at (" << row << ", " << col << ")\n";
-                }
-                else 
-                {
-                    std::cerr << "Failed to create robot from " << shared_lib << std::endl;
-                    dlclose(handle);
-                }
+                entries.push_back({robot_name, create_robot, robot_source_hash(source_path)});
             }
         }
     } 
@@ -245,13 +545,226 @@ bool Arena::load_robots()
         return false;
     }
 
+    return !entries.empty();
+}
+
+// make one of each robot and put them on free cells. the arena owns them.
+bool Arena::add_robots(const std::vector<RobotEntry>& entries)
+{
+    for (const RobotEntry& entry : entries)
+    {
+        // Instantiate the robot and add it to the m_robots list
+        RobotBase* robot = entry.create();
+        if (!robot) 
+        {
+            std::cerr << "Failed to create robot " << entry.name << std::endl;
+            continue;
+        }
+        m_owned_robots.emplace_back(robot);
+
+        robot->m_name = entry.name;
+        m_robot_sources[entry.name] = entry.source_hash;
+        robot->set_boundaries(m_size_row, m_size_col);
+
+        int row, col;
+        do 
+        {
+            row = m_rng.below(m_size_row);
+            col = m_rng.below(m_size_col);
+        } while (m_board[row][col] != '.');
+
+        robot->move_to(row, col);
+        m_board[row][col] = 'R';
+        m_robots.push_back(robot);
+
+        if (!m_silent)
+        {
+            std::cout << "Loaded robot: " << entry.name
+                      << " at (" << row << ", " << col << ")\n";
+        }
+    }
+
+    m_board_dirty = true;
     return !m_robots.empty();
 }
 
+// Set up a recorded game to be played again: the recorded board, stand-in robots
+// that repeat the recorded decisions and the recorded random draws. No robot code
+// is compiled or loaded.
+bool Arena::load_replay(const std::string& path)
+{
+    auto playback = std::make_unique<ReplayPlayback>();
+    if (!playback->open(path))
+    {
+        return false;
+    }
+
+    const ReplayReader& reader = playback->reader();
+    m_size_row = reader.rows();
+    m_size_col = reader.cols();
+    m_board = playback->start_board();
+    m_robots = playback->robots();
+    m_max_rounds = reader.rounds();
+    set_seed(reader.seed());
+    m_renderer.invalidate_terrain();
+
+    // flamethrowers are put back when a robot steps off them
+    m_flamethrowers.clear();
+    for (int row = 0; row < m_size_row; ++row)
+    {
+        for (int col = 0; col < m_size_col; ++col)
+        {
+            if (m_board[row][col] == 'F')
+                m_flamethrowers.insert({row, col});
+        }
+    }
+
+    // nobody is watching a regression check
+    m_live = false;
+    m_board_dirty = true;
+    m_playback = std::move(playback);
+    return true;
+}
+
+bool Arena::replay_matched() const
+{
+    return m_playback && !m_playback->diverged();
+}
+
+// Everything the engine needs to carry on from the start of a round. Cheap:
+// the packed board is only rebuilt when a cell has changed since the last one.
+ArenaSnapshot Arena::snapshot(int round) const
+{
+    // set_cell() gives up listing changes once they are no cheaper to patch
+    // than to pack again
+    if (m_board_dirty || !m_packed_board)
+    {
+        m_packed_board = PackedBoard::pack(m_board, m_flamethrowers);
+    }
+    else if (!m_dirty_cells.empty())
+    {
+        m_packed_board = m_packed_board->patch(m_dirty_cells, m_board, m_flamethrowers);
+    }
+    m_board_dirty = false;
+    m_dirty_cells.clear();
+
+    ArenaSnapshot snapshot;
+    snapshot.round = round;
+    snapshot.seed = m_seed;
+    snapshot.rng_state = m_rng.state();
+    snapshot.rng_increment = m_rng.increment();
+    snapshot.robot_rng = thread_robot_random();
+    snapshot.board = m_packed_board;
+
+    snapshot.robots.reserve(m_robots.size());
+    snapshot.robot_data.resize(m_robots.size());
+    for (std::size_t i = 0; i < m_robots.size(); ++i)
+    {
+        snapshot.robots.push_back(pack_robot_state(read_robot_state(m_robots[i])));
+        if (auto* serializable = dynamic_cast<SerializableRobot*>(m_robots[i]))
+        {
+            snapshot.robot_data[i] = serializable->save_state();
+        }
+    }
+    return snapshot;
+}
+
+// Put the game back as it was. The robots must be the same ones, in the same
+// order, as when the snapshot was taken.
+bool Arena::restore(const ArenaSnapshot& snapshot)
+{
+    if (!snapshot.board || snapshot.robots.size() != m_robots.size())
+    {
+        std::cerr << "Snapshot is for " << snapshot.robots.size() << " robots, the arena has "
+                  << m_robots.size() << std::endl;
+        return false;
+    }
+
+    snapshot.board->unpack(m_board, m_flamethrowers);
+    m_size_row = snapshot.board->rows;
+    m_size_col = snapshot.board->cols;
+    m_packed_board = snapshot.board;
+    m_board_dirty = false;
+    m_dirty_cells.clear();
+
+    m_seed = snapshot.seed;
+    m_rng.restore(snapshot.rng_state, snapshot.rng_increment);
+    thread_robot_random() = snapshot.robot_rng;
+
+    bool ok = true;
+    for (std::size_t i = 0; i < m_robots.size(); ++i)
+    {
+        RobotSnapshotAccess::restore(m_robots[i], unpack_robot_state(snapshot.robots[i]));
+        if (i < snapshot.robot_data.size() && !snapshot.robot_data[i].empty())
+        {
+            auto* serializable = dynamic_cast<SerializableRobot*>(m_robots[i]);
+            if (!serializable || !serializable->load_state(snapshot.robot_data[i]))
+            {
+                std::cerr << "Could not restore the state of " << m_robots[i]->m_name << std::endl;
+                ok = false;
+            }
+        }
+    }
+
+    m_start_round = snapshot.round;
+    reset_hash();
+    m_renderer.invalidate_terrain();
+    m_changed = true;
+    return ok;
+}
+
+// Pick a killed game up again. The robots have been loaded from robots/ as usual;
+// they are put in the checkpoint's turn order and given back their health,
+// position and the rest. Checkpoints carry on going to the same file.
+bool Arena::resume(const std::string& checkpoint_path)
+{
+    Checkpoint checkpoint;
+    if (!load_checkpoint(checkpoint_path, checkpoint))
+    {
+        return false;
+    }
+
+    std::vector<RobotBase*> ordered;
+    for (const std::string& name : checkpoint.robot_names)
+    {
+        auto found = std::find_if(m_robots.begin(), m_robots.end(),
+                                  [&name](RobotBase* robot) { return robot->m_name == name; });
+        if (found == m_robots.end())
+        {
+            std::cerr << "Checkpoint robot " << name << " was not loaded from robots/" << std::endl;
+            return false;
+        }
+        ordered.push_back(*found);
+    }
+    if (ordered.size() != m_robots.size())
+    {
+        std::cerr << "Checkpoint has " << ordered.size() << " robots, " << m_robots.size()
+                  << " were loaded from robots/" << std::endl;
+        return false;
+    }
+
+    m_robots = ordered;
+    for (RobotBase* robot : m_robots)
+    {
+        robot->set_boundaries(checkpoint.snapshot.board->rows, checkpoint.snapshot.board->cols);
+    }
+    m_max_rounds = checkpoint.max_rounds;
+    if (!restore(checkpoint.snapshot))
+    {
+        return false;
+    }
+
+    m_checkpoint_path = checkpoint_path;
+    std::cout << "Resuming " << checkpoint_path << " at round " << checkpoint.snapshot.round
+              << " of " << m_max_rounds << std::endl;
+    return true;
+}
 
 // Given the robot's preference on radar direction, get radar results
 void Arena::get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results) 
 {
+    PhaseScope phase(m_phase_profile, EnginePhase::Radar);
+    TRACE_SCOPE("radar scan", "engine");
     // Clear the radar results vector
     radar_results.clear();
 
@@ -259,10 +772,11 @@ void Arena::get_radar_results(RobotBase* robot, int radar_direction, std::vector
     {
         get_radar_local(robot, radar_results);
     } 
-    else 
+    else if (radar_direction >= 1 && radar_direction <= 8)
     {
         get_radar_ray(robot, radar_direction, radar_results);
     }
+    // anything else points nowhere: directions[] only has 0-8
 }
 
 void Arena::get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_results) 
@@ -290,6 +804,11 @@ void Arena::get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_resul
                 continue;
             }
 
+            if (m_stats)
+            {
+                m_stats->add(HeatLayer::Radar, scan_row, scan_col);
+            }
+
             // Get the cell content
             char cell = m_board[scan_row][scan_col];
 
@@ -316,6 +835,8 @@ void Arena::scan_location(int row, int col, std::vector<RadarObj>& radar_results
             char cell = m_board[row][col];
             if (cell != '.')
                 radar_results.push_back(RadarObj(cell, row, col));
+            if (m_stats)
+                m_stats->add(HeatLayer::Radar, row, col);
         }
 }
 
@@ -373,9 +894,19 @@ void Arena::get_radar_ray(RobotBase* robot, int radar_direction, std::vector<Rad
 // Handle the robot's shot
 std::string Arena::handle_shot(RobotBase* robot, int shot_row, int shot_col) 
 {
+    PhaseScope phase(m_phase_profile, EnginePhase::Weapon);
+    TRACE_SCOPE("shot", "engine");
     std::stringstream ss;
 
     WeaponType weapon = robot->get_weapon();
+    uint64_t robots_hit = 0;
+    if (m_stats)
+    {
+        m_stats->weapon(weapon).shots++;
+        robots_hit = m_stats->weapon(weapon).robots_hit;
+    }
+    m_shooter = robot;
+
     switch (weapon) 
     {
         case flamethrower:
@@ -399,9 +930,16 @@ std::string Arena::handle_shot(RobotBase* robot, int shot_row, int shot_col)
             break;
 
         default:
+            m_shooter = nullptr;
             return "strange weapon? ";
 
     }
+    m_shooter = nullptr;
+    if (m_stats)
+    {
+        WeaponStats& stats = m_stats->weapon(weapon);
+        (stats.robots_hit > robots_hit ? stats.hits : stats.misses)++;
+    }
     return ss.str();
 }
 std::string Arena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon)
@@ -410,48 +948,178 @@ std::string Arena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon)
     int armor = robot->get_armor();
     int damage = calculate_damage(weapon,armor);
 
+    int health = robot->get_health();
     robot->take_damage(damage);
     robot->reduce_armor(1);
+    if (m_stats)
+    {
+        count_damage(robot, weapon, damage, health);
+    }
+
+    std::size_t target = std::find(m_robots.begin(), m_robots.end(), robot) - m_robots.begin();
+    count_result_damage(target, damage, health);
+    if (m_flight.active())
+    {
+        m_flight.record(FlightKind::Damage, static_cast<int>(target), damage, robot->get_health());
+    }
+    update_hash(robot);
+    m_repetitions.clear(); // damage breaks any loop
+    m_changed = true;
+    robot->get_current_location(m_action_row, m_action_col);
 
     ss << robot->m_name << " takes " << damage << " damage. Health: " << robot->get_health() << std::endl;
     return ss.str();
 
 }
 
-int Arena::calculate_damage(WeaponType weapon, int armor_level) 
+// for the results: who dealt it (m_shooter, if anyone), who took it and the
+// round they died in. every way a robot loses health comes through here.
+void Arena::count_result_damage(std::size_t target, int damage, int health_before)
 {
-    int min_damage = 0, max_damage = 0;
-    switch (weapon) {
-        case flamethrower:
-            min_damage = 30;
-            max_damage = 50;
-            break;
-        case railgun:
-            min_damage = 10;
-            max_damage = 20;
-            break;
-        case hammer:
-            min_damage = 50;
-            max_damage = 60;
-            break;
-        case grenade:
-            min_damage = 10;
-            max_damage = 40;
-            break;
-        default:
-            return 0; // No damage for unrecognized weapons
+    if (target >= m_damage_taken.size())
+    {
+        return;
     }
-
-    // Generate random damage within the range
-    int base_damage = min_damage + (std::rand() % (max_damage - min_damage + 1));
-
-    // Apply armor reduction (10% per armor level)
+    m_damage_taken[target] += damage;
+    if (health_before > 0 && m_robots[target]->get_health() <= 0)
+    {
+        m_death_round[target] = m_round;
+    }
+    std::size_t shooter = std::find(m_robots.begin(), m_robots.end(), m_shooter) - m_robots.begin();
+    if (shooter < m_damage_dealt.size())
+    {
+        m_damage_dealt[shooter] += damage;
+    }
+}
+
+// heatmaps and weapon stats: a shot counts for the shooter's weapon and cell,
+// anything else is a flamethrower on the board
+void Arena::count_damage(RobotBase* robot, WeaponType weapon, int damage, int health_before)
+{
+    int row, col;
+    robot->get_current_location(row, col);
+    m_stats->add(HeatLayer::DamageTaken, row, col, damage);
+    if (health_before > 0 && robot->get_health() <= 0)
+    {
+        m_stats->add(HeatLayer::Deaths, row, col);
+    }
+
+    if (m_shooter)
+    {
+        int shooter_row, shooter_col;
+        m_shooter->get_current_location(shooter_row, shooter_col);
+        m_stats->add(HeatLayer::DamageDealt, shooter_row, shooter_col, damage);
+        m_stats->weapon(weapon).robots_hit++;
+        m_stats->weapon(weapon).damage += damage;
+    }
+    else
+    {
+        m_stats->add(HeatLayer::FlameHits, row, col);
+    }
+}
+
+uint64_t Arena::rules_hash() const
+{
+    std::string rules = std::to_string(engine_rules_version) + " " + std::to_string(m_repeat_limit) + " " +
+                        std::to_string(m_repeat_window) + " " + std::to_string(m_stalemate_every) + " " +
+                        std::to_string(m_memory_cap);
+    return text_hash(rules);
+}
+
+void Arena::describe_game(GameRecord& record) const
+{
+    record.seed = m_seed;
+    record.rules = rules_hash();
+    record.rows = m_size_row;
+    record.cols = m_size_col;
+    record.max_rounds = m_max_rounds;
+    record.obstacle_density = static_cast<int>(m_obstacle_density);
+}
+
+uint64_t Arena::robot_source(const std::string& name) const
+{
+    auto source = m_robot_sources.find(name);
+    return source != m_robot_sources.end() && source->second ? source->second : text_hash(name);
+}
+
+// the game that just ended into the results store, robots by source hash
+void Arena::record_result()
+{
+    ResultsStore* store = shared_results_store(m_results_path);
+    if (!store)
+    {
+        return;
+    }
+
+    GameRecord record;
+    describe_game(record);
+    record.rounds = m_result.rounds;
+    record.draw = m_result.draw;
+    record.out_of_rounds = m_result.max_rounds;
+    record.winner = m_result.winner;
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        GamePlacement placement;
+        placement.robot = store->robot(robot_source(m_robots[i]->m_name), m_robots[i]->m_name);
+        placement.placement = m_result.placement[i];
+        placement.damage_dealt = m_result.damage_dealt[i];
+        placement.damage_taken = m_result.damage_taken[i];
+        record.robots.push_back(placement);
+    }
+    store->add(record);
+}
+
+int Arena::calculate_damage(WeaponType weapon, int armor_level) 
+{
+    int min_damage = 0, max_damage = 0;
+    switch (weapon) {
+        case flamethrower:
+            min_damage = 30;
+            max_damage = 50;
+            break;
+        case railgun:
+            min_damage = 10;
+            max_damage = 20;
+            break;
+        case hammer:
+            min_damage = 50;
+            max_damage = 60;
+            break;
+        case grenade:
+            min_damage = 10;
+            max_damage = 40;
+            break;
+        default:
+            return 0; // No damage for unrecognized weapons
+    }
+
+    // Generate random damage within the range
+    int base_damage = min_damage + random_below(max_damage - min_damage + 1);
+
+    // Apply armor reduction (10% per armor level)
     double armor_multiplier = 1.0 - (0.1 * armor_level);
     int final_damage = static_cast<int>(base_damage * armor_multiplier);
 
     return final_damage;
 }
 
+// Every random number the engine draws during a game goes through here, so the
+// replay can record it and a playback can hand the recorded one back.
+int Arena::random_below(int n)
+{
+    int value;
+    if (!m_playback || !m_playback->next_draw(n, value))
+    {
+        value = m_rng.below(n);
+    }
+
+    if (m_replay)
+    {
+        m_replay->random_draw(value);
+    }
+    return value;
+}
+
 
 std::string Arena::handle_flame_shot(RobotBase* robot, int shot_row, int shot_col)
 {
@@ -638,6 +1306,7 @@ std::string Arena::handle_grenade_shot(RobotBase* robot, int shot_row, int shot_
         return " out of grenades. ";    
         
     robot->decrement_grenades();
+    update_hash(robot);
 
     int max_distance = 10; // Grenade range
     int delta_row = shot_row - current_row;
@@ -738,10 +1407,14 @@ std::string Arena::handle_hammer_shot(RobotBase* robot, int shot_row, int shot_c
 
 std::string Arena::handle_move(RobotBase* robot) 
 {
+    TRACE_SCOPE("move", "engine");
     std::stringstream ss;
     int move_direction;
     int move_distance;
 
+    m_last_move_direction = 0;
+    m_last_move_distance = 0;
+
     // Check if the robot cannot move
     if (robot->get_move_speed() == 0)
     {
@@ -750,7 +1423,26 @@ std::string Arena::handle_move(RobotBase* robot)
     }
 
     // Get the direction and distance desired from the robot
-    robot->get_move_direction(move_direction, move_distance);
+    {
+        TRACE_SCOPE("get_move_direction", "robot");
+        CallTimer timer(m_turn_timing, RobotCall::MoveDirection);
+        FlightCall flight(m_flight, RobotCall::MoveDirection);
+        RobotMemoryScope memory(m_turn_memory);
+        RobotProfileScope profile(m_profiler.get());
+        try
+        {
+            robot->get_move_direction(move_direction, move_distance);
+        }
+        catch (const std::bad_alloc&)
+        {
+            move_direction = move_distance = 0; // over its memory cap
+        }
+    }
+    // the robot's own time is in its call timings, the engine's starts here
+    PhaseScope phase(m_phase_profile, EnginePhase::Move);
+    m_flight.record(FlightKind::Move, 0, move_direction, move_distance);
+    m_last_move_direction = move_direction;
+    m_last_move_distance = move_distance;
     move_distance = std::clamp(move_distance, 0, robot->get_move_speed());
 
     // Check if no movement is requested
@@ -779,8 +1471,9 @@ std::string Arena::handle_move(RobotBase* robot)
         if (cell == 'F')
         {
             // Move into the flamethrower cell
-            m_board[current_row][current_col] = '.'; // Clear the current cell
+            set_cell(current_row, current_col, '.'); // Clear the current cell
             robot->move_to(next_row, next_col);
+            m_changed = true;
 
             ss << robot->m_name << " encounters a flamethrower at (" 
                << next_row << "," << next_col << "). Taking damage! " << std::endl;
@@ -789,12 +1482,13 @@ std::string Arena::handle_move(RobotBase* robot)
             // If the robot dies on the F, leave a dead robot there and stop moving.
             if (robot->get_health() <= 0)
             {
-                m_board[next_row][next_col] = 'X';
+                set_cell(next_row, next_col, 'X');
+                update_hash(robot);
                 return ss.str();
             }
 
             // Robot survived: it now occupies this cell and the F is effectively consumed.
-            m_board[next_row][next_col] = 'R';
+            set_cell(next_row, next_col, 'R');
             current_row = next_row;
             current_col = next_col;
 
@@ -806,25 +1500,28 @@ std::string Arena::handle_move(RobotBase* robot)
         if (cell != '.')
         {
             ss << handle_collision(robot, cell, next_row, next_col);
+            update_hash(robot);
             return ss.str();
         }
 
         // Normal movement into empty cell
         if(m_flamethrowers.count({current_row, current_col}) > 0)
         {
-            m_board[current_row][current_col] = 'F'; // put the flame thrower back.
+            set_cell(current_row, current_col, 'F'); // put the flame thrower back.
         }
         else
         {
-            m_board[current_row][current_col] = '.'; // Clear the current cell
+            set_cell(current_row, current_col, '.'); // Clear the current cell
         }
         
         robot->move_to(next_row, next_col);
-        m_board[next_row][next_col] = 'R'; // Mark the new position
+        set_cell(next_row, next_col, 'R'); // Mark the new position
+        m_changed = true;
         current_row = next_row;
         current_col = next_col;
     }
 
+    update_hash(robot);
     ss << robot->m_name << " moves to (" << current_row << "," << current_col << ") ";
     return ss.str();
 }
@@ -856,11 +1553,12 @@ std::string Arena::handle_collision(RobotBase* robot, char cell, int row, int co
             robot->get_current_location(cur_row, cur_col);
 
             // Clear old position on the board
-            m_board[cur_row][cur_col] = '.';
+            set_cell(cur_row, cur_col, '.');
 
             // Move robot into the pit cell
             robot->move_to(row, col);
-            m_board[row][col] = 'R';
+            set_cell(row, col, 'R');
+            m_changed = true;
 
             // Disable movement forever
             robot->disable_movement();
@@ -891,6 +1589,8 @@ void Arena::initialize_board(bool empty)
 
     // Resize the board and initialize all cells to '.'
     m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
+    m_renderer.invalidate_terrain();
+    m_board_dirty = true;
     
     //empty makes it so there are no obstacles.
     if(empty)
@@ -917,7 +1617,7 @@ void Arena::initialize_board(bool empty)
     for (char obstacle : obstacle_types) 
     {
         // Random number of obstacles for this type (between 0 and max_obstacles)
-        int obstacle_count = std::rand() % (max_obstacles + 1);
+        int obstacle_count = m_rng.below(max_obstacles + 1);
 
         for (int i = 0; i < obstacle_count; ++i) 
         {
@@ -925,8 +1625,8 @@ void Arena::initialize_board(bool empty)
             do 
             {
                 // Randomly generate a position within the board
-                row = std::rand() % m_size_row;
-                col = std::rand() % m_size_col;
+                row = m_rng.below(m_size_row);
+                col = m_rng.below(m_size_col);
             } 
             while (m_board[row][col] != '.'); // Ensure the position is empty
 
@@ -942,8 +1642,6 @@ void Arena::initialize_board(bool empty)
 }
 
 void Arena::print_board(int round, std::ostream& out, bool clear_screen) const {
-    
-    std::vector<std::string> bot_list;
 
     if (clear_screen) {
         // Clear the screen
@@ -952,53 +1650,125 @@ void Arena::print_board(int round, std::ostream& out, bool clear_screen) const {
         }
     }
 
-    out << std::endl << "              =========== starting round " << round << " ===========" << std::endl;
+    out << render_board(round);
+}
 
-    // Calculate consistent spacing for the columns
-    const int col_width = 3; // Adjust width for even spacing (enough for two-digit numbers and a space)
+// Render the board for a round. The string stays valid until the next render.
+const std::string& Arena::render_board(int round) const
+{
+    PhaseScope phase(m_phase_profile, EnginePhase::Render);
+    TRACE_SCOPE("print board", "engine");
+    return m_renderer.render(round, m_board, m_robots, unique_char);
+}
 
-    // Print column headers with consistent spacing
-    out << "   "; // Leading space for row indices
-    for (int col = 0; col < m_size_col; ++col) {
-        out << std::setw(col_width) << col; // Use std::setw for fixed width
+// Render what the console shows for a round, see ViewMode. The window and the
+// minimap cost depends on the view size, not on the size of the arena.
+const std::string& Arena::render_view(int round) const
+{
+    TRACE_SCOPE("print view", "engine");
+    if (m_view_mode == ViewMode::Full)
+    {
+        return render_board(round);
     }
-    out << std::endl;
 
-    // Print each row of the arena
-    for (int row = 0; row < m_size_row; ++row) {
-        // Print row index with consistent spacing
-        out << std::setw(2) << row << " "; // Row indices aligned with column headers
+    int view_rows, view_cols;
+    get_view_size(view_rows, view_cols);
 
-        // Print the contents of the row
-        for (int col = 0; col < m_size_col; ++col) {
-            char cell = m_board[row][col];
-            if (cell == 'R' || cell == 'X') {
-                int bot_index = get_robot_index(row, col);
-                if (bot_index != -1) {
-                    // Append the unique character to 'R' or 'X'
-                    out << std::setw(col_width - 1) << cell << unique_char[bot_index];
-                    bot_list.push_back(unique_char[bot_index]+m_robots[bot_index]->m_name);
-                } else {
-                    // Default display if robot index is invalid
-                    out << std::setw(col_width) << cell;
-                }
-            } else {
-                // Display other cells as-is
-                out << std::setw(col_width) << cell;
+    if (m_view_mode == ViewMode::Minimap)
+    {
+        return m_renderer.render_minimap(round, m_board, m_robots, unique_char, view_rows, view_cols);
+    }
+
+    int center_row, center_col;
+    std::string caption = find_view_center(view_rows, view_cols, center_row, center_col);
+    return m_renderer.render_window(round, m_board, m_robots, unique_char,
+                                    center_row - view_rows / 2, center_col - view_cols / 2,
+                                    view_rows, view_cols, caption);
+}
+
+// How many cells fit on screen, unless ViewSize says otherwise.
+void Arena::get_view_size(int& view_rows, int& view_cols) const
+{
+    int term_rows = 24, term_cols = 80;
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0)
+    {
+        term_rows = ws.ws_row;
+        term_cols = ws.ws_col;
+    }
+
+    // status, blank, round and column header lines on top, legend at the bottom
+    view_rows = (m_view_rows > 0) ? m_view_rows : std::max(1, term_rows - 6);
+    view_cols = (m_view_cols > 0) ? m_view_cols : std::max(1, (term_cols - 6) / 3);
+}
+
+// Where the viewport is centred. Either on the robot named in ViewFollow, or on
+// the spot where the window holds the most living robots, preferring windows that
+// include the last damage dealt. Only looks at the robot list, never the board.
+std::string Arena::find_view_center(int view_rows, int view_cols, int& center_row, int& center_col) const
+{
+    center_row = m_size_row / 2;
+    center_col = m_size_col / 2;
+
+    std::string follow = m_view_follow;
+    std::transform(follow.begin(), follow.end(), follow.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+
+    if (follow != "action")
+    {
+        for (auto* robot : m_robots)
+        {
+            std::string name = robot->m_name;
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+            if (name == follow)
+            {
+                robot->get_current_location(center_row, center_col);
+                return "following " + robot->m_name;
             }
         }
-        out << std::endl;
     }
 
-    if(round==0)
+    std::vector<std::pair<int,int>> candidates;
+    for (auto* robot : m_robots)
     {
+        if (robot->get_health() > 0)
+        {
+            int row, col;
+            robot->get_current_location(row, col);
+            candidates.emplace_back(row, col);
+        }
+    }
+    if (m_action_row >= 0)
+    {
+        candidates.emplace_back(m_action_row, m_action_col);
+    }
 
-        for(auto bot : bot_list )
+    auto inside = [&](const std::pair<int,int>& center, int row, int col) {
+        return std::abs(row - center.first) <= view_rows / 2 && std::abs(col - center.second) <= view_cols / 2;
+    };
+
+    int best_score = -1;
+    for (const auto& center : candidates)
+    {
+        int score = 0;
+        for (const auto& other : candidates)
+        {
+            if (inside(center, other.first, other.second))
+                score += 2;
+        }
+        if (m_action_row >= 0 && inside(center, m_action_row, m_action_col))
+            score += 1;
+
+        if (score > best_score)
         {
-            out << bot << std::endl;
+            best_score = score;
+            center_row = center.first;
+            center_col = center.second;
         }
     }
 
+    return "following the action";
 }
 
 int Arena::get_robot_index(int row, int col) const
@@ -1032,7 +1802,7 @@ bool Arena::winner()
 
     if(num_living_robots == 1)
     {
-        std::cout << living_robot->m_name << " is the winner.\n";
+        output(living_robot->m_name + " is the winner.\n", LogWriter::Console);
         return true;
     }
 
@@ -1040,10 +1810,124 @@ bool Arena::winner()
 
 }
 
-void Arena::output(std::string text, std::ostream& file)
+// the sole survivor, or -1 while the game is still on
+int Arena::winner_index() const
+{
+    int index = -1;
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        if (m_robots[i]->get_health() > 0)
+        {
+            if (index != -1)
+                return -1;
+            index = static_cast<int>(i);
+        }
+    }
+    return index;
+}
+
+// who a game that ends without a winner goes to: the most health, then the most
+// armor, then whoever moves first
+int Arena::tiebreak_index() const
 {
-    std::cout << text;
-    file << text;
+    int best = -1;
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        RobotBase* robot = m_robots[i];
+        if (robot->get_health() <= 0)
+            continue;
+        if (best == -1 || robot->get_health() > m_robots[best]->get_health() ||
+            (robot->get_health() == m_robots[best]->get_health() && robot->get_armor() > m_robots[best]->get_armor()))
+        {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// Board changes during a game go through here so the replay sees them.
+void Arena::set_cell(int row, int col, char cell)
+{
+    std::size_t index = static_cast<std::size_t>(row) * m_size_col + col;
+    char was = m_board[row][col];
+    m_zobrist ^= zobrist_cell_key(index, was) ^ zobrist_cell_key(index, cell);
+    m_board[row][col] = cell;
+    m_renderer.terrain_changed(m_board, row, col, was);
+    m_flight.record(FlightKind::Cell, 0, row, col, cell);
+    if (!m_board_dirty)
+    {
+        // once the list is as long as the packed board, snapshot() packs it
+        // again anyway. stop adding to a list nobody may ask for.
+        if (!m_packed_board || m_dirty_cells.size() >= m_packed_board->words.size())
+        {
+            m_board_dirty = true;
+            m_dirty_cells.clear();
+        }
+        else
+        {
+            m_dirty_cells.emplace_back(row, col);
+        }
+    }
+    if (m_replay)
+    {
+        m_replay->cell_changed(row, col, cell);
+    }
+}
+
+// Work the hash out from scratch. Needed whenever the board or the robots were
+// set up without going through set_cell() and update_hash().
+void Arena::reset_hash()
+{
+    m_zobrist = zobrist_hash(m_board, m_robots);
+    m_robot_keys.clear();
+    for (std::size_t i = 0; i < m_robots.size(); ++i)
+    {
+        m_robot_keys.push_back(zobrist_robot_key(i, read_robot_state(m_robots[i])));
+    }
+    m_repetitions.set_window(m_repeat_window);
+}
+
+// after a robot moved, took damage or threw a grenade
+void Arena::update_hash(RobotBase* robot)
+{
+    for (std::size_t i = 0; i < m_robots.size() && i < m_robot_keys.size(); ++i)
+    {
+        if (m_robots[i] == robot)
+        {
+            uint64_t key = zobrist_robot_key(i, read_robot_state(robot));
+            m_zobrist ^= m_robot_keys[i] ^ key;
+            m_robot_keys[i] = key;
+            return;
+        }
+    }
+}
+
+// Everything the game prints goes through here. During a game it lands in the
+// LogWriter buffer and the writer thread does the actual I/O.
+void Arena::output(std::string_view text)
+{
+    output(text, m_text_sink);
+}
+
+void Arena::output(std::string_view text, LogWriter::Sink sink)
+{
+    if (m_live_view && (sink & LogWriter::Console))
+    {
+        m_held_console += text;
+        sink = static_cast<LogWriter::Sink>(sink & ~LogWriter::Console);
+        if (!sink)
+        {
+            return;
+        }
+    }
+    if (m_log)
+    {
+        m_log->write(text, sink);
+    }
+    else if ((sink & LogWriter::Console) && !m_silent)
+    {
+        std::cout << text;
+    }
 }
 
 // Run the simulation
@@ -1054,104 +1938,552 @@ void Arena::run_simulation()
     std::vector<RadarObj> radar_results;
     std::ostringstream outstring;
 
-   // Seed the random number generator
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
+    // before the tracer and the log start, so there is nothing to stop again
+    if (m_robots.empty())
+    {
+        if (!m_quiet)
+        {
+            output("Robot list did not load.\n");
+        }
+        return;
+    }
 
-    // open a log file.
-    std::ofstream log_file("RobotWarz_log.txt", std::ios::app);
+    // Seed the C random number generator from the game seed, for robots that use rand().
+    // rand() is this thread's own (RobotRandom.h), so games on other threads don't
+    // take numbers from this one. A restored game already has it back as it was.
+    if (m_start_round == 0)
+    {
+        std::srand(static_cast<unsigned>(m_seed));
+    }
 
-    if(m_robots.size() == 0)
+#ifndef ROBOTWARZ_NO_TRACE
+    // before the log opens, so its writer thread is traced too
+    bool tracing = !m_trace_path.empty();
+    if (tracing)
     {
-        output("Robot list did not load.",log_file);
-        return;
+        Tracer::instance().start(m_trace_buffer_events, m_trace_sample_every);
+        Tracer::instance().name_thread("game");
+    }
+#endif
+
+    // open the log. the writer thread owns the console and file I/O from here on.
+    // a quiet, silent game writes nowhere, so it goes without (batch games).
+    std::unique_ptr<LogWriter> log_file;
+    if (!m_quiet || !m_silent)
+    {
+        log_file = std::make_unique<LogWriter>(m_quiet ? "" : "RobotWarz_log.txt", !m_silent);
+    }
+    m_log = log_file.get();
+    if (m_quiet)
+    {
+        m_text_sink = LogWriter::File; // there is no file, so it goes nowhere
+    }
+
+    output("Game seed: " + std::to_string(m_seed) + "\n");
+
+    std::unique_ptr<ReplayWriter> replay;
+    if (!m_replay_path.empty())
+    {
+        replay = std::make_unique<ReplayWriter>(m_replay_path, m_replay_keyframe_every);
+        if (replay->is_open())
+        {
+            m_replay = replay.get();
+            m_replay->begin_game(m_seed, m_board, m_robots, unique_char);
+        }
+    }
+
+    // in live mode the terminal shows the board, the turn by turn text only goes in the log
+    std::unique_ptr<LiveView> live;
+    if (m_live)
+    {
+        // what the log has for the console lands before the view takes over
+        if (m_log)
+        {
+            m_log->flush();
+        }
+        live = std::make_unique<LiveView>(m_live_speed);
+        m_live_view = live.get();
+        m_text_sink = LogWriter::File;
+    }
+
+    m_memory_slots.clear();
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        m_memory_slots.push_back(RobotMemory::acquire(m_memory_cap));
+    }
+
+    std::vector<std::string> names;
+    for (RobotBase* robot : m_robots)
+    {
+        names.push_back(robot->m_name);
+    }
+    m_flight.begin_game(m_playback ? "" : m_crash_path, m_seed, m_max_rounds, names, &m_board);
+
+    m_robot_profile = RobotProfile();
+    if (!m_profile_path.empty())
+    {
+        m_profiler = std::make_unique<RobotProfiler>();
+        if (!m_profiler->start(m_profile_hz, names))
+        {
+            m_profiler.reset();
+        }
+    }
+
+    m_damage_dealt.assign(m_robots.size(), 0);
+    m_damage_taken.assign(m_robots.size(), 0);
+    m_death_round.assign(m_robots.size(), -1);
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        if (m_robots[i]->get_health() <= 0)
+            m_death_round[i] = 0; // a resumed game's dead
+    }
+
+    m_stats = nullptr;
+    if (!m_stats_path.empty())
+    {
+        m_game_stats.reset(m_size_row, m_size_col);
+        m_stats = &m_game_stats;
+    }
+
+    // a call budget needs the calls timed even with RobotTiming off
+    m_robot_timing.clear();
+    if (m_robot_timing_mode != RobotTimingMode::Off || m_call_budget_ns)
+    {
+        m_robot_timing.resize(m_robots.size());
+        for (size_t i = 0; i < m_robots.size(); ++i)
+        {
+            m_robot_timing[i].name = m_robots[i]->m_name;
+            m_robot_timing[i].cpu = (m_robot_timing_mode == RobotTimingMode::Cpu);
+        }
+    }
+
+    int round = m_start_round;
+    const int first_round = round;
+    m_start_round = 0;
+    reset_hash();
+    m_game_over.clear();
+
+    // checkpoints are written on their own thread, the game only hands them over
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    std::vector<std::string> robot_names;
+    if (!m_checkpoint_path.empty() && !m_playback)
+    {
+        checkpoints = std::make_unique<CheckpointWriter>(m_checkpoint_path);
+        for (RobotBase* robot : m_robots)
+        {
+            robot_names.push_back(robot->m_name);
+        }
+        snapshot(round); // pack the whole board now, later checkpoints only patch it
     }
 
-    int round = 0;
     while(!winner() && round < m_max_rounds)
     {
+        m_round = round;
+        TRACE_ROUND(round);
+        TRACE_SCOPE("round", "game", round);
         int row, col;
         char robot_id;
 
-        print_board(round, std::cout, m_live);
-        print_board(round, log_file, false);
+        // a recorded game ends where the recording does
+        if (m_repeat_limit > 0 && !m_playback && m_repetitions.record(m_zobrist) >= m_repeat_limit)
+        {
+            m_game_over = "the same position came up " + std::to_string(m_repeat_limit) +
+                          " times with no damage dealt";
+            break;
+        }
+        if (m_stalemate_every > 0 && !m_playback && round % m_stalemate_every == 0 &&
+            prove_stalemate(m_board, m_robots, m_flamethrowers, m_game_over))
+        {
+            break;
+        }
+
+        // Sample the board frames that go in the log.
+        bool log_frame = (round % m_board_log_every == 0) && (!m_board_log_on_change || m_changed);
+        if (round == first_round)
+            log_frame = true;
+
+        // the live view only takes a frame when it is ready to draw one
+        bool live_frame = live && live->wants_frame();
+
+        if (log_frame)
+        {
+            // build the frame once and send it to every sink that wants it
+            const std::string& frame = render_board(round);
+            output(frame);
+            if (live_frame && m_view_mode == ViewMode::Full)
+            {
+                live->publish(frame);
+                live_frame = false;
+            }
+        }
+        if (live_frame)
+        {
+            live->publish(render_view(round));
+        }
+        if (log_frame)
+            m_changed = false;
+
+        if (m_profiler)
+        {
+            m_profiler->drain();
+        }
+
+        if (m_playback)
+        {
+            m_playback->check_round(round, m_board, m_robots);
+        }
+
+        if (m_replay)
+        {
+            m_replay->begin_round(round, m_board, m_robots);
+        }
 
-        for (auto* robot : m_robots) 
+        if (checkpoints && round != first_round && round % m_checkpoint_every == 0)
         {
+            checkpoints->submit(Checkpoint{snapshot(round), m_max_rounds, robot_names});
+            if (!live)
+            {
+                output("Checkpoint: round " + std::to_string(round) + " of " + std::to_string(m_max_rounds) + "\n",
+                       LogWriter::Console);
+            }
+        }
+
+        for (size_t robot_index = 0; robot_index < m_robots.size(); ++robot_index) 
+        {
+            RobotBase* robot = m_robots[robot_index];
+            TRACE_SCOPE(robot->m_name.c_str(), "turn", static_cast<int64_t>(robot_index));
+            m_turn_timing = m_robot_timing.empty() ? nullptr : &m_robot_timing[robot_index];
+            m_turn_memory = m_memory_slots[robot_index];
+            m_flight.begin_turn(round, static_cast<int>(robot_index));
+            if (m_profiler)
+                m_profiler->begin_turn(static_cast<int>(robot_index));
             std::stringstream ss;
             robot->get_current_location(row, col);
             robot_id = unique_char[get_robot_index(row, col)];
 
+            ReplayTurn turn;
+            turn.robot = static_cast<int>(robot_index);
+            if (m_replay)
+            {
+                m_replay->begin_turn(turn.robot, m_robots);
+            }
+
             // Handle dead robots
             if (robot->get_health() <= 0) 
             {
                 ss << robot->m_name << " " << robot_id << " is out." << std::endl;
-                output(ss.str(),log_file);
+                output(ss.str());
                 if (m_board[row][col] != 'X') 
                 {
-                    m_board[row][col] = 'X';
+                    set_cell(row, col, 'X');
+                }
+                if (m_replay)
+                {
+                    m_replay->end_turn(turn, m_robots);
+                }
+                if (m_playback)
+                {
+                    m_playback->check_turn(m_board, m_robots);
                 }
                 continue;
             }
-            
+
+            if (m_phase_profile)
+            {
+                ++m_phase_profile->turns;
+            }
+            if (m_stats)
+            {
+                m_stats->add(HeatLayer::Occupancy, row, col);
+            }
+
             int bot_index = get_robot_index(row, col);
             if (bot_index != -1) 
             {
                     // Append the unique character to 'R' or 'X'
                     outstring.str("");
                     outstring << unique_char[bot_index];
-                    output(outstring.str(),log_file);
+                    output(outstring.str());
             }
-            output(robot->print_stats(),log_file);
+            output(robot->print_stats());
 
             //handle radar
-            output( "  checking radar, direction: ", log_file);
+            output( "  checking radar, direction: ");
 
             int radar_dir;
             
-            robot->get_radar_direction(radar_dir);
+            {
+                TRACE_SCOPE("get_radar_direction", "robot");
+                CallTimer timer(m_turn_timing, RobotCall::RadarDirection);
+                FlightCall flight(m_flight, RobotCall::RadarDirection);
+                RobotMemoryScope memory(m_turn_memory);
+                RobotProfileScope profile(m_profiler.get());
+                try
+                {
+                    robot->get_radar_direction(radar_dir);
+                }
+                catch (const std::bad_alloc&)
+                {
+                    radar_dir = 0; // over its memory cap, disqualified at the end of the turn
+                }
+            }
             outstring.str("");
             outstring << radar_dir << " ... ";
-            output( outstring.str(),log_file );
+            output( outstring.str());
             get_radar_results(robot,radar_dir,radar_results);
+            m_flight.record(FlightKind::Radar, radar_dir, static_cast<int>(radar_results.size()),
+                            radar_results.empty() ? 0 : radar_results[0].m_row << 16 | radar_results[0].m_col,
+                            radar_results.empty() ? 0 : radar_results[0].m_type);
 
             if(radar_results.empty())
-                output( " found nothing. ",log_file);
+                output( " found nothing. ");
             else
             {   outstring.str("");
                 outstring << " found '" << radar_results[0].m_type << "' at (" << radar_results[0].m_row << "," << radar_results[0].m_col << ") ";
-                output (outstring.str(),log_file);
+                output (outstring.str());
             }
 
-            robot->process_radar_results(radar_results);
+            {
+                TRACE_SCOPE("process_radar_results", "robot");
+                CallTimer timer(m_turn_timing, RobotCall::ProcessRadar);
+                FlightCall flight(m_flight, RobotCall::ProcessRadar);
+                RobotMemoryScope memory(m_turn_memory);
+                RobotProfileScope profile(m_profiler.get());
+                try
+                {
+                    robot->process_radar_results(radar_results);
+                }
+                catch (const std::bad_alloc&)
+                {
+                    // over its memory cap
+                }
+            }
 
 
             // Handle shoot or move
             int shot_row = 0, shot_col = 0;
-            if (robot->get_shot_location(shot_row, shot_col)) 
+            bool shoot;
             {
-                output("Shooting: ",log_file);
-                output(handle_shot(robot, shot_row, shot_col), log_file);
+                TRACE_SCOPE("get_shot_location", "robot");
+                CallTimer timer(m_turn_timing, RobotCall::ShotLocation);
+                FlightCall flight(m_flight, RobotCall::ShotLocation);
+                RobotMemoryScope memory(m_turn_memory);
+                RobotProfileScope profile(m_profiler.get());
+                try
+                {
+                    shoot = robot->get_shot_location(shot_row, shot_col);
+                }
+                catch (const std::bad_alloc&)
+                {
+                    shoot = false;
+                }
+            }
+            if (shoot) 
+            {
+                m_flight.record(FlightKind::Shot, 0, shot_row, shot_col);
+                output("Shooting: ");
+                output(handle_shot(robot, shot_row, shot_col));
+                turn.action = ReplayAction::Shot;
+                turn.param1 = shot_row;
+                turn.param2 = shot_col;
             } 
             else 
             {
-                output("Moving: ",log_file);
-                output(handle_move(robot),log_file);
+                output("Moving: ");
+                output(handle_move(robot));
+                turn.action = ReplayAction::Move;
+                turn.param1 = m_last_move_direction;
+                turn.param2 = m_last_move_distance;
+            }
+
+            // disqualified for asking for more memory than it may have. replays
+            // don't know about the cap, so playing one back diverges here.
+            if (m_memory_cap > 0 && robot->get_health() > 0 && RobotMemory::stats(m_turn_memory).over_cap)
+            {
+                output(robot->m_name + " is disqualified: it went over its " + format_bytes(m_memory_cap) + " memory cap. ");
+                int health = robot->get_health();
+                robot->take_damage(health);
+                count_result_damage(robot_index, health, health);
+                update_hash(robot);
+                m_repetitions.clear();
+                m_changed = true;
             }
 
             //next robot line.
-            output("\n",log_file);
+            output("\n");
+
+            if (m_replay)
+            {
+                turn.radar_direction = radar_dir;
+                turn.radar_hits = static_cast<int>(radar_results.size());
+                if (!radar_results.empty())
+                    turn.first_hit = radar_results[0];
+                m_replay->end_turn(turn, m_robots);
+            }
+            if (m_playback)
+            {
+                m_playback->check_turn(m_board, m_robots);
+            }
+        }
+
+        if (m_round_counter)
+        {
+            m_round_counter->fetch_add(1, std::memory_order_relaxed);
         }
 
-        // Pause for 1 second if live is true
-        if (m_live)
+        // pace the game and handle keys in live mode
+        if (live)
         {
-            sleep(1); // Plain C-style sleep
+            live->wait_for_tick();
         }
 
         round++;
 
     }
 
-    std::cout << "game over.";
+    // the view gives the terminal back, then the console lines it held back
+    // (the winner) go out, so they can't land in the middle of a frame
+    if (live)
+    {
+        live->finish(render_view(round));
+        m_live_view = nullptr;
+        output(m_held_console, LogWriter::Console);
+        m_held_console.clear();
+    }
+
+    if (!m_game_over.empty())
+    {
+        int tiebreak = tiebreak_index();
+        output("Draw at round " + std::to_string(round) + ": " + m_game_over + ". Tiebreak (most health, then armor): " +
+               (tiebreak >= 0 ? m_robots[tiebreak]->m_name : std::string("nobody")) + "\n", LogWriter::Both);
+    }
+
+    m_result.winner = winner_index();
+    m_result.rounds = round - first_round;
+    m_result.draw = !m_game_over.empty();
+    m_result.max_rounds = !m_result.draw && m_result.winner < 0 && round >= m_max_rounds;
+    m_result.placement.assign(m_robots.size(), 1);
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        // one place down for everyone who lasted longer
+        for (size_t j = 0; j < m_robots.size(); ++j)
+        {
+            if (m_death_round[i] >= 0 && (m_death_round[j] < 0 || m_death_round[j] > m_death_round[i]))
+                ++m_result.placement[i];
+        }
+    }
+    m_result.damage_dealt = m_damage_dealt;
+    m_result.damage_taken = m_damage_taken;
+    if (!m_results_path.empty() && !m_playback)
+    {
+        record_result();
+    }
+
+    if (m_replay)
+    {
+        m_replay->end_game(round, winner_index(), m_board, m_robots);
+        m_replay = nullptr;
+    }
+
+    if (m_playback)
+    {
+        m_playback->check_round(round, m_board, m_robots);
+        m_playback->finish(round, winner_index());
+        if (m_playback->diverged())
+        {
+            output("Replay check: diverged from the recording at round " +
+                   std::to_string(m_playback->divergence_round()) + ": " + m_playback->divergence() + "\n",
+                   LogWriter::Both);
+        }
+        else
+        {
+            output("Replay check: " + std::to_string(round) + " rounds match the recording.\n", LogWriter::Both);
+        }
+    }
+
+    // a replay's robots are stand-ins, their timings say nothing
+    m_turn_timing = nullptr;
+    if (!m_robot_timing.empty() && !m_playback)
+    {
+        if (m_robot_timing_mode != RobotTimingMode::Off)
+        {
+            output(format_robot_timing(m_robot_timing), LogWriter::Both);
+        }
+        if (m_call_budget_ns)
+        {
+            for (const RobotTiming& timing : m_robot_timing)
+            {
+                uint64_t slowest = 0;
+                for (const CallTiming& call : timing.calls)
+                {
+                    slowest = std::max(slowest, call.wall.max());
+                }
+                if (slowest > m_call_budget_ns)
+                {
+                    output("Warning: " + timing.name + " took up to " + format_ns(slowest) + " for a call, over the " +
+                           format_ns(m_call_budget_ns) + " budget.\n", LogWriter::Both);
+                }
+            }
+        }
+    }
+
+    m_flight.end_game();
+    if (m_profiler)
+    {
+        m_profiler->stop();
+        m_robot_profile = m_profiler->profile();
+        m_profiler.reset();
+        if (m_profile_report)
+        {
+            output(format_robot_profile(m_robot_profile, 10), LogWriter::Both);
+            if (write_folded_stacks(m_profile_path, m_robot_profile))
+            {
+                output("Robot profile folded stacks written to " + m_profile_path + "\n", LogWriter::Both);
+            }
+        }
+    }
+    if (m_stats)
+    {
+        m_stats->end_game(round - first_round);
+        if (m_stats_merge)
+            merge_stats_file(m_stats_path, *m_stats);
+        m_stats = nullptr;
+    }
+
+    m_turn_memory = 0;
+    m_robot_memory.clear();
+    bool allocated = false;
+    for (size_t i = 0; i < m_robots.size(); ++i)
+    {
+        m_robot_memory.push_back(RobotMemory::stats(m_memory_slots[i]));
+        RobotMemory::release(m_memory_slots[i]);
+        allocated |= m_robot_memory.back().allocations > 0;
+    }
+    // only worth a table with a cap to watch or a robot that used the heap,
+    // which a replay's stand-ins never do
+    if (m_memory_cap > 0 || allocated)
+    {
+        output(format_robot_memory(names, m_robot_memory), LogWriter::Both);
+    }
+
+#ifndef ROBOTWARZ_NO_TRACE
+    if (tracing)
+    {
+        Tracer::instance().stop();
+        if (log_file)
+        {
+            log_file->flush();
+        }
+        if (Tracer::instance().write_json(m_trace_path))
+        {
+            output("Trace: " + std::to_string(Tracer::instance().event_count()) + " spans in " + m_trace_path + "\n",
+                   LogWriter::Console);
+        }
+    }
+#endif
+
+    output("game over.", LogWriter::Console);
+    m_log = nullptr;
+    m_text_sink = LogWriter::Both;
 
 };
@@ -3,11 +3,35 @@
 
 #include "RobotBase.h"
 #include "RadarObj.h"
+#include "LogWriter.h"
+#include "BoardRenderer.h"
+#include "LiveView.h"
+#include "GameRandom.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include "Checkpoint.h"
+#include "Zobrist.h"
+#include "Stalemate.h"
+#include "Tracer.h"
+#include "RobotTiming.h"
+#include "PerfCounters.h"
+#include "RobotMemory.h"
+#include "FlightRecorder.h"
+#include "GameStats.h"
+#include "RobotProfiler.h"
+#include "ResultsStore.h"
+#include "SerializableRobot.h"
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <memory>
+#include <utility>
 #include <set>
 #include <string>
+#include <string_view>
 
 class TestArena; // Forward declaration of the test class
 
@@ -18,20 +42,192 @@ enum class ObstacleDensity
     High
 };
 
+// what the console shows: the whole board, a window that follows a robot or the
+// action, or a downsampled minimap of the whole board
+enum class ViewMode
+{
+    Full,
+    Viewport,
+    Minimap
+};
+
+// a robot compiled from robots/ and loaded, it can make a copy for every game
+struct RobotEntry
+{
+    std::string name;
+    RobotFactory create;
+    uint64_t source_hash = 0; // robot_source_hash() of Robot_<name>.cpp, 0 if there is none
+};
+
+// a config file's key = value settings, read once for any number of arenas
+struct ArenaConfig
+{
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> settings;
+    bool loaded = false;
+
+    ArenaConfig() = default;
+    explicit ArenaConfig(const std::string& config_path) { read(config_path); }
+
+    // false, with why on stderr, if the file can't be opened
+    bool read(const std::string& config_path);
+};
+
+// how the last run_simulation() came out
+struct GameResult
+{
+    int winner = -1;         // robot index, -1 for nobody
+    int rounds = 0;          // rounds played
+    bool max_rounds = false; // stopped at MaxRounds
+    bool draw = false;       // ended by RepetitionDraw or a stalemate
+
+    // per robot, in m_robots order. placement 1 is the winner, robots that died
+    // in the same round share a place and so do the survivors.
+    std::vector<int> placement;
+    std::vector<int> damage_dealt;
+    std::vector<int> damage_taken;
+};
+
+// bump it with any engine change that changes how games come out (damage, moves,
+// radar, the order of random draws...), so results in the store from before it
+// aren't taken for games played now. golden/RULES holds the version the golden
+// games were recorded under and a checksum of them: make golden won't record
+// games that come out differently under the same version, and make verify
+// fails while the two don't match.
+const int engine_rules_version = 1;
+
 class Arena {
     friend class TestArena; // Allow the test class to access private members
+    friend class Lockstep;  // runs the engine turn by turn next to ReferenceArena
 
 private:
     
     bool m_live;
+    int m_live_speed; // ticks per second in live mode
+    LiveView* m_live_view;      // while it has the terminal, console text waits
+    std::string m_held_console; // in here until the view is finished
     int m_size_row, m_size_col;
     std::set<std::pair<int,int>> m_flamethrowers; 
     std::vector<std::vector<char>> m_board;
     std::vector<RobotBase*> m_robots;
+    std::vector<std::unique_ptr<RobotBase>> m_owned_robots; // the ones add_robots() made
+
+    GameResult m_result;
+    std::atomic<uint64_t>* m_round_counter; // counts every round played, for batch metrics
 
     int m_max_rounds;
     ObstacleDensity m_obstacle_density;
 
+    // the engine's random numbers. the same seed gives the same map and dice.
+    uint64_t m_seed;
+    GameRandom m_rng;
+
+    // binary replay, only set while run_simulation() is running
+    ReplayWriter* m_replay;
+    std::string m_replay_path;
+    int m_replay_keyframe_every;
+    int m_last_move_direction, m_last_move_distance; // what the robot asked handle_move for
+
+    // set when replaying a recorded game with stand-in robots
+    std::unique_ptr<ReplayPlayback> m_playback;
+
+    // snapshots share the packed board until set_cell() changes it. cells changed
+    // by set_cell() are patched into a copy, anything else repacks the whole board.
+    mutable std::shared_ptr<const PackedBoard> m_packed_board;
+    mutable bool m_board_dirty;
+    mutable std::vector<std::pair<int,int>> m_dirty_cells;
+    int m_start_round; // run_simulation() starts here, set by restore()
+
+    // checkpoints on disk every m_checkpoint_every rounds, off when the path is empty
+    std::string m_checkpoint_path;
+    int m_checkpoint_every;
+
+    // Zobrist hash of the board and robots, kept up to date as they change, and
+    // the draw rule built on it: the same state m_repeat_limit times within
+    // m_repeat_window rounds, with no damage dealt, ends the game. 0 is off.
+    uint64_t m_zobrist;
+    std::vector<uint64_t> m_robot_keys;
+    RepetitionTable m_repetitions;
+    int m_repeat_limit;
+    int m_repeat_window;
+    int m_stalemate_every;   // rounds between prove_stalemate() checks, 0 is off
+    std::string m_game_over; // why the game ended without a winner, if it did
+
+    // Chrome trace of the game's timings, off when the path is empty
+    std::string m_trace_path;
+    int m_trace_sample_every;
+    int m_trace_buffer_events;
+
+    // how long every call into robot code took, reported when the game ends.
+    // m_turn_timing is the robot whose turn it is, null when timing is off.
+    RobotTimingMode m_robot_timing_mode;
+    std::vector<RobotTiming> m_robot_timing;
+    RobotTiming* m_turn_timing;
+
+    // heap use per robot, see RobotMemory.h. a robot that goes over m_memory_cap
+    // bytes (0 is no cap) is disqualified. m_turn_memory is the slot of the robot
+    // whose turn it is.
+    int64_t m_memory_cap;
+    std::vector<int> m_memory_slots;
+    std::vector<RobotMemoryStats> m_robot_memory;
+    int m_turn_memory;
+
+    // the longest one robot call should take, in ns, 0 for no budget. robots
+    // over it are named when the game ends, and test_robot holds them to it.
+    uint64_t m_call_budget_ns;
+
+    // the last turns of the game, written to m_crash_path if a robot crashes
+    // the process. off when the path is empty.
+    FlightRecorder m_flight;
+    std::string m_crash_path;
+
+    // sampling profile of the robots' code, on when m_profile_path is set. the
+    // folded stacks go there and the top functions in the log, unless a batch
+    // is adding the games up (m_profile_report off).
+    std::string m_profile_path;
+    int m_profile_hz;
+    bool m_profile_report;
+    std::unique_ptr<RobotProfiler> m_profiler;
+    RobotProfile m_robot_profile;
+
+    // heatmaps and weapon hit rates, only collected when m_stats_path is set.
+    // m_stats points at m_game_stats then, and m_shooter is the robot whose
+    // shot is being handled.
+    std::string m_stats_path;
+    GameStats m_game_stats;
+    GameStats* m_stats;
+    bool m_stats_merge; // into m_stats_path at the end of the game
+    RobotBase* m_shooter;
+
+    // every game's result goes in the results store at m_results_path (see
+    // ResultsStore.h), off when it is empty. robots are known there by their
+    // source hash, by name from add_robots(). m_round is the round being played.
+    std::string m_results_path;
+    std::map<std::string, uint64_t> m_robot_sources;
+    std::vector<int> m_damage_dealt, m_damage_taken, m_death_round;
+    int m_round;
+
+    // time and hardware counters per engine phase, set by bench, null otherwise
+    PhaseProfile* m_phase_profile;
+
+    // the game log, only set while run_simulation() is running
+    LogWriter* m_log;
+    LogWriter::Sink m_text_sink; // where output(text) goes by default
+    bool m_quiet;                // no turn by turn text and no log file
+    bool m_silent;               // not even the console lines, for bench
+
+    // board frames: rendered once per round, optionally sampled for the log
+    mutable BoardRenderer m_renderer;
+    int m_board_log_every;
+    bool m_board_log_on_change;
+    bool m_changed; // something moved or took damage since the last logged frame
+
+    // console view for big arenas
+    ViewMode m_view_mode;
+    std::string m_view_follow;       // robot name, or "action"
+    int m_view_rows, m_view_cols;    // 0 means fit the terminal
+    int m_action_row, m_action_col;  // where damage was last dealt
+
     //radar 
     void scan_location(int row, int col, std::vector<RadarObj>& radar_results);
     void get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results);
@@ -45,24 +241,106 @@ private:
     std::string handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col);
     std::string handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col);
     int calculate_damage(WeaponType weapon, int armor_level);
+    int random_below(int n);
     std::string apply_damage_to_robot(RobotBase* robot, WeaponType weapon);
+    void count_damage(RobotBase* robot, WeaponType weapon, int damage, int health_before);
+    void count_result_damage(std::size_t target, int damage, int health_before);
+    void record_result();
 
     //move
     std::string handle_move(RobotBase* robot);
     std::string handle_collision(RobotBase* robot, char cell, int row, int col);
 
     bool winner();
+    int winner_index() const;
+    int tiebreak_index() const;
     int get_robot_index(int row, int col) const;
+    void set_cell(int row, int col, char cell);
+    void reset_hash();
+    void update_hash(RobotBase* robot);
+
+    //view
+    void get_view_size(int& view_rows, int& view_cols) const;
+    std::string find_view_center(int view_rows, int view_cols, int& center_row, int& center_col) const;
 
 public:
 
     Arena(int row_in, int col_in);
     Arena(const std::string& config_path);
+    explicit Arena(const ArenaConfig& config);
     bool load_config(const std::string& config_path);
+    void apply_config(const ArenaConfig& config);
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const { return m_seed; }
     bool load_robots();
-    void output(std::string text,std::ostream& out_file);
+    static bool compile_robots(std::vector<RobotEntry>& entries);
+    bool add_robots(const std::vector<RobotEntry>& entries);
+    bool load_replay(const std::string& path);
+    bool replay_matched() const;
+
+    const GameResult& game_result() const { return m_result; }
+
+    // one of many games running at once: no live view, and none of the per game
+    // files (replay, checkpoint, trace, profile) that the other games would write over
+    void set_batch_game();
+    void set_round_counter(std::atomic<uint64_t>* counter) { m_round_counter = counter; }
+
+    // per robot call times from the last run_simulation(), in robot order
+    const std::vector<RobotTiming>& robot_timing() const { return m_robot_timing; }
+    RobotTimingMode robot_timing_mode() const { return m_robot_timing_mode; }
+
+    // heatmaps and weapon stats from the last run_simulation(), if StatsFile is set
+    const GameStats& game_stats() const { return m_game_stats; }
+    const std::string& stats_path() const { return m_stats_path; }
+
+    // count StatsFile's stats but leave the file to the caller, a batch that
+    // adds its games up first and writes them once
+    void set_stats_merge(bool merge) { m_stats_merge = merge; }
+
+    uint64_t call_budget_ns() const { return m_call_budget_ns; }
+    int64_t memory_cap() const { return m_memory_cap; }
+
+    // where in their code the robots spent their time in the last
+    // run_simulation(), if RobotProfileFile is set
+    const std::string& profile_path() const { return m_profile_path; }
+    const std::string& results_path() const { return m_results_path; }
+
+    // CheckpointFile. a batch keeps its progress there instead of each game's.
+    const std::string& checkpoint_path() const { return m_checkpoint_path; }
+
+    // the engine rules version and the settings that change how a game ends
+    // (RepetitionDraw, RepetitionWindow, StalemateCheckEvery, RobotMemoryCapMB)
+    uint64_t rules_hash() const;
+
+    // the seed, rules and board of the next game, everything but the robots
+    void describe_game(GameRecord& record) const;
+
+    // what a robot is known by in the results store
+    uint64_t robot_source(const std::string& name) const;
+    const RobotProfile& robot_profile() const { return m_robot_profile; }
+
+    // per robot heap use from the last run_simulation(), in robot order
+    const std::vector<RobotMemoryStats>& robot_memory() const { return m_robot_memory; }
+
+    // add what each engine phase costs to a profile, null to stop
+    void set_phase_profile(PhaseProfile* profile) { m_phase_profile = profile; }
+
+    // branch a game: snapshot() at some round, then restore() and run_simulation()
+    // as often as needed, with set_seed() for a different future each time
+    ArenaSnapshot snapshot(int round) const;
+    bool restore(const ArenaSnapshot& snapshot);
+
+    // carry on a game from a checkpoint file. load_robots() first: the robots
+    // are matched up with the checkpoint by name.
+    bool resume(const std::string& checkpoint_path);
+    void set_quiet(bool quiet) { m_quiet = quiet; }
+    void set_silent(bool silent) { m_silent = silent; }
+    void output(std::string_view text);
+    void output(std::string_view text, LogWriter::Sink sink);
     void initialize_board(bool empty=false);
     void print_board(int round, std::ostream& out, bool clear_screen) const;
+    const std::string& render_board(int round) const;
+    const std::string& render_view(int round) const;
     void run_simulation();
 };
 
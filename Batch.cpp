@@ -0,0 +1,286 @@
+#include "Batch.h"
+#include "Metrics.h"
+#include "ResultsStore.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// how often the batch checkpoint is saved
+static const std::chrono::seconds checkpoint_every(5);
+
+// The run of finished games from the first one. A game that finishes before
+// the ones ahead of it waits here until they have, so the checkpoint never
+// counts a game twice or skips one.
+class BatchProgress
+{
+public:
+
+    explicit BatchProgress(const BatchCheckpoint& start) : m_done(start) {}
+
+    void finish(uint64_t game, int winner, int rounds, bool max_rounds, bool draw)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_waiting[game] = Finished{winner, rounds, max_rounds, draw};
+            for (auto next = m_waiting.find(m_done.done); next != m_waiting.end(); next = m_waiting.find(m_done.done))
+            {
+                const Finished& finished = next->second;
+                m_done.game_rounds += finished.rounds;
+                m_done.max_rounds += finished.max_rounds ? 1 : 0;
+                m_done.draws += finished.draw ? 1 : 0;
+                if (finished.winner >= 0 && finished.winner < static_cast<int>(m_done.wins.size()))
+                    ++m_done.wins[finished.winner];
+                ++m_done.done;
+                m_waiting.erase(next);
+            }
+        }
+        m_changed.notify_all();
+    }
+
+    // true once every game is done, false if the time ran out first
+    bool wait_for(std::chrono::seconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_changed.wait_for(lock, timeout, [this] { return m_done.done >= m_done.games; });
+    }
+
+    BatchCheckpoint current() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_done;
+    }
+
+private:
+
+    struct Finished
+    {
+        int winner;
+        int rounds;
+        bool max_rounds;
+        bool draw;
+    };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    BatchCheckpoint m_done;
+    std::map<uint64_t, Finished> m_waiting;
+};
+
+static void play_games(const ArenaConfig& config, const std::vector<RobotEntry>& robots, uint64_t base_seed,
+                       BatchMetrics& metrics, BatchProgress& progress, int worker, RobotProfile& profile,
+                       std::vector<RobotTiming>& timing, GameStats& stats)
+{
+    WorkerCounters& counters = metrics.worker(worker);
+    uint64_t game;
+    while (metrics.take_game(game))
+    {
+        counters.busy.store(true, std::memory_order_relaxed);
+
+        Arena arena(config);
+        arena.set_quiet(true);
+        arena.set_silent(true);
+        arena.set_batch_game();
+        arena.set_stats_merge(false);
+        arena.set_seed(base_seed + game);
+        arena.initialize_board();
+        arena.add_robots(robots);
+        arena.set_round_counter(&counters.rounds);
+        arena.run_simulation();
+
+        profile.merge(arena.robot_profile());
+        merge_robot_timing(timing, arena.robot_timing());
+        if (arena.game_stats().games() > 0)
+        {
+            if (stats.games() == 0)
+                stats = arena.game_stats();
+            else
+                stats.merge(arena.game_stats()); // every game's board is the config's size
+        }
+
+        const GameResult& result = arena.game_result();
+        metrics.finish_game(worker, result.winner, result.rounds, result.max_rounds, result.draw);
+        progress.finish(game, result.winner, result.rounds, result.max_rounds, result.draw);
+        counters.busy.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool run_batch(const BatchOptions& options, const std::vector<RobotEntry>& robots)
+{
+    // a resumed batch is the checkpoint's config, games and seed
+    BatchCheckpoint start;
+    bool resuming = !options.resume_path.empty();
+    if (resuming && !load_batch_checkpoint(options.resume_path, start))
+    {
+        return false;
+    }
+    if (!resuming)
+    {
+        start.config_path = options.config_path;
+        start.games = options.games;
+    }
+
+    // read once for every game. the seed the config asks for, or the clock's.
+    ArenaConfig settings(start.config_path);
+    Arena config(settings);
+    if (!resuming)
+    {
+        start.base_seed = config.get_seed();
+    }
+    uint64_t base_seed = start.base_seed;
+    int jobs = std::max(1, options.jobs);
+
+    std::vector<std::string> names;
+    for (const RobotEntry& robot : robots)
+    {
+        names.push_back(robot.name);
+    }
+
+    // the checkpoint's wins, in the order robots/ listed them this time
+    std::vector<uint64_t> wins(names.size(), 0);
+    bool same_robots = !resuming || start.robots.size() == names.size();
+    for (std::size_t i = 0; i < start.robots.size() && same_robots; ++i)
+    {
+        auto found = std::find(names.begin(), names.end(), start.robots[i]);
+        same_robots = found != names.end();
+        if (same_robots)
+            wins[found - names.begin()] = start.wins[i];
+    }
+    if (!same_robots)
+    {
+        std::cerr << "The robots in " << options.resume_path << " aren't the ones in robots/" << std::endl;
+        return false;
+    }
+    start.robots = names;
+    start.wins = wins;
+
+    // a resumed batch carries on saving to the file it came from
+    std::string checkpoint_path = resuming ? options.resume_path : config.checkpoint_path();
+    BatchProgress progress(start);
+
+    BatchMetrics metrics(jobs, names, start.games, start.done);
+    MetricsExporter exporter(metrics, options.metrics_path, options.metrics_socket);
+    if (!exporter.start())
+    {
+        return false;
+    }
+
+    std::cout << "Batch: " << start.games << " games on " << jobs << " threads, seeds " << base_seed
+              << " to " << base_seed + start.games - 1 << std::endl;
+    if (resuming)
+    {
+        std::cout << "Resuming " << options.resume_path << " at game " << start.done << std::endl;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    std::vector<RobotProfile> profiles(jobs);
+    std::vector<std::vector<RobotTiming>> timings(jobs);
+    std::vector<GameStats> stats(jobs);
+    for (int i = 0; i < jobs; ++i)
+    {
+        workers.emplace_back(play_games, std::cref(settings), std::cref(robots), base_seed, std::ref(metrics),
+                             std::ref(progress), i, std::ref(profiles[i]), std::ref(timings[i]), std::ref(stats[i]));
+    }
+
+    // the workers never touch the disk for the checkpoint
+    uint64_t saved = start.done;
+    for (bool finished = false; !finished;)
+    {
+        finished = progress.wait_for(checkpoint_every);
+        BatchCheckpoint now = progress.current();
+        if (!checkpoint_path.empty() && now.done != saved && save_batch_checkpoint(checkpoint_path, now))
+        {
+            saved = now.done;
+        }
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    exporter.stop();
+
+    // the totals, with the games before a resume
+    BatchCheckpoint done = progress.current();
+    uint64_t games = done.done;
+    uint64_t played = done.done - start.done;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%llu games in %.1fs (%.1f games/s), %.1f rounds a game, %llu at MaxRounds, %llu draws\n",
+                  static_cast<unsigned long long>(games), seconds, seconds > 0 ? played / seconds : 0.0,
+                  games ? static_cast<double>(done.game_rounds) / games : 0.0,
+                  static_cast<unsigned long long>(done.max_rounds), static_cast<unsigned long long>(done.draws));
+    std::cout << line;
+    for (std::size_t robot = 0; robot < done.wins.size(); ++robot)
+    {
+        std::snprintf(line, sizeof(line), "  %-24s %8llu wins %6.1f%%\n", names[robot].c_str(),
+                      static_cast<unsigned long long>(done.wins[robot]), games ? 100.0 * done.wins[robot] / games : 0.0);
+        std::cout << line;
+    }
+
+    // every game's call times in one, as a game prints them
+    if (config.robot_timing_mode() != RobotTimingMode::Off)
+    {
+        std::vector<RobotTiming> timing;
+        for (const std::vector<RobotTiming>& worker : timings)
+        {
+            merge_robot_timing(timing, worker);
+        }
+        if (!timing.empty())
+        {
+            std::cout << format_robot_timing(timing);
+        }
+    }
+
+    // every game's stats in one, added to the file once
+    if (!config.stats_path().empty())
+    {
+        GameStats total;
+        for (const GameStats& worker : stats)
+        {
+            if (total.games() == 0)
+                total = worker;
+            else if (worker.games() > 0)
+                total.merge(worker);
+        }
+        if (total.games() > 0)
+        {
+            if (!merge_stats_file(config.stats_path(), total))
+            {
+                return false;
+            }
+            std::cout << "Stats of " << total.games() << " games added to " << config.stats_path() << "\n";
+        }
+    }
+
+    // every game went in the results store too
+    if (!config.results_path().empty())
+    {
+        if (ResultsStore* store = shared_results_store(config.results_path()))
+        {
+            store->flush();
+            std::cout << format_ratings(*store, 20);
+        }
+    }
+
+    // every game's robot profile in one
+    if (!config.profile_path().empty())
+    {
+        RobotProfile profile;
+        for (const RobotProfile& worker : profiles)
+        {
+            profile.merge(worker);
+        }
+        std::cout << format_robot_profile(profile, 10);
+        if (write_folded_stacks(config.profile_path(), profile))
+        {
+            std::cout << "Robot profile folded stacks written to " << config.profile_path() << "\n";
+        }
+    }
+    return true;
+}
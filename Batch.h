@@ -0,0 +1,40 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "Arena.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Many games with the same config and robots, on worker threads. Game n plays
+// with the config's seed plus n, so any one of them can be played again on its
+// own, whatever --jobs was (robots' rand() is per game, see RobotRandom.h). The
+// config is read once for them all. The games are quiet and silent, with no log
+// writer thread, write no per game files (see Arena::set_batch_game), and
+// StatsFile and RobotProfileFile total them all up, and so does the
+// RobotTiming table.
+// With ResultsFile set every game is added to the results store, and the
+// ratings are printed at the end.
+//
+// With CheckpointFile set the batch's progress (BatchCheckpoint) is saved there
+// every few seconds, by the thread waiting on the workers, and RobotWarz
+// --resume <file> plays the games that weren't done. Games that finished after
+// the last save are played again, and count again in the ResultsFile. The
+// robot profile, timing and StatsFile are of the games played since the
+// resume: the workers add up their games' stats and the file is written once,
+// at the end.
+
+struct BatchOptions
+{
+    std::string config_path = "RobotWarz.cfg";
+    uint64_t games = 1;
+    int jobs = 1;
+    std::string metrics_path;   // Prometheus text, rewritten every few seconds
+    std::string metrics_socket; // Unix socket that answers with the same text
+    std::string resume_path;    // a batch checkpoint: its config, games and seed instead
+};
+
+// false if the metrics can't be set up. a table of wins goes to stdout at the end.
+bool run_batch(const BatchOptions& options, const std::vector<RobotEntry>& robots);
+
+#endif
@@ -0,0 +1,422 @@
+#include "BenchHistory.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static void put_json_string(std::string& out, const std::string& text)
+{
+    out += '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string bench_run_json(const BenchRun& run)
+{
+    std::string out = "{\"revision\":";
+    put_json_string(out, run.revision);
+    out += ",\"dirty\":";
+    out += run.dirty ? "true" : "false";
+    out += ",\"compiler\":";
+    put_json_string(out, run.compiler);
+    out += ",\"flags\":";
+    put_json_string(out, run.flags);
+    out += ",\"date\":";
+    put_json_string(out, run.date);
+    out += ",\"runs\":" + std::to_string(run.runs) + ",\"metrics\":{";
+
+    bool first = true;
+    for (const auto& [name, samples] : run.metrics)
+    {
+        if (!first)
+            out += ',';
+        first = false;
+        put_json_string(out, name);
+        out += ":[";
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%s%.1f", i ? "," : "", samples[i]);
+            out += number;
+        }
+        out += ']';
+    }
+    out += "}}";
+    return out;
+}
+
+namespace
+{
+
+// just enough JSON for what bench_run_json() writes, plus skipping anything
+// a later version might add
+class JsonReader
+{
+public:
+
+    explicit JsonReader(const std::string& text) : m_text(text), m_pos(0) {}
+
+    bool failed() const { return !m_error.empty(); }
+    const std::string& error() const { return m_error; }
+
+    void fail(const std::string& what)
+    {
+        if (m_error.empty())
+            m_error = what + " at character " + std::to_string(m_pos);
+    }
+
+    char peek()
+    {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+            ++m_pos;
+        return m_pos < m_text.size() ? m_text[m_pos] : 0;
+    }
+
+    bool consume(char c)
+    {
+        if (peek() != c)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+            fail(std::string("expected '") + c + "'");
+    }
+
+    bool at_end() { return peek() == 0; }
+
+    std::string read_string()
+    {
+        std::string text;
+        expect('"');
+        while (!failed() && m_pos < m_text.size() && m_text[m_pos] != '"')
+        {
+            char c = m_text[m_pos++];
+            if (c == '\\' && m_pos < m_text.size())
+            {
+                char escaped = m_text[m_pos++];
+                switch (escaped)
+                {
+                    case 'n': text += '\n'; break;
+                    case 't': text += '\t'; break;
+                    case 'r': text += '\r'; break;
+                    case 'b': text += '\b'; break;
+                    case 'f': text += '\f'; break;
+                    case 'u':
+                        // only what put_json_string writes: control characters
+                        text += static_cast<char>(std::strtol(m_text.substr(m_pos, 4).c_str(), nullptr, 16));
+                        m_pos += 4;
+                        break;
+                    default: text += escaped; break;
+                }
+            }
+            else
+            {
+                text += c;
+            }
+        }
+        if (m_pos >= m_text.size())
+            fail("unterminated string");
+        ++m_pos;
+        return text;
+    }
+
+    double read_number()
+    {
+        peek();
+        const char* start = m_text.c_str() + m_pos;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start)
+            fail("expected a number");
+        m_pos += static_cast<std::size_t>(end - start);
+        return value;
+    }
+
+    bool read_bool()
+    {
+        peek();
+        if (m_text.compare(m_pos, 4, "true") == 0)
+        {
+            m_pos += 4;
+            return true;
+        }
+        if (m_text.compare(m_pos, 5, "false") == 0)
+        {
+            m_pos += 5;
+            return false;
+        }
+        fail("expected true or false");
+        return false;
+    }
+
+    std::vector<double> read_numbers()
+    {
+        std::vector<double> values;
+        expect('[');
+        if (consume(']'))
+            return values;
+        do
+        {
+            values.push_back(read_number());
+        } while (!failed() && consume(','));
+        expect(']');
+        return values;
+    }
+
+    void skip_value()
+    {
+        char c = peek();
+        if (c == '"')
+            read_string();
+        else if (c == '{' || c == '[')
+        {
+            char close = c == '{' ? '}' : ']';
+            ++m_pos;
+            if (consume(close))
+                return;
+            do
+            {
+                if (close == '}')
+                {
+                    read_string();
+                    expect(':');
+                }
+                skip_value();
+            } while (!failed() && consume(','));
+            expect(close);
+        }
+        else if (c == 't' || c == 'f')
+            read_bool();
+        else if (m_text.compare(m_pos, 4, "null") == 0)
+            m_pos += 4;
+        else
+            read_number();
+    }
+
+private:
+
+    const std::string& m_text;
+    std::size_t m_pos;
+    std::string m_error;
+};
+
+}
+
+bool parse_bench_run(const std::string& text, BenchRun& run, std::string& error)
+{
+    run = BenchRun();
+    JsonReader json(text);
+    bool has_metrics = false;
+
+    json.expect('{');
+    if (!json.consume('}'))
+    {
+        do
+        {
+            std::string key = json.read_string();
+            json.expect(':');
+            if (key == "revision")
+                run.revision = json.read_string();
+            else if (key == "dirty")
+                run.dirty = json.read_bool();
+            else if (key == "compiler")
+                run.compiler = json.read_string();
+            else if (key == "flags")
+                run.flags = json.read_string();
+            else if (key == "date")
+                run.date = json.read_string();
+            else if (key == "runs")
+                run.runs = static_cast<int>(json.read_number());
+            else if (key == "metrics")
+            {
+                has_metrics = true;
+                json.expect('{');
+                if (!json.consume('}'))
+                {
+                    do
+                    {
+                        std::string name = json.read_string();
+                        json.expect(':');
+                        run.metrics[name] = json.read_numbers();
+                    } while (!json.failed() && json.consume(','));
+                    json.expect('}');
+                }
+            }
+            else
+                json.skip_value();
+        } while (!json.failed() && json.consume(','));
+        json.expect('}');
+    }
+    if (!json.failed() && !json.at_end())
+        json.fail("unexpected text after the run");
+    if (!json.failed() && !has_metrics)
+        json.fail("no metrics");
+
+    error = json.error();
+    return !json.failed();
+}
+
+bool load_bench_history(const std::string& path, std::vector<BenchRun>& history)
+{
+    history.clear();
+    std::ifstream in(path);
+    if (!in)
+    {
+        return true;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line))
+    {
+        ++line_number;
+        if (line.empty())
+            continue;
+        BenchRun run;
+        std::string error;
+        if (!parse_bench_run(line, run, error))
+        {
+            std::cerr << path << ":" << line_number << ": " << error << std::endl;
+            return false;
+        }
+        history.push_back(std::move(run));
+    }
+    return true;
+}
+
+bool append_bench_history(const std::string& path, const BenchRun& run)
+{
+    std::ofstream out(path, std::ios::app);
+    if (!(out << bench_run_json(run) << "\n") || !out.flush())
+    {
+        std::cerr << "Failed to write bench history: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+double median(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double upper = values[middle];
+    if (values.size() % 2)
+    {
+        return upper;
+    }
+    double lower = *std::max_element(values.begin(), values.begin() + middle);
+    return (lower + upper) / 2;
+}
+
+double median_absolute_deviation(const std::vector<double>& values)
+{
+    double center = median(values);
+    std::vector<double> deviations;
+    for (double value : values)
+    {
+        deviations.push_back(std::fabs(value - center));
+    }
+    return 1.4826 * median(deviations);
+}
+
+std::vector<BenchComparison> compare_bench_run(const std::vector<BenchRun>& history, const BenchRun& run,
+                                               int window, double threshold)
+{
+    // only runs built the same way are comparable, newest last
+    std::vector<const BenchRun*> baseline;
+    for (auto it = history.rbegin(); it != history.rend() && static_cast<int>(baseline.size()) < window; ++it)
+    {
+        if (it->compiler == run.compiler && it->flags == run.flags)
+        {
+            baseline.push_back(&*it);
+        }
+    }
+
+    std::vector<BenchComparison> comparisons;
+    for (const auto& [name, samples] : run.metrics)
+    {
+        BenchComparison comparison;
+        comparison.metric = name;
+        comparison.now = median(samples);
+
+        std::vector<double> medians;
+        for (const BenchRun* old : baseline)
+        {
+            auto found = old->metrics.find(name);
+            if (found != old->metrics.end() && !found->second.empty())
+            {
+                medians.push_back(median(found->second));
+            }
+        }
+        comparison.baseline_runs = static_cast<int>(medians.size());
+        if (!medians.empty())
+        {
+            comparison.baseline = median(medians);
+            comparison.noise = median_absolute_deviation(medians);
+        }
+        // one or two old runs say too little about the noise to fail a build on
+        if (comparison.baseline_runs >= bench_min_baseline_runs && comparison.baseline > 0)
+        {
+            double margin = std::max(threshold * comparison.baseline, 3 * comparison.noise);
+            comparison.regressed = comparison.now > comparison.baseline + margin;
+            comparison.improved = comparison.now < comparison.baseline - margin;
+        }
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+std::string format_bench_comparison(const std::vector<BenchComparison>& comparisons)
+{
+    std::ostringstream out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-32s %12s %10s %12s %8s\n", "", "baseline", "noise", "now", "change");
+    out << line;
+    for (const BenchComparison& comparison : comparisons)
+    {
+        if (comparison.baseline_runs == 0 || comparison.baseline <= 0)
+        {
+            std::snprintf(line, sizeof(line), "  %-30s %12s %10s %12.1f %8s  new\n", comparison.metric.c_str(), "-", "-",
+                          comparison.now, "-");
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "  %-30s %12.1f %10.1f %12.1f %+7.1f%%%s\n", comparison.metric.c_str(),
+                          comparison.baseline, comparison.noise, comparison.now,
+                          100.0 * (comparison.now - comparison.baseline) / comparison.baseline,
+                          comparison.regressed ? "  SLOWER" : comparison.improved ? "  faster" :
+                          comparison.baseline_runs < bench_min_baseline_runs ? "  (too little history)" : "");
+        }
+        out << line;
+    }
+    return out.str();
+}
@@ -0,0 +1,69 @@
+#ifndef __BENCHHISTORY_H__
+#define __BENCHHISTORY_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+// What bench measured in one go, and a history of those to catch the engine
+// getting slower before a tournament does.
+//
+// bench --json writes a run as one line of JSON: the git revision, compiler
+// and flags it was built with, and for every game and metric the samples from
+// each timed run, e.g. "small_low/radar_ns": [412.1, 409.8, ...]. bench_compare
+// appends it to a history file (one run per line) and holds it up against the
+// runs before it.
+//
+// The baseline for a metric is the median over the last few runs built the same
+// way (same compiler and flags), each of those counted by its own median, and
+// the noise is their median absolute deviation. A metric has regressed when its
+// median is above the baseline by more than the threshold and by more than 3
+// times the noise, so one slow run in the history doesn't hide a slowdown and
+// one noisy machine doesn't raise an alarm.
+
+struct BenchRun
+{
+    std::string revision;  // git rev-parse --short HEAD, "unknown" outside git
+    bool dirty = false;    // uncommitted changes in the tree
+    std::string compiler;
+    std::string flags;
+    std::string date;      // UTC, ISO 8601
+    int runs = 0;
+    std::map<std::string, std::vector<double>> metrics; // "<game>/<metric>": a sample per run
+};
+
+std::string bench_run_json(const BenchRun& run);
+
+// false, with the reason in error, if text isn't a run bench --json wrote
+bool parse_bench_run(const std::string& text, BenchRun& run, std::string& error);
+
+// every run in a history file, oldest first. a missing file is an empty history.
+bool load_bench_history(const std::string& path, std::vector<BenchRun>& history);
+bool append_bench_history(const std::string& path, const BenchRun& run);
+
+double median(std::vector<double> values);
+
+// scaled by 1.4826, so it estimates the standard deviation for normal noise
+double median_absolute_deviation(const std::vector<double>& values);
+
+struct BenchComparison
+{
+    std::string metric;
+    double baseline = 0;
+    double noise = 0;
+    double now = 0;
+    int baseline_runs = 0; // 0 when this metric has no history yet
+    bool regressed = false;
+    bool improved = false;
+};
+
+// a metric needs this many earlier runs before it can be flagged
+static const int bench_min_baseline_runs = 3;
+
+// threshold is a fraction: 0.05 flags anything more than 5% slower
+std::vector<BenchComparison> compare_bench_run(const std::vector<BenchRun>& history, const BenchRun& run,
+                                               int window, double threshold);
+
+std::string format_bench_comparison(const std::vector<BenchComparison>& comparisons);
+
+#endif
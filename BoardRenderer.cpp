@@ -0,0 +1,362 @@
+#include "BoardRenderer.h"
+#include <algorithm>
+#include <cstdio>
+
+static const int col_width = 3; // every cell is printed as 3 characters
+
+BoardRenderer::BoardRenderer()
+    : m_rows(0), m_cols(0), m_terrain_rows(0), m_terrain_cols(0), m_block_rows(0), m_block_cols(0)
+{
+    // plain cells are right aligned in their slot: "  M"
+    for (int c = 0; c < 256; ++c)
+    {
+        m_cell_text[c] = {' ', ' ', static_cast<char>(c)};
+    }
+}
+
+void BoardRenderer::build_template(int rows, int cols)
+{
+    m_rows = rows;
+    m_cols = cols;
+    m_body.clear();
+    m_row_offset.assign(rows, 0);
+    m_robot_at.assign(static_cast<std::size_t>(rows) * cols, -1);
+
+    char number[16];
+
+    // column headers
+    m_body += "   ";
+    for (int col = 0; col < cols; ++col)
+    {
+        std::snprintf(number, sizeof(number), "%*d", col_width, col);
+        m_body += number;
+    }
+    m_body += '\n';
+
+    // row index followed by empty slots that render() fills in
+    for (int row = 0; row < rows; ++row)
+    {
+        std::snprintf(number, sizeof(number), "%2d ", row);
+        m_body += number;
+        m_row_offset[row] = m_body.size();
+        m_body.append(static_cast<std::size_t>(cols) * col_width, ' ');
+        m_body += '\n';
+    }
+}
+
+const std::string& BoardRenderer::render(int round, const std::vector<std::vector<char>>& board,
+                                         const std::vector<RobotBase*>& robots, const char* robot_tags)
+{
+    int rows = static_cast<int>(board.size());
+    int cols = rows > 0 ? static_cast<int>(board[0].size()) : 0;
+    if (rows != m_rows || cols != m_cols)
+    {
+        build_template(rows, cols);
+    }
+
+    // where each robot is. walk backwards so the lowest index wins a shared
+    // cell, which is what get_robot_index() returns.
+    std::vector<std::size_t> marked;
+    marked.reserve(robots.size());
+    for (int i = static_cast<int>(robots.size()) - 1; i >= 0; --i)
+    {
+        int row, col;
+        robots[i]->get_current_location(row, col);
+        if (row >= 0 && row < rows && col >= 0 && col < cols)
+        {
+            std::size_t cell = static_cast<std::size_t>(row) * cols + col;
+            m_robot_at[cell] = i;
+            marked.push_back(cell);
+        }
+    }
+
+    std::vector<int> listed; // robots in board order, for the round 0 legend
+
+    for (int row = 0; row < rows; ++row)
+    {
+        char* slot = &m_body[m_row_offset[row]];
+        const std::vector<char>& board_row = board[row];
+        const int* robot_row = &m_robot_at[static_cast<std::size_t>(row) * cols];
+
+        for (int col = 0; col < cols; ++col, slot += col_width)
+        {
+            char cell = board_row[col];
+            const std::array<char, 3>& text = m_cell_text[static_cast<unsigned char>(cell)];
+            slot[0] = text[0];
+            slot[1] = text[1];
+            slot[2] = text[2];
+
+            if ((cell == 'R' || cell == 'X') && robot_row[col] != -1)
+            {
+                // ' R!' - the cell plus the robot's unique character
+                slot[1] = cell;
+                slot[2] = robot_tags[robot_row[col]];
+                if (round == 0)
+                {
+                    listed.push_back(robot_row[col]);
+                }
+            }
+        }
+    }
+
+    for (std::size_t cell : marked)
+    {
+        m_robot_at[cell] = -1;
+    }
+
+    m_frame.clear();
+    m_frame += "\n              =========== starting round ";
+    m_frame += std::to_string(round);
+    m_frame += " ===========\n";
+    m_frame += m_body;
+
+    for (int index : listed)
+    {
+        m_frame += robot_tags[index];
+        m_frame += robots[index]->m_name;
+        m_frame += '\n';
+    }
+
+    return m_frame;
+}
+
+// priority of what a minimap slot shows when a block holds several things
+static int terrain_priority(char cell)
+{
+    switch (cell)
+    {
+        case 'F': return 3;
+        case 'P': return 2;
+        case 'M': return 1;
+        default:  return 0;
+    }
+}
+
+static int digits(int value)
+{
+    int count = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        ++count;
+    }
+    return count;
+}
+
+void BoardRenderer::append_legend(const std::vector<RobotBase*>& robots, const char* robot_tags, int width)
+{
+    // one line: tag, name and health of every robot, cut at the view width
+    std::string legend;
+    for (std::size_t i = 0; i < robots.size(); ++i)
+    {
+        legend += robot_tags[i];
+        legend += robots[i]->m_name;
+        legend += ':';
+        legend += std::to_string(robots[i]->get_health());
+        legend += "  ";
+    }
+    if (static_cast<int>(legend.size()) > width)
+        legend.resize(width);
+    m_frame += legend;
+    m_frame += '\n';
+}
+
+const std::string& BoardRenderer::render_window(int round, const std::vector<std::vector<char>>& board,
+                                                const std::vector<RobotBase*>& robots, const char* robot_tags,
+                                                int top, int left, int view_rows, int view_cols,
+                                                const std::string& caption)
+{
+    int rows = static_cast<int>(board.size());
+    int cols = rows > 0 ? static_cast<int>(board[0].size()) : 0;
+
+    view_rows = std::max(0, std::min(view_rows, rows));
+    view_cols = std::max(0, std::min(view_cols, cols));
+    top = std::max(0, std::min(top, rows - view_rows));
+    left = std::max(0, std::min(left, cols - view_cols));
+
+    // robots inside the window, lowest index wins a shared cell
+    std::vector<int> robot_at(static_cast<std::size_t>(view_rows) * view_cols, -1);
+    for (int i = static_cast<int>(robots.size()) - 1; i >= 0; --i)
+    {
+        int row, col;
+        robots[i]->get_current_location(row, col);
+        if (row >= top && row < top + view_rows && col >= left && col < left + view_cols)
+        {
+            robot_at[static_cast<std::size_t>(row - top) * view_cols + (col - left)] = i;
+        }
+    }
+
+    char number[16];
+    int row_width = digits(std::max(rows - 1, 0));
+
+    m_frame.clear();
+    m_frame += "\n              =========== starting round ";
+    m_frame += std::to_string(round);
+    m_frame += " =========== ";
+    m_frame += caption;
+    m_frame += '\n';
+
+    m_frame.append(row_width + 1, ' ');
+    for (int col = left; col < left + view_cols; ++col)
+    {
+        std::snprintf(number, sizeof(number), "%*d", col_width, col % 1000);
+        m_frame += number;
+    }
+    m_frame += '\n';
+
+    for (int row = top; row < top + view_rows; ++row)
+    {
+        std::snprintf(number, sizeof(number), "%*d ", row_width, row);
+        m_frame += number;
+
+        const std::vector<char>& board_row = board[row];
+        const int* robot_row = &robot_at[static_cast<std::size_t>(row - top) * view_cols];
+        for (int col = 0; col < view_cols; ++col)
+        {
+            char cell = board_row[left + col];
+            if ((cell == 'R' || cell == 'X') && robot_row[col] != -1)
+            {
+                m_frame += ' ';
+                m_frame += cell;
+                m_frame += robot_tags[robot_row[col]];
+            }
+            else
+            {
+                m_frame.append(m_cell_text[static_cast<unsigned char>(cell)].data(), col_width);
+            }
+        }
+        m_frame += '\n';
+    }
+
+    append_legend(robots, robot_tags, row_width + 1 + view_cols * col_width);
+    return m_frame;
+}
+
+void BoardRenderer::build_terrain(const std::vector<std::vector<char>>& board, int block_rows, int block_cols,
+                                  int map_rows, int map_cols)
+{
+    // the only full pass over the board. obstacles that change during the game
+    // come in through terrain_changed(), robots are drawn from the robot list
+    // every frame.
+    m_terrain_rows = map_rows;
+    m_terrain_cols = map_cols;
+    m_block_rows = block_rows;
+    m_block_cols = block_cols;
+    m_terrain.assign(static_cast<std::size_t>(map_rows) * map_cols, '.');
+
+    for (std::size_t row = 0; row < board.size(); ++row)
+    {
+        char* map_row = &m_terrain[(row / block_rows) * map_cols];
+        for (std::size_t col = 0; col < board[row].size(); ++col)
+        {
+            char cell = board[row][col];
+            char& slot = map_row[col / block_cols];
+            if (terrain_priority(cell) > terrain_priority(slot))
+                slot = cell;
+        }
+    }
+}
+
+void BoardRenderer::terrain_changed(const std::vector<std::vector<char>>& board, int row, int col, char was)
+{
+    if (m_terrain_rows == 0 || terrain_priority(was) == terrain_priority(board[row][col]))
+    {
+        return;
+    }
+    int block_row = row / m_block_rows;
+    int block_col = col / m_block_cols;
+    int last_row = std::min(static_cast<int>(board.size()), (block_row + 1) * m_block_rows);
+    int last_col = std::min(static_cast<int>(board[row].size()), (block_col + 1) * m_block_cols);
+    char& slot = m_terrain[static_cast<std::size_t>(block_row) * m_terrain_cols + block_col];
+    slot = '.';
+    for (int r = block_row * m_block_rows; r < last_row; ++r)
+    {
+        for (int c = block_col * m_block_cols; c < last_col; ++c)
+        {
+            if (terrain_priority(board[r][c]) > terrain_priority(slot))
+                slot = board[r][c];
+        }
+    }
+}
+
+const std::string& BoardRenderer::render_minimap(int round, const std::vector<std::vector<char>>& board,
+                                                 const std::vector<RobotBase*>& robots, const char* robot_tags,
+                                                 int view_rows, int view_cols)
+{
+    int rows = static_cast<int>(board.size());
+    int cols = rows > 0 ? static_cast<int>(board[0].size()) : 0;
+    view_rows = std::max(1, view_rows);
+    view_cols = std::max(1, view_cols);
+
+    int block_rows = std::max(1, (rows + view_rows - 1) / view_rows);
+    int block_cols = std::max(1, (cols + view_cols - 1) / view_cols);
+    int map_rows = (rows + block_rows - 1) / block_rows;
+    int map_cols = (cols + block_cols - 1) / block_cols;
+
+    if (m_terrain_rows != map_rows || m_terrain_cols != map_cols ||
+        m_block_rows != block_rows || m_block_cols != block_cols)
+    {
+        build_terrain(board, block_rows, block_cols, map_rows, map_cols);
+    }
+
+    // robots on top of the obstacles: a live robot beats a dead one, then lowest index
+    m_map = m_terrain;
+    std::vector<int> robot_at(m_map.size(), -1);
+    for (int i = static_cast<int>(robots.size()) - 1; i >= 0; --i)
+    {
+        int row, col;
+        robots[i]->get_current_location(row, col);
+        if (row < 0 || row >= rows || col < 0 || col >= cols)
+            continue;
+
+        std::size_t slot = static_cast<std::size_t>(row / block_rows) * map_cols + col / block_cols;
+        char mark = robots[i]->get_health() > 0 ? 'R' : 'X';
+        if (m_map[slot] != 'R' || mark == 'R')
+        {
+            m_map[slot] = mark;
+            robot_at[slot] = i;
+        }
+    }
+
+    char number[16];
+    int row_width = digits(std::max(rows - 1, 0));
+
+    m_frame.clear();
+    m_frame += "\n              =========== starting round ";
+    m_frame += std::to_string(round);
+    m_frame += " =========== minimap, ";
+    m_frame += std::to_string(block_rows) + "x" + std::to_string(block_cols);
+    m_frame += " cells per slot\n";
+
+    m_frame.append(row_width + 1, ' ');
+    for (int col = 0; col < map_cols; ++col)
+    {
+        std::snprintf(number, sizeof(number), "%*d", col_width, (col * block_cols) % 1000);
+        m_frame += number;
+    }
+    m_frame += '\n';
+
+    for (int row = 0; row < map_rows; ++row)
+    {
+        std::snprintf(number, sizeof(number), "%*d ", row_width, row * block_rows);
+        m_frame += number;
+        for (int col = 0; col < map_cols; ++col)
+        {
+            std::size_t slot = static_cast<std::size_t>(row) * map_cols + col;
+            if (robot_at[slot] != -1)
+            {
+                m_frame += ' ';
+                m_frame += m_map[slot];
+                m_frame += robot_tags[robot_at[slot]];
+            }
+            else
+            {
+                m_frame.append(m_cell_text[static_cast<unsigned char>(m_map[slot])].data(), col_width);
+            }
+        }
+        m_frame += '\n';
+    }
+
+    append_legend(robots, robot_tags, row_width + 1 + map_cols * col_width);
+    return m_frame;
+}
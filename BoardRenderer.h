@@ -0,0 +1,70 @@
+#ifndef __BOARDRENDERER_H__
+#define __BOARDRENDERER_H__
+
+#include "RobotBase.h"
+#include <array>
+#include <string>
+#include <vector>
+
+// Renders the classic text board (the one print_board() used to build with setw)
+// into a single string, so a frame is formatted once and shared by every sink.
+//
+// The frame body is a preformatted template: every cell is a fixed 3 character
+// slot that gets patched from a lookup table, and robot cells are found with one
+// pass over the robot list instead of a search per cell.
+//
+// For big arenas there are two smaller views whose cost depends on the size of the
+// view, not the arena: a window onto part of the board, and a minimap where every
+// slot summarises a block of cells.
+class BoardRenderer
+{
+public:
+
+    BoardRenderer();
+
+    // robot_tags holds the character shown after 'R'/'X' for each robot index.
+    const std::string& render(int round, const std::vector<std::vector<char>>& board,
+                              const std::vector<RobotBase*>& robots, const char* robot_tags);
+
+    // the view_rows x view_cols window with top left corner (top, left)
+    const std::string& render_window(int round, const std::vector<std::vector<char>>& board,
+                                     const std::vector<RobotBase*>& robots, const char* robot_tags,
+                                     int top, int left, int view_rows, int view_cols,
+                                     const std::string& caption);
+
+    // the whole board squeezed into at most view_rows x view_cols slots. each slot
+    // shows the highest priority thing in its block: robot, dead robot, F, P, M.
+    const std::string& render_minimap(int round, const std::vector<std::vector<char>>& board,
+                                      const std::vector<RobotBase*>& robots, const char* robot_tags,
+                                      int view_rows, int view_cols);
+
+    // the minimap caches obstacles per block. call this when the board is rebuilt.
+    void invalidate_terrain() { m_terrain_rows = 0; }
+
+    // a cell of the board changed from was to what it is now. redoes the one
+    // cached block if that changes what it shows.
+    void terrain_changed(const std::vector<std::vector<char>>& board, int row, int col, char was);
+
+    const std::string& frame() const { return m_frame; }
+
+private:
+
+    void build_template(int rows, int cols);
+    void build_terrain(const std::vector<std::vector<char>>& board, int block_rows, int block_cols,
+                       int map_rows, int map_cols);
+    void append_legend(const std::vector<RobotBase*>& robots, const char* robot_tags, int width);
+
+    int m_rows, m_cols;
+    std::string m_body;                      // column header + rows, patched in place
+    std::vector<std::size_t> m_row_offset;   // where each row's first cell slot starts
+    std::vector<int> m_robot_at;             // robot index per cell, -1 for none
+    std::array<std::array<char, 3>, 256> m_cell_text;
+    std::string m_frame;
+
+    // minimap obstacle summary, one char per block
+    int m_terrain_rows, m_terrain_cols, m_block_rows, m_block_cols;
+    std::vector<char> m_terrain;
+    std::vector<char> m_map;
+};
+
+#endif
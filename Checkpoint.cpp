@@ -0,0 +1,388 @@
+#include "Checkpoint.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const char checkpoint_magic[4] = {'R', 'W', 'C', 'P'};
+static const uint32_t checkpoint_version = 2; // 2: the robots' rand()
+static const char batch_magic[4] = {'R', 'W', 'B', 'C'};
+static const uint32_t batch_version = 1;
+
+static void put_u64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+static void put_string(std::string& out, const std::string& text)
+{
+    put_u64(out, text.size());
+    out += text;
+}
+
+// reads the fields back in order. any read past the end sets m_ok to false and
+// returns zeros, so load_checkpoint() only has to check once at the end.
+class CheckpointReader
+{
+public:
+
+    explicit CheckpointReader(const std::string& data) : m_data(data), m_pos(0), m_ok(true) {}
+
+    uint64_t u64()
+    {
+        if (m_pos + 8 > m_data.size())
+        {
+            m_ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(m_data[m_pos + i])) << (8 * i);
+        }
+        m_pos += 8;
+        return value;
+    }
+
+    std::string string()
+    {
+        uint64_t size = u64();
+        if (!m_ok || size > m_data.size() - m_pos)
+        {
+            m_ok = false;
+            return "";
+        }
+        std::string text = m_data.substr(m_pos, size);
+        m_pos += size;
+        return text;
+    }
+
+    // a count of things at least min_bytes each, checked against what is left
+    std::size_t count(std::size_t min_bytes)
+    {
+        uint64_t n = u64();
+        if (!m_ok || n > (m_data.size() - m_pos) / min_bytes)
+        {
+            m_ok = false;
+            return 0;
+        }
+        return static_cast<std::size_t>(n);
+    }
+
+    bool ok() const { return m_ok; }
+    bool at_end() const { return m_pos == m_data.size(); }
+
+private:
+    const std::string& m_data;
+    std::size_t m_pos;
+    bool m_ok;
+};
+
+// written to <path>.tmp and renamed over <path>
+static bool write_file(const std::string& path, const std::string& out)
+{
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), static_cast<std::streamsize>(out.size())) || !file.flush())
+        {
+            std::cerr << "Failed to write checkpoint: " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        std::cerr << "Failed to write checkpoint: " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool save_checkpoint(const std::string& path, const Checkpoint& checkpoint)
+{
+    const ArenaSnapshot& snapshot = checkpoint.snapshot;
+    if (!snapshot.board)
+    {
+        return false;
+    }
+    const PackedBoard& board = *snapshot.board;
+
+    std::string out;
+    out.reserve(128 + board.words.size() * 8 + board.other.size() * 16 + snapshot.bytes());
+    out.append(checkpoint_magic, sizeof(checkpoint_magic));
+    put_u64(out, checkpoint_version);
+    put_u64(out, static_cast<uint64_t>(snapshot.round));
+    put_u64(out, static_cast<uint64_t>(checkpoint.max_rounds));
+    put_u64(out, snapshot.seed);
+    put_u64(out, snapshot.rng_state);
+    put_u64(out, snapshot.rng_increment);
+    put_string(out, snapshot.robot_rng.state());
+
+    put_u64(out, static_cast<uint64_t>(board.rows));
+    put_u64(out, static_cast<uint64_t>(board.cols));
+    put_u64(out, board.words.size());
+    for (uint64_t word : board.words)
+    {
+        put_u64(out, word);
+    }
+    put_u64(out, board.other.size());
+    for (const auto& [cell, value] : board.other)
+    {
+        put_u64(out, cell);
+        put_u64(out, static_cast<unsigned char>(value));
+    }
+
+    put_u64(out, snapshot.robots.size());
+    for (std::size_t i = 0; i < snapshot.robots.size(); ++i)
+    {
+        put_string(out, i < checkpoint.robot_names.size() ? checkpoint.robot_names[i] : "");
+        put_u64(out, snapshot.robots[i]);
+        put_string(out, i < snapshot.robot_data.size() ? snapshot.robot_data[i] : "");
+    }
+
+    return write_file(path, out);
+}
+
+bool load_checkpoint(const std::string& path, Checkpoint& checkpoint)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open checkpoint: " << path << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(checkpoint_magic) || std::memcmp(data.data(), checkpoint_magic, sizeof(checkpoint_magic)) != 0)
+    {
+        std::cerr << path << " is not a RobotWarz checkpoint" << std::endl;
+        return false;
+    }
+    std::string body = data.substr(sizeof(checkpoint_magic));
+    CheckpointReader in(body);
+
+    uint64_t version = in.u64();
+    if (version != checkpoint_version)
+    {
+        std::cerr << path << ": checkpoint version " << version << ", expected " << checkpoint_version << std::endl;
+        return false;
+    }
+
+    Checkpoint loaded;
+    ArenaSnapshot& snapshot = loaded.snapshot;
+    snapshot.round = static_cast<int>(in.u64());
+    loaded.max_rounds = static_cast<int>(in.u64());
+    snapshot.seed = in.u64();
+    snapshot.rng_state = in.u64();
+    snapshot.rng_increment = in.u64();
+    bool rng_ok = snapshot.robot_rng.restore(in.string());
+
+    auto board = std::make_shared<PackedBoard>();
+    board->rows = static_cast<int>(in.u64());
+    board->cols = static_cast<int>(in.u64());
+    board->words.resize(in.count(8));
+    for (uint64_t& word : board->words)
+    {
+        word = in.u64();
+    }
+    board->other.resize(in.count(16));
+    for (auto& [cell, value] : board->other)
+    {
+        cell = static_cast<uint32_t>(in.u64());
+        value = static_cast<char>(in.u64());
+    }
+
+    std::size_t robots = in.count(24);
+    for (std::size_t i = 0; i < robots && in.ok(); ++i)
+    {
+        loaded.robot_names.push_back(in.string());
+        snapshot.robots.push_back(in.u64());
+        snapshot.robot_data.push_back(in.string());
+    }
+
+    // the board has to hold exactly rows x cols cells, or unpack() reads past it
+    std::size_t cells = static_cast<std::size_t>(board->rows) * static_cast<std::size_t>(board->cols);
+    bool board_ok = board->rows > 0 && board->cols > 0 && board->words.size() == (cells + 15) / 16;
+    for (const auto& other : board->other)
+    {
+        board_ok = board_ok && other.first < cells;
+    }
+
+    if (!in.ok() || !in.at_end() || !board_ok || !rng_ok)
+    {
+        std::cerr << path << ": checkpoint is damaged" << std::endl;
+        return false;
+    }
+
+    snapshot.board = board;
+    checkpoint = std::move(loaded);
+    return true;
+}
+
+//---------------------------------------------------------------- batches
+
+bool save_batch_checkpoint(const std::string& path, const BatchCheckpoint& checkpoint)
+{
+    std::string out(batch_magic, sizeof(batch_magic));
+    put_u64(out, batch_version);
+    put_string(out, checkpoint.config_path);
+    put_u64(out, checkpoint.games);
+    put_u64(out, checkpoint.base_seed);
+    put_u64(out, checkpoint.done);
+    put_u64(out, checkpoint.game_rounds);
+    put_u64(out, checkpoint.max_rounds);
+    put_u64(out, checkpoint.draws);
+    put_u64(out, checkpoint.robots.size());
+    for (std::size_t i = 0; i < checkpoint.robots.size(); ++i)
+    {
+        put_string(out, checkpoint.robots[i]);
+        put_u64(out, i < checkpoint.wins.size() ? checkpoint.wins[i] : 0);
+    }
+    return write_file(path, out);
+}
+
+bool load_batch_checkpoint(const std::string& path, BatchCheckpoint& checkpoint)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open checkpoint: " << path << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(batch_magic) || std::memcmp(data.data(), batch_magic, sizeof(batch_magic)) != 0)
+    {
+        std::cerr << path << " is not a RobotWarz batch checkpoint" << std::endl;
+        return false;
+    }
+    std::string body = data.substr(sizeof(batch_magic));
+    CheckpointReader in(body);
+
+    uint64_t version = in.u64();
+    if (version != batch_version)
+    {
+        std::cerr << path << ": batch checkpoint version " << version << ", expected " << batch_version << std::endl;
+        return false;
+    }
+
+    BatchCheckpoint loaded;
+    loaded.config_path = in.string();
+    loaded.games = in.u64();
+    loaded.base_seed = in.u64();
+    loaded.done = in.u64();
+    loaded.game_rounds = in.u64();
+    loaded.max_rounds = in.u64();
+    loaded.draws = in.u64();
+    std::size_t robots = in.count(16);
+    for (std::size_t i = 0; i < robots && in.ok(); ++i)
+    {
+        loaded.robots.push_back(in.string());
+        loaded.wins.push_back(in.u64());
+    }
+
+    if (!in.ok() || !in.at_end() || loaded.done > loaded.games)
+    {
+        std::cerr << path << ": checkpoint is damaged" << std::endl;
+        return false;
+    }
+    checkpoint = std::move(loaded);
+    return true;
+}
+
+bool is_batch_checkpoint(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(batch_magic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, batch_magic, sizeof(magic)) == 0;
+}
+
+//---------------------------------------------------------------- writer
+
+CheckpointWriter::CheckpointWriter(const std::string& path)
+    : m_path(path), m_writing(false), m_stopping(false), m_written(0), m_failed(0), m_dropped(0)
+{
+    m_thread = std::thread(&CheckpointWriter::writer_loop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_ready.notify_one();
+    m_thread.join();
+}
+
+void CheckpointWriter::submit(Checkpoint checkpoint)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending)
+        {
+            ++m_dropped;
+        }
+        m_pending = std::move(checkpoint);
+    }
+    m_work_ready.notify_one();
+}
+
+void CheckpointWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_pending && !m_writing; });
+}
+
+int CheckpointWriter::written() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+int CheckpointWriter::failed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+int CheckpointWriter::dropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+void CheckpointWriter::writer_loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_work_ready.wait(lock, [this] { return m_pending || m_stopping; });
+        if (!m_pending)
+        {
+            break; // stopping, and nothing left to write
+        }
+
+        Checkpoint checkpoint = std::move(*m_pending);
+        m_pending.reset();
+        m_writing = true;
+
+        lock.unlock();
+        bool ok = save_checkpoint(m_path, checkpoint);
+        lock.lock();
+
+        m_writing = false;
+        if (ok)
+            ++m_written;
+        else
+            ++m_failed;
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "Snapshot.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Checkpoints of a long game on disk, so one that is killed (a deploy, the OOM
+// killer) can carry on with RobotWarz --resume <file> instead of starting over.
+//
+// A checkpoint is an ArenaSnapshot plus what is needed to pick the robots out
+// again: their names, in turn order. The robot code itself is loaded from
+// robots/ as usual, and robots that implement SerializableRobot get their own
+// memory back too.
+//
+// File layout (little endian):
+//
+//     "RWCP", version, round, max rounds, seed, rng state, rng increment,
+//               the robots' rand() (RobotRandom::state())
+//     board     rows, cols, packed words, then the (index, char) cells that
+//               aren't . M P F R X
+//     robots    per robot: name, packed engine state, SerializableRobot data
+
+struct Checkpoint
+{
+    ArenaSnapshot snapshot;
+    int max_rounds = 0;
+    std::vector<std::string> robot_names;
+};
+
+// written to <path>.tmp and renamed over <path>, so a crash mid-write leaves
+// the previous checkpoint in place
+bool save_checkpoint(const std::string& path, const Checkpoint& checkpoint);
+bool load_checkpoint(const std::string& path, Checkpoint& checkpoint);
+
+// How far a batch (RobotWarz --games) has got. Games finish out of order on
+// the workers, so this is the run of games from 0 that are all done, and what
+// they added up to; RobotWarz --resume <file> plays the rest.
+//
+//     "RWBC", version, config path, games, seed, games done, rounds, games at
+//     MaxRounds, draws, robots (name, wins) per robot
+struct BatchCheckpoint
+{
+    std::string config_path;
+    uint64_t games = 0;       // in the whole batch
+    uint64_t base_seed = 0;   // game n plays with base_seed + n
+    uint64_t done = 0;        // games 0 to done - 1
+    uint64_t game_rounds = 0;
+    uint64_t max_rounds = 0;  // games that stopped at MaxRounds
+    uint64_t draws = 0;
+    std::vector<std::string> robots;
+    std::vector<uint64_t> wins; // per robot
+};
+
+bool save_batch_checkpoint(const std::string& path, const BatchCheckpoint& checkpoint);
+bool load_batch_checkpoint(const std::string& path, BatchCheckpoint& checkpoint);
+
+// a batch's checkpoint rather than a game's
+bool is_batch_checkpoint(const std::string& path);
+
+// Writes checkpoints on a background thread. submit() only moves the checkpoint
+// across (the packed board is shared, not copied), so the simulation thread
+// never waits on the disk. If the disk is slower than the game, a checkpoint
+// still waiting to be written is replaced by the newer one.
+class CheckpointWriter
+{
+public:
+
+    explicit CheckpointWriter(const std::string& path);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void submit(Checkpoint checkpoint);
+
+    // wait until everything submitted so far is on disk
+    void flush();
+
+    int written() const;
+    int failed() const;
+    int dropped() const;
+
+private:
+
+    void writer_loop();
+
+    std::string m_path;
+    std::optional<Checkpoint> m_pending;
+    bool m_writing;
+    bool m_stopping;
+    int m_written;
+    int m_failed;
+    int m_dropped;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work_ready;
+    std::condition_variable m_idle;
+    std::thread m_thread;
+};
+
+#endif
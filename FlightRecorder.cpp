@@ -0,0 +1,281 @@
+#include "FlightRecorder.h"
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+
+namespace
+{
+
+thread_local FlightRecorder* t_recorder = nullptr;
+thread_local std::unique_ptr<char[]> t_alt_stack;
+const std::size_t alt_stack_size = 64 * 1024;
+
+const int crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+const char* signal_name(int signal)
+{
+    switch (signal)
+    {
+        case SIGSEGV: return "SIGSEGV";
+        case SIGBUS:  return "SIGBUS";
+        case SIGFPE:  return "SIGFPE";
+        case SIGILL:  return "SIGILL";
+        case SIGABRT: return "SIGABRT";
+        default:      return "signal";
+    }
+}
+
+// text to a file descriptor without stdio, snprintf or allocating, so it is
+// safe in a signal handler
+class SafeWriter
+{
+public:
+
+    explicit SafeWriter(int fd) : m_fd(fd), m_length(0) {}
+    ~SafeWriter() { flush(); }
+
+    SafeWriter& operator<<(const char* text)
+    {
+        while (*text)
+        {
+            if (m_length == sizeof(m_buffer))
+                flush();
+            m_buffer[m_length++] = *text++;
+        }
+        return *this;
+    }
+
+    SafeWriter& operator<<(char c)
+    {
+        char text[2] = {c, 0};
+        return *this << text;
+    }
+
+    SafeWriter& operator<<(uint64_t value)
+    {
+        char text[24];
+        char* at = text + sizeof(text);
+        *--at = 0;
+        do
+        {
+            *--at = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        return *this << static_cast<const char*>(at);
+    }
+
+    SafeWriter& operator<<(int64_t value)
+    {
+        if (value < 0)
+        {
+            *this << '-';
+            return *this << (0 - static_cast<uint64_t>(value));
+        }
+        return *this << static_cast<uint64_t>(value);
+    }
+
+    SafeWriter& operator<<(int value) { return *this << static_cast<int64_t>(value); }
+
+    void flush()
+    {
+        std::size_t written = 0;
+        while (written < m_length)
+        {
+            ssize_t n = ::write(m_fd, m_buffer + written, m_length - written);
+            if (n <= 0)
+                break;
+            written += static_cast<std::size_t>(n);
+        }
+        m_length = 0;
+    }
+
+private:
+
+    int m_fd;
+    char m_buffer[512];
+    std::size_t m_length;
+};
+
+void crash_handler(int signal)
+{
+    const FlightRecorder* recorder = t_recorder;
+    if (recorder)
+    {
+        recorder->dump(-1, signal);
+    }
+    // SA_RESETHAND put the default action back: core dump and all
+    std::raise(signal);
+}
+
+void install_crash_handler()
+{
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = crash_handler;
+        action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+        for (int signal : crash_signals)
+        {
+            sigaction(signal, &action, nullptr);
+        }
+    });
+
+    // every thread that plays games needs its own stack to crash on
+    if (!t_alt_stack)
+    {
+        t_alt_stack = std::make_unique<char[]>(alt_stack_size);
+        stack_t stack;
+        stack.ss_sp = t_alt_stack.get();
+        stack.ss_size = alt_stack_size;
+        stack.ss_flags = 0;
+        sigaltstack(&stack, nullptr);
+    }
+}
+
+}
+
+FlightRecorder::FlightRecorder()
+{
+    m_next = 0;
+    m_round = 0;
+    m_robot = 0;
+    m_call = -1;
+    m_board = nullptr;
+    m_seed = 0;
+    m_max_rounds = 0;
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    end_game();
+}
+
+void FlightRecorder::begin_game(const std::string& crash_path, uint64_t seed, int max_rounds,
+                                const std::vector<std::string>& robot_names,
+                                const std::vector<std::vector<char>>* board)
+{
+    end_game();
+    if (crash_path.empty())
+    {
+        return;
+    }
+
+    m_events.assign(capacity, FlightEvent{});
+    m_next = 0;
+    m_round = 0;
+    m_robot = 0;
+    m_call = -1;
+    m_crash_path.assign(crash_path.begin(), crash_path.end());
+    m_crash_path.push_back(0);
+    m_names.clear();
+    for (const std::string& name : robot_names)
+    {
+        m_names.emplace_back(name.begin(), name.end());
+        m_names.back().push_back(0);
+    }
+    m_board = board;
+    m_seed = seed;
+    m_max_rounds = max_rounds;
+
+    install_crash_handler();
+    t_recorder = this;
+}
+
+void FlightRecorder::end_game()
+{
+    if (t_recorder == this)
+    {
+        t_recorder = nullptr;
+    }
+    m_events.clear();
+}
+
+void FlightRecorder::dump(int fd, int signal) const
+{
+    bool crash_file = fd < 0;
+    if (crash_file)
+    {
+        fd = ::open(m_crash_path.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return;
+        }
+    }
+
+    auto name = [this](int robot) -> const char* {
+        return robot >= 0 && robot < static_cast<int>(m_names.size()) ? m_names[robot].data() : "?";
+    };
+
+    {
+        SafeWriter out(fd);
+        int call = m_call;
+        out << "RobotWarz crashed: " << signal_name(signal) << "\n";
+        if (call >= 0)
+            out << "in " << name(m_robot) << "'s " << robot_call_name(static_cast<RobotCall>(call)) << "\n";
+        else
+            out << "in the engine, on " << name(m_robot) << "'s turn\n";
+        out << "round " << m_round << " of " << m_max_rounds << "\n";
+        out << "Seed = " << m_seed << "\n";
+        out << "The same config and robots with this Seed play the game up to here again.\n\n";
+
+        out << "Robots:";
+        for (std::size_t i = 0; i < m_names.size(); ++i)
+            out << " " << static_cast<int>(i) << " " << m_names[i].data();
+        out << "\n\n";
+
+        uint64_t kept = m_next < capacity ? m_next : capacity;
+        out << "Last " << kept << " events, oldest first:\n";
+        for (uint64_t i = m_next - kept; i < m_next; ++i)
+        {
+            const FlightEvent& event = m_events[i & (capacity - 1)];
+            out << "  round " << static_cast<int64_t>(event.round) << "  " << name(event.robot) << "  ";
+            switch (event.kind)
+            {
+                case FlightKind::Call:
+                    out << robot_call_name(static_cast<RobotCall>(event.detail));
+                    break;
+                case FlightKind::Radar:
+                    out << "radar " << static_cast<int>(event.detail) << ": " << event.a << " hits";
+                    if (event.a > 0)
+                        out << ", first " << event.cell << " at (" << (event.b >> 16) << "," << (event.b & 0xffff) << ")";
+                    break;
+                case FlightKind::Shot:
+                    out << "shoots at (" << event.a << "," << event.b << ")";
+                    break;
+                case FlightKind::Move:
+                    out << "moves " << event.a << ", distance " << event.b;
+                    break;
+                case FlightKind::Cell:
+                    out << "cell (" << event.a << "," << event.b << ") is now " << event.cell;
+                    break;
+                case FlightKind::Damage:
+                    out << name(event.detail) << " takes " << event.a << " damage, health " << event.b;
+                    break;
+            }
+            out << "\n";
+        }
+
+        if (m_board)
+        {
+            out << "\nBoard:\n";
+            for (const std::vector<char>& row : *m_board)
+            {
+                for (char cell : row)
+                    out << cell;
+                out << "\n";
+            }
+        }
+    }
+
+    if (crash_file)
+    {
+        ::close(fd);
+        SafeWriter err(STDERR_FILENO);
+        err << "\nRobotWarz crashed (" << signal_name(signal) << "), the last turns are in " << m_crash_path.data() << "\n";
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef __FLIGHTRECORDER_H__
+#define __FLIGHTRECORDER_H__
+
+#include "RobotTiming.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The last few thousand things that happened in a game, for when a robot takes
+// the whole process down. Every call into a robot, what it answered, every
+// board cell that changed and all damage go into a fixed ring of 16 byte
+// events. Writing one is a handful of stores, so it is always on.
+//
+// On SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT the handler writes the ring,
+// the seed, the round, which robot call was running and the board to the crash
+// file, then lets the signal carry on so a core dump still happens. It only
+// uses write() and memory that was set up before the game started, so it is
+// safe in a signal handler, and it runs on its own stack so a robot that
+// recursed itself to death still gets a report.
+
+enum class FlightKind : uint8_t
+{
+    Call,   // a robot is about to be called, detail is the RobotCall
+    Radar,  // detail direction, a hits, b first hit row << 16 | col, cell its type
+    Shot,   // a row, b column
+    Move,   // a direction, b distance
+    Cell,   // a row, b column, cell what it is now
+    Damage  // a damage, b health left
+};
+
+struct FlightEvent
+{
+    uint32_t round;
+    FlightKind kind;
+    uint8_t robot;
+    uint8_t detail;
+    char cell;
+    int32_t a;
+    int32_t b;
+};
+
+class FlightRecorder
+{
+public:
+
+    static const std::size_t capacity = 4096;
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // makes this the recorder the crash handler dumps for this thread, and
+    // installs the handler the first time. an empty path turns it off.
+    void begin_game(const std::string& crash_path, uint64_t seed, int max_rounds,
+                    const std::vector<std::string>& robot_names,
+                    const std::vector<std::vector<char>>* board);
+    void end_game();
+    bool active() const { return !m_events.empty(); }
+
+    void begin_turn(int round, int robot) { m_round = round; m_robot = robot; }
+
+    void record(FlightKind kind, int detail, int a, int b, char cell = 0)
+    {
+        if (m_events.empty())
+            return;
+        m_events[m_next++ & (capacity - 1)] = {static_cast<uint32_t>(m_round), kind, static_cast<uint8_t>(m_robot),
+                                               static_cast<uint8_t>(detail), cell, a, b};
+    }
+
+    // which robot call is running, for the first line of the report
+    void enter_call(RobotCall call) { m_call = static_cast<int>(call); record(FlightKind::Call, m_call, 0, 0); }
+    void leave_call() { m_call = -1; }
+
+    // the report the crash handler writes. fd -1 is the crash file, with a
+    // line on stderr saying so.
+    void dump(int fd, int signal) const;
+
+private:
+
+    std::vector<FlightEvent> m_events;
+    uint64_t m_next;
+    int m_round;
+    int m_robot;
+    volatile int m_call; // RobotCall, -1 outside robot code
+
+    // copied when the game starts, the handler can't allocate
+    std::vector<char> m_crash_path;
+    std::vector<std::vector<char>> m_names;
+    const std::vector<std::vector<char>>* m_board;
+    uint64_t m_seed;
+    int m_max_rounds;
+};
+
+// marks a robot call as running for as long as it is in scope, like CallTimer
+class FlightCall
+{
+public:
+
+    FlightCall(FlightRecorder& recorder, RobotCall call) : m_recorder(recorder) { m_recorder.enter_call(call); }
+    ~FlightCall() { m_recorder.leave_call(); }
+
+    FlightCall(const FlightCall&) = delete;
+    FlightCall& operator=(const FlightCall&) = delete;
+
+private:
+
+    FlightRecorder& m_recorder;
+};
+
+#endif
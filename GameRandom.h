@@ -0,0 +1,53 @@
+#ifndef __GAMERANDOM_H__
+#define __GAMERANDOM_H__
+
+#include <cstdint>
+
+// The arena's own random numbers (a PCG32 generator). Robots are free to call
+// srand()/rand() as much as they like, so the engine can't share std::rand with
+// them and still replay a game from its seed. The whole state is two integers,
+// which makes it cheap to save in snapshots and checkpoints.
+class GameRandom
+{
+public:
+
+    explicit GameRandom(uint64_t seed = 1) { this->seed(seed); }
+
+    void seed(uint64_t seed)
+    {
+        m_state = 0;
+        m_inc = (seed << 1u) | 1u;
+        next();
+        m_state += seed;
+        next();
+    }
+
+    uint32_t next()
+    {
+        uint64_t old = m_state;
+        m_state = old * 6364136223846793005ULL + m_inc;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // 0 .. n-1, the replacement for std::rand() % n
+    int below(int n)
+    {
+        return n > 0 ? static_cast<int>(next() % static_cast<uint32_t>(n)) : 0;
+    }
+
+    uint64_t state() const { return m_state; }
+    uint64_t increment() const { return m_inc; }
+    void restore(uint64_t state, uint64_t increment)
+    {
+        m_state = state;
+        m_inc = increment;
+    }
+
+private:
+    uint64_t m_state;
+    uint64_t m_inc;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "GameStats.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+
+// File layout (little endian, every number 8 bytes):
+//
+//     "RWST", version, rows, cols, games, rounds
+//     weapons   flamethrower, railgun, grenade, hammer: shots, hits, misses,
+//               robots hit, damage
+//     layers    in HeatLayer order, rows * cols counts each
+
+static const char stats_magic[4] = {'R', 'W', 'S', 'T'};
+static const uint64_t stats_version = 1;
+static const char* weapon_names[] = {"flamethrower", "railgun", "grenade", "hammer"};
+
+const char* heat_layer_name(HeatLayer layer)
+{
+    switch (layer)
+    {
+        case HeatLayer::Occupancy:   return "occupancy";
+        case HeatLayer::DamageDealt: return "damage_dealt";
+        case HeatLayer::DamageTaken: return "damage_taken";
+        case HeatLayer::Deaths:      return "deaths";
+        case HeatLayer::FlameHits:   return "flame_hits";
+        case HeatLayer::Radar:       return "radar";
+        default:                     return "?";
+    }
+}
+
+void GameStats::reset(int rows, int cols)
+{
+    m_rows = rows;
+    m_cols = cols;
+    m_games = 0;
+    m_rounds = 0;
+    for (std::vector<uint64_t>& layer : m_layers)
+    {
+        layer.assign(static_cast<std::size_t>(rows) * cols, 0);
+    }
+    m_weapons.fill(WeaponStats{});
+}
+
+bool GameStats::merge(const GameStats& other)
+{
+    if (other.m_rows != m_rows || other.m_cols != m_cols)
+    {
+        return false;
+    }
+    for (int i = 0; i < heat_layer_count; ++i)
+    {
+        std::vector<uint64_t>& layer = m_layers[i];
+        const std::vector<uint64_t>& more = other.m_layers[i];
+        for (std::size_t cell = 0; cell < layer.size(); ++cell)
+        {
+            layer[cell] += more[cell];
+        }
+    }
+    for (std::size_t i = 0; i < m_weapons.size(); ++i)
+    {
+        m_weapons[i].shots += other.m_weapons[i].shots;
+        m_weapons[i].hits += other.m_weapons[i].hits;
+        m_weapons[i].misses += other.m_weapons[i].misses;
+        m_weapons[i].robots_hit += other.m_weapons[i].robots_hit;
+        m_weapons[i].damage += other.m_weapons[i].damage;
+    }
+    m_games += other.m_games;
+    m_rounds += other.m_rounds;
+    return true;
+}
+
+static void put_u64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+static uint64_t get_u64(const std::string& data, std::size_t& pos)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+    }
+    pos += 8;
+    return value;
+}
+
+bool GameStats::save(const std::string& path) const
+{
+    std::string out(stats_magic, sizeof(stats_magic));
+    put_u64(out, stats_version);
+    put_u64(out, static_cast<uint64_t>(m_rows));
+    put_u64(out, static_cast<uint64_t>(m_cols));
+    put_u64(out, m_games);
+    put_u64(out, m_rounds);
+    for (const WeaponStats& weapon : m_weapons)
+    {
+        put_u64(out, weapon.shots);
+        put_u64(out, weapon.hits);
+        put_u64(out, weapon.misses);
+        put_u64(out, weapon.robots_hit);
+        put_u64(out, weapon.damage);
+    }
+    for (const std::vector<uint64_t>& layer : m_layers)
+    {
+        for (uint64_t count : layer)
+        {
+            put_u64(out, count);
+        }
+    }
+
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(out.data(), static_cast<std::streamsize>(out.size())) || !file.flush())
+        {
+            std::cerr << "Failed to write stats: " << temp_path << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        std::cerr << "Failed to write stats: " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool GameStats::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Failed to open stats file: " << path << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const std::size_t header = sizeof(stats_magic) + 5 * 8 + m_weapons.size() * 5 * 8;
+    if (data.size() < header || data.compare(0, sizeof(stats_magic), stats_magic, sizeof(stats_magic)) != 0)
+    {
+        std::cerr << "Not a stats file: " << path << std::endl;
+        return false;
+    }
+    std::size_t pos = sizeof(stats_magic);
+    if (get_u64(data, pos) != stats_version)
+    {
+        std::cerr << "Stats file version not supported: " << path << std::endl;
+        return false;
+    }
+    uint64_t rows = get_u64(data, pos);
+    uint64_t cols = get_u64(data, pos);
+    if (rows > 65535 || cols > 65535 || data.size() != header + rows * cols * heat_layer_count * 8)
+    {
+        std::cerr << "Stats file is damaged: " << path << std::endl;
+        return false;
+    }
+
+    reset(static_cast<int>(rows), static_cast<int>(cols));
+    m_games = get_u64(data, pos);
+    m_rounds = get_u64(data, pos);
+    for (WeaponStats& weapon : m_weapons)
+    {
+        weapon.shots = get_u64(data, pos);
+        weapon.hits = get_u64(data, pos);
+        weapon.misses = get_u64(data, pos);
+        weapon.robots_hit = get_u64(data, pos);
+        weapon.damage = get_u64(data, pos);
+    }
+    for (std::vector<uint64_t>& layer : m_layers)
+    {
+        for (uint64_t& count : layer)
+        {
+            count = get_u64(data, pos);
+        }
+    }
+    return true;
+}
+
+bool GameStats::write_csv(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Failed to write stats: " << path << std::endl;
+        return false;
+    }
+
+    file << "games," << m_games << "\nrounds," << m_rounds << "\n\n";
+    file << "weapon,shots,hits,misses,robots_hit,damage\n";
+    for (std::size_t i = 0; i < m_weapons.size(); ++i)
+    {
+        const WeaponStats& weapon = m_weapons[i];
+        file << weapon_names[i] << "," << weapon.shots << "," << weapon.hits << "," << weapon.misses << ","
+             << weapon.robots_hit << "," << weapon.damage << "\n";
+    }
+
+    for (int i = 0; i < heat_layer_count; ++i)
+    {
+        file << "\n" << heat_layer_name(static_cast<HeatLayer>(i)) << "\n";
+        const std::vector<uint64_t>& layer = m_layers[i];
+        for (int row = 0; row < m_rows; ++row)
+        {
+            for (int col = 0; col < m_cols; ++col)
+            {
+                if (col > 0)
+                    file << ",";
+                file << layer[static_cast<std::size_t>(row) * m_cols + col];
+            }
+            file << "\n";
+        }
+    }
+    return static_cast<bool>(file.flush());
+}
+
+bool merge_stats_file(const std::string& path, const GameStats& stats)
+{
+    // games of a tournament finish on several threads at once
+    static std::mutex file_mutex;
+    std::lock_guard<std::mutex> lock(file_mutex);
+
+    GameStats total;
+    if (!std::filesystem::exists(path))
+    {
+        total = stats;
+    }
+    else if (!total.load(path))
+    {
+        // load() said why. what the file has added up so far is worth more than these games.
+        std::cerr << "Not adding " << stats.games() << " games to " << path << std::endl;
+        return false;
+    }
+    else if (!total.merge(stats))
+    {
+        std::cerr << path << " is for a " << total.rows() << "x" << total.cols() << " board, starting it over for "
+                  << stats.rows() << "x" << stats.cols() << std::endl;
+        total = stats;
+    }
+    if (!total.save(path))
+    {
+        return false;
+    }
+    return total.write_csv(std::filesystem::path(path).replace_extension(".csv").string());
+}
@@ -0,0 +1,106 @@
+#ifndef __GAMESTATS_H__
+#define __GAMESTATS_H__
+
+#include "RobotBase.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Where things happen on the map, for tuning maps and ObstacleDensity without
+// reading logs. Per cell:
+//
+//     occupancy       robot turns spent on the cell
+//     damage_dealt    damage done by shots fired from the cell
+//     damage_taken    damage done to robots on the cell, by shots and flamethrowers
+//     deaths          robots that died on the cell
+//     flame_hits      robots burned by the flamethrower on the cell
+//     radar           times a radar scan looked at the cell
+//
+// and per weapon: shots fired, shots that hit at least one robot, shots that
+// hit nobody, robots hit and damage done.
+//
+// Every layer is one flat array, row after row, and counting is an add to it.
+// Totals from many games add up with merge(), as long as the board size is
+// the same, and go to disk as a binary file (to merge into later) or CSV.
+
+enum class HeatLayer
+{
+    Occupancy,
+    DamageDealt,
+    DamageTaken,
+    Deaths,
+    FlameHits,
+    Radar,
+    Count
+};
+
+const char* heat_layer_name(HeatLayer layer);
+
+static const int heat_layer_count = static_cast<int>(HeatLayer::Count);
+
+struct WeaponStats
+{
+    uint64_t shots = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t robots_hit = 0;
+    uint64_t damage = 0;
+};
+
+class GameStats
+{
+public:
+
+    GameStats() : m_rows(0), m_cols(0), m_games(0), m_rounds(0) {}
+
+    // empty counters for a board this size
+    void reset(int rows, int cols);
+
+    void add(HeatLayer layer, int row, int col, uint64_t amount = 1)
+    {
+        m_layers[static_cast<int>(layer)][static_cast<std::size_t>(row) * m_cols + col] += amount;
+    }
+
+    uint64_t at(HeatLayer layer, int row, int col) const
+    {
+        return m_layers[static_cast<int>(layer)][static_cast<std::size_t>(row) * m_cols + col];
+    }
+
+    WeaponStats& weapon(WeaponType weapon) { return m_weapons[static_cast<int>(weapon)]; }
+    const WeaponStats& weapon(WeaponType weapon) const { return m_weapons[static_cast<int>(weapon)]; }
+
+    void end_game(int rounds) { ++m_games; m_rounds += rounds; }
+
+    // false if the boards are different sizes
+    bool merge(const GameStats& other);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    uint64_t games() const { return m_games; }
+    uint64_t rounds() const { return m_rounds; }
+
+    // binary, see GameStats.cpp. save() goes through <path>.tmp.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // the weapon table, then each layer as a grid of rows of comma separated counts
+    bool write_csv(const std::string& path) const;
+
+private:
+
+    int m_rows;
+    int m_cols;
+    uint64_t m_games;
+    uint64_t m_rounds;
+    std::array<std::vector<uint64_t>, heat_layer_count> m_layers;
+    std::array<WeaponStats, 4> m_weapons;
+};
+
+// load what is in path, add stats and save it again, plus a CSV export next
+// to it. a file for a different board size is started over; one that can't be
+// read is left alone and the result is false. safe to call from several
+// threads.
+bool merge_stats_file(const std::string& path, const GameStats& stats);
+
+#endif
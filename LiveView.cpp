@@ -0,0 +1,288 @@
+#include "LiveView.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+static const int max_ticks_per_second = 1000;
+static const int refresh_rate = 30;          // frames per second drawn at most
+static const int fast_key_check_every = 64;  // rounds between key checks at full speed
+
+static void arm_timer(int fd, long long interval_ns)
+{
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = interval_ns / 1000000000LL;
+    spec.it_interval.tv_nsec = interval_ns % 1000000000LL;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+static void terminal_write(const char* text, std::size_t length)
+{
+    while (::write(STDOUT_FILENO, text, length) < 0 && errno == EINTR)
+    {
+    }
+}
+
+static void drain_timer(int fd)
+{
+    uint64_t expirations;
+    while (::read(fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR)
+    {
+    }
+}
+
+LiveView::LiveView(int ticks_per_second)
+    : m_ticks_per_second(std::clamp(ticks_per_second, 1, max_ticks_per_second)),
+      m_speed(Speed::Paced), m_step(false), m_rounds_since_poll(0),
+      m_raw_terminal(false), m_terminal(STDOUT_FILENO),
+      m_wants_frame(true), m_stopping(false), m_frame_ready(false)
+{
+    // keys are read one at a time without waiting for enter
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &m_saved_termios) == 0)
+    {
+        struct termios raw = m_saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        m_raw_terminal = (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0);
+    }
+
+    m_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    set_timer();
+
+    m_draw_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    arm_timer(m_draw_timer_fd, 1000000000LL / refresh_rate);
+
+    m_status = status_line();
+
+    terminal_write("\x1b[?25l", 6); // hide the cursor
+    m_draw_thread = std::thread(&LiveView::draw_loop, this);
+}
+
+LiveView::~LiveView()
+{
+    if (m_draw_thread.joinable())
+    {
+        finish(std::string());
+    }
+    ::close(m_timer_fd);
+    ::close(m_draw_timer_fd);
+}
+
+void LiveView::set_timer()
+{
+    arm_timer(m_timer_fd, 1000000000LL / m_ticks_per_second);
+}
+
+std::string LiveView::status_line() const
+{
+    std::string status = "speed: ";
+    switch (m_speed)
+    {
+        case Speed::Paced:       status += std::to_string(m_ticks_per_second) + " ticks/s"; break;
+        case Speed::Paused:      status += "paused"; break;
+        case Speed::FastForward: status += "fast forward"; break;
+        case Speed::SkipToEnd:   status += "skipping to the end"; break;
+    }
+    if (m_raw_terminal)
+    {
+        status += "   [space] pause  [s] step  [+/-] speed  [f] fast forward  [e] end";
+    }
+    return status;
+}
+
+bool LiveView::wants_frame() const
+{
+    return m_speed != Speed::SkipToEnd && m_wants_frame.load(std::memory_order_acquire);
+}
+
+void LiveView::publish(const std::string& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_frame_mutex);
+        m_frame = frame;
+        m_frame_ready = true;
+    }
+    m_wants_frame.store(false, std::memory_order_release);
+}
+
+void LiveView::handle_key(char key)
+{
+    Speed before = m_speed;
+    int ticks_before = m_ticks_per_second;
+
+    switch (key)
+    {
+        case ' ':
+            m_speed = (m_speed == Speed::Paused) ? Speed::Paced : Speed::Paused;
+            break;
+        case 's':
+            m_speed = Speed::Paused;
+            m_step = true;
+            break;
+        case '+':
+        case '=':
+            m_ticks_per_second = std::min(m_ticks_per_second * 2, max_ticks_per_second);
+            m_speed = Speed::Paced;
+            break;
+        case '-':
+            m_ticks_per_second = std::max(m_ticks_per_second / 2, 1);
+            m_speed = Speed::Paced;
+            break;
+        case 'f':
+            m_speed = (m_speed == Speed::FastForward) ? Speed::Paced : Speed::FastForward;
+            break;
+        case 'e':
+            m_speed = Speed::SkipToEnd;
+            break;
+        default:
+            return;
+    }
+
+    if (m_ticks_per_second != ticks_before)
+    {
+        set_timer();
+    }
+
+    if (m_speed != before || m_ticks_per_second != ticks_before)
+    {
+        std::lock_guard<std::mutex> lock(m_frame_mutex);
+        m_status = status_line();
+    }
+}
+
+void LiveView::poll_keys(int timeout_ms)
+{
+    if (!m_raw_terminal)
+    {
+        return;
+    }
+
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN))
+    {
+        char keys[16];
+        ssize_t n = ::read(STDIN_FILENO, keys, sizeof(keys));
+        for (ssize_t i = 0; i < n; ++i)
+        {
+            handle_key(keys[i]);
+        }
+    }
+}
+
+void LiveView::wait_for_tick()
+{
+    while (true)
+    {
+        switch (m_speed)
+        {
+            case Speed::SkipToEnd:
+                return;
+
+            case Speed::FastForward:
+                if (++m_rounds_since_poll >= fast_key_check_every)
+                {
+                    m_rounds_since_poll = 0;
+                    poll_keys(0);
+                }
+                return;
+
+            case Speed::Paused:
+                if (m_step)
+                {
+                    m_step = false;
+                    return;
+                }
+                // nothing to do until a key arrives
+                poll_keys(m_raw_terminal ? -1 : 0);
+                break;
+
+            case Speed::Paced:
+            {
+                struct pollfd fds[2] = {
+                    {m_timer_fd, POLLIN, 0},
+                    {STDIN_FILENO, POLLIN, 0}
+                };
+                int count = m_raw_terminal ? 2 : 1;
+                if (poll(fds, count, -1) <= 0)
+                    break;
+
+                if (count == 2 && (fds[1].revents & POLLIN))
+                {
+                    poll_keys(0);
+                }
+                if (fds[0].revents & POLLIN)
+                {
+                    drain_timer(m_timer_fd);
+                    if (m_speed == Speed::Paced)
+                        return;
+                }
+                break;
+            }
+        }
+    }
+}
+
+void LiveView::draw_loop()
+{
+    std::string frame;
+    std::string screen;
+    std::string drawn_status;
+
+    while (!m_stopping.load(std::memory_order_acquire))
+    {
+        struct pollfd pfd = {m_draw_timer_fd, POLLIN, 0};
+        if (poll(&pfd, 1, -1) <= 0)
+            continue;
+        drain_timer(m_draw_timer_fd);
+
+        bool have_frame = false;
+        {
+            std::lock_guard<std::mutex> lock(m_frame_mutex);
+            if (m_frame_ready)
+            {
+                frame.swap(m_frame);
+                m_frame_ready = false;
+                have_frame = true;
+            }
+            screen = m_status;
+        }
+
+        // a key press changes the status line even while no new frames arrive
+        bool status_changed = (screen != drawn_status) && !frame.empty();
+
+        if (have_frame || status_changed)
+        {
+            drawn_status = screen;
+            screen += '\n';
+            screen += frame;
+            m_terminal.draw(screen);
+        }
+        if (have_frame)
+        {
+            m_wants_frame.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void LiveView::finish(const std::string& final_frame)
+{
+    m_stopping.store(true, std::memory_order_release);
+    m_draw_thread.join();
+
+    if (!final_frame.empty())
+    {
+        m_terminal.draw("game over\n" + final_frame);
+    }
+    m_terminal.park_cursor();
+    terminal_write("\x1b[?25h", 6); // show the cursor again
+
+    if (m_raw_terminal)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &m_saved_termios);
+        m_raw_terminal = false;
+    }
+}
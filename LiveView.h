@@ -0,0 +1,79 @@
+#ifndef __LIVEVIEW_H__
+#define __LIVEVIEW_H__
+
+#include "TerminalRenderer.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <termios.h>
+
+// Runs GameMode = live. The simulation thread calls wait_for_tick() once per round,
+// which paces the game to the chosen ticks per second with a timerfd and reads keys
+// without blocking:
+//
+//     space   pause / resume         s   single step while paused
+//     + / -   double / halve speed   f   fast forward (no pacing)
+//     e       skip to the end (stop drawing until the game is over)
+//
+// Frames are drawn by a separate thread with TerminalRenderer at a fixed refresh
+// rate. The simulation only hands over a frame when the drawing thread is ready for
+// one, so at full speed frames are dropped instead of slowing the game down.
+class LiveView
+{
+public:
+
+    explicit LiveView(int ticks_per_second);
+    ~LiveView();
+
+    LiveView(const LiveView&) = delete;
+    LiveView& operator=(const LiveView&) = delete;
+
+    // true when the drawing thread is waiting for a new frame
+    bool wants_frame() const;
+
+    void publish(const std::string& frame);
+
+    // blocks until the next round should run
+    void wait_for_tick();
+
+    // draw the final frame, stop the drawing thread and restore the terminal
+    void finish(const std::string& final_frame);
+
+private:
+
+    enum class Speed
+    {
+        Paced,
+        Paused,
+        FastForward,
+        SkipToEnd
+    };
+
+    void draw_loop();
+    void handle_key(char key);
+    void poll_keys(int timeout_ms);
+    void set_timer();
+    std::string status_line() const;
+
+    int m_ticks_per_second;
+    Speed m_speed;
+    bool m_step;                       // a single step was requested while paused
+    int m_timer_fd;
+    int m_rounds_since_poll;
+
+    bool m_raw_terminal;
+    struct termios m_saved_termios;
+
+    TerminalRenderer m_terminal;
+    std::thread m_draw_thread;
+    int m_draw_timer_fd;
+    std::atomic<bool> m_wants_frame;
+    std::atomic<bool> m_stopping;
+    std::mutex m_frame_mutex;
+    std::string m_frame;               // latest frame handed over by the simulation
+    std::string m_status;              // status line, guarded by m_frame_mutex
+    bool m_frame_ready;
+};
+
+#endif
@@ -0,0 +1,371 @@
+#include "Lockstep.h"
+#include <algorithm>
+#include <sstream>
+
+Lockstep::Lockstep(int rows, int cols, uint64_t seed)
+    : m_arena(rows, cols), m_reference(rows, cols, seed), m_rounds(0), m_stalemate_round(-1)
+{
+    m_arena.set_seed(seed);
+}
+
+void Lockstep::set_board(const std::vector<std::vector<char>>& board)
+{
+    m_arena.m_board = board;
+    m_reference.m_board = board;
+    m_arena.m_flamethrowers.clear();
+    m_reference.m_flamethrowers.clear();
+    for (std::size_t row = 0; row < board.size(); ++row)
+    {
+        for (std::size_t col = 0; col < board[row].size(); ++col)
+        {
+            if (board[row][col] == 'F')
+            {
+                m_arena.m_flamethrowers.insert({static_cast<int>(row), static_cast<int>(col)});
+                m_reference.m_flamethrowers.insert({static_cast<int>(row), static_cast<int>(col)});
+            }
+        }
+    }
+}
+
+void Lockstep::add_robot(const std::string& name, WeaponType weapon, int move, int armor, int row, int col)
+{
+    ReplayRobotInfo info{name, '?', weapon};
+    RobotState state;
+    state.health = 100;
+    state.move = move;
+    state.armor = armor;
+    state.row = row;
+    state.col = col;
+
+    // one body per engine, each engine moves and damages its own
+    m_arena_robots.push_back(std::make_unique<ReplayRobot>(info, state));
+    m_reference_robots.push_back(std::make_unique<ReplayRobot>(info, state));
+    m_arena_robots.back()->set_boundaries(m_arena.m_size_row, m_arena.m_size_col);
+    m_reference_robots.back()->set_boundaries(m_reference.m_size_row, m_reference.m_size_col);
+    m_arena.m_robots.push_back(m_arena_robots.back().get());
+    m_reference.m_robots.push_back(m_reference_robots.back().get());
+
+    m_arena.m_board[row][col] = 'R';
+    m_reference.m_board[row][col] = 'R';
+}
+
+int Lockstep::alive() const
+{
+    int count = 0;
+    for (const auto& robot : m_arena_robots)
+    {
+        if (robot->get_health() > 0)
+            ++count;
+    }
+    return count;
+}
+
+bool Lockstep::play(LockstepBrain& brain, int max_rounds)
+{
+    std::vector<RadarObj> arena_radar, reference_radar;
+
+    // the board and robots were set up directly, start the incremental hash from them
+    m_arena.reset_hash();
+
+    for (m_rounds = 0; m_rounds < max_rounds && alive() > 1; ++m_rounds)
+    {
+        std::string reason;
+        if (m_stalemate_round < 0 && m_rounds % 10 == 0 && prove_stalemate(m_arena.m_board, m_arena.m_robots, m_arena.m_flamethrowers, reason))
+        {
+            m_stalemate_round = m_rounds;
+        }
+
+        for (std::size_t i = 0; i < m_arena_robots.size(); ++i)
+        {
+            ReplayRobot* arena_robot = m_arena_robots[i].get();
+            ReplayRobot* reference_robot = m_reference_robots[i].get();
+            arena_radar.clear();
+            reference_radar.clear();
+
+            // dead robots only get their 'X' put back, as in run_simulation()
+            if (arena_robot->get_health() <= 0 || reference_robot->get_health() <= 0)
+            {
+                int row, col;
+                arena_robot->get_current_location(row, col);
+                if (arena_robot->get_health() <= 0 && m_arena.m_board[row][col] != 'X')
+                    m_arena.set_cell(row, col, 'X');
+                reference_robot->get_current_location(row, col);
+                if (reference_robot->get_health() <= 0 && m_reference.m_board[row][col] != 'X')
+                    m_reference.m_board[row][col] = 'X';
+
+                if (!compare(m_rounds, static_cast<int>(i), nullptr, arena_radar, reference_radar, "", ""))
+                    return false;
+                continue;
+            }
+
+            int radar_direction = brain.radar_direction(static_cast<int>(i));
+            m_arena.get_radar_results(arena_robot, radar_direction, arena_radar);
+            m_reference.get_radar_results(reference_robot, radar_direction, reference_radar);
+
+            ReplayDecision decision = brain.decide(static_cast<int>(i), radar_direction, arena_radar);
+            decision.radar_direction = radar_direction;
+
+            // the stand-ins hand the decision to whichever engine asks
+            int ignored;
+            arena_robot->add_decision(decision);
+            reference_robot->add_decision(decision);
+            arena_robot->get_radar_direction(ignored);
+            reference_robot->get_radar_direction(ignored);
+
+            std::string arena_text, reference_text;
+            if (decision.shoot)
+            {
+                arena_text = m_arena.handle_shot(arena_robot, decision.param1, decision.param2);
+                reference_text = m_reference.handle_shot(reference_robot, decision.param1, decision.param2);
+            }
+            else
+            {
+                arena_text = m_arena.handle_move(arena_robot);
+                reference_text = m_reference.handle_move(reference_robot);
+            }
+
+            if (!compare(m_rounds, static_cast<int>(i), &decision, arena_radar, reference_radar,
+                         arena_text, reference_text))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void dump_board(std::ostream& out, const std::vector<std::vector<char>>& board)
+{
+    for (const auto& row : board)
+    {
+        out << "    ";
+        for (char cell : row)
+            out << cell;
+        out << "\n";
+    }
+}
+
+static void dump_radar(std::ostream& out, const std::vector<RadarObj>& radar)
+{
+    out << "    " << radar.size() << " objects:";
+    for (const RadarObj& obj : radar)
+        out << " " << obj.m_type << "(" << obj.m_row << "," << obj.m_col << ")";
+    out << "\n";
+}
+
+static bool same_radar(const std::vector<RadarObj>& a, const std::vector<RadarObj>& b)
+{
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const RadarObj& x, const RadarObj& y) {
+               return x.m_type == y.m_type && x.m_row == y.m_row && x.m_col == y.m_col;
+           });
+}
+
+bool Lockstep::compare(int round, int robot, const ReplayDecision* decision,
+                       const std::vector<RadarObj>& arena_radar, const std::vector<RadarObj>& reference_radar,
+                       const std::string& arena_text, const std::string& reference_text)
+{
+    std::string what;
+    if (!same_radar(arena_radar, reference_radar))
+        what = "radar results differ";
+    else if (m_arena.m_board != m_reference.m_board)
+        what = "boards differ";
+    else if (arena_text != reference_text)
+        what = "turn text differs";
+    else if (m_arena.m_zobrist != zobrist_hash(m_arena.m_board, m_arena.m_robots))
+        what = "the arena's incremental hash is out of step";
+
+    else
+    {
+        for (std::size_t i = 0; i < m_arena_robots.size() && what.empty(); ++i)
+        {
+            if (!(read_robot_state(m_arena_robots[i].get()) == read_robot_state(m_reference_robots[i].get())))
+                what = m_arena_robots[i]->m_name + " differs";
+        }
+    }
+
+    // hurting yourself (a hammer aimed at your own cell) doesn't count
+    m_health.resize(m_arena_robots.size(), 100);
+    for (std::size_t i = 0; i < m_arena_robots.size(); ++i)
+    {
+        int health = m_arena_robots[i]->get_health();
+        if (what.empty() && m_stalemate_round >= 0 && static_cast<int>(i) != robot && health < m_health[i])
+            what = m_arena_robots[i]->m_name + " took damage after a stalemate was proven in round " +
+                   std::to_string(m_stalemate_round);
+        m_health[i] = health;
+    }
+
+    if (what.empty())
+        return true;
+
+    std::ostringstream out;
+    out << "Divergence in round " << round << ", turn of " << m_arena_robots[robot]->m_name << ": " << what << "\n";
+    if (decision)
+    {
+        out << "  decision: radar " << decision->radar_direction << ", "
+            << (decision->shoot ? "shoot at " : "move ") << decision->param1 << "," << decision->param2 << "\n";
+    }
+    else
+    {
+        out << "  decision: none, the robot is dead\n";
+    }
+
+    out << "  robots (arena | reference):\n";
+    for (std::size_t i = 0; i < m_arena_robots.size(); ++i)
+    {
+        RobotState a = read_robot_state(m_arena_robots[i].get());
+        RobotState b = read_robot_state(m_reference_robots[i].get());
+        out << "    " << m_arena_robots[i]->m_name << ": H " << a.health << " A " << a.armor << " M " << a.move
+            << " G " << a.grenades << " at (" << a.row << "," << a.col << ")  |  H " << b.health << " A "
+            << b.armor << " M " << b.move << " G " << b.grenades << " at (" << b.row << "," << b.col << ")"
+            << (a == b ? "" : "  <--") << "\n";
+    }
+
+    out << "  arena radar:\n";
+    dump_radar(out, arena_radar);
+    out << "  reference radar:\n";
+    dump_radar(out, reference_radar);
+    out << "  arena text: " << arena_text << "\n";
+    out << "  reference text: " << reference_text << "\n";
+    out << "  arena board:\n";
+    dump_board(out, m_arena.m_board);
+    out << "  reference board:\n";
+    dump_board(out, m_reference.m_board);
+
+    m_report = out.str();
+    return false;
+}
+
+//---------------------------------------------------------------- fuzzing
+
+// A mix of behaviours, all driven by one random stream: some robots act at
+// random (including directions and distances that are out of range), some hunt
+// whatever their radar finds and some sit still and swing at their neighbours.
+class FuzzBrain : public LockstepBrain
+{
+public:
+
+    enum Behaviour { Random, Hunter, Camper, Behaviours };
+
+    FuzzBrain(uint64_t seed, int robots, int rows, int cols)
+        : m_rng(seed), m_rows(rows), m_cols(cols)
+    {
+        for (int i = 0; i < robots; ++i)
+            m_behaviour.push_back(static_cast<Behaviour>(m_rng.below(Behaviours)));
+    }
+
+    int radar_direction(int robot) override
+    {
+        switch (m_behaviour[robot])
+        {
+            case Camper: return 0;
+            case Hunter: return m_rng.below(9);
+            default:     return m_rng.below(11) - 1;  // -1 and 9 are out of range
+        }
+    }
+
+    ReplayDecision decide(int robot, int radar_direction, const std::vector<RadarObj>& radar_results) override
+    {
+        (void)radar_direction;
+        ReplayDecision decision;
+
+        const RadarObj* target = nullptr;
+        for (const RadarObj& obj : radar_results)
+        {
+            if (obj.m_type == 'R')
+            {
+                target = &obj;
+                break;
+            }
+        }
+
+        switch (m_behaviour[robot])
+        {
+            case Hunter:
+            case Camper:
+                if (target)
+                {
+                    decision.shoot = true;
+                    decision.param1 = target->m_row;
+                    decision.param2 = target->m_col;
+                }
+                else if (m_behaviour[robot] == Hunter)
+                {
+                    decision.param1 = 1 + m_rng.below(8);
+                    decision.param2 = 1 + m_rng.below(5);
+                }
+                break;
+
+            default:
+                decision.shoot = m_rng.below(2) == 0;
+                if (decision.shoot)
+                {
+                    decision.param1 = m_rng.below(m_rows + 6) - 3;
+                    decision.param2 = m_rng.below(m_cols + 6) - 3;
+                }
+                else
+                {
+                    decision.param1 = m_rng.below(11) - 1;
+                    decision.param2 = m_rng.below(9) - 1;
+                }
+                break;
+        }
+        return decision;
+    }
+
+private:
+    GameRandom m_rng;
+    int m_rows, m_cols;
+    std::vector<Behaviour> m_behaviour;
+};
+
+bool run_lockstep_fuzz_game(uint64_t seed, int max_rounds, std::string& report)
+{
+    GameRandom rng(seed);
+    int rows = 3 + rng.below(38);
+    int cols = 3 + rng.below(38);
+
+    // anything from an empty board to one that is a third obstacles
+    std::vector<std::vector<char>> board(rows, std::vector<char>(cols, '.'));
+    int percent = rng.below(34);
+    static const char obstacles[] = {'M', 'P', 'F'};
+    for (auto& row : board)
+    {
+        for (char& cell : row)
+        {
+            if (rng.below(100) < percent)
+                cell = obstacles[rng.below(3)];
+        }
+    }
+
+    Lockstep game(rows, cols, seed);
+    game.set_board(board);
+
+    int robots = 2 + rng.below(7);
+    static const WeaponType weapons[] = {flamethrower, railgun, grenade, hammer};
+    int placed = 0;
+    for (int i = 0; i < robots; ++i)
+    {
+        // a few tries at an empty cell, crowded boards just get fewer robots
+        for (int attempt = 0; attempt < 20; ++attempt)
+        {
+            int row = rng.below(rows);
+            int col = rng.below(cols);
+            if (board[row][col] != '.')
+                continue;
+            board[row][col] = 'R';
+            game.add_robot("Fuzz" + std::to_string(i), weapons[rng.below(4)], rng.below(8), rng.below(8), row, col);
+            ++placed;
+            break;
+        }
+    }
+
+    FuzzBrain brain(seed ^ 0x9e3779b97f4a7c15ULL, placed, rows, cols);
+    if (game.play(brain, max_rounds))
+    {
+        return true;
+    }
+
+    std::ostringstream out;
+    out << "Seed " << seed << ": " << rows << "x" << cols << " arena, " << placed << " robots\n" << game.report();
+    report = out.str();
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef __LOCKSTEP_H__
+#define __LOCKSTEP_H__
+
+#include "Arena.h"
+#include "ReferenceArena.h"
+#include "Replay.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Decides for every robot in a lockstep game. One brain feeds both engines, so
+// they see exactly the same decisions.
+class LockstepBrain
+{
+public:
+    virtual ~LockstepBrain() {}
+    virtual int radar_direction(int robot) = 0;
+    virtual ReplayDecision decide(int robot, int radar_direction, const std::vector<RadarObj>& radar_results) = 0;
+};
+
+// Runs Arena and ReferenceArena side by side on the same board, seed and
+// decisions, and compares radar results, the board, every robot and the turn
+// text after each turn. It also checks Arena's Zobrist hash against one worked
+// out from scratch, and that no robot damages another once prove_stalemate()
+// has said none can. The first difference stops the game and leaves both
+// boards and both radar results in report().
+class Lockstep
+{
+    friend class TestArena;
+
+public:
+
+    Lockstep(int rows, int cols, uint64_t seed);
+
+    // obstacles only. flamethrowers are taken from the 'F' cells.
+    void set_board(const std::vector<std::vector<char>>& board);
+    void add_robot(const std::string& name, WeaponType weapon, int move, int armor, int row, int col);
+
+    // false at the first divergence
+    bool play(LockstepBrain& brain, int max_rounds);
+
+    int rounds_played() const { return m_rounds; }
+    const std::string& report() const { return m_report; }
+
+private:
+
+    bool compare(int round, int robot, const ReplayDecision* decision,
+                 const std::vector<RadarObj>& arena_radar, const std::vector<RadarObj>& reference_radar,
+                 const std::string& arena_text, const std::string& reference_text);
+    int alive() const;
+
+    Arena m_arena;
+    ReferenceArena m_reference;
+    std::vector<std::unique_ptr<ReplayRobot>> m_arena_robots;
+    std::vector<std::unique_ptr<ReplayRobot>> m_reference_robots;
+    int m_rounds;
+    int m_stalemate_round;  // when prove_stalemate() first said yes, -1 before
+    std::vector<int> m_health; // after the last turn, to see who a turn damaged
+    std::string m_report;
+};
+
+// One randomised game: board size, obstacles, robots and their behaviour all
+// come from the seed. false and a report if the engines disagree.
+bool run_lockstep_fuzz_game(uint64_t seed, int max_rounds, std::string& report);
+
+#endif
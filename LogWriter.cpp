@@ -0,0 +1,228 @@
+#include "LogWriter.h"
+#include "Tracer.h"
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+LogWriter::LogWriter(const std::string& log_path, bool to_console,
+                     std::size_t buffer_size, std::size_t max_buffers)
+    : m_console_fd(to_console ? STDOUT_FILENO : -1), m_file_fd(-1),
+      m_buffer_size(buffer_size), m_max_buffers(max_buffers < 2 ? 2 : max_buffers),
+      m_allocated(1), m_stalls(0), m_in_flight(0), m_stopping(false)
+{
+    if (!log_path.empty())
+    {
+        m_file_fd = ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (m_file_fd < 0)
+        {
+            std::cerr << "Failed to open log file: " << log_path << std::endl;
+        }
+    }
+
+    // anything already sitting in std::cout has to land before our raw writes
+    std::cout.flush();
+
+    m_current.text.reserve(m_buffer_size);
+    m_thread = std::thread(&LogWriter::writer_loop, this);
+}
+
+LogWriter::~LogWriter()
+{
+    submit();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_work_ready.notify_one();
+    m_thread.join();
+
+    if (m_file_fd >= 0)
+    {
+        ::close(m_file_fd);
+    }
+}
+
+void LogWriter::write(std::string_view text, Sink sink)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    int sinks = sink;
+    if (m_console_fd < 0)
+        sinks &= ~Console;
+    if (m_file_fd < 0)
+        sinks &= ~File;
+    if (sinks == 0)
+        return;
+
+    if (m_current.text.size() + text.size() > m_buffer_size && !m_current.text.empty())
+    {
+        submit();
+    }
+
+    // grow the last span when the sinks match, so a buffer is usually one span
+    std::size_t offset = m_current.text.size();
+    m_current.text.append(text.data(), text.size());
+
+    if (!m_current.spans.empty() && m_current.spans.back().sinks == sinks)
+    {
+        m_current.spans.back().length += text.size();
+    }
+    else
+    {
+        m_current.spans.push_back({offset, text.size(), sinks});
+    }
+}
+
+LogWriter::Buffer LogWriter::take_free_buffer(std::unique_lock<std::mutex>& lock)
+{
+    while (m_free.empty() && m_allocated >= m_max_buffers)
+    {
+        // every buffer is queued or being written: this is the backpressure
+        ++m_stalls;
+        m_buffer_ready.wait(lock);
+    }
+
+    Buffer buffer;
+    if (!m_free.empty())
+    {
+        buffer = std::move(m_free.back());
+        m_free.pop_back();
+    }
+    else
+    {
+        ++m_allocated;
+        buffer.text.reserve(m_buffer_size);
+    }
+    return buffer;
+}
+
+void LogWriter::submit()
+{
+    if (m_current.text.empty())
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(m_current));
+        m_current = take_free_buffer(lock);
+    }
+    m_work_ready.notify_one();
+}
+
+void LogWriter::flush()
+{
+    submit();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_buffer_ready.wait(lock, [this] { return m_pending.empty() && m_in_flight == 0; });
+}
+
+void LogWriter::writer_loop()
+{
+    std::vector<Buffer> batch;
+    Tracer::instance().name_thread("log writer");
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_ready.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+
+            if (m_pending.empty() && m_stopping)
+            {
+                return;
+            }
+
+            // take everything that is waiting, one writev per sink covers it all
+            while (!m_pending.empty())
+            {
+                batch.push_back(std::move(m_pending.front()));
+                m_pending.pop_front();
+            }
+            m_in_flight = batch.size();
+        }
+
+        {
+            TRACE_SCOPE("write", "io", static_cast<int64_t>(batch.size()));
+            write_spans(m_console_fd, Console, batch);
+            write_spans(m_file_fd, File, batch);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Buffer& buffer : batch)
+            {
+                buffer.text.clear();
+                buffer.spans.clear();
+                m_free.push_back(std::move(buffer));
+            }
+            m_in_flight = 0;
+        }
+        batch.clear();
+        m_buffer_ready.notify_all();
+    }
+}
+
+void LogWriter::write_spans(int fd, int sink, const std::vector<Buffer>& batch)
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    std::vector<iovec> iov;
+    for (const Buffer& buffer : batch)
+    {
+        for (const Span& span : buffer.spans)
+        {
+            if (!(span.sinks & sink))
+                continue;
+
+            char* start = const_cast<char*>(buffer.text.data()) + span.offset;
+
+            // neighbouring spans for this sink are contiguous in memory: merge them
+            if (!iov.empty() && static_cast<char*>(iov.back().iov_base) + iov.back().iov_len == start)
+                iov.back().iov_len += span.length;
+            else
+                iov.push_back({start, span.length});
+        }
+    }
+
+    std::size_t first = 0;
+    while (first < iov.size())
+    {
+        int count = static_cast<int>(std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        ssize_t written = ::writev(fd, &iov[first], count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return; // nowhere to report a broken log, drop it
+        }
+
+        // skip whatever was fully written and trim a partially written entry
+        std::size_t done = static_cast<std::size_t>(written);
+        while (first < iov.size() && done >= iov[first].iov_len)
+        {
+            done -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < iov.size() && done > 0)
+        {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef __LOGWRITER_H__
+#define __LOGWRITER_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstddef>
+
+// The single log sink for a game. Text is formatted once into a large buffer,
+// and full buffers are handed to a background thread that writev()s them to the
+// console and to the log file. The simulation thread never touches the disk or
+// the terminal directly.
+//
+// Every appended fragment is tagged with the sinks it belongs to, so console-only
+// text (like the live mode clear-screen code) shares the buffer with everything else.
+class LogWriter
+{
+public:
+
+    // which sinks a fragment goes to
+    enum Sink
+    {
+        Console = 1,
+        File = 2,
+        Both = Console | File
+    };
+
+    // log_path may be empty for console only. max_buffers bounds the memory
+    // used: when every buffer is waiting on the writer thread, write() waits.
+    LogWriter(const std::string& log_path, bool to_console = true,
+              std::size_t buffer_size = 1 << 20, std::size_t max_buffers = 8);
+    ~LogWriter();
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    bool is_open() const { return m_file_fd >= 0; }
+
+    void write(std::string_view text, Sink sink = Both);
+
+    // hand the current buffer to the writer thread (does not wait for it)
+    void submit();
+
+    // submit and wait until everything written so far is on disk/terminal
+    void flush();
+
+    // how many times write() had to wait for a free buffer
+    std::size_t stalls() const { return m_stalls; }
+
+private:
+
+    // a contiguous piece of a buffer that goes to a set of sinks
+    struct Span
+    {
+        std::size_t offset;
+        std::size_t length;
+        int sinks;
+    };
+
+    struct Buffer
+    {
+        std::string text;
+        std::vector<Span> spans;
+    };
+
+    void writer_loop();
+    void write_spans(int fd, int sink, const std::vector<Buffer>& batch);
+    Buffer take_free_buffer(std::unique_lock<std::mutex>& lock);
+
+    int m_console_fd;
+    int m_file_fd;
+    std::size_t m_buffer_size;
+    std::size_t m_max_buffers;
+    std::size_t m_allocated;
+    std::size_t m_stalls;
+
+    Buffer m_current;                // only touched by the simulation thread
+    std::deque<Buffer> m_pending;    // full buffers waiting for the writer
+    std::vector<Buffer> m_free;      // recycled buffers
+    std::size_t m_in_flight;         // buffers the writer is currently writing
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_ready;
+    std::condition_variable m_buffer_ready;
+    bool m_stopping;
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+BatchMetrics::BatchMetrics(int workers, const std::vector<std::string>& robot_names, uint64_t games,
+                           uint64_t first_game)
+    : m_robot_names(robot_names), m_games(games), m_next_game(first_game)
+{
+    for (int i = 0; i < workers; ++i)
+    {
+        m_workers.push_back(std::make_unique<WorkerCounters>(robot_names.size()));
+    }
+    m_start = std::chrono::steady_clock::now();
+    m_sample_time = m_start;
+    m_sample_games = 0;
+    m_sample_rounds = 0;
+}
+
+bool BatchMetrics::take_game(uint64_t& game)
+{
+    game = m_next_game.fetch_add(1, std::memory_order_relaxed);
+    return game < m_games;
+}
+
+void BatchMetrics::finish_game(int worker, int winner, int rounds, bool max_rounds, bool draw)
+{
+    // one writer per worker, so a plain add is all it takes
+    WorkerCounters& counters = *m_workers[worker];
+    counters.game_rounds.fetch_add(static_cast<uint64_t>(rounds), std::memory_order_relaxed);
+    if (max_rounds)
+        counters.max_rounds.fetch_add(1, std::memory_order_relaxed);
+    if (draw)
+        counters.draws.fetch_add(1, std::memory_order_relaxed);
+    if (winner >= 0 && winner < static_cast<int>(counters.wins.size()))
+        counters.wins[winner].fetch_add(1, std::memory_order_relaxed);
+    counters.games.fetch_add(1, std::memory_order_release);
+}
+
+BatchMetrics::Totals BatchMetrics::totals() const
+{
+    Totals totals;
+    totals.wins.assign(m_robot_names.size(), 0);
+    for (const std::unique_ptr<WorkerCounters>& worker : m_workers)
+    {
+        totals.games += worker->games.load(std::memory_order_acquire);
+        totals.rounds += worker->rounds.load(std::memory_order_relaxed);
+        totals.game_rounds += worker->game_rounds.load(std::memory_order_relaxed);
+        totals.max_rounds += worker->max_rounds.load(std::memory_order_relaxed);
+        totals.draws += worker->draws.load(std::memory_order_relaxed);
+        totals.busy += worker->busy.load(std::memory_order_relaxed) ? 1 : 0;
+        for (std::size_t i = 0; i < totals.wins.size(); ++i)
+        {
+            totals.wins[i] += worker->wins[i].load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+// robot names go in label values, which can't have a raw quote, backslash or newline
+static std::string label_value(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (c == '\n')
+            escaped += "\\n";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+std::string BatchMetrics::format(bool sample)
+{
+    Totals totals = this->totals();
+    auto now = std::chrono::steady_clock::now();
+    double since_sample = std::chrono::duration<double>(now - m_sample_time).count();
+    double elapsed = std::chrono::duration<double>(now - m_start).count();
+    double games_per_second = since_sample > 0 ? (totals.games - m_sample_games) / since_sample : 0;
+    double rounds_per_second = since_sample > 0 ? (totals.rounds - m_sample_rounds) / since_sample : 0;
+    if (sample)
+    {
+        m_sample_time = now;
+        m_sample_games = totals.games;
+        m_sample_rounds = totals.rounds;
+    }
+    uint64_t handed_out = std::min(m_next_game.load(std::memory_order_relaxed), m_games);
+
+    std::string out;
+    char line[256];
+    auto metric = [&](const char* name, const char* type, const char* help, double value) {
+        std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %.10g\n", name, help, name, type, name, value);
+        out += line;
+    };
+
+    metric("robotwarz_games_total", "counter", "Games finished.", static_cast<double>(totals.games));
+    metric("robotwarz_games_planned", "gauge", "Games in the whole batch.", static_cast<double>(m_games));
+    metric("robotwarz_games_per_second", "gauge", "Games finished per second lately.", games_per_second);
+    metric("robotwarz_rounds_total", "counter", "Rounds played, including games still going.", static_cast<double>(totals.rounds));
+    metric("robotwarz_rounds_per_second", "gauge", "Rounds played per second lately.", rounds_per_second);
+    metric("robotwarz_workers", "gauge", "Worker threads.", static_cast<double>(m_workers.size()));
+    metric("robotwarz_workers_active", "gauge", "Workers in the middle of a game.", static_cast<double>(totals.busy));
+    metric("robotwarz_queue_depth", "gauge", "Games not started yet.", static_cast<double>(m_games - handed_out));
+    metric("robotwarz_game_rounds_average", "gauge", "Average rounds per finished game.",
+           totals.games ? static_cast<double>(totals.game_rounds) / totals.games : 0);
+    metric("robotwarz_max_rounds_games_total", "counter", "Games that stopped at MaxRounds.", static_cast<double>(totals.max_rounds));
+    metric("robotwarz_draws_total", "counter", "Games ended by RepetitionDraw or a stalemate.", static_cast<double>(totals.draws));
+    metric("robotwarz_elapsed_seconds", "gauge", "Seconds since the batch started.", elapsed);
+
+    out += "# HELP robotwarz_wins_total Games won, per robot.\n# TYPE robotwarz_wins_total counter\n";
+    for (std::size_t i = 0; i < m_robot_names.size(); ++i)
+    {
+        std::snprintf(line, sizeof(line), "robotwarz_wins_total{robot=\"%s\"} %llu\n",
+                      label_value(m_robot_names[i]).c_str(), static_cast<unsigned long long>(totals.wins[i]));
+        out += line;
+    }
+    out += "# HELP robotwarz_win_rate Share of finished games won, per robot.\n# TYPE robotwarz_win_rate gauge\n";
+    for (std::size_t i = 0; i < m_robot_names.size(); ++i)
+    {
+        std::snprintf(line, sizeof(line), "robotwarz_win_rate{robot=\"%s\"} %.6f\n",
+                      label_value(m_robot_names[i]).c_str(),
+                      totals.games ? static_cast<double>(totals.wins[i]) / totals.games : 0.0);
+        out += line;
+    }
+    return out;
+}
+
+MetricsExporter::MetricsExporter(BatchMetrics& metrics, const std::string& file_path, const std::string& socket_path)
+    : m_metrics(metrics), m_file_path(file_path), m_socket_path(socket_path), m_listen_fd(-1)
+{
+    m_wake[0] = m_wake[1] = -1;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start()
+{
+    if (m_file_path.empty() && m_socket_path.empty())
+    {
+        return true;
+    }
+
+    if (!m_socket_path.empty())
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (m_socket_path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Metrics socket path is too long: " << m_socket_path << std::endl;
+            return false;
+        }
+        std::strcpy(address.sun_path, m_socket_path.c_str());
+
+        ::unlink(m_socket_path.c_str()); // left over from a batch that was killed
+        m_listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_listen_fd < 0 ||
+            ::bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(m_listen_fd, 16) != 0)
+        {
+            std::cerr << "Failed to open metrics socket " << m_socket_path << ": " << std::strerror(errno) << std::endl;
+            if (m_listen_fd >= 0)
+                ::close(m_listen_fd);
+            m_listen_fd = -1;
+            return false;
+        }
+    }
+
+    if (::pipe(m_wake) != 0)
+    {
+        std::cerr << "Failed to start metrics: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    m_thread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (m_thread.joinable())
+    {
+        char byte = 0;
+        while (::write(m_wake[1], &byte, 1) < 0 && errno == EINTR)
+        {
+        }
+        m_thread.join();
+    }
+    for (int& fd : m_wake)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+    if (m_listen_fd >= 0)
+    {
+        ::close(m_listen_fd);
+        ::unlink(m_socket_path.c_str());
+        m_listen_fd = -1;
+    }
+}
+
+void MetricsExporter::run()
+{
+    const auto interval = std::chrono::seconds(interval_seconds);
+    auto next_write = std::chrono::steady_clock::now() + interval;
+
+    while (true)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_write)
+        {
+            write_file(m_metrics.format(true));
+            next_write = now + interval;
+        }
+
+        pollfd fds[2] = {{m_wake[0], POLLIN, 0}, {m_listen_fd, POLLIN, 0}};
+        int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(next_write - now).count());
+        int ready = ::poll(fds, m_listen_fd >= 0 ? 2 : 1, std::max(timeout, 0));
+        if (ready < 0 && errno != EINTR)
+        {
+            break;
+        }
+        if (fds[0].revents)
+        {
+            break;
+        }
+        if (m_listen_fd >= 0 && (fds[1].revents & POLLIN))
+        {
+            int client = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0)
+            {
+                answer(client);
+                ::close(client);
+            }
+        }
+    }
+
+    write_file(m_metrics.format(true));
+}
+
+void MetricsExporter::write_file(const std::string& text)
+{
+    if (m_file_path.empty())
+    {
+        return;
+    }
+
+    std::string temp_path = m_file_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        if (!file.write(text.data(), static_cast<std::streamsize>(text.size())) || !file.flush())
+        {
+            std::cerr << "Failed to write metrics: " << temp_path << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp_path, m_file_path, error);
+    if (error)
+    {
+        std::cerr << "Failed to write metrics: " << m_file_path << ": " << error.message() << std::endl;
+    }
+}
+
+// a client that says nothing for a moment gets the plain text, one that sends
+// an HTTP request gets an HTTP answer
+void MetricsExporter::answer(int client)
+{
+    char request[512];
+    ssize_t length = 0;
+    pollfd fd = {client, POLLIN, 0};
+    if (::poll(&fd, 1, 50) > 0)
+    {
+        length = ::recv(client, request, sizeof(request), 0);
+    }
+
+    std::string body = m_metrics.format(false);
+    std::string reply;
+    if (length >= 4 && std::memcmp(request, "GET ", 4) == 0)
+    {
+        reply = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    }
+    reply += body;
+
+    std::size_t written = 0;
+    while (written < reply.size())
+    {
+        ssize_t n = ::send(client, reply.data() + written, reply.size() - written, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        written += static_cast<std::size_t>(n);
+    }
+}
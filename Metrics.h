@@ -0,0 +1,111 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Progress and health of a batch of games, for dashboards to scrape while it
+// runs: games and rounds per second, busy workers, games still queued, wins
+// per robot, average game length and games that ran into MaxRounds.
+//
+// Every worker thread counts into its own cache line with relaxed atomics, so
+// playing games never waits on a lock or on another worker. The exporter sums
+// the workers up when it writes, which is the only place they are read.
+
+struct WorkerCounters
+{
+    explicit WorkerCounters(std::size_t robots) : wins(robots) {}
+
+    alignas(64) std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> rounds{0};      // every round, including games still going
+    std::atomic<uint64_t> game_rounds{0}; // rounds of finished games
+    std::atomic<uint64_t> max_rounds{0};  // games that stopped at MaxRounds
+    std::atomic<uint64_t> draws{0};
+    std::atomic<bool> busy{false};
+    std::vector<std::atomic<uint64_t>> wins; // per robot
+};
+
+class BatchMetrics
+{
+public:
+
+    // games before first_game were played before a --resume
+    BatchMetrics(int workers, const std::vector<std::string>& robot_names, uint64_t games, uint64_t first_game = 0);
+
+    WorkerCounters& worker(int index) { return *m_workers[index]; }
+
+    // the queue is a counter of games handed out. false when there are none left.
+    bool take_game(uint64_t& game);
+
+    // one game finished on this worker. winner is a robot index or -1.
+    void finish_game(int worker, int winner, int rounds, bool max_rounds, bool draw);
+
+    // everything in the Prometheus text format. the rates are since the last
+    // call that passed a sample, or since the start.
+    std::string format(bool sample);
+
+private:
+
+    struct Totals
+    {
+        uint64_t games = 0;
+        uint64_t rounds = 0;
+        uint64_t game_rounds = 0;
+        uint64_t max_rounds = 0;
+        uint64_t draws = 0;
+        int busy = 0;
+        std::vector<uint64_t> wins;
+    };
+
+    Totals totals() const;
+
+    std::vector<std::unique_ptr<WorkerCounters>> m_workers;
+    std::vector<std::string> m_robot_names;
+    uint64_t m_games;
+    alignas(64) std::atomic<uint64_t> m_next_game;
+
+    // only the exporter thread touches these
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_sample_time;
+    uint64_t m_sample_games;
+    uint64_t m_sample_rounds;
+};
+
+// Writes the metrics to a file every few seconds (to <path>.tmp, then renamed,
+// so a scraper never sees half a file) and answers on a Unix socket: connect
+// and read, or send an HTTP GET (curl --unix-socket) and get an HTTP answer.
+// Either path can be empty.
+class MetricsExporter
+{
+public:
+
+    static const int interval_seconds = 2;
+
+    MetricsExporter(BatchMetrics& metrics, const std::string& file_path, const std::string& socket_path);
+    ~MetricsExporter();
+
+    bool start();
+
+    // writes the file one last time, so it has the final counts
+    void stop();
+
+private:
+
+    void run();
+    void write_file(const std::string& text);
+    void answer(int client);
+
+    BatchMetrics& m_metrics;
+    std::string m_file_path;
+    std::string m_socket_path;
+    int m_listen_fd;
+    int m_wake[2]; // a pipe, written to by stop()
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "PerfCounters.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* engine_phase_name(EnginePhase phase)
+{
+    switch (phase)
+    {
+        case EnginePhase::Radar:  return "radar";
+        case EnginePhase::Weapon: return "weapon";
+        case EnginePhase::Move:   return "move";
+        case EnginePhase::Render: return "render";
+        default:                  return "?";
+    }
+}
+
+const char* perf_counter_name(PerfCounter counter)
+{
+    switch (counter)
+    {
+        case PerfCounter::Cycles:       return "cycles";
+        case PerfCounter::Instructions: return "instructions";
+        case PerfCounter::CacheMisses:  return "cache-misses";
+        case PerfCounter::BranchMisses: return "branch-misses";
+        default:                        return "?";
+    }
+}
+
+PerfCounters::PerfCounters()
+{
+    m_fds.fill(-1);
+    m_leader = -1;
+    m_time_enabled = 0;
+    m_time_running = 0;
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+#ifdef __linux__
+
+static uint64_t hardware_event(PerfCounter counter)
+{
+    switch (counter)
+    {
+        case PerfCounter::Cycles:       return PERF_COUNT_HW_CPU_CYCLES;
+        case PerfCounter::Instructions: return PERF_COUNT_HW_INSTRUCTIONS;
+        case PerfCounter::CacheMisses:  return PERF_COUNT_HW_CACHE_MISSES;
+        default:                        return PERF_COUNT_HW_BRANCH_MISSES;
+    }
+}
+
+bool PerfCounters::open()
+{
+    close();
+
+    for (int i = 0; i < perf_counter_count; ++i)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = hardware_event(static_cast<PerfCounter>(i));
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // user space only: that is all perf_event_paranoid 2 lets anyone count
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.disabled = m_leader < 0 ? 1 : 0;
+
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+        if (fd < 0)
+        {
+            if (m_error.empty())
+            {
+                m_error = std::string(perf_counter_name(static_cast<PerfCounter>(i))) + ": " + std::strerror(errno);
+                if (errno == EACCES || errno == EPERM)
+                    m_error += " (see /proc/sys/kernel/perf_event_paranoid)";
+                else if (errno == ENOENT || errno == EOPNOTSUPP)
+                    m_error += " (no hardware counters, a VM perhaps)";
+            }
+            continue;
+        }
+        m_fds[i] = fd;
+        if (m_leader < 0)
+        {
+            m_leader = fd;
+        }
+    }
+
+    if (m_leader < 0)
+    {
+        return false;
+    }
+    ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int& fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    m_leader = -1;
+    m_error.clear();
+}
+
+bool PerfCounters::read(CounterValues& values)
+{
+    values.fill(0);
+    if (m_leader < 0)
+    {
+        return false;
+    }
+
+    // nr, time enabled, time running, then one value per counter in the order
+    // they joined the group
+    uint64_t data[3 + perf_counter_count];
+    if (::read(m_leader, data, sizeof(data)) < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+    {
+        return false;
+    }
+    m_time_enabled = data[1];
+    m_time_running = data[2];
+
+    uint64_t next = 0;
+    for (int i = 0; i < perf_counter_count && next < data[0]; ++i)
+    {
+        if (m_fds[i] >= 0)
+        {
+            values[i] = data[3 + next++];
+        }
+    }
+    return true;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    m_error = "perf_event_open is Linux only";
+    return false;
+}
+
+void PerfCounters::close()
+{
+}
+
+bool PerfCounters::read(CounterValues& values)
+{
+    values.fill(0);
+    return false;
+}
+
+#endif
+
+void PhaseProfile::merge(const PhaseProfile& other)
+{
+    for (int i = 0; i < engine_phase_count; ++i)
+    {
+        phases[i].calls += other.phases[i].calls;
+        phases[i].wall_ns += other.phases[i].wall_ns;
+        for (int c = 0; c < perf_counter_count; ++c)
+        {
+            phases[i].counters[c] += other.phases[i].counters[c];
+        }
+    }
+    turns += other.turns;
+}
+
+static uint64_t wall_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+PhaseScope::PhaseScope(PhaseProfile* profile, EnginePhase phase)
+{
+    m_profile = profile;
+    m_totals = profile ? &(*profile)[phase] : nullptr;
+    if (m_profile && m_profile->counters)
+    {
+        m_profile->counters->read(m_start);
+    }
+    m_wall_start = m_profile ? wall_ns() : 0;
+}
+
+PhaseScope::~PhaseScope()
+{
+    if (!m_profile)
+    {
+        return;
+    }
+    m_totals->wall_ns += wall_ns() - m_wall_start;
+    ++m_totals->calls;
+    if (m_profile->counters)
+    {
+        CounterValues end;
+        m_profile->counters->read(end);
+        for (int c = 0; c < perf_counter_count; ++c)
+        {
+            m_totals->counters[c] += end[c] - m_start[c];
+        }
+    }
+}
+
+std::string format_phase_profile(const PhaseProfile& profile)
+{
+    std::ostringstream out;
+    char line[200];
+    const PerfCounters* counters = profile.counters;
+    double turns = profile.turns > 0 ? static_cast<double>(profile.turns) : 1.0;
+
+    std::snprintf(line, sizeof(line), "Engine phases per robot turn (%llu turns)\n",
+                  static_cast<unsigned long long>(profile.turns));
+    out << line;
+    std::snprintf(line, sizeof(line), "  %-8s %10s %10s %12s %12s %6s %12s %13s\n",
+                  "phase", "calls", "ns", "cycles", "instructions", "IPC", "cache-misses", "branch-misses");
+    out << line;
+
+    auto per_turn = [&](const PhaseTotals& totals, PerfCounter counter) -> std::string {
+        if (!counters || !counters->has(counter))
+            return "n/a";
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.1f", totals.counters[static_cast<int>(counter)] / turns);
+        return value;
+    };
+
+    for (int i = 0; i < engine_phase_count; ++i)
+    {
+        const PhaseTotals& totals = profile.phases[i];
+        std::string ipc = "n/a";
+        if (counters && counters->has(PerfCounter::Cycles) && counters->has(PerfCounter::Instructions))
+        {
+            uint64_t cycles = totals.counters[static_cast<int>(PerfCounter::Cycles)];
+            char value[32];
+            std::snprintf(value, sizeof(value), "%.2f",
+                          cycles ? static_cast<double>(totals.counters[static_cast<int>(PerfCounter::Instructions)]) / cycles : 0.0);
+            ipc = value;
+        }
+        std::snprintf(line, sizeof(line), "  %-8s %10llu %10.1f %12s %12s %6s %12s %13s\n",
+                      engine_phase_name(static_cast<EnginePhase>(i)),
+                      static_cast<unsigned long long>(totals.calls),
+                      totals.wall_ns / turns,
+                      per_turn(totals, PerfCounter::Cycles).c_str(),
+                      per_turn(totals, PerfCounter::Instructions).c_str(),
+                      ipc.c_str(),
+                      per_turn(totals, PerfCounter::CacheMisses).c_str(),
+                      per_turn(totals, PerfCounter::BranchMisses).c_str());
+        out << line;
+    }
+
+    if (counters && !counters->error().empty())
+    {
+        out << "  some counters are missing: " << counters->error() << "\n";
+    }
+    if (counters && counters->multiplexed())
+    {
+        out << "  the counters were multiplexed with other users, the counts are estimates\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,126 @@
+#ifndef __PERFCOUNTERS_H__
+#define __PERFCOUNTERS_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Hardware counters around the engine's phases, for tuning the engine rather
+// than the robots: cycles, instructions, cache misses and branch misses spent
+// on radar, weapons, movement and board rendering.
+//
+// The four counters are opened as one perf_event_open group and read with a
+// single read() at each phase boundary, so they all cover exactly the same
+// stretch of code. That read is a system call, which is why this is only
+// switched on by bench --counters and never in a normal game.
+//
+// Counters the machine or the kernel won't give us (no PMU in a VM,
+// perf_event_paranoid, a container without the syscall) are left out and show
+// as n/a. With none at all the phases are still timed on the wall clock.
+
+enum class EnginePhase
+{
+    Radar,
+    Weapon,
+    Move,
+    Render,
+    Count
+};
+
+const char* engine_phase_name(EnginePhase phase);
+
+enum class PerfCounter
+{
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    Count
+};
+
+const char* perf_counter_name(PerfCounter counter);
+
+static const int perf_counter_count = static_cast<int>(PerfCounter::Count);
+static const int engine_phase_count = static_cast<int>(EnginePhase::Count);
+
+using CounterValues = std::array<uint64_t, perf_counter_count>;
+
+class PerfCounters
+{
+public:
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // counts this thread in user space. false if not one counter could be opened.
+    bool open();
+    void close();
+
+    bool has(PerfCounter counter) const { return m_fds[static_cast<int>(counter)] >= 0; }
+    bool any() const { return m_leader >= 0; }
+
+    // why counters are missing, empty if none are
+    const std::string& error() const { return m_error; }
+
+    // the running totals. counters that aren't open read 0.
+    bool read(CounterValues& values);
+
+    // true if the kernel had to share the PMU with others, which makes the
+    // counts estimates
+    bool multiplexed() const { return m_time_running < m_time_enabled; }
+
+private:
+
+    std::array<int, perf_counter_count> m_fds;
+    int m_leader;
+    uint64_t m_time_enabled;
+    uint64_t m_time_running;
+    std::string m_error;
+};
+
+struct PhaseTotals
+{
+    uint64_t calls = 0;
+    uint64_t wall_ns = 0;
+    CounterValues counters{};
+};
+
+// what a game spent in each phase. give it to Arena::set_phase_profile().
+struct PhaseProfile
+{
+    PerfCounters* counters = nullptr; // null for wall clock only
+    std::array<PhaseTotals, engine_phase_count> phases;
+    uint64_t turns = 0; // robot turns, dead robots don't count
+
+    PhaseTotals& operator[](EnginePhase phase) { return phases[static_cast<int>(phase)]; }
+    const PhaseTotals& operator[](EnginePhase phase) const { return phases[static_cast<int>(phase)]; }
+    void merge(const PhaseProfile& other);
+};
+
+// adds the time and counts between construction and destruction to a phase.
+// a null profile does nothing.
+class PhaseScope
+{
+public:
+
+    PhaseScope(PhaseProfile* profile, EnginePhase phase);
+    ~PhaseScope();
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+
+    PhaseProfile* m_profile;
+    PhaseTotals* m_totals;
+    uint64_t m_wall_start;
+    CounterValues m_start;
+};
+
+// per robot turn: ns, cycles, instructions, IPC, cache and branch misses
+std::string format_phase_profile(const PhaseProfile& profile);
+
+#endif
@@ -0,0 +1,647 @@
+#include "ReferenceArena.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+// A copy of the rules in Arena.cpp, kept as they were. See ReferenceArena.h.
+
+ReferenceArena::ReferenceArena(int row_in, int col_in, uint64_t seed)
+    : m_size_row(row_in), m_size_col(col_in), m_rng(seed)
+{
+    m_board.resize(m_size_row, std::vector<char>(m_size_col, '.'));
+}
+
+// Given the robot's preference on radar direction, get radar results
+void ReferenceArena::get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results) 
+{
+    // Clear the radar results vector
+    radar_results.clear();
+
+    if (radar_direction == 0) 
+    {
+        get_radar_local(robot, radar_results);
+    } 
+    else if (radar_direction >= 1 && radar_direction <= 8)
+    {
+        get_radar_ray(robot, radar_direction, radar_results);
+    }
+    // anything else points nowhere: directions[] only has 0-8
+}
+
+void ReferenceArena::get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_results) 
+{
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // Perform a 3x3 scan around the robot
+    for (int row_offset = -1; row_offset <= 1; ++row_offset) 
+    {
+        for (int col_offset = -1; col_offset <= 1; ++col_offset) 
+        {
+            // Skip the robot's own location
+            if (row_offset == 0 && col_offset == 0) 
+            {
+                continue;
+            }
+
+            int scan_row = current_row + row_offset;
+            int scan_col = current_col + col_offset;
+
+            // Skip out-of-bounds locations
+            if (scan_row < 0 || scan_row >= m_size_row || scan_col < 0 || scan_col >= m_size_col) 
+            {
+                continue;
+            }
+
+            // Get the cell content
+            char cell = m_board[scan_row][scan_col];
+
+            // Skip empty cells
+            if (cell == '.') 
+            {
+                continue;
+            }
+
+            // Record the radar object
+            RadarObj radar_obj;
+            radar_obj.m_type = cell;
+            radar_obj.m_row = scan_row;
+            radar_obj.m_col = scan_col;
+            radar_results.push_back(radar_obj);
+        }
+    }
+}
+
+void ReferenceArena::scan_location(int row, int col, std::vector<RadarObj>& radar_results)
+{
+    if (row >= 0 && row < m_size_row && col >= 0 && col < m_size_col) 
+        {
+            char cell = m_board[row][col];
+            if (cell != '.')
+                radar_results.push_back(RadarObj(cell, row, col));
+        }
+}
+
+
+void ReferenceArena::get_radar_ray(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results) 
+{
+    //some setup stuff
+    static const std::set<int> diagonal_directions = {2, 4, 6, 8};
+    const auto [delta_row, delta_col] = directions[radar_direction];
+    int current_row, current_col;
+
+    robot->get_current_location(current_row, current_col);
+
+    int scan_row = current_row + delta_row;
+    int scan_col = current_col + delta_col;
+
+    radar_results.clear();
+
+    // look at each location from the start location to the edge of the arena
+    while (scan_row < m_size_row && scan_row >= 0 && scan_col < m_size_col && scan_col >= 0) 
+    {
+        // Scan the middle beam
+        scan_location(scan_row,scan_col, radar_results);
+
+        // Scan the +1 perpendicular cell
+        int extra_row = scan_row + delta_col;
+        int extra_col = scan_col - delta_row;
+        scan_location(extra_row, extra_col, radar_results);
+
+        // Scan the -1 perpendicular cell
+        extra_row = scan_row - delta_col;
+        extra_col = scan_col + delta_row;
+        scan_location(extra_row,extra_col,radar_results);
+
+        // if diagonal, we also need to get the hole. 
+        if(diagonal_directions.count(radar_direction))
+        {
+            //same row, diff column
+            extra_row = scan_row;
+            extra_col = scan_col + delta_row;
+            scan_location(extra_row,extra_col,radar_results);
+
+            //same col, diff row
+            extra_row = scan_row + delta_col;
+            extra_col = scan_col;
+            scan_location(extra_row,extra_col,radar_results);
+        }
+        
+        // Move the beam forward
+        scan_row += delta_row;
+        scan_col += delta_col;
+    }
+}
+
+// Handle the robot's shot
+std::string ReferenceArena::handle_shot(RobotBase* robot, int shot_row, int shot_col) 
+{
+    std::stringstream ss;
+
+    WeaponType weapon = robot->get_weapon();
+    switch (weapon) 
+    {
+        case flamethrower:
+            ss << " firing flamethrower... ";
+            ss << handle_flame_shot(robot, shot_row, shot_col);
+            break;
+
+        case railgun:
+            ss << " shooting railgun... ";
+            ss << handle_railgun_shot(robot, shot_row, shot_col);
+            break;
+
+        case grenade:
+            ss << " launching grenade... ";
+            ss << handle_grenade_shot(robot, shot_row, shot_col);
+            break;
+
+        case hammer:
+            ss << " pounding with the hammer...";
+            ss <<  handle_hammer_shot(robot, shot_row, shot_col);
+            break;
+
+        default:
+            return "strange weapon? ";
+
+    }
+    return ss.str();
+}
+std::string ReferenceArena::apply_damage_to_robot(RobotBase* robot, WeaponType weapon)
+{
+    std::stringstream ss;
+    int armor = robot->get_armor();
+    int damage = calculate_damage(weapon,armor);
+
+    robot->take_damage(damage);
+    robot->reduce_armor(1);
+
+    ss << robot->m_name << " takes " << damage << " damage. Health: " << robot->get_health() << std::endl;
+    return ss.str();
+
+}
+
+int ReferenceArena::calculate_damage(WeaponType weapon, int armor_level) 
+{
+    int min_damage = 0, max_damage = 0;
+    switch (weapon) {
+        case flamethrower:
+            min_damage = 30;
+            max_damage = 50;
+            break;
+        case railgun:
+            min_damage = 10;
+            max_damage = 20;
+            break;
+        case hammer:
+            min_damage = 50;
+            max_damage = 60;
+            break;
+        case grenade:
+            min_damage = 10;
+            max_damage = 40;
+            break;
+        default:
+            return 0; // No damage for unrecognized weapons
+    }
+
+    // Generate random damage within the range
+    int base_damage = min_damage + m_rng.below(max_damage - min_damage + 1);
+
+    // Apply armor reduction (10% per armor level)
+    double armor_multiplier = 1.0 - (0.1 * armor_level);
+    int final_damage = static_cast<int>(base_damage * armor_multiplier);
+
+    return final_damage;
+}
+
+std::string ReferenceArena::handle_flame_shot(RobotBase* robot, int shot_row, int shot_col)
+{
+    std::stringstream ss;
+
+    // Get the current location of the robot
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // Calculate directional increments for the flame path
+    int delta_row = shot_row - current_row;
+    int delta_col = shot_col - current_col;
+
+    int steps = 4; // Flame extends 4 cells from the robot's current location
+    double slope_row = static_cast<double>(delta_row) / steps;
+    double slope_col = static_cast<double>(delta_col) / steps;
+
+    // Collect all cells affected by the flame
+    std::vector<RadarObj> flame_cells;
+
+    auto cell_exists = [&flame_cells](int row, int col) {
+        return std::any_of(flame_cells.begin(), flame_cells.end(), [row, col](const RadarObj& obj) {
+            return obj.m_row == row && obj.m_col == col;
+        });
+    };
+
+    double r = current_row;
+    double c = current_col;
+
+    for (int step = 1; step <= steps; ++step)
+    {
+        // Advance the flame ray
+        r += slope_row;
+        c += slope_col;
+
+        int path_row = static_cast<int>(std::round(r));
+        int path_col = static_cast<int>(std::round(c));
+
+        // Boundary checks for the main flame path
+        if (path_row < 0 || path_row >= m_size_row || path_col < 0 || path_col >= m_size_col)
+        {
+            break; // Stop if out of bounds
+        }
+
+        // Calculate Euclidean distance from the robot
+        double distance = std::sqrt(std::pow(path_row - current_row, 2) + std::pow(path_col - current_col, 2));
+        if (distance > 4.0)
+        {
+            break; // Stop if the cell is beyond the flame's range
+        }
+
+        // Skip adding the shooter’s current location to the flame path
+        if (path_row == current_row && path_col == current_col)
+        {
+            continue;
+        }
+
+        // Add the main flame cell to the path if not already present
+        if (!cell_exists(path_row, path_col))
+        {
+            flame_cells.emplace_back('F', path_row, path_col);
+        }
+
+        // Add adjacent cells for the 3-cell wide flame
+        for (int offset = -1; offset <= 1; ++offset)
+        {
+            int adj_row = path_row + offset * (delta_col != 0 ? 0 : 1); // Vertical spread if horizontal movement
+            int adj_col = path_col + offset * (delta_row != 0 ? 0 : 1); // Horizontal spread if vertical movement
+
+            // Boundary checks for adjacent cells
+            if (adj_row >= 0 && adj_row < m_size_row && adj_col >= 0 && adj_col < m_size_col)
+            {
+                // Calculate distance for the adjacent cell
+                double adj_distance = std::sqrt(std::pow(adj_row - current_row, 2) + std::pow(adj_col - current_col, 2));
+                if (adj_distance <= 4.0 && !cell_exists(adj_row, adj_col))
+                {
+                    flame_cells.emplace_back('F', adj_row, adj_col);
+                }
+            }
+        }
+    }
+
+    // Apply damage to robots in the flame path
+    for (auto* target_robot : m_robots)
+    {
+        int target_row, target_col;
+        target_robot->get_current_location(target_row, target_col);
+
+        // Check if the robot's location matches any cell in the flame path
+        for (const RadarObj& flame_cell : flame_cells)
+        {
+            if (flame_cell.m_row == target_row && flame_cell.m_col == target_col)
+            {
+                // Skip applying damage to the shooter
+                if (target_robot == robot)
+                {
+                    continue;
+                }
+
+                ss << apply_damage_to_robot(target_robot, flamethrower);
+                break; // No need to check further flame cells for this robot
+            }
+        }
+    }
+    return ss.str();
+}
+
+std::string ReferenceArena::handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col) 
+{
+    std::stringstream ss;
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // Calculate directional increments for the ray
+    int delta_row = shot_row - current_row;
+    int delta_col = shot_col - current_col;
+
+    // Normalize the direction to unit increments (step in a straight line)
+    int steps = std::max(std::abs(delta_row), std::abs(delta_col));
+    if (steps == 0) {
+        ss << "Invalid shot direction.";
+        return ss.str();
+    }
+
+    double step_row = static_cast<double>(delta_row) / steps;
+    double step_col = static_cast<double>(delta_col) / steps;
+
+    // Traverse the path
+    double r = current_row + step_row;
+    double c = current_col + step_col;
+    std::vector<RobotBase*> target_list;
+
+    while (true) {
+        int path_row = static_cast<int>(std::round(r));
+        int path_col = static_cast<int>(std::round(c));
+
+        // Check if out of bounds
+        if (path_row < 0 || path_row >= m_size_row || path_col < 0 || path_col >= m_size_col) {
+            break;
+        }
+
+        char cell = m_board[path_row][path_col];
+
+        // Check for robots (exclude the shooting robot itself)
+        if (cell == 'R') {
+            for (RobotBase* target_robot : m_robots) {
+                int target_row, target_col;
+                target_robot->get_current_location(target_row, target_col);
+
+                if (target_row == path_row && target_col == path_col && target_robot != robot) 
+                {
+                    target_list.push_back(target_robot);
+                }
+            }
+        }
+
+        // Move to the next step along the ray
+        r += step_row;
+        c += step_col;
+    }
+
+    // Apply damage to all robots in the target list
+    if (!target_list.empty()) {
+        for (RobotBase* target_robot : target_list) {
+            ss << apply_damage_to_robot(target_robot, railgun) << "  ";
+        }
+    } else {
+        ss << " railgun missed!  The universe is upside down! ";
+    }
+
+    return ss.str();
+
+}
+
+
+std::string ReferenceArena::handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col) 
+{
+    std::stringstream ss;
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // reduce the number of grenades...
+    if(robot->get_grenades() <=0 )
+        return " out of grenades. ";    
+        
+    robot->decrement_grenades();
+
+    int max_distance = 10; // Grenade range
+    int delta_row = shot_row - current_row;
+    int delta_col = shot_col - current_col;
+    int distance = std::abs(delta_row) + std::abs(delta_col);
+
+    // Clamp the target location to max_distance if it's out of range
+    if (distance > max_distance) 
+    {
+        double scaling_factor = static_cast<double>(max_distance) / distance;
+        shot_row = current_row + static_cast<int>(delta_row * scaling_factor);
+        shot_col = current_col + static_cast<int>(delta_col * scaling_factor);
+    }
+
+    // Generate a 5x5 grid of cells around the target location
+    std::vector<std::pair<int, int>> explosion_cells;
+    for (int r = shot_row - 2; r <= shot_row + 2; ++r) 
+    {
+        for (int c = shot_col - 2; c <= shot_col + 2; ++c) 
+        {
+            // Ensure the cell is within arena boundaries
+            if (r >= 0 && r < m_size_row && c >= 0 && c < m_size_col) 
+            {
+                explosion_cells.emplace_back(r, c);
+            }
+        }
+    }
+
+
+    // Check each cell for robots
+    for (const auto& cell : explosion_cells) 
+    {
+        int cell_row = cell.first;
+        int cell_col = cell.second;
+
+        if (m_board[cell_row][cell_col] == 'R') // Check if there is a robot in the cell
+        {
+            // Match the cell to a robot in m_robots
+            for (auto* target : m_robots) 
+            {
+                int target_row, target_col;
+                target->get_current_location(target_row, target_col);
+
+                if (target_row == cell_row && target_col == cell_col) 
+                {
+                    // Apply grenade damage to the robot
+                    ss << apply_damage_to_robot(target, grenade) << " ";
+                    break; // No need to check further robots for this cell
+                }
+            }
+        }
+    }
+
+    return ss.str();
+}
+
+
+std::string ReferenceArena::handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col) 
+{
+    std::stringstream ss;
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // Calculate the direction vector for the shot
+    int delta_row = shot_row - current_row;
+    int delta_col = shot_col - current_col;
+
+    // Normalize the direction to ensure the hit is exactly one square away
+    int target_row = current_row + (delta_row != 0 ? (delta_row / std::abs(delta_row)) : 0);
+    int target_col = current_col + (delta_col != 0 ? (delta_col / std::abs(delta_col)) : 0);
+
+    // Clamp the target cell to stay within arena bounds
+    target_row = std::clamp(target_row, 0, m_size_row - 1);
+    target_col = std::clamp(target_col, 0, m_size_col - 1);
+
+    // Check if there's a robot in the calculated target cell
+    if (m_board[target_row][target_col] == 'R') 
+    {
+        // Find the robot in the list and apply damage
+        for (auto* target : m_robots) 
+        {
+            int target_row_robot, target_col_robot;
+            target->get_current_location(target_row_robot, target_col_robot);
+
+            if (target_row_robot == target_row && target_col_robot == target_col) 
+            {
+                ss << apply_damage_to_robot(target, hammer);
+                return ss.str();
+            }
+        }
+    }
+
+    ss << robot->m_name << " hammer missed trying to hit (" << target_row << "," << target_col << ") ";
+    return ss.str();
+}
+
+
+
+std::string ReferenceArena::handle_move(RobotBase* robot) 
+{
+    std::stringstream ss;
+    int move_direction;
+    int move_distance;
+
+    // Check if the robot cannot move
+    if (robot->get_move_speed() == 0)
+    {
+        ss << robot->m_name << " cannot move. ";
+        return ss.str();
+    }
+
+    // Get the direction and distance desired from the robot
+    robot->get_move_direction(move_direction, move_distance);
+    move_distance = std::clamp(move_distance, 0, robot->get_move_speed());
+
+    // Check if no movement is requested
+    if (move_direction < 1 || move_direction > 8  || move_distance == 0)
+    {
+        ss << robot->m_name << " chooses not to move.";
+        return ss.str();
+    }
+
+    int current_row, current_col;
+    robot->get_current_location(current_row, current_col);
+
+    // Retrieve the direction deltas from the predefined directions map
+    int delta_row = directions[move_direction].first;
+    int delta_col = directions[move_direction].second;
+
+    // Loop through each step of the intended movement
+    for (int step = 1; step <= move_distance; ++step)
+    {
+        // Calculate the next cell - make sure it is in the arena.
+        int next_row = std::clamp(current_row + delta_row, 0, m_size_row - 1);
+        int next_col = std::clamp(current_col + delta_col, 0, m_size_col - 1);
+        char cell = m_board[next_row][next_col];
+
+        // Special case: Flamethrower cells do NOT block movement.
+        if (cell == 'F')
+        {
+            // Move into the flamethrower cell
+            m_board[current_row][current_col] = '.'; // Clear the current cell
+            robot->move_to(next_row, next_col);
+
+            ss << robot->m_name << " encounters a flamethrower at (" 
+               << next_row << "," << next_col << "). Taking damage! " << std::endl;
+            ss << apply_damage_to_robot(robot, flamethrower);
+
+            // If the robot dies on the F, leave a dead robot there and stop moving.
+            if (robot->get_health() <= 0)
+            {
+                m_board[next_row][next_col] = 'X';
+                return ss.str();
+            }
+
+            // Robot survived: it now occupies this cell and the F is effectively consumed.
+            m_board[next_row][next_col] = 'R';
+            current_row = next_row;
+            current_col = next_col;
+
+            // Continue with remaining movement steps (if any).
+            continue;
+        }
+
+        // Other obstacles or collisions behave as before.
+        if (cell != '.')
+        {
+            ss << handle_collision(robot, cell, next_row, next_col);
+            return ss.str();
+        }
+
+        // Normal movement into empty cell
+        if(m_flamethrowers.count({current_row, current_col}) > 0)
+        {
+            m_board[current_row][current_col] = 'F'; // put the flame thrower back.
+        }
+        else
+        {
+            m_board[current_row][current_col] = '.'; // Clear the current cell
+        }
+        
+        robot->move_to(next_row, next_col);
+        m_board[next_row][next_col] = 'R'; // Mark the new position
+        current_row = next_row;
+        current_col = next_col;
+    }
+
+    ss << robot->m_name << " moves to (" << current_row << "," << current_col << ") ";
+    return ss.str();
+}
+
+
+
+// Handle collisions or interactions with obstacles
+std::string ReferenceArena::handle_collision(RobotBase* robot, char cell, int row, int col) 
+{
+    std::stringstream ss;
+
+    switch (cell) 
+    {
+        case 'M': // Mound
+            ss << robot->m_name << " is stopped by a mound at (" << row << "," << col << "). " << std::endl;
+            break;
+
+        case 'X': // Dead Robot
+            ss << robot->m_name << " is stopped by a dead robot at (" << row << "," << col << "). " << std::endl;
+            break;
+
+        case 'R': // Another robot
+            ss << robot->m_name << " crashes into another robot at ("  << row << "," << col << "). " << std::endl;
+            break;
+
+        case 'P': // Pit
+        {
+            int cur_row, cur_col;
+            robot->get_current_location(cur_row, cur_col);
+
+            // Clear old position on the board
+            m_board[cur_row][cur_col] = '.';
+
+            // Move robot into the pit cell
+            robot->move_to(row, col);
+            m_board[row][col] = 'R';
+
+            // Disable movement forever
+            robot->disable_movement();
+
+            ss << robot->m_name << " is stuck in a pit at (" << row << "," << col 
+            << "). Movement disabled. " << std::endl;
+            break;
+        }
+
+
+        case 'F': // Flamethrower
+            ss << robot->m_name << " encounters a flamethrower at ("  << row << "," << col << "). Taking damage! " << std::endl;
+            ss << apply_damage_to_robot(robot, flamethrower); // Apply flamethrower damage
+            break;
+
+        default:
+            ss << "Unknown obstacle: " << cell << " at (" << row << "," << col << ")." << std::endl;
+            break;
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,50 @@
+#ifndef __REFERENCEARENA_H__
+#define __REFERENCEARENA_H__
+
+#include "RobotBase.h"
+#include "RadarObj.h"
+#include "GameRandom.h"
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The game rules as they were before the engine was optimised: board, radar,
+// weapons, moves and damage, copied from Arena and then left alone. Lockstep
+// runs it next to Arena and compares the two after every turn.
+//
+// Don't optimise this one. If a rule is meant to change, change it here and in
+// Arena together.
+class ReferenceArena
+{
+public:
+
+    ReferenceArena(int row_in, int col_in, uint64_t seed);
+
+    int m_size_row, m_size_col;
+    std::set<std::pair<int,int>> m_flamethrowers;
+    std::vector<std::vector<char>> m_board;
+    std::vector<RobotBase*> m_robots;
+    GameRandom m_rng;
+
+    //radar
+    void scan_location(int row, int col, std::vector<RadarObj>& radar_results);
+    void get_radar_results(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results);
+    void get_radar_local(RobotBase* robot, std::vector<RadarObj>& radar_results);
+    void get_radar_ray(RobotBase* robot, int radar_direction, std::vector<RadarObj>& radar_results);
+
+    //shot
+    std::string handle_shot(RobotBase* robot, int shot_row, int shot_col);
+    std::string handle_flame_shot(RobotBase* robot, int shot_row, int shot_col);
+    std::string handle_railgun_shot(RobotBase* robot, int shot_row, int shot_col);
+    std::string handle_grenade_shot(RobotBase* robot, int shot_row, int shot_col);
+    std::string handle_hammer_shot(RobotBase* robot, int shot_row, int shot_col);
+    int calculate_damage(WeaponType weapon, int armor_level);
+    std::string apply_damage_to_robot(RobotBase* robot, WeaponType weapon);
+
+    //move
+    std::string handle_move(RobotBase* robot);
+    std::string handle_collision(RobotBase* robot, char cell, int row, int col);
+};
+
+#endif
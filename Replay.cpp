@@ -0,0 +1,969 @@
+#include "Replay.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char replay_magic[8] = {'R', 'W', 'R', 'E', 'P', 'L', 'A', 'Y'};
+static const uint32_t replay_version = 3; // 2: turns carry the engine's random draws, 3: round hashes
+
+// fixed size header at the start of the file. patched by end_game().
+struct ReplayHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t robot_count;
+    uint32_t keyframe_every;
+    uint32_t rounds;
+    int32_t winner;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t stream_offset;
+    uint64_t index_offset;
+    uint64_t index_count;
+};
+
+// record tags in the stream
+static const char tag_keyframe = 'K';
+static const char tag_round = 'N';
+static const char tag_turn = 'T';
+static const char tag_end = 'E';
+
+RobotState read_robot_state(RobotBase* robot)
+{
+    RobotState state;
+    state.health = robot->get_health();
+    state.armor = robot->get_armor();
+    state.move = robot->get_move_speed();
+    state.grenades = robot->get_grenades();
+    robot->get_current_location(state.row, state.col);
+    return state;
+}
+
+static uint64_t fnv_add(uint64_t hash, const void* data, std::size_t length)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t fnv_add_state(uint64_t hash, const RobotState& state)
+{
+    int32_t values[6] = {state.health, state.armor, state.move, state.grenades, state.row, state.col};
+    return fnv_add(hash, values, sizeof(values));
+}
+
+static uint64_t fnv_add_board(uint64_t hash, const std::vector<std::vector<char>>& board)
+{
+    for (const auto& row : board)
+    {
+        hash = fnv_add(hash, row.data(), row.size());
+    }
+    return hash;
+}
+
+static const uint64_t fnv_basis = 14695981039346656037ULL;
+
+uint64_t replay_state_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotState>& robots)
+{
+    uint64_t hash = fnv_add_board(fnv_basis, board);
+    for (const RobotState& state : robots)
+    {
+        hash = fnv_add_state(hash, state);
+    }
+    return hash;
+}
+
+uint64_t replay_state_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots)
+{
+    uint64_t hash = fnv_add_board(fnv_basis, board);
+    for (RobotBase* robot : robots)
+    {
+        hash = fnv_add_state(hash, read_robot_state(robot));
+    }
+    return hash;
+}
+
+//---------------------------------------------------------------- encoding
+
+static void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// zigzag, so small negative numbers stay small
+static void put_signed(std::string& out, int64_t value)
+{
+    put_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static void put_state(std::string& out, const RobotState& state)
+{
+    put_varint(out, state.health);
+    put_varint(out, state.armor);
+    put_varint(out, state.move);
+    put_varint(out, state.grenades);
+    put_varint(out, state.row);
+    put_varint(out, state.col);
+}
+
+// bounds checked reads from the mapped file
+struct ReplayCursor
+{
+    const unsigned char* data;
+    std::size_t size;
+    std::size_t pos;
+    bool ok = true;
+
+    uint64_t fixed64()
+    {
+        uint64_t value = 0;
+        if (pos + sizeof(value) > size)
+        {
+            ok = false;
+            return 0;
+        }
+        std::memcpy(&value, data + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= size)
+            {
+                ok = false;
+                return 0;
+            }
+            unsigned char byte = data[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok = false;
+        return value;
+    }
+
+    int64_t signed_varint()
+    {
+        uint64_t value = varint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    char byte()
+    {
+        if (pos >= size)
+        {
+            ok = false;
+            return 0;
+        }
+        return static_cast<char>(data[pos++]);
+    }
+
+    RobotState state()
+    {
+        RobotState state;
+        state.health = static_cast<int>(varint());
+        state.armor = static_cast<int>(varint());
+        state.move = static_cast<int>(varint());
+        state.grenades = static_cast<int>(varint());
+        state.row = static_cast<int>(varint());
+        state.col = static_cast<int>(varint());
+        return state;
+    }
+};
+
+//---------------------------------------------------------------- writer
+
+ReplayWriter::ReplayWriter(const std::string& path, int keyframe_every)
+    : m_file(path, std::ios::binary | std::ios::trunc), m_written(0),
+      m_keyframe_every(std::max(1, keyframe_every)), m_rows(0), m_cols(0),
+      m_robot_count(0), m_seed(0), m_in_round(false)
+{
+    if (!m_file)
+    {
+        std::cerr << "Failed to open replay file: " << path << std::endl;
+    }
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    flush_buffer();
+}
+
+void ReplayWriter::flush_buffer()
+{
+    if (!m_out.empty() && m_file)
+    {
+        m_file.write(m_out.data(), static_cast<std::streamsize>(m_out.size()));
+    }
+    m_written += m_out.size();
+    m_out.clear();
+}
+
+void ReplayWriter::begin_game(uint64_t seed, const std::vector<std::vector<char>>& board,
+                              const std::vector<RobotBase*>& robots, const char* robot_tags)
+{
+    m_seed = seed;
+    m_rows = static_cast<int>(board.size());
+    m_cols = m_rows > 0 ? static_cast<int>(board[0].size()) : 0;
+    m_robot_count = static_cast<int>(robots.size());
+
+    // placeholder header, the real one is written by end_game()
+    m_out.append(sizeof(ReplayHeader), '\0');
+
+    for (std::size_t i = 0; i < robots.size(); ++i)
+    {
+        m_out += robot_tags[i];
+        m_out += static_cast<char>(robots[i]->get_weapon());
+        put_varint(m_out, robots[i]->m_name.size());
+        m_out += robots[i]->m_name;
+    }
+}
+
+void ReplayWriter::begin_round(int round, const std::vector<std::vector<char>>& board,
+                               const std::vector<RobotBase*>& robots)
+{
+    if (m_in_round)
+    {
+        end_round();
+    }
+    m_in_round = true;
+
+    // the hash goes right after the tag so the reader can peek at it
+    uint64_t hash = replay_state_hash(board, robots);
+
+    // a game restored from a snapshot can start anywhere, and starts with a keyframe
+    if (round % m_keyframe_every != 0 && !m_index.empty())
+    {
+        m_out += tag_round;
+        m_out.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        return;
+    }
+
+    m_index.emplace_back(round, m_written + m_out.size());
+    m_out += tag_keyframe;
+    m_out.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    put_varint(m_out, round);
+
+    // the board, run length encoded: mostly runs of '.'
+    char run_cell = 0;
+    uint64_t run_length = 0;
+    for (const auto& row : board)
+    {
+        for (char cell : row)
+        {
+            if (cell == run_cell && run_length > 0)
+            {
+                ++run_length;
+                continue;
+            }
+            if (run_length > 0)
+            {
+                m_out += run_cell;
+                put_varint(m_out, run_length);
+            }
+            run_cell = cell;
+            run_length = 1;
+        }
+    }
+    if (run_length > 0)
+    {
+        m_out += run_cell;
+        put_varint(m_out, run_length);
+    }
+
+    for (auto* robot : robots)
+    {
+        put_state(m_out, read_robot_state(robot));
+    }
+
+    if (m_out.size() > (1u << 20))
+    {
+        flush_buffer();
+    }
+}
+
+void ReplayWriter::end_round()
+{
+    m_out += tag_end;
+    m_in_round = false;
+}
+
+void ReplayWriter::begin_turn(int robot_index, const std::vector<RobotBase*>& robots)
+{
+    (void)robot_index;
+    m_cells.clear();
+    m_draws.clear();
+    m_before.resize(robots.size());
+    for (std::size_t i = 0; i < robots.size(); ++i)
+    {
+        m_before[i] = read_robot_state(robots[i]);
+    }
+}
+
+void ReplayWriter::cell_changed(int row, int col, char cell)
+{
+    m_cells.push_back({row, col, cell});
+}
+
+void ReplayWriter::random_draw(int value)
+{
+    m_draws.push_back(value);
+}
+
+void ReplayWriter::end_turn(ReplayTurn& turn, const std::vector<RobotBase*>& robots)
+{
+    turn.cells = std::move(m_cells);
+    m_cells.clear();
+    turn.draws = std::move(m_draws);
+    m_draws.clear();
+    turn.robots.clear();
+    for (std::size_t i = 0; i < robots.size() && i < m_before.size(); ++i)
+    {
+        RobotState after = read_robot_state(robots[i]);
+        if (!(after == m_before[i]))
+        {
+            turn.robots.emplace_back(static_cast<int>(i), after);
+        }
+    }
+
+    m_out += tag_turn;
+    put_varint(m_out, turn.robot);
+    m_out += static_cast<char>(turn.action);
+    put_signed(m_out, turn.radar_direction);
+    put_varint(m_out, turn.radar_hits);
+    if (turn.radar_hits > 0)
+    {
+        m_out += turn.first_hit.m_type;
+        put_varint(m_out, turn.first_hit.m_row);
+        put_varint(m_out, turn.first_hit.m_col);
+    }
+    put_signed(m_out, turn.param1);
+    put_signed(m_out, turn.param2);
+
+    put_varint(m_out, turn.draws.size());
+    for (int draw : turn.draws)
+    {
+        put_varint(m_out, draw);
+    }
+
+    put_varint(m_out, turn.cells.size());
+    for (const ReplayCell& cell : turn.cells)
+    {
+        put_varint(m_out, cell.row);
+        put_varint(m_out, cell.col);
+        m_out += cell.cell;
+    }
+
+    put_varint(m_out, turn.robots.size());
+    for (const auto& [index, state] : turn.robots)
+    {
+        put_varint(m_out, index);
+        put_state(m_out, state);
+    }
+
+    if (m_out.size() > (1u << 20))
+    {
+        flush_buffer();
+    }
+}
+
+void ReplayWriter::end_game(int rounds, int winner, const std::vector<std::vector<char>>& board,
+                             const std::vector<RobotBase*>& robots)
+{
+    if (m_in_round)
+    {
+        end_round();
+    }
+
+    // a last record with just the hash of the final state, so it can be checked too
+    uint64_t hash = replay_state_hash(board, robots);
+    m_out += tag_round;
+    m_out.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    end_round();
+
+    ReplayHeader header = {};
+    std::memcpy(header.magic, replay_magic, sizeof(replay_magic));
+    header.version = replay_version;
+    header.rows = m_rows;
+    header.cols = m_cols;
+    header.robot_count = m_robot_count;
+    header.keyframe_every = m_keyframe_every;
+    header.rounds = rounds;
+    header.winner = winner;
+    header.seed = m_seed;
+
+    // the stream starts right after the roster, which is where the first keyframe is
+    header.stream_offset = m_index.empty() ? m_written + m_out.size() : m_index.front().second;
+    header.index_offset = m_written + m_out.size();
+    header.index_count = m_index.size();
+
+    for (const auto& [round, offset] : m_index)
+    {
+        m_out.append(reinterpret_cast<const char*>(&round), sizeof(round));
+        m_out.append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    flush_buffer();
+
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.flush();
+}
+
+//---------------------------------------------------------------- reader
+
+ReplayReader::ReplayReader()
+    : m_data(nullptr), m_size(0), m_rows(0), m_cols(0), m_rounds(0), m_winner(-1),
+      m_keyframe_every(1), m_seed(0)
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+    if (m_data)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+}
+
+bool ReplayReader::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open replay: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ReplayHeader))
+    {
+        std::cerr << "Not a replay file: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        std::cerr << "Failed to map replay: " << path << std::endl;
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(mapped);
+    m_size = st.st_size;
+
+    ReplayHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (std::memcmp(header.magic, replay_magic, sizeof(replay_magic)) != 0 || header.version != replay_version ||
+        header.index_offset > m_size || header.index_count > (m_size - header.index_offset) / 16)
+    {
+        std::cerr << "Not a replay file (or an unfinished one): " << path << std::endl;
+        return false;
+    }
+
+    m_rows = header.rows;
+    m_cols = header.cols;
+    m_rounds = header.rounds;
+    m_winner = header.winner;
+    m_keyframe_every = header.keyframe_every;
+    m_seed = header.seed;
+
+    ReplayCursor in{m_data, m_size, sizeof(ReplayHeader)};
+    m_roster.clear();
+    for (uint32_t i = 0; i < header.robot_count; ++i)
+    {
+        ReplayRobotInfo info;
+        info.tag = in.byte();
+        info.weapon = static_cast<WeaponType>(in.byte());
+        uint64_t length = in.varint();
+        if (!in.ok || in.pos + length > m_size)
+            return false;
+        info.name.assign(reinterpret_cast<const char*>(m_data + in.pos), length);
+        in.pos += length;
+        m_roster.push_back(info);
+    }
+
+    m_index.resize(header.index_count);
+    for (uint64_t i = 0; i < header.index_count; ++i)
+    {
+        std::memcpy(&m_index[i].first, m_data + header.index_offset + i * 16, 8);
+        std::memcpy(&m_index[i].second, m_data + header.index_offset + i * 16 + 8, 8);
+    }
+
+    return in.ok && !m_index.empty();
+}
+
+bool ReplayReader::read_header(std::size_t& pos, ReplayFrame& frame) const
+{
+    ReplayCursor in{m_data, m_size, pos};
+
+    char tag = in.byte();
+    if (tag != tag_keyframe && tag != tag_round)
+    {
+        return false;
+    }
+    frame.hash = in.fixed64();
+
+    if (tag == tag_keyframe)
+    {
+        frame.round = static_cast<int>(in.varint());
+        frame.board.assign(m_rows, std::vector<char>(m_cols, '.'));
+
+        std::size_t cell = 0, total = static_cast<std::size_t>(m_rows) * m_cols;
+        while (cell < total && in.ok)
+        {
+            char value = in.byte();
+            uint64_t run = in.varint();
+            for (uint64_t i = 0; i < run && cell < total; ++i, ++cell)
+            {
+                frame.board[cell / m_cols][cell % m_cols] = value;
+            }
+        }
+
+        frame.robots.resize(m_roster.size());
+        for (auto& state : frame.robots)
+        {
+            state = in.state();
+        }
+    }
+
+    pos = in.pos;
+    return in.ok;
+}
+
+bool ReplayReader::read_turns(std::size_t& pos, ReplayFrame& frame, std::vector<ReplayTurn>* turns) const
+{
+    ReplayCursor in{m_data, m_size, pos};
+
+    if (turns)
+    {
+        turns->clear();
+    }
+
+    while (in.ok)
+    {
+        char tag = in.byte();
+        if (tag == tag_end)
+            break;
+        if (tag != tag_turn)
+            return false;
+
+        // anything out of range is a corrupt file, not something to index with
+        ReplayTurn turn;
+        uint64_t robot = in.varint();
+        unsigned char action = static_cast<unsigned char>(in.byte());
+        if (robot >= m_roster.size() || action > static_cast<unsigned char>(ReplayAction::Move))
+            return false;
+        turn.robot = static_cast<int>(robot);
+        turn.action = static_cast<ReplayAction>(action);
+        turn.radar_direction = static_cast<int>(in.signed_varint());
+        turn.radar_hits = static_cast<int>(in.varint());
+        if (turn.radar_hits > 0)
+        {
+            turn.first_hit.m_type = in.byte();
+            turn.first_hit.m_row = static_cast<int>(in.varint());
+            turn.first_hit.m_col = static_cast<int>(in.varint());
+        }
+        turn.param1 = static_cast<int>(in.signed_varint());
+        turn.param2 = static_cast<int>(in.signed_varint());
+
+        uint64_t draws = in.varint();
+        for (uint64_t i = 0; i < draws && in.ok; ++i)
+        {
+            int draw = static_cast<int>(in.varint());
+            if (turns)
+                turn.draws.push_back(draw);
+        }
+
+        uint64_t cells = in.varint();
+        for (uint64_t i = 0; i < cells && in.ok; ++i)
+        {
+            uint64_t row = in.varint();
+            uint64_t col = in.varint();
+            if (row >= static_cast<uint64_t>(m_rows) || col >= static_cast<uint64_t>(m_cols))
+                return false;
+            ReplayCell change;
+            change.row = static_cast<int>(row);
+            change.col = static_cast<int>(col);
+            change.cell = in.byte();
+            frame.board[change.row][change.col] = change.cell;
+            if (turns)
+                turn.cells.push_back(change);
+        }
+
+        uint64_t changed = in.varint();
+        for (uint64_t i = 0; i < changed && in.ok; ++i)
+        {
+            std::size_t index = in.varint();
+            RobotState state = in.state();
+            if (index < frame.robots.size())
+                frame.robots[index] = state;
+            if (turns)
+                turn.robots.emplace_back(static_cast<int>(index), state);
+        }
+
+        if (turns)
+        {
+            turns->push_back(std::move(turn));
+        }
+    }
+
+    pos = in.pos;
+    return in.ok;
+}
+
+bool ReplayReader::next_round(ReplayFrame& frame, std::vector<ReplayTurn>* turns) const
+{
+    if (frame.round >= m_rounds)
+    {
+        return false;
+    }
+
+    std::size_t pos = frame.offset;
+    if (!read_header(pos, frame) || frame.board.empty() || !read_turns(pos, frame, turns))
+    {
+        return false;
+    }
+
+    frame.round++;
+    frame.offset = pos;
+
+    // the next record starts with the hash of the state we are now in
+    ReplayCursor in{m_data, m_size, pos};
+    char tag = in.byte();
+    uint64_t hash = in.fixed64();
+    if (!in.ok || (tag != tag_round && tag != tag_keyframe))
+    {
+        return false;
+    }
+    frame.hash = hash;
+    return true;
+}
+
+bool ReplayReader::seek(int round, ReplayFrame& frame) const
+{
+    if (round < 0 || round > m_rounds)
+    {
+        return false;
+    }
+
+    // last keyframe at or before the round
+    auto it = std::upper_bound(m_index.begin(), m_index.end(),
+                               std::make_pair(static_cast<uint64_t>(round), UINT64_MAX));
+    if (it == m_index.begin())
+    {
+        return false;
+    }
+    --it;
+
+    frame.board.clear();
+    frame.round = static_cast<int>(it->first);
+    frame.offset = it->second;
+
+    // at most keyframe_every rounds of deltas
+    while (frame.round < round)
+    {
+        if (!next_round(frame, nullptr))
+            return false;
+    }
+
+    // landed exactly on a keyframe: load it without applying its turns
+    if (frame.board.empty())
+    {
+        std::size_t pos = frame.offset;
+        return read_header(pos, frame);
+    }
+    return true;
+}
+
+//---------------------------------------------------------------- playback
+
+ReplayRobot::ReplayRobot(const ReplayRobotInfo& info, const RobotState& state)
+    : RobotBase(state.move, state.armor, info.weapon), m_ran_out(false)
+{
+    m_name = info.name;
+    if (state.health < get_health())
+    {
+        take_damage(get_health() - state.health);
+    }
+    move_to(state.row, state.col);
+}
+
+void ReplayRobot::get_radar_direction(int& radar_direction)
+{
+    // radar is the first thing asked on every turn, so this is where a turn starts
+    if (m_decisions.empty())
+    {
+        m_ran_out = true;
+        m_current = ReplayDecision();
+    }
+    else
+    {
+        m_current = m_decisions.front();
+        m_decisions.pop_front();
+    }
+    radar_direction = m_current.radar_direction;
+}
+
+void ReplayRobot::process_radar_results(const std::vector<RadarObj>& radar_results)
+{
+    (void)radar_results; // the decisions are already made
+}
+
+bool ReplayRobot::get_shot_location(int& shot_row, int& shot_col)
+{
+    shot_row = m_current.shoot ? m_current.param1 : 0;
+    shot_col = m_current.shoot ? m_current.param2 : 0;
+    return m_current.shoot;
+}
+
+void ReplayRobot::get_move_direction(int& direction, int& distance)
+{
+    direction = m_current.shoot ? 0 : m_current.param1;
+    distance = m_current.shoot ? 0 : m_current.param2;
+}
+
+ReplayPlayback::ReplayPlayback()
+    : m_frame_ok(false), m_round(0), m_turn(0), m_divergence_round(-1)
+{
+}
+
+bool ReplayPlayback::open(const std::string& path)
+{
+    if (!m_reader.open(path) || !m_reader.seek(0, m_start))
+    {
+        return false;
+    }
+
+    const auto& roster = m_reader.roster();
+    m_robots.clear();
+    for (std::size_t i = 0; i < roster.size(); ++i)
+    {
+        m_robots.push_back(std::make_unique<ReplayRobot>(roster[i], m_start.robots[i]));
+        m_robots.back()->set_boundaries(m_reader.rows(), m_reader.cols());
+    }
+
+    // hand every robot its decisions and queue up the engine's draws
+    ReplayFrame frame = m_start;
+    std::vector<ReplayTurn> turns;
+    while (frame.round < m_reader.rounds())
+    {
+        if (!m_reader.next_round(frame, &turns))
+        {
+            std::cerr << "Replay is damaged at round " << frame.round << ": " << path << std::endl;
+            return false;
+        }
+        for (const ReplayTurn& turn : turns)
+        {
+            if (turn.action != ReplayAction::Out && turn.robot < static_cast<int>(m_robots.size()))
+            {
+                ReplayDecision decision;
+                decision.radar_direction = turn.radar_direction;
+                decision.shoot = (turn.action == ReplayAction::Shot);
+                decision.param1 = turn.param1;
+                decision.param2 = turn.param2;
+                m_robots[turn.robot]->add_decision(decision);
+            }
+            m_draws.insert(m_draws.end(), turn.draws.begin(), turn.draws.end());
+        }
+    }
+
+    m_frame = m_start;
+    m_frame_ok = true;
+    m_round = 0;
+    m_divergence_round = -1;
+    m_divergence.clear();
+    return true;
+}
+
+std::vector<RobotBase*> ReplayPlayback::robots() const
+{
+    std::vector<RobotBase*> robots;
+    for (const auto& robot : m_robots)
+    {
+        robots.push_back(robot.get());
+    }
+    return robots;
+}
+
+void ReplayPlayback::diverge(int round, const std::string& what)
+{
+    // only the first one matters, everything after it follows from it
+    if (!diverged())
+    {
+        m_divergence_round = round;
+        m_divergence = what;
+    }
+}
+
+bool ReplayPlayback::next_draw(int n, int& value)
+{
+    if (m_draws.empty())
+    {
+        diverge(m_round, "the engine drew more random numbers than the recording has");
+        return false;
+    }
+    value = m_draws.front();
+    m_draws.pop_front();
+    if (value >= n)
+    {
+        diverge(m_round, "recorded draw " + std::to_string(value) + " is out of range for below(" +
+                         std::to_string(n) + ")");
+        return false;
+    }
+    return true;
+}
+
+// what differs between the game and the recording, empty when nothing does
+static std::string describe_difference(const std::vector<std::vector<char>>& board,
+                                       const std::vector<RobotBase*>& robots, const ReplayFrame& recorded)
+{
+    for (std::size_t row = 0; row < board.size() && row < recorded.board.size(); ++row)
+    {
+        for (std::size_t col = 0; col < board[row].size() && col < recorded.board[row].size(); ++col)
+        {
+            if (board[row][col] != recorded.board[row][col])
+            {
+                return "cell (" + std::to_string(row) + "," + std::to_string(col) + ") is '" +
+                       board[row][col] + "', recorded '" + recorded.board[row][col] + "'";
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < robots.size() && i < recorded.robots.size(); ++i)
+    {
+        RobotState state = read_robot_state(robots[i]);
+        const RobotState& expected = recorded.robots[i];
+        if (!(state == expected))
+        {
+            return robots[i]->m_name + " has health " + std::to_string(state.health) + " armor " +
+                   std::to_string(state.armor) + " at (" + std::to_string(state.row) + "," +
+                   std::to_string(state.col) + "), recorded health " + std::to_string(expected.health) +
+                   " armor " + std::to_string(expected.armor) + " at (" + std::to_string(expected.row) + "," +
+                   std::to_string(expected.col) + ")";
+        }
+    }
+    return "";
+}
+
+void ReplayPlayback::check_round(int round, const std::vector<std::vector<char>>& board,
+                                 const std::vector<RobotBase*>& robots)
+{
+    m_round = round;
+    m_turns.clear();
+    m_turn = 0;
+    if (diverged() || !m_frame_ok)
+    {
+        return;
+    }
+
+    for (const auto& robot : m_robots)
+    {
+        if (robot->ran_out())
+        {
+            diverge(round - 1, robot->m_name + " was asked for more turns than it played");
+            return;
+        }
+    }
+
+    // bring the recording up to this round
+    while (m_frame.round < round && m_frame_ok)
+    {
+        m_frame_ok = m_reader.next_round(m_frame, nullptr);
+    }
+    if (!m_frame_ok || m_frame.round != round)
+    {
+        diverge(round, "the recording ends after " + std::to_string(m_reader.rounds()) + " rounds");
+        return;
+    }
+
+    if (replay_state_hash(board, robots) != m_frame.hash)
+    {
+        std::string what = describe_difference(board, robots, m_frame);
+        diverge(round, "state hash differs" + (what.empty() ? std::string() : ": " + what));
+        return;
+    }
+
+    // this round's turns, to check the game after each one
+    if (round < m_reader.rounds())
+    {
+        m_turn_frame = m_frame;
+        ReplayFrame next = m_frame;
+        if (!m_reader.next_round(next, &m_turns))
+        {
+            m_turns.clear();
+        }
+    }
+}
+
+void ReplayPlayback::check_turn(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots)
+{
+    if (diverged() || m_turn >= m_turns.size())
+    {
+        return;
+    }
+
+    const ReplayTurn& turn = m_turns[m_turn++];
+    for (const ReplayCell& cell : turn.cells)
+    {
+        if (cell.row >= 0 && cell.row < static_cast<int>(m_turn_frame.board.size()) &&
+            cell.col >= 0 && cell.col < static_cast<int>(m_turn_frame.board[cell.row].size()))
+        {
+            m_turn_frame.board[cell.row][cell.col] = cell.cell;
+        }
+    }
+    for (const auto& [index, state] : turn.robots)
+    {
+        if (index >= 0 && index < static_cast<int>(m_turn_frame.robots.size()))
+            m_turn_frame.robots[index] = state;
+    }
+
+    std::string what = describe_difference(board, robots, m_turn_frame);
+    if (!what.empty())
+    {
+        static const char* actions[] = {"out", "shot", "move"};
+        int action = static_cast<int>(turn.action);
+        std::string name = turn.robot >= 0 && turn.robot < static_cast<int>(m_robots.size()) ?
+                           m_robots[turn.robot]->m_name : "?";
+        diverge(m_round, "after the turn of " + name + " (" + (action >= 0 && action < 3 ? actions[action] : "?") + " " +
+                         std::to_string(turn.param1) + "," + std::to_string(turn.param2) + "): " + what);
+    }
+}
+
+// call after check_round() for the final state
+void ReplayPlayback::finish(int rounds, int winner)
+{
+    if (rounds != m_reader.rounds())
+    {
+        diverge(rounds, "the game ran " + std::to_string(rounds) + " rounds, recorded " +
+                        std::to_string(m_reader.rounds()));
+    }
+    else if (winner != m_reader.winner())
+    {
+        diverge(rounds, "winner is robot " + std::to_string(winner) + ", recorded " +
+                        std::to_string(m_reader.winner()));
+    }
+    else if (!m_draws.empty())
+    {
+        diverge(rounds, std::to_string(m_draws.size()) + " recorded random draws were never used");
+    }
+}
@@ -0,0 +1,264 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "RobotBase.h"
+#include "RadarObj.h"
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary replays of a game.
+//
+// File layout (little endian):
+//
+//     header    fixed size, see ReplayHeader
+//     roster    per robot: tag, weapon, name
+//     stream    one record per round. every keyframe_every rounds the record starts
+//               with the whole board (run length encoded) and every robot's state.
+//               every record starts with a hash of the board and robots at the
+//               start of the round, and goes on with one delta per robot turn: radar direction and first hit,
+//               the action taken, the engine's random draws, the cells that changed
+//               and the robots whose state changed (which is where damage shows up).
+//               a last record holds only the hash of the final state.
+//     index     (round, offset) of every keyframe
+//
+// Numbers in the roster and stream are LEB128 varints, so a quiet turn costs a
+// handful of bytes. The reader maps the file and seeks by jumping to the nearest
+// keyframe through the index, then applying at most keyframe_every rounds of deltas.
+//
+// A turn holds everything the robot decided (radar direction, shot or move and its
+// parameters) and every random number the engine drew, so a game can be played
+// again by ReplayPlayback without loading any robot code.
+
+// what the engine knows about a robot (the private parts of RobotBase)
+struct RobotState
+{
+    int health = 0;
+    int armor = 0;
+    int move = 0;
+    int grenades = 0;
+    int row = 0;
+    int col = 0;
+
+    bool operator==(const RobotState& other) const = default;
+};
+
+RobotState read_robot_state(RobotBase* robot);
+
+// FNV-1a over the board and the robot states, stored for every round
+uint64_t replay_state_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotState>& robots);
+uint64_t replay_state_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots);
+
+enum class ReplayAction
+{
+    Out,    // robot is dead, it only gets its 'X' put back
+    Shot,
+    Move
+};
+
+struct ReplayCell
+{
+    int row;
+    int col;
+    char cell;
+};
+
+struct ReplayTurn
+{
+    int robot = 0;
+    ReplayAction action = ReplayAction::Out;
+    int radar_direction = 0;
+    int radar_hits = 0;
+    RadarObj first_hit;
+    int param1 = 0;   // shot row, or move direction
+    int param2 = 0;   // shot column, or move distance asked for
+    std::vector<int> draws;         // engine random numbers, in the order they were drawn
+    std::vector<ReplayCell> cells;
+    std::vector<std::pair<int, RobotState>> robots; // robots whose state changed
+};
+
+struct ReplayRobotInfo
+{
+    std::string name;
+    char tag;
+    WeaponType weapon;
+};
+
+// board and robots at the start of a round
+struct ReplayFrame
+{
+    int round = 0;
+    std::vector<std::vector<char>> board;
+    std::vector<RobotState> robots;
+    uint64_t hash = 0;      // recorded state hash, see replay_state_hash()
+    std::size_t offset = 0; // where this round's record starts in the file
+};
+
+class ReplayWriter
+{
+public:
+
+    ReplayWriter(const std::string& path, int keyframe_every);
+    ~ReplayWriter();
+
+    bool is_open() const { return m_file.is_open(); }
+
+    void begin_game(uint64_t seed, const std::vector<std::vector<char>>& board,
+                    const std::vector<RobotBase*>& robots, const char* robot_tags);
+    void begin_round(int round, const std::vector<std::vector<char>>& board,
+                     const std::vector<RobotBase*>& robots);
+
+    // a turn: the cells that change in between are noted with cell_changed()
+    void begin_turn(int robot_index, const std::vector<RobotBase*>& robots);
+    void cell_changed(int row, int col, char cell);
+    void random_draw(int value);
+    void end_turn(ReplayTurn& turn, const std::vector<RobotBase*>& robots);
+
+    // rounds played, the winner's index or -1, and the final state
+    void end_game(int rounds, int winner, const std::vector<std::vector<char>>& board,
+                  const std::vector<RobotBase*>& robots);
+
+    std::size_t bytes_written() const { return m_written + m_out.size(); }
+
+private:
+
+    void end_round();
+    void flush_buffer();
+
+    std::ofstream m_file;
+    std::string m_out;
+    std::size_t m_written;
+    int m_keyframe_every;
+    int m_rows, m_cols, m_robot_count;
+    uint64_t m_seed;
+    bool m_in_round;
+
+    std::vector<std::pair<uint64_t, uint64_t>> m_index;  // keyframe round, offset
+    std::vector<RobotState> m_before;                    // robot states when the turn began
+    std::vector<ReplayCell> m_cells;
+    std::vector<int> m_draws;
+};
+
+class ReplayReader
+{
+public:
+
+    ReplayReader();
+    ~ReplayReader();
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    bool open(const std::string& path);
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    uint64_t seed() const { return m_seed; }
+    int rounds() const { return m_rounds; }
+    int winner() const { return m_winner; }
+    int keyframe_every() const { return m_keyframe_every; }
+    const std::vector<ReplayRobotInfo>& roster() const { return m_roster; }
+    std::size_t file_size() const { return m_size; }
+
+    // board and robots at the start of round (0 .. rounds()). false if out of range.
+    bool seek(int round, ReplayFrame& frame) const;
+
+    // read the turns of frame.round and move the frame on to the next round
+    bool next_round(ReplayFrame& frame, std::vector<ReplayTurn>* turns) const;
+
+private:
+
+    bool read_header(std::size_t& pos, ReplayFrame& frame) const;
+    bool read_turns(std::size_t& pos, ReplayFrame& frame, std::vector<ReplayTurn>* turns) const;
+
+    const unsigned char* m_data;
+    std::size_t m_size;
+    int m_rows, m_cols, m_rounds, m_winner, m_keyframe_every;
+    uint64_t m_seed;
+    std::vector<ReplayRobotInfo> m_roster;
+    std::vector<std::pair<uint64_t, uint64_t>> m_index;
+};
+
+// what a robot decided on one turn
+struct ReplayDecision
+{
+    int radar_direction = 0;
+    bool shoot = false;
+    int param1 = 0;
+    int param2 = 0;
+};
+
+// stands in for a recorded robot and makes the same decisions again, in order
+class ReplayRobot : public RobotBase
+{
+public:
+
+    ReplayRobot(const ReplayRobotInfo& info, const RobotState& state);
+
+    void add_decision(const ReplayDecision& decision) { m_decisions.push_back(decision); }
+    bool ran_out() const { return m_ran_out; }
+
+    void get_radar_direction(int& radar_direction) override;
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override;
+    bool get_shot_location(int& shot_row, int& shot_col) override;
+    void get_move_direction(int& direction, int& distance) override;
+
+private:
+
+    std::deque<ReplayDecision> m_decisions;
+    ReplayDecision m_current;
+    bool m_ran_out;
+};
+
+// Plays a recorded game again with ReplayRobots and the recorded random draws.
+// The state hash is checked at the start of every round and the board and robots
+// after every turn, so a divergence is pinned to the turn that caused it. Used to
+// check engine changes against old games (make verify).
+class ReplayPlayback
+{
+public:
+
+    ReplayPlayback();
+
+    bool open(const std::string& path);
+    const ReplayReader& reader() const { return m_reader; }
+
+    // board at the start of the game, and the stand-ins in roster order
+    const std::vector<std::vector<char>>& start_board() const { return m_start.board; }
+    std::vector<RobotBase*> robots() const;
+
+    // the next recorded draw for below(n). false when the engine asks for more
+    // draws than were recorded, or a draw that doesn't fit.
+    bool next_draw(int n, int& value);
+
+    void check_round(int round, const std::vector<std::vector<char>>& board,
+                     const std::vector<RobotBase*>& robots);
+    void check_turn(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots);
+    void finish(int rounds, int winner);
+
+    bool diverged() const { return m_divergence_round >= 0; }
+    int divergence_round() const { return m_divergence_round; }
+    const std::string& divergence() const { return m_divergence; }
+
+private:
+
+    void diverge(int round, const std::string& what);
+
+    ReplayReader m_reader;
+    ReplayFrame m_start;
+    ReplayFrame m_frame;        // the recording at the start of the round being played
+    bool m_frame_ok;
+    int m_round;                // round being played
+    std::vector<ReplayTurn> m_turns;
+    std::size_t m_turn;         // next turn to check
+    ReplayFrame m_turn_frame;   // the recording after the turns checked so far
+    std::vector<std::unique_ptr<ReplayRobot>> m_robots;
+    std::deque<int> m_draws;
+    int m_divergence_round;
+    std::string m_divergence;
+};
+
+#endif
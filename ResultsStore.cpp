@@ -0,0 +1,591 @@
+#include "ResultsStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+
+static const char results_magic[4] = {'R', 'W', 'R', 'S'};
+static const uint64_t results_version = 1;
+static const std::size_t flush_bytes = 1 << 16;
+
+static uint64_t fnv_add(uint64_t hash, const char* data, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static const uint64_t fnv_basis = 14695981039346656037ULL;
+
+uint64_t robot_source_hash(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return 0;
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return fnv_add(fnv_basis, source.data(), source.size());
+}
+
+uint64_t text_hash(const std::string& text)
+{
+    return fnv_add(fnv_basis, text.data(), text.size());
+}
+
+static void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void put_u64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+// reads numbers out of a record, ok goes false past the end
+struct RecordReader
+{
+    const std::string& data;
+    std::size_t pos;
+    std::size_t end;
+    bool ok = true;
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= end)
+            {
+                ok = false;
+                return 0;
+            }
+            unsigned char byte = static_cast<unsigned char>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok = false;
+        return value;
+    }
+
+    uint64_t u64()
+    {
+        if (end - pos < 8)
+        {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        }
+        return value;
+    }
+};
+
+ResultsStore::~ResultsStore()
+{
+    flush();
+}
+
+bool ResultsStore::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_path = path;
+    m_open = false;
+
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    if (data.empty())
+    {
+        std::string header(results_magic, sizeof(results_magic));
+        put_varint(header, results_version);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.write(header.data(), header.size()))
+        {
+            std::cerr << "Failed to create results file: " << path << std::endl;
+            return false;
+        }
+        m_open = true;
+        return true;
+    }
+
+    if (data.size() < sizeof(results_magic) || data.compare(0, sizeof(results_magic), results_magic, sizeof(results_magic)) != 0)
+    {
+        std::cerr << "Not a results file: " << path << std::endl;
+        return false;
+    }
+    RecordReader header{data, sizeof(results_magic), data.size()};
+    if (header.varint() != results_version)
+    {
+        std::cerr << "Results file version not supported: " << path << std::endl;
+        return false;
+    }
+
+    std::size_t pos = header.pos;
+    while (pos < data.size())
+    {
+        RecordReader length{data, pos, data.size()};
+        uint64_t size = length.varint();
+        if (!length.ok || size == 0 || data.size() - length.pos < size + 4)
+        {
+            // the process died writing it: cut it off and carry on after the last whole one
+            std::cerr << "Results file " << path << " ends in a torn record, dropping its " << data.size() - pos
+                      << " bytes" << std::endl;
+            std::error_code error;
+            std::filesystem::resize_file(path, pos, error);
+            break;
+        }
+
+        uint64_t check = fnv_add(fnv_basis, data.data() + length.pos, size);
+        uint64_t written = 0;
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            written |= static_cast<uint64_t>(static_cast<unsigned char>(data[length.pos + size + i])) << (8 * i);
+        }
+        if (written != (check & 0xffffffffu))
+        {
+            std::cerr << "Results file " << path << " is corrupt at byte " << pos << std::endl;
+            return false;
+        }
+
+        RecordReader body{data, length.pos + 1, length.pos + size};
+        char kind = data[length.pos];
+        if (kind == 'R')
+        {
+            uint64_t source = body.u64();
+            std::string name = data.substr(body.pos, body.end - body.pos);
+            add_robot(source, name);
+        }
+        else if (kind == 'G')
+        {
+            GameRecord record;
+            record.seed = body.varint();
+            record.rows = static_cast<int>(body.varint());
+            record.cols = static_cast<int>(body.varint());
+            record.max_rounds = static_cast<int>(body.varint());
+            record.obstacle_density = static_cast<int>(body.varint());
+            record.rounds = static_cast<int>(body.varint());
+            uint64_t flags = body.varint();
+            record.draw = flags & 1;
+            record.out_of_rounds = flags & 2;
+            uint64_t robots = body.varint();
+            for (uint64_t i = 0; i < robots && body.ok; ++i)
+            {
+                GamePlacement placement;
+                placement.robot = static_cast<int>(body.varint());
+                placement.placement = static_cast<int>(body.varint());
+                placement.damage_dealt = static_cast<int>(body.varint());
+                placement.damage_taken = static_cast<int>(body.varint());
+                if (placement.robot < 0 || placement.robot >= static_cast<int>(m_robots.size()))
+                    body.ok = false;
+                record.robots.push_back(placement);
+            }
+            record.rules = body.u64();
+            record.winner = static_cast<int>(body.varint()) - 1;
+            if (record.winner >= static_cast<int>(record.robots.size()))
+                body.ok = false;
+            if (!body.ok)
+            {
+                std::cerr << "Results file " << path << " has a bad game at byte " << pos << std::endl;
+                return false;
+            }
+            record.game = m_games.size();
+            add_game(record);
+        }
+        // anything else is from a later version that only added kinds, skip it
+
+        pos = length.pos + size + 4;
+    }
+
+    m_open = true;
+    return true;
+}
+
+bool ResultsStore::flush()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if (!m_open || m_pending.empty())
+    {
+        return true;
+    }
+    std::ofstream out(m_path, std::ios::binary | std::ios::app);
+    if (!out.write(m_pending.data(), m_pending.size()) || !out.flush())
+    {
+        std::cerr << "Failed to write results file: " << m_path << std::endl;
+        return false;
+    }
+    m_pending.clear();
+    return true;
+}
+
+void ResultsStore::append(char kind, const std::string& body)
+{
+    if (!m_open)
+    {
+        return;
+    }
+    std::string record(1, kind);
+    record += body;
+    put_varint(m_pending, record.size());
+    m_pending += record;
+    uint64_t check = fnv_add(fnv_basis, record.data(), record.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        m_pending.push_back(static_cast<char>(check >> (8 * i)));
+    }
+
+    if (m_pending.size() >= flush_bytes)
+    {
+        std::ofstream out(m_path, std::ios::binary | std::ios::app);
+        if (!out.write(m_pending.data(), m_pending.size()))
+        {
+            std::cerr << "Failed to write results file: " << m_path << std::endl;
+        }
+        m_pending.clear();
+    }
+}
+
+int ResultsStore::robot(uint64_t source, const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto found = m_by_source.find(source);
+    if (found != m_by_source.end())
+    {
+        return found->second;
+    }
+
+    std::string body;
+    put_u64(body, source);
+    body += name;
+    append('R', body);
+    return add_robot(source, name);
+}
+
+int ResultsStore::add_robot(uint64_t source, const std::string& name)
+{
+    auto found = m_by_source.find(source);
+    if (found != m_by_source.end())
+    {
+        return found->second;
+    }
+    RobotRecord robot;
+    robot.source = source;
+    robot.name = name;
+    robot.rating = initial_rating;
+    m_robots.push_back(robot);
+    m_by_robot.emplace_back();
+    m_by_source[source] = static_cast<int>(m_robots.size()) - 1;
+    return static_cast<int>(m_robots.size()) - 1;
+}
+
+void ResultsStore::add(GameRecord record)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    record.game = m_games.size();
+
+    std::string body;
+    put_varint(body, record.seed);
+    put_varint(body, record.rows);
+    put_varint(body, record.cols);
+    put_varint(body, record.max_rounds);
+    put_varint(body, record.obstacle_density);
+    put_varint(body, record.rounds);
+    put_varint(body, (record.draw ? 1 : 0) | (record.out_of_rounds ? 2 : 0));
+    put_varint(body, record.robots.size());
+    for (const GamePlacement& placement : record.robots)
+    {
+        put_varint(body, placement.robot);
+        put_varint(body, placement.placement);
+        put_varint(body, std::max(0, placement.damage_dealt));
+        put_varint(body, std::max(0, placement.damage_taken));
+    }
+    put_u64(body, record.rules);
+    put_varint(body, record.winner + 1);
+    append('G', body);
+    add_game(record);
+}
+
+// counts, indexes and rates one game, from add() or the file
+void ResultsStore::add_game(const GameRecord& record)
+{
+    const uint32_t index = static_cast<uint32_t>(m_games.size());
+    StoredGame game;
+    game.seed = record.seed;
+    game.rules = record.rules;
+    game.rows = record.rows;
+    game.cols = record.cols;
+    game.max_rounds = record.max_rounds;
+    game.rounds = record.rounds;
+    game.obstacle_density = static_cast<uint8_t>(record.obstacle_density);
+    game.flags = (record.draw ? 1 : 0) | (record.out_of_rounds ? 2 : 0);
+    game.robots = static_cast<uint16_t>(record.robots.size());
+    game.winner = static_cast<int16_t>(record.winner);
+    game.first = static_cast<uint32_t>(m_placements.size());
+    m_games.push_back(game);
+    m_placements.insert(m_placements.end(), record.robots.begin(), record.robots.end());
+
+    if (record.rules)
+    {
+        std::vector<uint64_t> sources;
+        for (const GamePlacement& placement : record.robots)
+        {
+            sources.push_back(m_robots[placement.robot].source);
+        }
+        m_by_key[game_key(record, sources)] = index;
+    }
+
+    const std::size_t count = record.robots.size();
+
+    std::vector<double> change(count, 0.0);
+    for (std::size_t a = 0; a < count; ++a)
+    {
+        const GamePlacement& mine = record.robots[a];
+        RobotRecord& robot = m_robots[mine.robot];
+        ++robot.games;
+        robot.wins += record.winner == static_cast<int>(a) ? 1 : 0;
+        robot.damage_dealt += std::max(0, mine.damage_dealt);
+        robot.damage_taken += std::max(0, mine.damage_taken);
+        if (m_by_robot[mine.robot].empty() || m_by_robot[mine.robot].back() != index)
+            m_by_robot[mine.robot].push_back(index);
+
+        for (std::size_t b = a + 1; b < count; ++b)
+        {
+            const GamePlacement& theirs = record.robots[b];
+            if (theirs.robot == mine.robot)
+                continue;
+            uint64_t pair = static_cast<uint64_t>(std::min(mine.robot, theirs.robot)) << 32 |
+                            static_cast<uint32_t>(std::max(mine.robot, theirs.robot));
+            std::vector<uint32_t>& between = m_by_pair[pair];
+            if (between.empty() || between.back() != index)
+                between.push_back(index);
+
+            // each pair is a game of its own, worth 1/(n-1) of K
+            double expected = 1.0 / (1.0 + std::pow(10.0, (m_robots[theirs.robot].rating - robot.rating) / 400.0));
+            double score = mine.placement < theirs.placement ? 1.0 : mine.placement == theirs.placement ? 0.5 : 0.0;
+            double step = k_factor / (count - 1) * (score - expected);
+            change[a] += step;
+            change[b] -= step;
+        }
+    }
+    for (std::size_t a = 0; a < count; ++a)
+    {
+        m_robots[record.robots[a].robot].rating += change[a];
+    }
+}
+
+int ResultsStore::find_robot(uint64_t source) const
+{
+    auto found = m_by_source.find(source);
+    return found == m_by_source.end() ? -1 : found->second;
+}
+
+int ResultsStore::find_robot(const std::string& name) const
+{
+    int best = -1;
+    for (std::size_t i = 0; i < m_robots.size(); ++i)
+    {
+        if (m_robots[i].name == name && (best < 0 || m_robots[i].games > m_robots[best].games))
+            best = static_cast<int>(i);
+    }
+    return best;
+}
+
+uint64_t ResultsStore::game_key(const GameRecord& game, const std::vector<uint64_t>& sources)
+{
+    std::string key;
+    put_u64(key, game.rules);
+    put_u64(key, game.seed);
+    put_varint(key, game.rows);
+    put_varint(key, game.cols);
+    put_varint(key, game.max_rounds);
+    put_varint(key, game.obstacle_density);
+    for (uint64_t source : sources)
+    {
+        put_u64(key, source);
+    }
+    return fnv_add(fnv_basis, key.data(), key.size());
+}
+
+bool ResultsStore::find_game(uint64_t key, GameRecord& game)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    auto found = m_by_key.find(key);
+    if (found == m_by_key.end())
+    {
+        return false;
+    }
+    game = this->game(found->second);
+    return true;
+}
+
+GameRecord ResultsStore::game(uint64_t index) const
+{
+    const StoredGame& game = m_games[index];
+    GameRecord record;
+    record.game = index;
+    record.seed = game.seed;
+    record.rules = game.rules;
+    record.rows = game.rows;
+    record.cols = game.cols;
+    record.max_rounds = game.max_rounds;
+    record.obstacle_density = game.obstacle_density;
+    record.rounds = game.rounds;
+    record.draw = game.flags & 1;
+    record.out_of_rounds = game.flags & 2;
+    record.winner = game.winner;
+    record.robots.assign(m_placements.begin() + game.first, m_placements.begin() + game.first + game.robots);
+    return record;
+}
+
+const std::vector<uint32_t>& ResultsStore::games_of(int robot) const
+{
+    static const std::vector<uint32_t> none;
+    return robot >= 0 && robot < static_cast<int>(m_by_robot.size()) ? m_by_robot[robot] : none;
+}
+
+const std::vector<uint32_t>& ResultsStore::games_between(int robot, int other) const
+{
+    static const std::vector<uint32_t> none;
+    if (robot < 0 || other < 0)
+    {
+        return none;
+    }
+    auto found = m_by_pair.find(static_cast<uint64_t>(std::min(robot, other)) << 32 |
+                                static_cast<uint32_t>(std::max(robot, other)));
+    return found == m_by_pair.end() ? none : found->second;
+}
+
+HeadToHead ResultsStore::head_to_head(int robot, int other) const
+{
+    HeadToHead result;
+    for (uint32_t index : games_between(robot, other))
+    {
+        const StoredGame& game = m_games[index];
+        int mine = 0, theirs = 0;
+        for (uint32_t i = game.first; i < game.first + game.robots; ++i)
+        {
+            if (m_placements[i].robot == robot)
+                mine = m_placements[i].placement;
+            else if (m_placements[i].robot == other)
+                theirs = m_placements[i].placement;
+        }
+        ++result.games;
+        if (mine < theirs)
+            ++result.wins;
+        else if (mine > theirs)
+            ++result.losses;
+        else
+            ++result.draws;
+    }
+    return result;
+}
+
+std::vector<int> ResultsStore::ladder() const
+{
+    std::vector<int> order(m_robots.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [this](int a, int b) { return m_robots[a].rating > m_robots[b].rating; });
+    return order;
+}
+
+ResultsStore* shared_results_store(const std::string& path)
+{
+    static std::mutex lock;
+    static std::map<std::string, std::unique_ptr<ResultsStore>> stores;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = stores.find(path);
+    if (found == stores.end())
+    {
+        auto store = std::make_unique<ResultsStore>();
+        if (!store->open(path))
+        {
+            store.reset(); // said why once, the games carry on without it
+        }
+        found = stores.emplace(path, std::move(store)).first;
+    }
+    return found->second.get();
+}
+
+// name and the start of the source hash, so two versions of a robot can be told apart
+static std::string robot_label(const RobotRecord& robot)
+{
+    char hash[16];
+    std::snprintf(hash, sizeof(hash), "%08llx", static_cast<unsigned long long>(robot.source >> 32));
+    return robot.name.substr(0, 20) + " " + hash;
+}
+
+std::string format_ratings(const ResultsStore& store, std::size_t top)
+{
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-34s %7s %9s %9s %9s %9s\n",
+                  ("Ratings after " + std::to_string(store.game_count()) + " games").c_str(), "rating", "games",
+                  "wins", "dealt", "taken");
+    out += line;
+    std::size_t rank = 0;
+    for (int robot : store.ladder())
+    {
+        if (top && rank == top)
+            break;
+        const RobotRecord& record = store.robot_record(robot);
+        double games = record.games ? static_cast<double>(record.games) : 1.0;
+        std::snprintf(line, sizeof(line), "%3zu. %-29s %7.1f %9llu %9llu %9.1f %9.1f\n", ++rank,
+                      robot_label(record).c_str(), record.rating, static_cast<unsigned long long>(record.games),
+                      static_cast<unsigned long long>(record.wins), record.damage_dealt / games,
+                      record.damage_taken / games);
+        out += line;
+    }
+    return out;
+}
+
+std::string format_head_to_head(const ResultsStore& store, int robot)
+{
+    const RobotRecord& record = store.robot_record(robot);
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%s, rating %.1f, %llu games\n", robot_label(record).c_str(), record.rating,
+                  static_cast<unsigned long long>(record.games));
+    out += line;
+    std::snprintf(line, sizeof(line), "  %-29s %7s %9s %9s %9s %9s\n", "against", "rating", "games", "wins", "losses",
+                  "draws");
+    out += line;
+    for (int other : store.ladder())
+    {
+        HeadToHead result = store.head_to_head(robot, other);
+        if (other == robot || result.games == 0)
+            continue;
+        std::snprintf(line, sizeof(line), "  %-29s %7.1f %9llu %9llu %9llu %9llu\n",
+                      robot_label(store.robot_record(other)).c_str(), store.robot_record(other).rating,
+                      static_cast<unsigned long long>(result.games), static_cast<unsigned long long>(result.wins),
+                      static_cast<unsigned long long>(result.losses), static_cast<unsigned long long>(result.draws));
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,193 @@
+#ifndef __RESULTSSTORE_H__
+#define __RESULTSSTORE_H__
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every game's result, kept for good in one append-only file, with Elo ratings
+// worked out as the results come in.
+//
+// A robot is its source: the FNV-1a hash of Robot_<name>.cpp. Change a line and
+// it is a new robot with a rating of its own, the old one keeps its games.
+// Robots with no source file (the tests' robots) go by a hash of the name.
+//
+// File layout (little endian):
+//
+//     "RWRS", version
+//     records   length (varint), kind, body, check (4 bytes of FNV-1a of kind
+//               and body). kind 'R' is a robot: source hash (8 bytes), name.
+//               kind 'G' is a game, numbers all varints: seed, rows, cols,
+//               max rounds, obstacle density, rounds, flags (1 a draw, 2 it
+//               hit MaxRounds), robots, then per robot its number in the order
+//               the 'R' records came, its placement, damage dealt and taken,
+//               then the engine rules hash (8 bytes) and last the winner's
+//               position in the game plus 1, 0 for nobody.
+//
+// A two robot game is about 36 bytes, 8 of them the rules hash. Opening a
+// store reads the whole file, rates every game again and builds the indexes,
+// which for a million games is a second or two; a torn last record (the
+// process died mid write) is cut off.
+//
+// A game is the same game again when the rules, seed, board and robots in
+// turn order all are (game_key()), so a tournament can take a result from the
+// store instead of playing it. Games added with rules 0 are never taken.
+//
+// Ratings are Elo, with a game of n robots counted as each of them playing
+// every other one: whoever placed better won, equal places drew, and each of
+// those counts 1/(n-1) of the K factor.
+
+// FNV-1a of the file, 0 if it can't be read
+uint64_t robot_source_hash(const std::string& path);
+
+// FNV-1a of some text: the name of a robot with no source, the rules
+uint64_t text_hash(const std::string& text);
+
+// who was in a game and how they did. placement 1 is the winner, robots that
+// died in the same round share a place, and so do all the survivors of a game
+// nobody won.
+struct GamePlacement
+{
+    int robot = 0;  // ResultsStore::robot()
+    int placement = 1;
+    int damage_dealt = 0;
+    int damage_taken = 0;
+};
+
+struct GameRecord
+{
+    uint64_t game = 0;      // set by the store: games in it before this one
+    uint64_t seed = 0;
+    uint64_t rules = 0;       // Arena::rules_hash()
+    int rows = 0;
+    int cols = 0;
+    int max_rounds = 0;
+    int obstacle_density = 0; // ObstacleDensity as a number
+    int rounds = 0;
+    bool draw = false;        // RepetitionDraw or a stalemate
+    bool out_of_rounds = false;
+    int winner = -1;          // a position in robots, -1 for nobody (GameResult::winner)
+    std::vector<GamePlacement> robots;
+};
+
+// everything about one robot in the store
+struct RobotRecord
+{
+    uint64_t source = 0;
+    std::string name;
+    double rating = 0;
+    uint64_t games = 0;
+    uint64_t wins = 0;      // GameRecord::winner
+    uint64_t damage_dealt = 0;
+    uint64_t damage_taken = 0;
+};
+
+// a robot's games against one other
+struct HeadToHead
+{
+    uint64_t games = 0;
+    uint64_t wins = 0;   // placed better
+    uint64_t losses = 0;
+    uint64_t draws = 0;
+};
+
+class ResultsStore
+{
+public:
+
+    static constexpr double initial_rating = 1500;
+    static constexpr double k_factor = 16;
+
+    ResultsStore() = default;
+    ~ResultsStore();
+
+    ResultsStore(const ResultsStore&) = delete;
+    ResultsStore& operator=(const ResultsStore&) = delete;
+
+    // reads what is in path (if anything) and appends to it from then on.
+    // false, with why on stderr, if it isn't a results file or can't be written.
+    bool open(const std::string& path);
+
+    // writes out what is buffered. add() does every so often and the
+    // destructor at the end.
+    bool flush();
+
+    // the robot's number, added to the store if it is new. thread safe.
+    int robot(uint64_t source, const std::string& name);
+
+    // rates the game, indexes it and appends it. thread safe, the queries below
+    // are not while games are being added.
+    void add(GameRecord record);
+
+    // what identifies a game: its rules, seed and board, and the source hashes
+    // of its robots in turn order
+    static uint64_t game_key(const GameRecord& game, const std::vector<uint64_t>& sources);
+
+    // the latest game with this key. thread safe, for looking up while adding.
+    bool find_game(uint64_t key, GameRecord& game);
+
+    std::size_t robot_count() const { return m_robots.size(); }
+    const RobotRecord& robot_record(int robot) const { return m_robots[robot]; }
+
+    // -1 if there is no such robot. by name, the one with the most games.
+    int find_robot(uint64_t source) const;
+    int find_robot(const std::string& name) const;
+
+    uint64_t game_count() const { return m_games.size(); }
+    GameRecord game(uint64_t index) const;
+
+    // game indices, oldest first
+    const std::vector<uint32_t>& games_of(int robot) const;
+    const std::vector<uint32_t>& games_between(int robot, int other) const;
+
+    HeadToHead head_to_head(int robot, int other) const;
+
+    // robot numbers, best rating first
+    std::vector<int> ladder() const;
+
+private:
+
+    // a game as it is kept in memory, the placements are in m_placements
+    struct StoredGame
+    {
+        uint64_t seed;
+        uint64_t rules;
+        int32_t rows, cols, max_rounds, rounds;
+        uint8_t obstacle_density, flags;
+        uint16_t robots;
+        int16_t winner;
+        uint32_t first;
+    };
+
+    int add_robot(uint64_t source, const std::string& name);
+    void add_game(const GameRecord& record);
+    void append(char kind, const std::string& body);
+
+    std::mutex m_lock;
+    std::string m_path;
+    std::string m_pending;   // records not written yet
+    bool m_open = false;
+
+    std::vector<RobotRecord> m_robots;
+    std::unordered_map<uint64_t, int> m_by_source;
+    std::vector<StoredGame> m_games;
+    std::vector<GamePlacement> m_placements;
+    std::vector<std::vector<uint32_t>> m_by_robot;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_by_pair; // lower robot << 32 | higher
+    std::unordered_map<uint64_t, uint32_t> m_by_key;                // game_key()
+};
+
+// the one store for path in this process, opened the first time. every game
+// with ResultsFile set adds to it, from any thread. null if it can't be opened.
+ResultsStore* shared_results_store(const std::string& path);
+
+// the ladder: rank, robot, rating, games, wins, damage dealt and taken a game.
+// top 0 for everyone.
+std::string format_ratings(const ResultsStore& store, std::size_t top = 0);
+
+// one robot against everyone it has played, best rating first
+std::string format_head_to_head(const ResultsStore& store, int robot);
+
+#endif
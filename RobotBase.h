@@ -39,6 +39,9 @@ private:
     int m_location_row;
     int m_location_col;
 
+    // the arena's snapshots put these back when a game is restored
+    friend struct RobotSnapshotAccess;
+
 public:
 
     int m_board_row_max;
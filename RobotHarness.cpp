@@ -0,0 +1,455 @@
+#include "RobotHarness.h"
+#include "GameRandom.h"
+#include "ReferenceArena.h"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const std::size_t max_problems_kept = 25;
+static const int random_turns = 3;
+static const std::string board_things = "RXMPF";
+
+static bool on_board(const std::vector<std::vector<char>>& board, int row, int col)
+{
+    return row >= 0 && row < static_cast<int>(board.size()) && col >= 0 && col < static_cast<int>(board[0].size());
+}
+
+bool parse_scenario(std::istream& in, const std::string& name, Scenario& scenario)
+{
+    scenario = Scenario();
+    scenario.name = name;
+
+    std::string line;
+    int line_number = 0;
+    int current_turn = 0;
+    bool in_board = false;
+    auto fail = [&](const std::string& what) {
+        std::cerr << name << ":" << line_number << ": " << what << std::endl;
+        return false;
+    };
+
+    while (std::getline(in, line))
+    {
+        ++line_number;
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword))
+            continue;
+
+        if (in_board)
+        {
+            if (keyword == "end")
+            {
+                in_board = false;
+                continue;
+            }
+            if (!scenario.board.empty() && keyword.size() != scenario.board[0].size())
+                return fail("board rows have to be the same length");
+            std::vector<char> row;
+            for (char cell : keyword)
+            {
+                if (cell == 'S')
+                {
+                    scenario.start_row = static_cast<int>(scenario.board.size());
+                    scenario.start_col = static_cast<int>(row.size());
+                    cell = '.';
+                }
+                else if (cell != '.' && board_things.find(cell) == std::string::npos)
+                    return fail(std::string("unknown board cell '") + cell + "'");
+                row.push_back(cell);
+            }
+            scenario.board.push_back(row);
+            continue;
+        }
+
+        if (keyword == "board")
+        {
+            scenario.board.clear();
+            in_board = true;
+        }
+        else if (keyword == "size")
+        {
+            int rows = 0, cols = 0;
+            if (!(words >> rows >> cols) || rows < 1 || cols < 1)
+                return fail("size needs rows and columns");
+            scenario.board.assign(rows, std::vector<char>(cols, '.'));
+        }
+        else if (keyword == "start")
+        {
+            if (!(words >> scenario.start_row >> scenario.start_col))
+                return fail("start needs a row and a column");
+        }
+        else if (keyword == "turns")
+        {
+            if (!(words >> scenario.turns) || scenario.turns < 1)
+                return fail("turns needs a number above 0");
+        }
+        else if (keyword == "turn")
+        {
+            if (!(words >> current_turn) || current_turn < 1)
+                return fail("turn needs a number above 0");
+        }
+        else if (keyword == "radar" || keyword == "expect")
+        {
+            if (current_turn == 0)
+                return fail(keyword + " has to come after a turn line");
+            ScenarioTurn& turn = scenario.turn[current_turn];
+            if (keyword == "radar")
+            {
+                std::string type;
+                RadarObj object;
+                if (!(words >> type >> object.m_row >> object.m_col) || type.size() != 1 ||
+                    board_things.find(type[0]) == std::string::npos)
+                    return fail("radar needs a type (R, X, M, P or F), a row and a column");
+                object.m_type = type[0];
+                turn.scripted_radar = true;
+                turn.radar.push_back(object);
+            }
+            else
+            {
+                std::string what;
+                words >> what;
+                ScenarioExpect expect;
+                if (what == "shot")
+                    expect.kind = (words >> expect.row >> expect.col) ? ExpectKind::ShotAt : ExpectKind::Shot;
+                else if (what == "no_shot")
+                    expect.kind = ExpectKind::NoShot;
+                else if (what == "move")
+                    expect.kind = ExpectKind::Move;
+                else if (what == "radar" && (words >> expect.row) && expect.row >= 0 && expect.row <= 8)
+                    expect.kind = ExpectKind::Radar;
+                else
+                    return fail("expect shot [row col], no_shot, move or radar <0-8>");
+                turn.expects.push_back(expect);
+            }
+        }
+        else
+        {
+            return fail("unknown line: " + keyword);
+        }
+    }
+
+    if (in_board)
+        return fail("board without an end");
+    if (scenario.board.empty())
+        return fail("no board or size");
+    if (!on_board(scenario.board, scenario.start_row, scenario.start_col) ||
+        scenario.board[scenario.start_row][scenario.start_col] != '.')
+        return fail("no start for the robot (S on the board, or start <row> <col> on an empty cell)");
+    return true;
+}
+
+bool load_scenario(const std::string& path, Scenario& scenario)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Failed to open scenario: " << path << std::endl;
+        return false;
+    }
+    return parse_scenario(in, path, scenario);
+}
+
+RobotHarness::RobotHarness(RobotFactory create, const std::string& name, uint64_t budget_ns, int64_t memory_cap)
+    : m_create(create), m_name(name), m_budget_ns(budget_ns)
+{
+    m_memory_slot = RobotMemory::acquire(memory_cap);
+    m_timing.name = name;
+    m_situations = 0;
+    m_turns = 0;
+    m_problem_count = 0;
+}
+
+RobotHarness::~RobotHarness()
+{
+    RobotMemory::release(m_memory_slot);
+}
+
+void RobotHarness::problem(const std::string& label, int turn, const std::string& what)
+{
+    ++m_problem_count;
+    if (m_problems.size() < max_problems_kept)
+    {
+        m_problems.push_back(label + ", turn " + std::to_string(turn) + ": " + what);
+    }
+}
+
+void RobotHarness::run_scenario(const Scenario& scenario, bool verbose)
+{
+    play(scenario, scenario.name, verbose);
+}
+
+void RobotHarness::run_random(int situations, uint64_t seed)
+{
+    GameRandom rng(seed);
+    for (int i = 0; i < situations; ++i)
+    {
+        Scenario scenario;
+        scenario.turns = random_turns;
+        int rows = 5 + rng.below(36);
+        int cols = 5 + rng.below(36);
+        scenario.board.assign(rows, std::vector<char>(cols, '.'));
+
+        // obstacles on up to a fifth of the board, a few robots, now and then a dead one
+        int obstacles = rows * cols * rng.below(21) / 100;
+        int robots = 1 + rng.below(5);
+        int dead = rng.below(3);
+        auto place = [&](char thing) {
+            for (int tries = 0; tries < 100; ++tries)
+            {
+                int row = rng.below(rows);
+                int col = rng.below(cols);
+                if (scenario.board[row][col] == '.')
+                {
+                    scenario.board[row][col] = thing;
+                    return;
+                }
+            }
+        };
+        for (int n = 0; n < obstacles; ++n)
+            place("MPF"[rng.below(3)]);
+        for (int n = 0; n < robots; ++n)
+            place('R');
+        for (int n = 0; n < dead; ++n)
+            place('X');
+        do
+        {
+            scenario.start_row = rng.below(rows);
+            scenario.start_col = rng.below(cols);
+        } while (scenario.board[scenario.start_row][scenario.start_col] != '.');
+
+        // one turn in eight the radar brings back a crowd of anything, anywhere on the board
+        for (int turn = 1; turn <= scenario.turns; ++turn)
+        {
+            if (rng.below(8) == 0)
+            {
+                ScenarioTurn& scripted = scenario.turn[turn];
+                scripted.scripted_radar = true;
+                int count = rng.below(25);
+                for (int n = 0; n < count; ++n)
+                {
+                    scripted.radar.push_back(RadarObj(board_things[rng.below(5)], rng.below(rows), rng.below(cols)));
+                }
+            }
+        }
+
+        play(scenario, "random board " + std::to_string(i) + " (" + std::to_string(rows) + "x" + std::to_string(cols) + ")", false);
+    }
+}
+
+void RobotHarness::play(const Scenario& scenario, const std::string& label, bool verbose)
+{
+    const int rows = static_cast<int>(scenario.board.size());
+    const int cols = static_cast<int>(scenario.board[0].size());
+    ++m_situations;
+
+    RobotBase* robot = m_create();
+    if (!robot)
+    {
+        problem(label, 0, "create_robot returned nothing");
+        return;
+    }
+    robot->m_name = m_name;
+    robot->set_boundaries(rows, cols);
+    robot->move_to(scenario.start_row, scenario.start_col);
+
+    // the radar as the arena works it out
+    ReferenceArena radar(rows, cols, 1);
+    radar.m_board = scenario.board;
+    radar.m_board[scenario.start_row][scenario.start_col] = 'R';
+
+    int turn = 0;
+    auto call = [&](RobotCall which, auto&& body) {
+        CallTimer timer(&m_timing, which);
+        RobotMemoryScope memory(m_memory_slot);
+        try
+        {
+            body();
+            return true;
+        }
+        catch (const std::exception& e)
+        {
+            problem(label, turn, std::string(robot_call_name(which)) + " threw " + e.what());
+        }
+        catch (...)
+        {
+            problem(label, turn, std::string(robot_call_name(which)) + " threw something");
+        }
+        return false;
+    };
+
+    for (turn = 1; turn <= scenario.turns; ++turn)
+    {
+        ++m_turns;
+        auto scripted = scenario.turn.find(turn);
+        const ScenarioTurn* script = scripted == scenario.turn.end() ? nullptr : &scripted->second;
+        int row, col;
+        robot->get_current_location(row, col);
+
+        int radar_direction = 0;
+        call(RobotCall::RadarDirection, [&] { robot->get_radar_direction(radar_direction); });
+        bool radar_ok = radar_direction >= 0 && radar_direction <= 8;
+        if (!radar_ok)
+            problem(label, turn, "radar direction " + std::to_string(radar_direction) + ", it has to be 0-8");
+
+        std::vector<RadarObj> radar_results;
+        if (script && script->scripted_radar)
+        {
+            // the radar never reports the robot itself
+            for (const RadarObj& object : script->radar)
+            {
+                if (object.m_row != row || object.m_col != col)
+                    radar_results.push_back(object);
+            }
+        }
+        else if (radar_ok)
+            radar.get_radar_results(robot, radar_direction, radar_results);
+        call(RobotCall::ProcessRadar, [&] { robot->process_radar_results(radar_results); });
+
+        int shot_row = 0, shot_col = 0;
+        bool shoot = false;
+        call(RobotCall::ShotLocation, [&] { shoot = robot->get_shot_location(shot_row, shot_col); });
+        if (shoot && !on_board(scenario.board, shot_row, shot_col))
+            problem(label, turn, "shoots at (" + std::to_string(shot_row) + "," + std::to_string(shot_col) + "), off the board");
+        else if (shoot && shot_row == row && shot_col == col)
+            problem(label, turn, "shoots at its own cell");
+
+        int move_direction = 0, move_distance = 0;
+        if (!shoot && robot->get_move_speed() > 0)
+        {
+            call(RobotCall::MoveDirection, [&] { robot->get_move_direction(move_direction, move_distance); });
+            // taken the way the arena takes it: anything but 1-8 stays put, and
+            // no further than its speed
+            move_distance = std::clamp(move_distance, 0, robot->get_move_speed());
+            if (move_direction >= 1 && move_direction <= 8)
+            {
+                // step by step, stopping short of anything in the way
+                radar.m_board[row][col] = '.';
+                for (int step = 0; step < move_distance; ++step)
+                {
+                    int next_row = row + directions[move_direction].first;
+                    int next_col = col + directions[move_direction].second;
+                    if (!on_board(radar.m_board, next_row, next_col) || radar.m_board[next_row][next_col] != '.')
+                        break;
+                    row = next_row;
+                    col = next_col;
+                }
+                radar.m_board[row][col] = 'R';
+                robot->move_to(row, col);
+            }
+        }
+
+        if (verbose)
+        {
+            std::cout << "  turn " << turn << ": radar " << radar_direction << " found " << radar_results.size();
+            if (shoot)
+                std::cout << ", shoots at (" << shot_row << "," << shot_col << ")";
+            else if (move_direction >= 1 && move_direction <= 8 && move_distance > 0)
+                std::cout << ", moves " << move_direction << " by " << move_distance << " to (" << row << "," << col << ")";
+            else
+                std::cout << ", stays at (" << row << "," << col << ")";
+            std::cout << "\n";
+        }
+
+        if (!script)
+            continue;
+        for (const ScenarioExpect& expect : script->expects)
+        {
+            switch (expect.kind)
+            {
+                case ExpectKind::Shot:
+                    if (!shoot)
+                        problem(label, turn, "was expected to shoot");
+                    break;
+                case ExpectKind::ShotAt:
+                    if (!shoot || shot_row != expect.row || shot_col != expect.col)
+                        problem(label, turn, "was expected to shoot at (" + std::to_string(expect.row) + "," +
+                                             std::to_string(expect.col) + ")");
+                    break;
+                case ExpectKind::NoShot:
+                    if (shoot)
+                        problem(label, turn, "was expected not to shoot");
+                    break;
+                case ExpectKind::Move:
+                    if (shoot || move_direction < 1 || move_direction > 8 || move_distance < 1)
+                        problem(label, turn, "was expected to move");
+                    break;
+                case ExpectKind::Radar:
+                    if (radar_direction != expect.row)
+                        problem(label, turn, "was expected to point its radar at " + std::to_string(expect.row));
+                    break;
+            }
+        }
+    }
+
+    delete robot;
+}
+
+bool RobotHarness::over_budget() const
+{
+    if (m_budget_ns == 0)
+    {
+        return false;
+    }
+    for (const CallTiming& call : m_timing.calls)
+    {
+        if (call.wall.count() && call.wall.max() > m_budget_ns)
+            return true;
+    }
+    return false;
+}
+
+RobotMemoryStats RobotHarness::memory() const
+{
+    return RobotMemory::stats(m_memory_slot);
+}
+
+std::string RobotHarness::report() const
+{
+    std::ostringstream out;
+    out << m_name << ": " << m_situations << " boards, " << m_turns << " turns, " << m_problem_count << " problems\n";
+    for (const std::string& what : m_problems)
+    {
+        out << "  " << what << "\n";
+    }
+    if (m_problem_count > static_cast<int>(m_problems.size()))
+    {
+        out << "  ... and " << m_problem_count - m_problems.size() << " more\n";
+    }
+
+    out << "\n" << format_robot_timing({m_timing});
+    if (m_budget_ns)
+    {
+        for (int i = 0; i < static_cast<int>(RobotCall::Count); ++i)
+        {
+            const LatencyHistogram& wall = m_timing.calls[i].wall;
+            if (wall.count() && wall.max() > m_budget_ns)
+            {
+                out << "  OVER BUDGET: " << robot_call_name(static_cast<RobotCall>(i)) << " took up to "
+                    << format_ns(wall.max()) << ", the arena allows " << format_ns(m_budget_ns) << "\n";
+            }
+        }
+        if (!over_budget())
+        {
+            out << "  every call within the arena's " << format_ns(m_budget_ns) << "\n";
+        }
+    }
+
+    RobotMemoryStats stats = memory();
+    char per_turn[32];
+    std::snprintf(per_turn, sizeof(per_turn), "%.1f", m_turns ? static_cast<double>(stats.allocations) / m_turns : 0.0);
+    out << "\nMemory: peak " << format_bytes(stats.peak) << ", " << stats.allocations << " allocations (" << per_turn
+        << " a turn), " << format_bytes(stats.live) << " never freed";
+    if (stats.over_cap)
+    {
+        out << ", OVER its " << format_bytes(stats.cap) << " cap";
+    }
+    out << "\n";
+    return out.str();
+}
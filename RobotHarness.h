@@ -0,0 +1,127 @@
+#ifndef __ROBOTHARNESS_H__
+#define __ROBOTHARNESS_H__
+
+#include "RobotBase.h"
+#include "RadarObj.h"
+#include "RobotMemory.h"
+#include "RobotTiming.h"
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+// What test_robot puts a robot through before it plays anyone: scripted
+// scenarios, then thousands of random boards. Each turn goes the way the arena
+// plays it (radar direction, radar results, shot, and a move if it didn't
+// shoot), with the radar worked out by ReferenceArena, so a robot sees exactly
+// what it would see in a game. The other robots on the board stand still.
+//
+// Every call is checked against the rules (radar direction 0-8, shots on the
+// board and not at itself, no exceptions) and against what the scenario
+// expects that turn. Moves are taken the way the arena takes them. Calls are timed into the same
+// histograms the arena uses and allocations go to a RobotMemory slot, so a slow
+// or leaky robot shows up here and not in the middle of a tournament.
+//
+// A scenario file:
+//
+//     # an enemy right next to it
+//     turns 4
+//     board
+//     ..........
+//     ....SR....
+//     ..........
+//     end
+//     turn 2
+//     radar R 1 5          # the radar finds exactly this on turn 2, whatever
+//     radar M 0 4          # direction the robot picked
+//     expect shot 1 5      # it has to shoot that cell on turn 2
+//
+// S is where the robot under test starts, R, X, M, P and F are robots, dead
+// robots, mounds, pits and flamethrowers. Without a board, "size <rows> <cols>"
+// and "start <row> <col>" give an empty one. A turn can expect "shot", "shot
+// <row> <col>", "no_shot", "move" or "radar <direction>".
+
+enum class ExpectKind
+{
+    Shot,
+    ShotAt,
+    NoShot,
+    Move,
+    Radar
+};
+
+struct ScenarioExpect
+{
+    ExpectKind kind;
+    int row = 0; // the direction for Radar
+    int col = 0;
+};
+
+struct ScenarioTurn
+{
+    bool scripted_radar = false;
+    std::vector<RadarObj> radar;
+    std::vector<ScenarioExpect> expects;
+};
+
+struct Scenario
+{
+    std::string name;
+    std::vector<std::vector<char>> board;
+    int start_row = -1;
+    int start_col = -1;
+    int turns = 10;
+    std::map<int, ScenarioTurn> turn; // by turn number, from 1
+};
+
+// false, with a message on stderr, if the file can't be read or makes no sense
+bool parse_scenario(std::istream& in, const std::string& name, Scenario& scenario);
+bool load_scenario(const std::string& path, Scenario& scenario);
+
+class RobotHarness
+{
+public:
+
+    // budget_ns is the longest a single call may take, 0 for no limit.
+    // memory_cap as in RobotMemory::acquire.
+    RobotHarness(RobotFactory create, const std::string& name, uint64_t budget_ns, int64_t memory_cap);
+    ~RobotHarness();
+
+    RobotHarness(const RobotHarness&) = delete;
+    RobotHarness& operator=(const RobotHarness&) = delete;
+
+    // a fresh robot for the scenario. verbose prints every turn.
+    void run_scenario(const Scenario& scenario, bool verbose);
+
+    // random boards, a few turns each, a fresh robot on every one
+    void run_random(int situations, uint64_t seed);
+
+    // rule breaks, missed expectations, slow calls and memory over the cap
+    int problem_count() const { return m_problem_count; }
+    bool over_budget() const;
+
+    const RobotTiming& timing() const { return m_timing; }
+    RobotMemoryStats memory() const;
+
+    // what was played, the problems, the call times and memory
+    std::string report() const;
+
+private:
+
+    void play(const Scenario& scenario, const std::string& label, bool verbose);
+    void problem(const std::string& label, int turn, const std::string& what);
+
+    RobotFactory m_create;
+    std::string m_name;
+    uint64_t m_budget_ns;
+    int m_memory_slot;
+
+    RobotTiming m_timing;
+    int m_situations;
+    int m_turns;
+    int m_problem_count;
+    std::vector<std::string> m_problems; // the first few, the rest are only counted
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "RobotMemory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+namespace
+{
+
+const int slot_count = 1024;
+
+struct Slot
+{
+    std::atomic<int64_t> live;
+    std::atomic<int64_t> peak;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> frees;
+    std::atomic<int64_t> cap;
+    std::atomic<bool> over_cap;
+    std::atomic<uint32_t> generation;
+    bool in_use;
+};
+
+// zero initialised before anything runs, so operator new can use it from the start
+Slot slots[slot_count];
+std::mutex slots_mutex;
+
+thread_local int t_slot = 0;
+
+// in front of every block. size and owner share a word: 48 bits is plenty.
+struct Header
+{
+    uint64_t size_owner;  // size << 16 | slot
+    uint32_t generation;  // the slot's generation when the block was allocated
+    uint16_t offset;      // from the start of what malloc gave us to the block
+    uint16_t magic;
+};
+
+const uint16_t header_magic = 0x524d; // "RM"
+const std::size_t header_size = sizeof(Header);
+static_assert(header_size == 16, "the header keeps blocks 16 byte aligned");
+
+void* allocate(std::size_t size, std::size_t align)
+{
+    int slot = t_slot;
+    if (slot)
+    {
+        Slot& owner = slots[slot];
+        int64_t cap = owner.cap.load(std::memory_order_relaxed);
+        if (cap > 0 && owner.live.load(std::memory_order_relaxed) + static_cast<int64_t>(size) > cap)
+        {
+            owner.over_cap.store(true, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    // the block has to be aligned, with room for the header just in front of it
+    std::size_t offset = std::max(align, header_size);
+    void* raw;
+    if (align <= header_size)
+    {
+        raw = std::malloc(size + offset);
+    }
+    else
+    {
+        std::size_t total = (size + offset + align - 1) / align * align;
+        raw = std::aligned_alloc(align, total);
+    }
+    if (!raw)
+    {
+        return nullptr;
+    }
+
+    char* block = static_cast<char*>(raw) + offset;
+    Header* header = reinterpret_cast<Header*>(block - header_size);
+    header->size_owner = static_cast<uint64_t>(size) << 16 | static_cast<uint64_t>(slot);
+    header->generation = slot ? slots[slot].generation.load(std::memory_order_relaxed) : 0;
+    header->offset = static_cast<uint16_t>(offset);
+    header->magic = header_magic;
+
+    if (slot)
+    {
+        Slot& owner = slots[slot];
+        int64_t live = owner.live.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+        // frees on other threads can race us, so only ever raise the peak
+        int64_t peak = owner.peak.load(std::memory_order_relaxed);
+        while (live > peak && !owner.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+        owner.allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void deallocate(void* block)
+{
+    if (!block)
+    {
+        return;
+    }
+    // every operator new in the process is ours (the robots' libraries find
+    // these too), so every block has a header. one without is a double delete
+    // or a block that never came from new, and freeing it can only do harm.
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(block) - header_size);
+    if (header->magic != header_magic)
+    {
+        std::fputs("RobotMemory: operator delete of a block operator new didn't make\n", stderr);
+        std::abort();
+    }
+
+    int slot = static_cast<int>(header->size_owner & 0xffff);
+    if (slot && slots[slot].generation.load(std::memory_order_relaxed) == header->generation)
+    {
+        Slot& owner = slots[slot];
+        owner.live.fetch_sub(static_cast<int64_t>(header->size_owner >> 16), std::memory_order_relaxed);
+        owner.frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    header->magic = 0;
+    std::free(static_cast<char*>(block) - header->offset);
+}
+
+void* allocate_or_throw(std::size_t size, std::size_t align)
+{
+    void* block = allocate(size, align);
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+}
+
+void* operator new(std::size_t size) { return allocate_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return allocate_or_throw(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocate_or_throw(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate_or_throw(size, static_cast<std::size_t>(align)); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(align)); }
+
+void operator delete(void* block) noexcept { deallocate(block); }
+void operator delete[](void* block) noexcept { deallocate(block); }
+void operator delete(void* block, std::size_t) noexcept { deallocate(block); }
+void operator delete[](void* block, std::size_t) noexcept { deallocate(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { deallocate(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { deallocate(block); }
+void operator delete(void* block, std::align_val_t) noexcept { deallocate(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { deallocate(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { deallocate(block); }
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept { deallocate(block); }
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(block); }
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(block); }
+
+int RobotMemory::acquire(int64_t cap_bytes)
+{
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    for (int slot = 1; slot < slot_count; ++slot)
+    {
+        Slot& entry = slots[slot];
+        if (!entry.in_use)
+        {
+            entry.in_use = true;
+            entry.live.store(0, std::memory_order_relaxed);
+            entry.peak.store(0, std::memory_order_relaxed);
+            entry.allocations.store(0, std::memory_order_relaxed);
+            entry.frees.store(0, std::memory_order_relaxed);
+            entry.cap.store(std::max<int64_t>(0, cap_bytes), std::memory_order_relaxed);
+            entry.over_cap.store(false, std::memory_order_relaxed);
+            return slot;
+        }
+    }
+    return 0;
+}
+
+void RobotMemory::release(int slot)
+{
+    if (slot <= 0 || slot >= slot_count)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    // blocks still out belong to a generation that no longer counts
+    slots[slot].generation.fetch_add(1, std::memory_order_relaxed);
+    slots[slot].in_use = false;
+}
+
+RobotMemoryStats RobotMemory::stats(int slot)
+{
+    RobotMemoryStats stats;
+    if (slot <= 0 || slot >= slot_count)
+    {
+        return stats;
+    }
+    const Slot& owner = slots[slot];
+    stats.live = owner.live.load(std::memory_order_relaxed);
+    stats.peak = owner.peak.load(std::memory_order_relaxed);
+    stats.allocations = owner.allocations.load(std::memory_order_relaxed);
+    stats.frees = owner.frees.load(std::memory_order_relaxed);
+    stats.cap = owner.cap.load(std::memory_order_relaxed);
+    stats.over_cap = owner.over_cap.load(std::memory_order_relaxed);
+    return stats;
+}
+
+RobotMemoryScope::RobotMemoryScope(int slot)
+{
+    m_previous = t_slot;
+    t_slot = slot;
+}
+
+RobotMemoryScope::~RobotMemoryScope()
+{
+    t_slot = m_previous;
+}
+
+std::string format_bytes(int64_t bytes)
+{
+    char text[32];
+    if (bytes < 1024)
+        std::snprintf(text, sizeof(text), "%lldB", static_cast<long long>(bytes));
+    else if (bytes < 1024 * 1024)
+        std::snprintf(text, sizeof(text), "%.1fKB", bytes / 1024.0);
+    else
+        std::snprintf(text, sizeof(text), "%.1fMB", bytes / (1024.0 * 1024.0));
+    return text;
+}
+
+std::string format_robot_memory(const std::vector<std::string>& names, const std::vector<RobotMemoryStats>& stats)
+{
+    std::ostringstream out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "Robot memory %13s %10s %10s %12s\n", "", "live", "peak", "allocations");
+    out << line;
+    for (std::size_t i = 0; i < names.size() && i < stats.size(); ++i)
+    {
+        std::snprintf(line, sizeof(line), "  %-24s %10s %10s %12llu%s\n",
+                      names[i].c_str(),
+                      format_bytes(stats[i].live).c_str(),
+                      format_bytes(stats[i].peak).c_str(),
+                      static_cast<unsigned long long>(stats[i].allocations),
+                      stats[i].over_cap ? "  over its cap" : "");
+        out << line;
+    }
+    return out.str();
+}
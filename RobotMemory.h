@@ -0,0 +1,69 @@
+#ifndef __ROBOTMEMORY_H__
+#define __ROBOTMEMORY_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Heap use per robot. RobotMemory.cpp replaces the global operator new and
+// delete: every block gets a 16 byte header saying who allocated it. While a
+// robot's callback runs (RobotMemoryScope), what it allocates is put down to
+// its slot, and so is freeing it again, whenever and on whatever thread that
+// happens. Outside robot calls nothing is counted, so the engine's own
+// allocations cost a header and one thread local read.
+//
+// A slot can have a cap. An allocation that would take the robot over it
+// throws std::bad_alloc, like running out of memory would, and marks the robot
+// so the game can disqualify it before it takes the whole worker down.
+//
+// Robots allocate through libstdc++, which finds our operator new in the
+// executable. malloc() called directly isn't counted.
+
+struct RobotMemoryStats
+{
+    int64_t live = 0;         // bytes allocated and not freed yet
+    int64_t peak = 0;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    int64_t cap = 0;          // 0 for none
+    bool over_cap = false;    // an allocation was refused
+};
+
+class RobotMemory
+{
+public:
+
+    // a slot to count a robot's allocations in, 0 when every slot is taken.
+    // cap_bytes 0 is no cap.
+    static int acquire(int64_t cap_bytes);
+
+    // frees of the slot's blocks after this aren't counted any more
+    static void release(int slot);
+
+    static RobotMemoryStats stats(int slot);
+};
+
+// counts this thread's allocations against a slot while in scope. 0 counts
+// nothing.
+class RobotMemoryScope
+{
+public:
+
+    explicit RobotMemoryScope(int slot);
+    ~RobotMemoryScope();
+
+    RobotMemoryScope(const RobotMemoryScope&) = delete;
+    RobotMemoryScope& operator=(const RobotMemoryScope&) = delete;
+
+private:
+
+    int m_previous;
+};
+
+// "512B", "12.5KB", "3.2MB"
+std::string format_bytes(int64_t bytes);
+
+// live, peak and allocations per robot, names in the same order as stats
+std::string format_robot_memory(const std::vector<std::string>& names, const std::vector<RobotMemoryStats>& stats);
+
+#endif
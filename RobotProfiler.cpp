@@ -0,0 +1,565 @@
+#include "RobotProfiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#ifdef __linux__
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+void RobotProfile::merge(const RobotProfile& other)
+{
+    hz = std::max(hz, other.hz);
+    if (robots.empty())
+    {
+        robots = other.robots;
+    }
+    if (samples.size() < other.samples.size())
+    {
+        samples.resize(other.samples.size(), 0);
+    }
+    for (std::size_t i = 0; i < other.samples.size(); ++i)
+    {
+        samples[i] += other.samples[i];
+    }
+    engine_samples += other.engine_samples;
+    lost_samples += other.lost_samples;
+    for (const auto& [stack, count] : other.folded)
+    {
+        folded[stack] += count;
+    }
+}
+
+std::string format_robot_profile(const RobotProfile& profile, std::size_t top)
+{
+    uint64_t robot_samples = 0;
+    for (uint64_t count : profile.samples)
+    {
+        robot_samples += count;
+    }
+
+    std::ostringstream out;
+    out << "Robot profile, " << profile.hz << " samples a second of CPU: " << robot_samples << " in robot calls, "
+        << profile.engine_samples << " in the arena";
+    if (profile.lost_samples)
+    {
+        out << ", " << profile.lost_samples << " lost";
+    }
+    out << "\n";
+
+    // self is the leaf of each stack, total is every function on it once
+    std::map<std::string, std::map<std::string, std::pair<uint64_t, uint64_t>>> functions;
+    for (const auto& [stack, count] : profile.folded)
+    {
+        std::vector<std::string> frames;
+        std::stringstream split(stack);
+        std::string frame;
+        while (std::getline(split, frame, ';'))
+        {
+            frames.push_back(frame);
+        }
+        if (frames.size() < 2)
+            continue;
+        auto& robot = functions[frames[0]];
+        robot[frames.back()].first += count;
+        std::set<std::string> seen(frames.begin() + 1, frames.end());
+        for (const std::string& function : seen)
+        {
+            robot[function].second += count;
+        }
+    }
+
+    for (std::size_t i = 0; i < profile.robots.size(); ++i)
+    {
+        uint64_t samples = i < profile.samples.size() ? profile.samples[i] : 0;
+        out << "  " << profile.robots[i] << ": " << samples << " samples\n";
+        auto found = functions.find(profile.robots[i]);
+        if (samples == 0 || found == functions.end())
+            continue;
+
+        std::vector<std::pair<std::string, std::pair<uint64_t, uint64_t>>> rows(found->second.begin(),
+                                                                                  found->second.end());
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return a.second.first != b.second.first ? a.second.first > b.second.first : a.second.second > b.second.second;
+        });
+        if (rows.size() > top)
+            rows.resize(top);
+
+        char line[64];
+        std::snprintf(line, sizeof(line), "    %7s %7s  ", "self", "total");
+        out << line << "function\n";
+        for (const auto& [function, counts] : rows)
+        {
+            std::snprintf(line, sizeof(line), "    %6.1f%% %6.1f%%  ", 100.0 * counts.first / samples,
+                          100.0 * counts.second / samples);
+            out << line << function << "\n";
+        }
+    }
+    return out.str();
+}
+
+bool write_folded_stacks(const std::string& path, const RobotProfile& profile)
+{
+    std::ofstream out(path);
+    for (const auto& [stack, count] : profile.folded)
+    {
+        out << stack << " " << count << "\n";
+    }
+    if (!out.flush())
+    {
+        std::cerr << "Failed to write robot profile: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the profiler sampling this thread, for the signal handler
+static thread_local RobotProfiler* t_profiler = nullptr;
+
+#ifdef __linux__
+
+static void on_sigprof(int, siginfo_t*, void* context)
+{
+    int saved_errno = errno;
+    RobotProfiler* profiler = t_profiler;
+    if (profiler)
+    {
+        profiler->take_sample(context);
+    }
+    errno = saved_errno;
+}
+
+#endif
+
+RobotProfiler::RobotProfiler()
+{
+    m_running = false;
+    m_timer = nullptr;
+    m_stack_low = 0;
+    m_stack_high = 0;
+    m_in_call = 0;
+    m_robot = 0;
+    m_head = 0;
+    m_tail = 0;
+    m_engine_samples = 0;
+    m_lost_samples = 0;
+}
+
+RobotProfiler::~RobotProfiler()
+{
+    stop();
+}
+
+#ifdef __linux__
+
+bool RobotProfiler::start(int hz, const std::vector<std::string>& robot_names)
+{
+    stop();
+
+    // batch workers start their profilers at the same time. call_once makes
+    // installed visible to every one of them once it is set.
+    static std::once_flag install;
+    static bool installed = false;
+    std::call_once(install, [] {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = on_sigprof;
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, nullptr) != 0)
+        {
+            std::cerr << "Robot profiling off, no SIGPROF handler: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        installed = true;
+    });
+    if (!installed)
+    {
+        return false;
+    }
+
+    // the walk never leaves this thread's stack
+    pthread_attr_t attr;
+    void* stack = nullptr;
+    std::size_t stack_size = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        pthread_attr_getstack(&attr, &stack, &stack_size);
+        pthread_attr_destroy(&attr);
+    }
+    m_stack_low = reinterpret_cast<uintptr_t>(stack);
+    m_stack_high = m_stack_low + stack_size;
+
+    sigevent event;
+    std::memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event._sigev_un._tid = static_cast<pid_t>(syscall(SYS_gettid));
+    timer_t timer;
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0)
+    {
+        std::cerr << "Robot profiling off, no CPU timer: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::memcpy(&m_timer, &timer, std::min(sizeof(timer), sizeof(m_timer)));
+
+    m_ring.resize(ring_capacity);
+    m_head = 0;
+    m_tail = 0;
+    m_engine_samples = 0;
+    m_lost_samples = 0;
+    m_in_call = 0;
+    m_robot = 0;
+    m_stacks.clear();
+    m_profile = RobotProfile();
+    m_profile.hz = std::max(1, hz);
+    m_profile.robots = robot_names;
+    m_profile.samples.assign(robot_names.size(), 0);
+
+    t_profiler = this;
+    m_running = true;
+
+    long interval = 1000000000L / m_profile.hz;
+    itimerspec spec;
+    spec.it_interval.tv_sec = interval / 1000000000L;
+    spec.it_interval.tv_nsec = interval % 1000000000L;
+    spec.it_value = spec.it_interval;
+    timer_settime(timer, 0, &spec, nullptr);
+    return true;
+}
+
+void RobotProfiler::take_sample(void* context)
+{
+    if (!m_in_call)
+    {
+        m_engine_samples.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= ring_capacity)
+    {
+        m_lost_samples.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Sample& sample = m_ring[head % ring_capacity];
+    sample.robot = m_robot;
+    const ucontext_t* interrupted = static_cast<const ucontext_t*>(context);
+    uintptr_t pc = 0, frame = 0;
+#if defined(__x86_64__)
+    pc = static_cast<uintptr_t>(interrupted->uc_mcontext.gregs[REG_RIP]);
+    frame = static_cast<uintptr_t>(interrupted->uc_mcontext.gregs[REG_RBP]);
+#elif defined(__aarch64__)
+    pc = static_cast<uintptr_t>(interrupted->uc_mcontext.pc);
+    frame = static_cast<uintptr_t>(interrupted->uc_mcontext.regs[29]);
+#else
+    (void)interrupted;
+#endif
+    int depth = 0;
+    sample.pcs[depth++] = pc;
+
+    // each frame holds the caller's frame pointer, then the return address.
+    // callers are further up the stack, anything else is not a frame.
+    while (depth < max_depth && frame % sizeof(uintptr_t) == 0 && frame >= m_stack_low &&
+           frame + 2 * sizeof(uintptr_t) <= m_stack_high)
+    {
+        const uintptr_t* words = reinterpret_cast<const uintptr_t*>(frame);
+        uintptr_t caller = words[0];
+        uintptr_t return_address = words[1];
+        if (return_address == 0)
+            break;
+        sample.pcs[depth++] = return_address;
+        if (caller <= frame)
+            break;
+        frame = caller;
+    }
+    sample.depth = depth;
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+void RobotProfiler::drain()
+{
+    std::size_t head = m_head.load(std::memory_order_acquire);
+    std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    std::vector<uintptr_t> key;
+    for (; tail != head; ++tail)
+    {
+        const Sample& sample = m_ring[tail % ring_capacity];
+        key.assign(1, static_cast<uintptr_t>(sample.robot));
+        key.insert(key.end(), sample.pcs.begin(), sample.pcs.begin() + sample.depth);
+        ++m_stacks[key];
+    }
+    m_tail.store(tail, std::memory_order_release);
+}
+
+namespace
+{
+
+struct ElfFunction
+{
+    uintptr_t start;
+    uintptr_t size;
+    std::string name;
+};
+
+// the functions in a file's .symtab, which has the static ones dladdr can't
+// see, sorted by address. empty if the file is stripped.
+std::vector<ElfFunction> read_elf_functions(const std::string& path, bool& relative)
+{
+    std::vector<ElfFunction> functions;
+    relative = true;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return functions;
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > static_cast<off_t>(sizeof(ElfW(Ehdr))))
+        mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return functions;
+
+    const char* base = static_cast<const char*>(mapped);
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    const ElfW(Ehdr)* header = reinterpret_cast<const ElfW(Ehdr)*>(base);
+    bool sane = std::memcmp(header->e_ident, ELFMAG, SELFMAG) == 0 && header->e_ident[EI_CLASS] == (__ELF_NATIVE_CLASS == 64 ? ELFCLASS64 : ELFCLASS32) &&
+                header->e_shentsize == sizeof(ElfW(Shdr)) &&
+                header->e_shoff + header->e_shnum * sizeof(ElfW(Shdr)) <= size;
+    if (sane)
+    {
+        relative = header->e_type == ET_DYN;
+        const ElfW(Shdr)* sections = reinterpret_cast<const ElfW(Shdr)*>(base + header->e_shoff);
+        for (int i = 0; i < header->e_shnum; ++i)
+        {
+            const ElfW(Shdr)& symtab = sections[i];
+            if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= header->e_shnum ||
+                symtab.sh_offset + symtab.sh_size > size)
+                continue;
+            const ElfW(Shdr)& strtab = sections[symtab.sh_link];
+            if (strtab.sh_offset + strtab.sh_size > size)
+                continue;
+            const ElfW(Sym)* symbols = reinterpret_cast<const ElfW(Sym)*>(base + symtab.sh_offset);
+            std::size_t count = symtab.sh_size / sizeof(ElfW(Sym));
+            for (std::size_t s = 0; s < count; ++s)
+            {
+                const ElfW(Sym)& symbol = symbols[s];
+                if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_value == 0 ||
+                    symbol.st_name >= strtab.sh_size)
+                    continue;
+                const char* name = base + strtab.sh_offset + symbol.st_name;
+                functions.push_back({symbol.st_value, symbol.st_size,
+                                     std::string(name, strnlen(name, strtab.sh_size - symbol.st_name))});
+            }
+        }
+    }
+    munmap(mapped, size);
+    std::sort(functions.begin(), functions.end(),
+              [](const ElfFunction& a, const ElfFunction& b) { return a.start < b.start; });
+    return functions;
+}
+
+// "Ratboy::scan(int) const" comes out as "Ratboy::scan"
+std::string function_name(const char* symbol)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(symbol, nullptr, nullptr, &status);
+    std::string name = status == 0 && demangled ? demangled : symbol;
+    std::free(demangled);
+
+    int depth = 0;
+    for (std::size_t i = 0; i < name.size(); ++i)
+    {
+        char c = name[i];
+        if (c == '<')
+            ++depth;
+        else if (c == '>' && depth > 0)
+            --depth;
+        else if (c == '(' && depth == 0)
+        {
+            if (i >= 8 && name.compare(i - 8, 8, "operator") == 0)
+            {
+                i = name.find(')', i);
+                if (i == std::string::npos)
+                    break;
+                continue;
+            }
+            name.erase(i);
+            break;
+        }
+    }
+    return name;
+}
+
+struct Module
+{
+    bool relative = true;
+    std::vector<ElfFunction> functions;
+};
+
+class Symbolizer
+{
+public:
+
+    Symbolizer()
+    {
+        Dl_info info;
+        m_engine = dladdr(reinterpret_cast<void*>(&on_sigprof), &info) ? info.dli_fbase : nullptr;
+    }
+
+    // "<library>`<function>", and whether it is the arena's own code
+    const std::string& frame(uintptr_t pc, bool& engine)
+    {
+        auto found = m_frames.find(pc);
+        if (found == m_frames.end())
+        {
+            std::string name = symbolize(pc, engine);
+            found = m_frames.emplace(pc, std::make_pair(name, engine)).first;
+        }
+        engine = found->second.second;
+        return found->second.first;
+    }
+
+private:
+
+    std::string symbolize(uintptr_t pc, bool& engine)
+    {
+        Dl_info info;
+        if (!dladdr(reinterpret_cast<void*>(pc), &info) || !info.dli_fname)
+        {
+            engine = false;
+            char unknown[32];
+            std::snprintf(unknown, sizeof(unknown), "?`0x%llx", static_cast<unsigned long long>(pc));
+            return unknown;
+        }
+        engine = info.dli_fbase == m_engine;
+
+        // the main program's name comes back empty or as typed on the command line
+        std::string path = engine || !*info.dli_fname ? "/proc/self/exe" : info.dli_fname;
+        std::string library = engine ? program_invocation_short_name : info.dli_fname;
+        library = library.substr(library.find_last_of('/') + 1);
+
+        auto module = m_modules.find(path);
+        if (module == m_modules.end())
+        {
+            Module loaded;
+            loaded.functions = read_elf_functions(path, loaded.relative);
+            module = m_modules.emplace(path, std::move(loaded)).first;
+        }
+        uintptr_t base = reinterpret_cast<uintptr_t>(info.dli_fbase);
+        uintptr_t address = module->second.relative ? pc - base : pc;
+        const std::vector<ElfFunction>& functions = module->second.functions;
+        auto after = std::upper_bound(functions.begin(), functions.end(), address,
+                                      [](uintptr_t value, const ElfFunction& f) { return value < f.start; });
+        if (after != functions.begin())
+        {
+            const ElfFunction& function = *(after - 1);
+            if (address < function.start + std::max<uintptr_t>(function.size, 1))
+                return library + "`" + function_name(function.name.c_str());
+        }
+        if (info.dli_sname)
+        {
+            return library + "`" + function_name(info.dli_sname);
+        }
+        char offset[32];
+        std::snprintf(offset, sizeof(offset), "`+0x%llx", static_cast<unsigned long long>(pc - base));
+        return library + offset;
+    }
+
+    void* m_engine;
+    std::map<uintptr_t, std::pair<std::string, bool>> m_frames;
+    std::map<std::string, Module> m_modules;
+};
+
+}
+
+void RobotProfiler::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+    timer_t timer;
+    std::memcpy(&timer, &m_timer, std::min(sizeof(timer), sizeof(m_timer)));
+    timer_delete(timer);
+    t_profiler = nullptr;
+    m_running = false;
+    drain();
+
+    m_profile.engine_samples = m_engine_samples.load();
+    m_profile.lost_samples = m_lost_samples.load();
+
+    // from the robot's call inwards: return addresses point just after the
+    // call, so they're looked up one byte back. the walk stops where the
+    // robot's code was called from the arena.
+    Symbolizer symbolizer;
+    std::vector<std::string> frames;
+    for (const auto& [key, count] : m_stacks)
+    {
+        std::size_t robot = key[0];
+        if (robot >= m_profile.robots.size())
+            continue;
+        m_profile.samples[robot] += count;
+
+        frames.clear();
+        bool left_engine = false;
+        for (std::size_t i = 1; i < key.size(); ++i)
+        {
+            bool engine = false;
+            const std::string& frame = symbolizer.frame(i == 1 ? key[i] : key[i] - 1, engine);
+            if (engine && left_engine)
+                break;
+            left_engine |= !engine;
+            frames.push_back(frame);
+        }
+
+        std::string stack = m_profile.robots[robot];
+        for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame)
+        {
+            stack += ";" + *frame;
+        }
+        m_profile.folded[stack] += count;
+    }
+    m_stacks.clear();
+}
+
+#else
+
+bool RobotProfiler::start(int hz, const std::vector<std::string>& robot_names)
+{
+    (void)hz;
+    (void)robot_names;
+    std::cerr << "Robot profiling needs Linux's per thread CPU timers, not profiling." << std::endl;
+    return false;
+}
+
+void RobotProfiler::take_sample(void* context)
+{
+    (void)context;
+}
+
+void RobotProfiler::drain()
+{
+}
+
+void RobotProfiler::stop()
+{
+    m_running = false;
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef __ROBOTPROFILER_H__
+#define __ROBOTPROFILER_H__
+
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Which function inside which robot is eating the CPU. A per thread CPU time
+// timer sends the game's thread SIGPROF a few hundred times a second of CPU it
+// uses. If a robot call is running (RobotProfileScope), the handler walks the
+// stack by frame pointers from where the robot was interrupted and puts the
+// return addresses in a ring. Once a round the ring is emptied into counts per
+// stack, and at the end of the game those are symbolised with dladdr against
+// the robot libraries and whatever else they called into.
+//
+// No root, no perf, no extra threads. The handler only reads memory inside the
+// thread's own stack, so a robot that trashed its frame pointers gets a short
+// stack rather than a crash. The robots are built with -fno-omit-frame-pointer
+// so the walk goes through them; library code built without frame pointers
+// (libstdc++ mostly) still shows as the leaf, it just may hide its caller.
+//
+// The timer counts CPU time on a kernel tick, so anything past the kernel's HZ
+// (250 to 1000) samples a second is no finer. Linux only: elsewhere start()
+// says so and nothing is sampled.
+
+// what a game's samples came to. merge() adds up games, e.g. a batch.
+struct RobotProfile
+{
+    int hz = 0;
+    std::vector<std::string> robots;
+    std::vector<uint64_t> samples;  // in robot calls, per robot
+    uint64_t engine_samples = 0;    // the arena's own CPU, not broken down
+    uint64_t lost_samples = 0;      // the ring was full
+
+    // "<robot>;<library>`<function>;...;<library>`<leaf>" outermost first, as
+    // flamegraph.pl and speedscope read them
+    std::map<std::string, uint64_t> folded;
+
+    void merge(const RobotProfile& other);
+};
+
+// per robot, the functions with the most samples: self (the leaf) and total
+// (anywhere on the stack), top of each
+std::string format_robot_profile(const RobotProfile& profile, std::size_t top);
+
+// one "stack count" line per folded stack
+bool write_folded_stacks(const std::string& path, const RobotProfile& profile);
+
+class RobotProfiler
+{
+public:
+
+    static const int max_depth = 32;
+    static const std::size_t ring_capacity = 4096;
+
+    RobotProfiler();
+    ~RobotProfiler();
+
+    RobotProfiler(const RobotProfiler&) = delete;
+    RobotProfiler& operator=(const RobotProfiler&) = delete;
+
+    // samples the calling thread, hz times a second of its CPU time. false,
+    // with why on stderr, if the timer can't be had.
+    bool start(int hz, const std::vector<std::string>& robot_names);
+
+    // empties the ring into the stack counts. call it now and then on the
+    // sampled thread, the ring holds ring_capacity samples.
+    void drain();
+
+    // stops the timer and symbolises what was sampled
+    void stop();
+    bool running() const { return m_running; }
+
+    // whose calls the samples are put down to from now on
+    void begin_turn(int robot) { m_robot = robot; }
+
+    const RobotProfile& profile() const { return m_profile; }
+
+    // for the signal handler only
+    void take_sample(void* context);
+
+private:
+
+    friend class RobotProfileScope;
+
+    struct Sample
+    {
+        int robot;
+        int depth;
+        std::array<uintptr_t, max_depth> pcs;
+    };
+
+    bool m_running;
+    void* m_timer; // a timer_t, which is a pointer on Linux
+    uintptr_t m_stack_low;
+    uintptr_t m_stack_high;
+
+    volatile sig_atomic_t m_in_call;
+    volatile sig_atomic_t m_robot;
+
+    std::vector<Sample> m_ring;
+    std::atomic<std::size_t> m_head;
+    std::atomic<std::size_t> m_tail;
+    std::atomic<uint64_t> m_engine_samples;
+    std::atomic<uint64_t> m_lost_samples;
+
+    std::map<std::vector<uintptr_t>, uint64_t> m_stacks; // robot, then the pcs leaf first
+    RobotProfile m_profile;
+};
+
+// robot code is running while in scope, so samples go to the robot whose turn
+// it is. a null profiler does nothing.
+class RobotProfileScope
+{
+public:
+
+    explicit RobotProfileScope(RobotProfiler* profiler) : m_profiler(profiler)
+    {
+        if (m_profiler)
+            m_profiler->m_in_call = 1;
+    }
+
+    ~RobotProfileScope()
+    {
+        if (m_profiler)
+            m_profiler->m_in_call = 0;
+    }
+
+    RobotProfileScope(const RobotProfileScope&) = delete;
+    RobotProfileScope& operator=(const RobotProfileScope&) = delete;
+
+private:
+
+    RobotProfiler* m_profiler;
+};
+
+#endif
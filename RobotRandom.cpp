@@ -0,0 +1,99 @@
+#include "RobotRandom.h"
+
+void RobotRandom::seed(unsigned seed)
+{
+    // glibc's srandom(): a minimal standard generator fills the table, then the
+    // first 310 numbers are thrown away
+    int32_t word = seed == 0 ? 1 : static_cast<int32_t>(seed);
+    m_table[0] = word;
+    for (int i = 1; i < 31; ++i)
+    {
+        int32_t hi = word / 127773;
+        int32_t lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+        {
+            word += 2147483647;
+        }
+        m_table[i] = word;
+    }
+    m_front = 3;
+    m_rear = 0;
+    for (int i = 0; i < 310; ++i)
+    {
+        next();
+    }
+}
+
+int RobotRandom::next()
+{
+    uint32_t sum = static_cast<uint32_t>(m_table[m_front]) + static_cast<uint32_t>(m_table[m_rear]);
+    m_table[m_front] = static_cast<int32_t>(sum);
+    m_front = m_front == 30 ? 0 : m_front + 1;
+    m_rear = m_rear == 30 ? 0 : m_rear + 1;
+    return static_cast<int>(sum >> 1);
+}
+
+std::string RobotRandom::state() const
+{
+    // 31 words, then the two positions, a byte each
+    std::string out;
+    for (int32_t word : m_table)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            out.push_back(static_cast<char>(static_cast<uint32_t>(word) >> (8 * i)));
+        }
+    }
+    out.push_back(static_cast<char>(m_front));
+    out.push_back(static_cast<char>(m_rear));
+    return out;
+}
+
+bool RobotRandom::restore(const std::string& state)
+{
+    if (state.size() != sizeof(m_table) + 2)
+    {
+        return false;
+    }
+    int front = static_cast<unsigned char>(state[sizeof(m_table)]);
+    int rear = static_cast<unsigned char>(state[sizeof(m_table) + 1]);
+    // the front always runs 3 ahead of the rear
+    if (front > 30 || rear > 30 || front != (rear + 3) % 31)
+    {
+        return false;
+    }
+    for (int word = 0; word < 31; ++word)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(state[word * 4 + i])) << (8 * i);
+        }
+        m_table[word] = static_cast<int32_t>(value);
+    }
+    m_front = front;
+    m_rear = rear;
+    return true;
+}
+
+bool RobotRandom::operator==(const RobotRandom& other) const
+{
+    return state() == other.state();
+}
+
+RobotRandom& thread_robot_random()
+{
+    thread_local RobotRandom random;
+    return random;
+}
+
+extern "C" int rand()
+{
+    return thread_robot_random().next();
+}
+
+extern "C" void srand(unsigned seed)
+{
+    thread_robot_random().seed(seed);
+}
@@ -0,0 +1,48 @@
+#ifndef __ROBOTRANDOM_H__
+#define __ROBOTRANDOM_H__
+
+#include <cstdint>
+#include <string>
+
+// rand() for the robots, one per thread. RobotRandom.cpp replaces the C
+// library's rand() and srand(), which robots find in the executable the same
+// way they find RobotMemory's operator new. A game runs its robots on the
+// thread that plays it and seeds rand() there from the game's seed, so with
+// games on several threads each game still gets the numbers its seed gives,
+// whatever the other games are doing.
+//
+// The numbers are the ones glibc's rand() gives for the same seed (its
+// additive feedback generator), so games recorded before come out the same.
+// A snapshot of a game takes the generator with it, so a game resumed from a
+// checkpoint draws the numbers it would have drawn without the break.
+
+class RobotRandom
+{
+public:
+
+    explicit RobotRandom(unsigned seed = 1) { this->seed(seed); }
+
+    void seed(unsigned seed);
+
+    // 0 .. RAND_MAX
+    int next();
+
+    // the table and where the generator is in it, for checkpoints. restore()
+    // is false, and leaves the generator as it was, for anything state() can't
+    // have given.
+    std::string state() const;
+    bool restore(const std::string& state);
+
+    bool operator==(const RobotRandom& other) const;
+
+private:
+
+    int32_t m_table[31];
+    int m_front;
+    int m_rear;
+};
+
+// this thread's generator, the one rand() and srand() use
+RobotRandom& thread_robot_random();
+
+#endif
@@ -0,0 +1,226 @@
+#include "RobotTiming.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+
+LatencyHistogram::LatencyHistogram()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+    m_total = 0;
+}
+
+// below 16 a bucket is one value. from there on a power of two 2^e is split in
+// 16 and the bucket is (e - 3) * 16 plus which sixteenth the value is in.
+int LatencyHistogram::bucket(uint64_t ns)
+{
+    if (ns < sub_buckets)
+    {
+        return static_cast<int>(ns);
+    }
+    int exponent = std::bit_width(ns) - 1;
+    int sub = static_cast<int>(ns >> (exponent - 4)) - sub_buckets;
+    return (exponent - 3) * sub_buckets + sub;
+}
+
+uint64_t LatencyHistogram::bucket_top(int index)
+{
+    if (index < sub_buckets)
+    {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = index / sub_buckets + 3;
+    uint64_t sub = static_cast<uint64_t>(index % sub_buckets);
+    uint64_t width = 1ULL << (exponent - 4);
+    return (sub_buckets + sub) * width + (width - 1);
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    ++m_buckets[bucket(ns)];
+    ++m_count;
+    m_total += ns;
+    m_max = std::max(m_max, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (int i = 0; i < bucket_count; ++i)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_total += other.m_total;
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+    uint64_t wanted = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * m_count));
+    wanted = std::max<uint64_t>(wanted, 1);
+
+    uint64_t seen = 0;
+    for (int i = 0; i < bucket_count; ++i)
+    {
+        seen += m_buckets[i];
+        if (seen >= wanted)
+        {
+            return std::min(bucket_top(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+const char* robot_call_name(RobotCall call)
+{
+    switch (call)
+    {
+        case RobotCall::RadarDirection: return "get_radar_direction";
+        case RobotCall::ProcessRadar:   return "process_radar_results";
+        case RobotCall::ShotLocation:   return "get_shot_location";
+        case RobotCall::MoveDirection:  return "get_move_direction";
+        default:                        return "?";
+    }
+}
+
+uint64_t RobotTiming::cpu_ns() const
+{
+    uint64_t total = 0;
+    for (const CallTiming& call : calls)
+    {
+        total += call.cpu_ns;
+    }
+    return total;
+}
+
+uint64_t RobotTiming::cost_ns() const
+{
+    if (cpu)
+    {
+        return cpu_ns();
+    }
+    uint64_t total = 0;
+    for (const CallTiming& call : calls)
+    {
+        total += call.wall.total();
+    }
+    return total;
+}
+
+void RobotTiming::merge(const RobotTiming& other)
+{
+    for (std::size_t i = 0; i < calls.size(); ++i)
+    {
+        calls[i].wall.merge(other.calls[i].wall);
+        calls[i].cpu_ns += other.calls[i].cpu_ns;
+    }
+}
+
+void merge_robot_timing(std::vector<RobotTiming>& into, const std::vector<RobotTiming>& from)
+{
+    for (const RobotTiming& timing : from)
+    {
+        auto same = std::find_if(into.begin(), into.end(),
+                                 [&](const RobotTiming& robot) { return robot.name == timing.name; });
+        if (same == into.end())
+            into.push_back(timing);
+        else
+            same->merge(timing);
+    }
+}
+
+CallTimer::CallTimer(RobotTiming* timing, RobotCall call)
+{
+    // the CPU clock costs a system call, keep it outside the wall clock reads
+    m_timing = timing ? &(*timing)[call] : nullptr;
+    m_cpu = timing && timing->cpu;
+    m_cpu_start = m_cpu ? thread_cpu_ns() : 0;
+    m_wall_start = m_timing ? wall_ns() : 0;
+}
+
+CallTimer::~CallTimer()
+{
+    if (m_timing)
+    {
+        m_timing->wall.record(wall_ns() - m_wall_start);
+        if (m_cpu)
+        {
+            m_timing->cpu_ns += thread_cpu_ns() - m_cpu_start;
+        }
+    }
+}
+
+uint64_t CallTimer::wall_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t CallTimer::thread_cpu_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+std::string format_ns(uint64_t ns)
+{
+    char text[32];
+    if (ns < 1000)
+        std::snprintf(text, sizeof(text), "%lluns", static_cast<unsigned long long>(ns));
+    else if (ns < 1000000)
+        std::snprintf(text, sizeof(text), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        std::snprintf(text, sizeof(text), "%.1fms", ns / 1e6);
+    else
+        std::snprintf(text, sizeof(text), "%.2fs", ns / 1e9);
+    return text;
+}
+
+std::string format_robot_timing(const std::vector<RobotTiming>& robots)
+{
+    std::vector<const RobotTiming*> sorted;
+    for (const RobotTiming& robot : robots)
+    {
+        sorted.push_back(&robot);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const RobotTiming* a, const RobotTiming* b) { return a->cost_ns() > b->cost_ns(); });
+
+    std::ostringstream out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "Robot call times %9s %9s %9s %9s %9s %9s\n",
+                  "", "calls", "p50", "p99", "max", "cpu");
+    out << line;
+    for (const RobotTiming* robot : sorted)
+    {
+        out << "  " << robot->name;
+        if (robot->cpu)
+        {
+            out << " (cpu " << format_ns(robot->cpu_ns()) << ")";
+        }
+        out << "\n";
+        for (int i = 0; i < static_cast<int>(RobotCall::Count); ++i)
+        {
+            const CallTiming& call = robot->calls[i];
+            std::snprintf(line, sizeof(line), "    %-22s %9llu %9s %9s %9s %9s\n",
+                          robot_call_name(static_cast<RobotCall>(i)),
+                          static_cast<unsigned long long>(call.wall.count()),
+                          format_ns(call.wall.percentile(0.5)).c_str(),
+                          format_ns(call.wall.percentile(0.99)).c_str(),
+                          format_ns(call.wall.max()).c_str(),
+                          robot->cpu ? format_ns(call.cpu_ns).c_str() : "-");
+            out << line;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,123 @@
+#ifndef __ROBOTTIMING_H__
+#define __ROBOTTIMING_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How long robots take to make up their minds. Every call into robot code is
+// timed on the wall clock into a latency histogram, and optionally the calling
+// thread's CPU time is added up too. The game prints p50/p99/max per robot and
+// callback when it ends, so a slow robot shows up by name rather than as a
+// slow tournament.
+//
+// The wall clock is read in user space for a few tens of ns. The thread CPU
+// clock is a system call, around 300ns a read on Linux, which on a long game of
+// fast robots adds up to several percent. Hence the two modes.
+
+// HDR style histogram: exact below 16ns, then 16 buckets for every power of
+// two, so any value read back is within 1/16 of the one recorded. Fixed size,
+// recording is a couple of shifts and an increment.
+class LatencyHistogram
+{
+public:
+
+    static const int sub_buckets = 16;
+    static const int bucket_count = (64 - 3) * sub_buckets;
+
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t max() const { return m_max; }
+    uint64_t total() const { return m_total; }
+
+    // the smallest value at least this fraction (0 to 1) of the calls took no
+    // longer than, as the top of its bucket and never above max()
+    uint64_t percentile(double fraction) const;
+
+private:
+
+    static int bucket(uint64_t ns);
+    static uint64_t bucket_top(int index);
+
+    std::array<uint64_t, bucket_count> m_buckets;
+    uint64_t m_count;
+    uint64_t m_max;
+    uint64_t m_total;
+};
+
+enum class RobotTimingMode
+{
+    Off,
+    Wall, // latency histograms only
+    Cpu   // and thread CPU time
+};
+
+enum class RobotCall
+{
+    RadarDirection,
+    ProcessRadar,
+    ShotLocation,
+    MoveDirection,
+    Count
+};
+
+const char* robot_call_name(RobotCall call);
+
+struct CallTiming
+{
+    LatencyHistogram wall;
+    uint64_t cpu_ns = 0;
+};
+
+struct RobotTiming
+{
+    std::string name;
+    bool cpu = false; // whether CPU time is counted
+    std::array<CallTiming, static_cast<int>(RobotCall::Count)> calls;
+
+    CallTiming& operator[](RobotCall call) { return calls[static_cast<int>(call)]; }
+    const CallTiming& operator[](RobotCall call) const { return calls[static_cast<int>(call)]; }
+    uint64_t cpu_ns() const;
+    uint64_t cost_ns() const; // CPU time if counted, wall time if not
+
+    // adds up games, e.g. a batch
+    void merge(const RobotTiming& other);
+};
+
+// each robot's timing added to the one of the same name, or added as a new one
+void merge_robot_timing(std::vector<RobotTiming>& into, const std::vector<RobotTiming>& from);
+
+// times one call for as long as it is in scope. a null timing times nothing.
+class CallTimer
+{
+public:
+
+    CallTimer(RobotTiming* timing, RobotCall call);
+    ~CallTimer();
+
+    CallTimer(const CallTimer&) = delete;
+    CallTimer& operator=(const CallTimer&) = delete;
+
+    static uint64_t wall_ns();
+    static uint64_t thread_cpu_ns();
+
+private:
+
+    CallTiming* m_timing;
+    bool m_cpu;
+    uint64_t m_wall_start;
+    uint64_t m_cpu_start;
+};
+
+// "850ns", "12.5us", "3.2ms", "1.40s"
+std::string format_ns(uint64_t ns);
+
+// the end of game table, slowest robot first
+std::string format_robot_timing(const std::vector<RobotTiming>& robots);
+
+#endif
@@ -2,19 +2,202 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <limits>
 #include "Arena.h"
+#include "Batch.h"
+#include "Tournament.h"
+#include "ResultsStore.h"
 
-int main()
+// RobotWarz [--config <file>] [--batch] [--quiet] [--replay <file>] [--resume <file>]
+//   --config   settings file, RobotWarz.cfg by default
+//   --batch    don't wait for the enter key
+//   --quiet    no turn by turn text and no log file
+//   --replay   play a recorded game again without the robots and check it
+//   --resume   carry on a game or a batch of --games from a checkpoint (see
+//              CheckpointFile in the config). a tournament is carried on by
+//              running it again with a ResultsFile and a Seed: the games it
+//              played are taken from the store.
+//
+// RobotWarz --games <n> [--jobs <n>] [--metrics <file>] [--metrics-socket <path>] [--config <file>]
+//   --games    play n games without output, with seeds Seed, Seed+1, ...
+//   --jobs     worker threads for the games, 1 by default
+//   --metrics  progress in the Prometheus text format, rewritten every few seconds
+//   --metrics-socket  the same, to whoever connects to this Unix socket
+//
+// RobotWarz --tournament <format> [--players <n>] [--repeats <n>] [--rounds <n>] [--map <file>]... [--jobs <n>] [--results <file>] [--fresh]
+//   --tournament  roundrobin, swiss or ffa (see Tournament.h)
+//   --players     robots a game in roundrobin and swiss, 2 by default
+//   --repeats     games per pairing on each map, 1 by default
+//   --rounds      swiss rounds, log2 of the robots by default
+//   --map         a config to play every pairing on, as many as you like. --config if none
+//   --results     the results matrix as CSV
+//   --fresh       play every game, even the ones already in the ResultsFile
+//
+// RobotWarz --ratings [--robot <name>] [--config <file>]
+//   --ratings  the Elo ladder from the config's ResultsFile
+//   --robot    that robot's record against every other one instead
+//
+// RobotWarz --rules-version
+//   engine_rules_version, for make golden and make verify
+int main(int argc, char* argv[])
 {
+    std::string config_path = "RobotWarz.cfg";
+    std::string replay_path;
+    std::string resume_path;
+    bool batch = false;
+    bool quiet = false;
+    BatchOptions batch_options;
+    uint64_t games = 0;
+    bool tournament = false;
+    bool ratings = false;
+    std::string ratings_robot;
+    TournamentOptions tournament_options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc)
+            config_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (arg == "--resume" && i + 1 < argc)
+            resume_path = argv[++i];
+        else if (arg == "--games" && i + 1 < argc)
+            games = std::stoull(argv[++i]);
+        else if (arg == "--jobs" && i + 1 < argc)
+            batch_options.jobs = tournament_options.jobs = std::stoi(argv[++i]);
+        else if (arg == "--tournament" && i + 1 < argc && parse_tournament_format(argv[++i], tournament_options.format))
+            tournament = true;
+        else if (arg == "--players" && i + 1 < argc)
+            tournament_options.players = std::stoi(argv[++i]);
+        else if (arg == "--repeats" && i + 1 < argc)
+            tournament_options.repeats = std::stoi(argv[++i]);
+        else if (arg == "--rounds" && i + 1 < argc)
+            tournament_options.rounds = std::stoi(argv[++i]);
+        else if (arg == "--map" && i + 1 < argc)
+            tournament_options.maps.push_back(argv[++i]);
+        else if (arg == "--results" && i + 1 < argc)
+            tournament_options.results_path = argv[++i];
+        else if (arg == "--fresh")
+            tournament_options.reuse = false;
+        else if (arg == "--metrics" && i + 1 < argc)
+            batch_options.metrics_path = argv[++i];
+        else if (arg == "--metrics-socket" && i + 1 < argc)
+            batch_options.metrics_socket = argv[++i];
+        else if (arg == "--ratings")
+            ratings = true;
+        else if (arg == "--robot" && i + 1 < argc)
+            ratings_robot = argv[++i];
+        else if (arg == "--rules-version")
+        {
+            std::cout << engine_rules_version << std::endl;
+            return 0;
+        }
+        else if (arg == "--batch")
+            batch = true;
+        else if (arg == "--quiet")
+            quiet = true;
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--config <file>] [--batch] [--quiet] [--replay <file>] [--resume <file>]\n"
+                      << "       " << argv[0] << " --games <n> [--jobs <n>] [--metrics <file>] [--metrics-socket <path>] [--config <file>]\n"
+                      << "       " << argv[0] << " --tournament roundrobin|swiss|ffa [--players <n>] [--repeats <n>] [--rounds <n>] [--map <file>]... [--jobs <n>] [--results <file>] [--fresh]\n"
+                      << "       " << argv[0] << " --ratings [--robot <name>] [--config <file>]\n"
+                      << "       " << argv[0] << " --rules-version\n";
+            return 1;
+        }
+    }
+
     std::srand(static_cast<unsigned>(std::time(nullptr)));
-    Arena the_arena("RobotWarz.cfg");
+
+    if (ratings)
+    {
+        Arena config(config_path);
+        ResultsStore store;
+        if (config.results_path().empty())
+        {
+            std::cerr << "No ResultsFile in " << config_path << "." << std::endl;
+            return 1;
+        }
+        if (!store.open(config.results_path()))
+        {
+            return 1;
+        }
+        if (ratings_robot.empty())
+        {
+            std::cout << format_ratings(store);
+            return 0;
+        }
+        int robot = store.find_robot(ratings_robot);
+        if (robot < 0)
+        {
+            std::cerr << "No games for " << ratings_robot << " in " << config.results_path() << "." << std::endl;
+            return 1;
+        }
+        std::cout << format_head_to_head(store, robot);
+        return 0;
+    }
+
+    if (tournament)
+    {
+        std::vector<RobotEntry> robots;
+        if (!Arena::compile_robots(robots))
+        {
+            std::cerr << "No robots to play with." << std::endl;
+            return 1;
+        }
+        if (tournament_options.maps.empty())
+            tournament_options.maps.push_back(config_path);
+        return run_tournament(tournament_options, robots) ? 0 : 1;
+    }
+
+    if (games > 0 || (!resume_path.empty() && is_batch_checkpoint(resume_path)))
+    {
+        std::vector<RobotEntry> robots;
+        if (!Arena::compile_robots(robots))
+        {
+            std::cerr << "No robots to play with." << std::endl;
+            return 1;
+        }
+        batch_options.config_path = config_path;
+        batch_options.games = games;
+        batch_options.resume_path = resume_path;
+        return run_batch(batch_options, robots) ? 0 : 1;
+    }
+
+    Arena the_arena(config_path);
+    the_arena.set_quiet(quiet);
+
+    if (!replay_path.empty())
+    {
+        if (!the_arena.load_replay(replay_path))
+        {
+            return 1;
+        }
+        the_arena.run_simulation();
+        return the_arena.replay_matched() ? 0 : 1;
+    }
+
+    if (!resume_path.empty())
+    {
+        if (!the_arena.load_robots() || !the_arena.resume(resume_path))
+        {
+            return 1;
+        }
+        the_arena.run_simulation();
+        return 0;
+    }
+
     the_arena.initialize_board();
     the_arena.load_robots();
-    the_arena.print_board(0,std::cout,true);
-    std::cout << "Press enter key to begin.";
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    if (!batch)
+    {
+        the_arena.print_board(0,std::cout,true);
+        std::cout << "Press enter key to begin.";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
 
     the_arena.run_simulation();
 
     return 0;
-}
\ No newline at end of file
+}
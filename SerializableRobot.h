@@ -0,0 +1,24 @@
+#ifndef __SERIALIZABLEROBOT_H__
+#define __SERIALIZABLEROBOT_H__
+
+#include <string>
+#include <string_view>
+
+// Optional for robots. The arena's snapshots and checkpoints always keep a
+// robot's health, armor, moves, grenades and location. A robot that remembers
+// things of its own (targets, maps, a plan) can also inherit from this to have
+// that saved and put back:
+//
+//     class Robot_Foo : public RobotBase, public SerializableRobot
+//
+// save_state() returns whatever bytes it needs, load_state() gets them back and
+// returns false if it can't use them.
+class SerializableRobot
+{
+public:
+    virtual ~SerializableRobot() {}
+    virtual std::string save_state() const = 0;
+    virtual bool load_state(std::string_view state) = 0;
+};
+
+#endif
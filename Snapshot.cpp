@@ -0,0 +1,158 @@
+#include "Snapshot.h"
+#include <algorithm>
+
+// 3 bit codes for what a cell holds, bit 3 marks a flamethrower underneath
+static const char cell_chars[] = {'.', 'M', 'P', 'F', 'R', 'X'};
+static const int other_code = 7;
+static const uint64_t flame_bit = 8;
+static const int cells_per_word = 16;
+
+static int cell_code(char cell)
+{
+    switch (cell)
+    {
+        case '.': return 0;
+        case 'M': return 1;
+        case 'P': return 2;
+        case 'F': return 3;
+        case 'R': return 4;
+        case 'X': return 5;
+        default:  return other_code;
+    }
+}
+
+std::shared_ptr<const PackedBoard> PackedBoard::pack(const std::vector<std::vector<char>>& board,
+                                                     const std::set<std::pair<int,int>>& flamethrowers)
+{
+    auto packed = std::make_shared<PackedBoard>();
+    packed->rows = static_cast<int>(board.size());
+    packed->cols = packed->rows > 0 ? static_cast<int>(board[0].size()) : 0;
+
+    std::size_t total = static_cast<std::size_t>(packed->rows) * packed->cols;
+    packed->words.assign((total + cells_per_word - 1) / cells_per_word, 0);
+
+    std::size_t index = 0;
+    for (const auto& row : board)
+    {
+        for (char cell : row)
+        {
+            uint64_t code = cell_code(cell);
+            if (code == other_code)
+            {
+                packed->other.emplace_back(static_cast<uint32_t>(index), cell);
+            }
+            packed->words[index / cells_per_word] |= code << (4 * (index % cells_per_word));
+            ++index;
+        }
+    }
+
+    for (const auto& [row, col] : flamethrowers)
+    {
+        if (row >= 0 && row < packed->rows && col >= 0 && col < packed->cols)
+        {
+            std::size_t cell = static_cast<std::size_t>(row) * packed->cols + col;
+            packed->words[cell / cells_per_word] |= flame_bit << (4 * (cell % cells_per_word));
+        }
+    }
+    return packed;
+}
+
+void PackedBoard::unpack(std::vector<std::vector<char>>& board, std::set<std::pair<int,int>>& flamethrowers) const
+{
+    board.resize(rows);
+    flamethrowers.clear();
+
+    std::size_t index = 0;
+    for (int row = 0; row < rows; ++row)
+    {
+        board[row].resize(cols);
+        char* cells = board[row].data();
+        for (int col = 0; col < cols; ++col, ++index)
+        {
+            unsigned nibble = static_cast<unsigned>(words[index / cells_per_word] >> (4 * (index % cells_per_word))) & 15;
+            unsigned code = nibble & 7;
+            cells[col] = code < sizeof(cell_chars) ? cell_chars[code] : '.';
+            if (nibble & flame_bit)
+            {
+                flamethrowers.insert({row, col});
+            }
+        }
+    }
+
+    for (const auto& [cell, value] : other)
+    {
+        board[cell / cols][cell % cols] = value;
+    }
+}
+
+std::shared_ptr<const PackedBoard> PackedBoard::patch(const std::vector<std::pair<int,int>>& cells,
+                                                      const std::vector<std::vector<char>>& board,
+                                                      const std::set<std::pair<int,int>>& flamethrowers) const
+{
+    auto packed = std::make_shared<PackedBoard>(*this);
+
+    for (const auto& [row, col] : cells)
+    {
+        std::size_t index = static_cast<std::size_t>(row) * cols + col;
+        char cell = board[row][col];
+        uint64_t code = cell_code(cell);
+        if (flamethrowers.count({row, col}))
+        {
+            code |= flame_bit;
+        }
+
+        uint64_t& word = packed->words[index / cells_per_word];
+        int shift = 4 * (index % cells_per_word);
+        word = (word & ~(15ULL << shift)) | (code << shift);
+
+        // the odd characters are kept to one side, drop the cell's old one if it had one
+        auto& other = packed->other;
+        other.erase(std::remove_if(other.begin(), other.end(),
+                                   [index](const auto& entry) { return entry.first == index; }),
+                    other.end());
+        if ((code & 7) == static_cast<uint64_t>(other_code))
+        {
+            other.emplace_back(static_cast<uint32_t>(index), cell);
+        }
+    }
+    return packed;
+}
+
+uint64_t pack_robot_state(const RobotState& state)
+{
+    auto field = [](int value, int bits) { return static_cast<uint64_t>(value) & ((1ULL << bits) - 1); };
+    return field(state.health, 8) | field(state.armor, 8) << 8 | field(state.move, 8) << 16 |
+           field(state.grenades, 8) << 24 | field(state.row, 16) << 32 | field(state.col, 16) << 48;
+}
+
+RobotState unpack_robot_state(uint64_t packed)
+{
+    RobotState state;
+    state.health = static_cast<int>(packed & 0xff);
+    state.armor = static_cast<int>((packed >> 8) & 0xff);
+    state.move = static_cast<int>((packed >> 16) & 0xff);
+    state.grenades = static_cast<int>((packed >> 24) & 0xff);
+    state.row = static_cast<int>((packed >> 32) & 0xffff);
+    state.col = static_cast<int>((packed >> 48) & 0xffff);
+    return state;
+}
+
+std::size_t ArenaSnapshot::bytes() const
+{
+    std::size_t total = sizeof(*this) + robots.size() * sizeof(uint64_t);
+    for (const std::string& data : robot_data)
+    {
+        total += sizeof(data) + data.size();
+    }
+    return total;
+}
+
+void RobotSnapshotAccess::restore(RobotBase* robot, const RobotState& state)
+{
+    robot->m_health = state.health;
+    robot->m_armor = state.armor;
+    robot->m_move = state.move;
+    robot->m_grenades = state.grenades;
+    robot->m_location_row = state.row;
+    robot->m_location_col = state.col;
+}
@@ -0,0 +1,70 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include "RobotBase.h"
+#include "Replay.h"
+#include "RobotRandom.h"
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Snapshots of a game in progress, for branching (many what-if continuations
+// from round N) and for checkpoints.
+//
+// The board is packed 4 bits a cell: 3 bits for what is there and 1 bit for a
+// flamethrower underneath, which comes back when a robot steps off it. Packed
+// boards are shared and never modified: every snapshot taken while the board
+// hasn't changed points at the same one, and restoring one doesn't copy it
+// again. When only a few cells have changed, the new one is a patched copy of
+// the last. A robot's engine side state fits in one 64 bit word.
+
+struct PackedBoard
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<uint64_t> words;                  // 16 cells per word
+    std::vector<std::pair<uint32_t, char>> other; // cells that aren't . M P F R X
+
+    static std::shared_ptr<const PackedBoard> pack(const std::vector<std::vector<char>>& board,
+                                                   const std::set<std::pair<int,int>>& flamethrowers);
+    void unpack(std::vector<std::vector<char>>& board, std::set<std::pair<int,int>>& flamethrowers) const;
+
+    // a copy with some cells packed again. much cheaper than pack() on a big
+    // board where a turn only changes a few cells.
+    std::shared_ptr<const PackedBoard> patch(const std::vector<std::pair<int,int>>& cells,
+                                             const std::vector<std::vector<char>>& board,
+                                             const std::set<std::pair<int,int>>& flamethrowers) const;
+
+    std::size_t bytes() const { return sizeof(*this) + words.size() * 8 + other.size() * 8; }
+};
+
+// health, armor, moves and grenades 8 bits each, row and column 16 bits each
+uint64_t pack_robot_state(const RobotState& state);
+RobotState unpack_robot_state(uint64_t packed);
+
+struct ArenaSnapshot
+{
+    int round = 0;
+    uint64_t seed = 0;
+    uint64_t rng_state = 0;
+    uint64_t rng_increment = 0;
+    RobotRandom robot_rng; // the game thread's rand(), see RobotRandom.h
+    std::shared_ptr<const PackedBoard> board;
+    std::vector<uint64_t> robots;
+    std::vector<std::string> robot_data; // from SerializableRobot, empty for other robots
+
+    // memory held by this snapshot alone (the board may be shared)
+    std::size_t bytes() const;
+};
+
+// puts a robot's private engine side state back. RobotBase only lets the game
+// take health, armor and the rest away.
+struct RobotSnapshotAccess
+{
+    static void restore(RobotBase* robot, const RobotState& state);
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "Stalemate.h"
+#include <deque>
+#include <utility>
+
+namespace
+{
+
+struct Grid
+{
+    int rows, cols;
+    std::vector<int> values;
+
+    Grid(int rows_in, int cols_in, int value) : rows(rows_in), cols(cols_in), values(static_cast<std::size_t>(rows_in) * cols_in, value) {}
+    int& at(int row, int col) { return values[static_cast<std::size_t>(row) * cols + col]; }
+};
+
+const int king_moves[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+const int rook_moves[4][2] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+
+}
+
+// cells robot can get to, marked 1 in the returned grid. false if one of them
+// is a flamethrower.
+static bool reachable_cells(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& living,
+                            const std::set<std::pair<int,int>>& flamethrowers, RobotBase* robot, Grid& reach)
+{
+    int row, col;
+    robot->get_current_location(row, col);
+    reach.at(row, col) = 1;
+    if (robot->get_move_speed() == 0)
+    {
+        return true;
+    }
+    if (flamethrowers.count({row, col}))
+    {
+        return false; // standing on one, it can step off and back on
+    }
+
+    // cells of robots that can still move are only in the way for now
+    Grid mobile(reach.rows, reach.cols, 0);
+    for (RobotBase* other : living)
+    {
+        if (other != robot && other->get_move_speed() > 0)
+        {
+            int other_row, other_col;
+            other->get_current_location(other_row, other_col);
+            mobile.at(other_row, other_col) = 1;
+        }
+    }
+
+    std::deque<std::pair<int,int>> queue{{row, col}};
+    while (!queue.empty())
+    {
+        auto [r, c] = queue.front();
+        queue.pop_front();
+        for (const auto& move : king_moves)
+        {
+            int next_row = r + move[0];
+            int next_col = c + move[1];
+            if (next_row < 0 || next_row >= reach.rows || next_col < 0 || next_col >= reach.cols ||
+                reach.at(next_row, next_col))
+                continue;
+
+            char cell = board[next_row][next_col];
+            if (cell == 'F' || (cell == 'R' && mobile.at(next_row, next_col) &&
+                                flamethrowers.count({next_row, next_col})))
+                return false;
+            if (cell == 'P')
+            {
+                reach.at(next_row, next_col) = 1; // in, but not out again
+            }
+            else if (cell == '.' || (cell == 'R' && mobile.at(next_row, next_col)))
+            {
+                reach.at(next_row, next_col) = 1;
+                queue.push_back({next_row, next_col});
+            }
+        }
+    }
+    return true;
+}
+
+// how far every cell is from the nearest cell in from, up to limit. king moves
+// or rook moves, obstacles don't matter to a shot.
+static Grid distance_from(const Grid& from, int limit, bool king)
+{
+    Grid distance(from.rows, from.cols, limit + 1);
+    std::deque<std::pair<int,int>> queue;
+    for (int r = 0; r < from.rows; ++r)
+    {
+        for (int c = 0; c < from.cols; ++c)
+        {
+            if (from.values[static_cast<std::size_t>(r) * from.cols + c])
+            {
+                distance.at(r, c) = 0;
+                queue.push_back({r, c});
+            }
+        }
+    }
+
+    while (!queue.empty())
+    {
+        auto [r, c] = queue.front();
+        queue.pop_front();
+        int next_distance = distance.at(r, c) + 1;
+        if (next_distance > limit)
+            continue;
+
+        int count = king ? 8 : 4;
+        for (int i = 0; i < count; ++i)
+        {
+            int next_row = r + (king ? king_moves[i][0] : rook_moves[i][0]);
+            int next_col = c + (king ? king_moves[i][1] : rook_moves[i][1]);
+            if (next_row < 0 || next_row >= from.rows || next_col < 0 || next_col >= from.cols ||
+                distance.at(next_row, next_col) <= next_distance)
+                continue;
+            distance.at(next_row, next_col) = next_distance;
+            queue.push_back({next_row, next_col});
+        }
+    }
+    return distance;
+}
+
+bool prove_stalemate(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots,
+                     const std::set<std::pair<int,int>>& flamethrowers, std::string& reason)
+{
+    std::vector<RobotBase*> living;
+    for (RobotBase* robot : robots)
+    {
+        if (robot->get_health() > 0)
+            living.push_back(robot);
+    }
+    if (living.size() < 2 || board.empty())
+    {
+        return false; // there's a winner, or nobody left to win
+    }
+
+    int rows = static_cast<int>(board.size());
+    int cols = static_cast<int>(board[0].size());
+
+    std::vector<Grid> reach;
+    for (RobotBase* robot : living)
+    {
+        reach.emplace_back(rows, cols, 0);
+        if (!reachable_cells(board, living, flamethrowers, robot, reach.back()))
+        {
+            return false; // it can still walk into a flamethrower
+        }
+    }
+
+    for (std::size_t i = 0; i < living.size(); ++i)
+    {
+        RobotBase* attacker = living[i];
+        int range = 0;
+        bool king = true;
+        switch (attacker->get_weapon())
+        {
+            case railgun:
+                return false;
+            case hammer:
+                range = 1;
+                break;
+            case flamethrower:
+                range = 4;
+                break;
+            case grenade:
+                if (attacker->get_grenades() <= 0)
+                    continue;
+                range = 14;
+                king = false;
+                break;
+            default:
+                continue;
+        }
+
+        Grid distance = distance_from(reach[i], range, king);
+        for (std::size_t j = 0; j < living.size(); ++j)
+        {
+            if (j == i)
+                continue;
+            for (std::size_t cell = 0; cell < distance.values.size(); ++cell)
+            {
+                if (reach[j].values[cell] && distance.values[cell] <= range)
+                    return false;
+            }
+        }
+    }
+
+    reason = "no robot can ever damage another";
+    return true;
+}
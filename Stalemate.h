@@ -0,0 +1,37 @@
+#ifndef __STALEMATE_H__
+#define __STALEMATE_H__
+
+#include "RobotBase.h"
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Proves that no living robot can ever damage another, so a game that can only
+// spin to MaxRounds can be ended now.
+//
+// Every bound is on the generous side, so "proven" really means it:
+//   - where a robot can get to: every cell joined to it by '.' cells, plus the
+//     cells of other robots that can still move (they may get out of the way)
+//     and pits (which it can fall into but not leave). A robot that can't move
+//     stays where it is. Mounds, dead robots and robots stuck for good block.
+//   - what its weapon can hit from a cell: hammer 1 cell away, flamethrower 4
+//     cells (counted in king moves, the flame itself is round), grenades 14 cells
+//     counted in rook moves (10 to the target, 2 more each way for the blast)
+//     while it has any left. A railgun shot crosses the whole board at any angle
+//     through anything, so a living railgun robot is never a stalemate.
+//   - flamethrower cells hurt whoever walks in, so a robot that can reach one
+//     can still die, and the game isn't settled. A robot that survived stepping
+//     onto one hides it on the board (it shows R until the robot leaves), so
+//     flamethrowers is where they all are; a mobile robot standing on one can
+//     step off and back.
+//
+// Only damage one robot deals another counts. A hammer aimed at the robot's own
+// cell hits the robot itself, and so can its own grenade; a robot can still end
+// its own game that way.
+//
+// Takes O(robots x cells) time.
+bool prove_stalemate(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots,
+                     const std::set<std::pair<int,int>>& flamethrowers, std::string& reason);
+
+#endif
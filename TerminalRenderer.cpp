@@ -0,0 +1,133 @@
+#include "TerminalRenderer.h"
+#include <cerrno>
+#include <unistd.h>
+
+// two changed runs closer than this are sent as one, a cursor move costs ~8 bytes
+static const std::size_t merge_gap = 8;
+
+TerminalRenderer::TerminalRenderer(int fd) : m_fd(fd), m_full_redraw(true)
+{
+}
+
+void TerminalRenderer::reset()
+{
+    m_full_redraw = true;
+    m_screen.clear();
+}
+
+static void move_cursor(std::string& out, int row, std::size_t col)
+{
+    // terminal rows and columns are 1 based
+    out += "\x1b[";
+    out += std::to_string(row + 1);
+    out += ';';
+    out += std::to_string(col + 1);
+    out += 'H';
+}
+
+std::size_t TerminalRenderer::draw(const std::string& frame)
+{
+    m_lines.clear();
+    std::size_t start = 0;
+    while (start < frame.size())
+    {
+        std::size_t end = frame.find('\n', start);
+        if (end == std::string::npos)
+            end = frame.size();
+        m_lines.emplace_back(frame, start, end - start);
+        start = end + 1;
+    }
+
+    m_out.clear();
+
+    if (m_full_redraw)
+    {
+        m_out += "\x1b[2J\x1b[H";
+        m_screen.clear();
+        m_full_redraw = false;
+    }
+
+    for (std::size_t row = 0; row < m_lines.size(); ++row)
+    {
+        static const std::string blank;
+        diff_line(static_cast<int>(row), row < m_screen.size() ? m_screen[row] : blank, m_lines[row]);
+    }
+
+    // wipe lines left over from a taller frame
+    for (std::size_t row = m_lines.size(); row < m_screen.size(); ++row)
+    {
+        move_cursor(m_out, static_cast<int>(row), 0);
+        m_out += "\x1b[K";
+    }
+
+    m_screen.swap(m_lines);
+
+    std::size_t written = m_out.size();
+    flush_output();
+    return written;
+}
+
+void TerminalRenderer::diff_line(int row, const std::string& old_line, const std::string& new_line)
+{
+    std::size_t common = std::min(old_line.size(), new_line.size());
+    std::size_t col = 0;
+
+    while (col < common)
+    {
+        if (old_line[col] == new_line[col])
+        {
+            ++col;
+            continue;
+        }
+
+        // found a change, extend the run until we see merge_gap equal characters
+        std::size_t run_start = col;
+        std::size_t run_end = col + 1;
+        std::size_t scan = run_end;
+        while (scan < common && scan - run_end < merge_gap)
+        {
+            if (old_line[scan] != new_line[scan])
+                run_end = scan + 1;
+            ++scan;
+        }
+
+        move_cursor(m_out, row, run_start);
+        m_out.append(new_line, run_start, run_end - run_start);
+        col = run_end;
+    }
+
+    if (new_line.size() > old_line.size())
+    {
+        move_cursor(m_out, row, common);
+        m_out.append(new_line, common, std::string::npos);
+    }
+    else if (new_line.size() < old_line.size())
+    {
+        move_cursor(m_out, row, new_line.size());
+        m_out += "\x1b[K"; // erase to end of line
+    }
+}
+
+void TerminalRenderer::park_cursor()
+{
+    m_out.clear();
+    move_cursor(m_out, static_cast<int>(m_screen.size()), 0);
+    m_out += '\n';
+    flush_output();
+}
+
+void TerminalRenderer::flush_output()
+{
+    std::size_t done = 0;
+    while (done < m_out.size())
+    {
+        ssize_t n = ::write(m_fd, m_out.data() + done, m_out.size() - done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+}
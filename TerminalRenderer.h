@@ -0,0 +1,38 @@
+#ifndef __TERMINALRENDERER_H__
+#define __TERMINALRENDERER_H__
+
+#include <string>
+#include <vector>
+
+// Draws text frames on an ANSI terminal by only rewriting what changed since the
+// last frame. The frame is split into lines, each line is compared with what is
+// already on screen and only the differing runs are sent, using cursor addressing.
+// The first frame (or one after reset()) clears the screen and draws everything.
+class TerminalRenderer
+{
+public:
+
+    explicit TerminalRenderer(int fd = 1);
+
+    // draw a frame. returns the number of bytes written to the terminal.
+    std::size_t draw(const std::string& frame);
+
+    // forget what is on screen, the next draw repaints everything
+    void reset();
+
+    // move the cursor below the last frame so normal output can continue
+    void park_cursor();
+
+private:
+
+    void diff_line(int row, const std::string& old_line, const std::string& new_line);
+    void flush_output();
+
+    int m_fd;
+    bool m_full_redraw;
+    std::vector<std::string> m_screen; // what we believe is on the terminal
+    std::vector<std::string> m_lines;  // scratch: the new frame split into lines
+    std::string m_out;                 // escape codes and text for one draw
+};
+
+#endif
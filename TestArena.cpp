@@ -1,5 +1,32 @@
 #include "TestArena.h"
+#include "Lockstep.h"
+#include "Batch.h"
+#include "BenchHistory.h"
+#include "Metrics.h"
+#include "RobotHarness.h"
+#include "ResultsStore.h"
+#include "RobotRandom.h"
+#include "Tournament.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iomanip> // For std::setw
+#include <memory>
+#include <numeric>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 bool TestArena::print_test_result(const std::string& test_name, bool condition) {
 	
@@ -783,4 +810,2290 @@ void TestArena::test_radar_local() {
     std::cout << "\t*** Radar local testing complete ***\n\n";
     test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
 
-}
\ No newline at end of file
+}
+
+
+void TestArena::test_board_renderer()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Board Renderer----------------\n";
+
+    // the board the way print_board used to build it, cell by cell with setw
+    auto reference_frame = [](Arena& arena, int round) {
+        std::ostringstream out;
+        std::vector<std::string> bot_list;
+        out << std::endl << "              =========== starting round " << round << " ===========" << std::endl;
+        out << "   ";
+        for (int col = 0; col < arena.m_size_col; ++col)
+            out << std::setw(3) << col;
+        out << std::endl;
+        for (int row = 0; row < arena.m_size_row; ++row) {
+            out << std::setw(2) << row << " ";
+            for (int col = 0; col < arena.m_size_col; ++col) {
+                char cell = arena.m_board[row][col];
+                int bot_index = arena.get_robot_index(row, col);
+                if ((cell == 'R' || cell == 'X') && bot_index != -1) {
+                    char tag = (bot_index == 0) ? '!' : '@';
+                    out << std::setw(2) << cell << tag;
+                    bot_list.push_back(tag + arena.m_robots[bot_index]->m_name);
+                } else {
+                    out << std::setw(3) << cell;
+                }
+            }
+            out << std::endl;
+        }
+        if (round == 0)
+            for (auto bot : bot_list)
+                out << bot << std::endl;
+        return out.str();
+    };
+
+    struct RenderTestCase {
+        int rows, cols;
+        std::string description;
+    };
+
+    std::vector<RenderTestCase> render_tests = {
+        {10, 10, "Small board matches the setw layout"},
+        {12, 105, "Wide board with three digit column headers"},
+        {104, 8, "Tall board with three digit row indices"}
+    };
+
+    for (const auto& test : render_tests) {
+        Arena arena(test.rows, test.cols);
+        arena.initialize_board();
+
+        TestRobot live_robot(3, 3, railgun, "LiveBot");
+        TestRobot dead_robot(3, 3, hammer, "DeadBot");
+        live_robot.move_to(1, 1);
+        dead_robot.move_to(test.rows - 1, test.cols - 1);
+        arena.m_robots.push_back(&live_robot);
+        arena.m_robots.push_back(&dead_robot);
+        arena.m_board[1][1] = 'R';
+        arena.m_board[test.rows - 1][test.cols - 1] = 'X';
+        arena.m_board[0][test.cols - 1] = 'R'; // an 'R' no robot owns
+
+        bool same = true;
+        for (int round : {0, 1, 250000}) {
+            same &= (arena.render_board(round) == reference_frame(arena, round));
+        }
+
+        // move a robot and render again to make sure the template is patched cleanly
+        arena.m_board[1][1] = '.';
+        arena.m_board[2][2] = 'R';
+        live_robot.move_to(2, 2);
+        same &= (arena.render_board(7) == reference_frame(arena, 7));
+
+        bool ok = print_test_result(test.description, same);
+        module_passed &= ok;
+    }
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+
+void TestArena::test_board_views()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Viewport and Minimap----------------\n";
+
+    Arena arena(300, 300);
+    arena.initialize_board(true);
+    arena.m_board[0][0] = 'M';
+    arena.m_board[299][299] = 'P';
+
+    TestRobot robot(3, 3, railgun, "FarBot");
+    robot.move_to(150, 200);
+    arena.m_robots.push_back(&robot);
+    arena.m_board[150][200] = 'R';
+
+    arena.m_view_rows = 10;
+    arena.m_view_cols = 10;
+
+    auto split_lines = [](const std::string& frame) {
+        std::vector<std::string> lines;
+        std::istringstream in(frame);
+        std::string line;
+        while (std::getline(in, line))
+            lines.push_back(line);
+        return lines;
+    };
+
+    // viewport: blank, round, column header, 10 rows and the legend
+    arena.m_view_mode = ViewMode::Viewport;
+    std::vector<std::string> lines = split_lines(arena.render_view(3));
+    bool sized = (lines.size() == 14);
+    bool shows_robot = false;
+    for (const auto& line : lines)
+        shows_robot |= (line.find(" R!") != std::string::npos);
+    module_passed &= print_test_result("Viewport is sized by the view, not the arena", sized);
+    module_passed &= print_test_result("Viewport follows the action to the robot", shows_robot);
+
+    arena.m_view_follow = "farbot";
+    lines = split_lines(arena.render_view(3));
+    module_passed &= print_test_result("Viewport follows a robot by name",
+                                       lines.size() > 1 && lines[1].find("following FarBot") != std::string::npos);
+
+    // minimap: 10x10 slots of 30x30 cells
+    arena.m_view_mode = ViewMode::Minimap;
+    lines = split_lines(arena.render_view(3));
+    bool map_sized = (lines.size() == 14);
+    module_passed &= print_test_result("Minimap is sized by the view", map_sized);
+
+    if (map_sized)
+    {
+        // rows start after "blank, round, header", each row is "%3d " then 3 chars per slot
+        auto slot = [&](int map_row, int map_col) { return lines[3 + map_row].substr(4 + map_col * 3, 3); };
+        module_passed &= print_test_result("Minimap shows the mound block", slot(0, 0) == "  M");
+        module_passed &= print_test_result("Minimap shows the pit block", slot(9, 9) == "  P");
+        module_passed &= print_test_result("Minimap shows the robot block", slot(5, 6) == " R!");
+
+        // a flamethrower lit and put out again during the game
+        arena.set_cell(40, 40, 'F');
+        lines = split_lines(arena.render_view(4));
+        bool lit = slot(1, 1) == "  F";
+        arena.set_cell(40, 40, '.');
+        arena.set_cell(0, 1, 'F');
+        lines = split_lines(arena.render_view(5));
+        module_passed &= print_test_result("Minimap follows obstacles set during the game",
+                                           lit && slot(1, 1) == "  ." && slot(0, 0) == "  F");
+    }
+
+    // print_board is the whole board, whatever the view
+    std::ostringstream printed;
+    arena.print_board(6, printed, false);
+    module_passed &= print_test_result("print_board prints the whole board",
+                                       split_lines(printed.str()).size() > 300);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_replay()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Binary Replay----------------\n";
+
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+    arena.m_board[4][4] = 'M';
+
+    JumperRobot jumper;
+    TestRobot wanderer(3, 3, railgun, "Wanderer");
+    jumper.set_boundaries(10, 10);
+    wanderer.set_boundaries(10, 10);
+    jumper.move_to(1, 0);
+    wanderer.move_to(6, 6);
+    arena.m_board[1][0] = 'R';
+    arena.m_board[6][6] = 'R';
+    arena.m_robots.push_back(&jumper);
+    arena.m_robots.push_back(&wanderer);
+
+    const std::string path = "test_replay.replay";
+    const int rounds = 10;
+    std::vector<std::vector<std::vector<char>>> boards;
+    std::vector<std::vector<RobotState>> states;
+
+    {
+        ReplayWriter writer(path, 3);
+        arena.m_replay = &writer;
+        writer.begin_game(42, arena.m_board, arena.m_robots, "!@");
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            boards.push_back(arena.m_board);
+            states.push_back({read_robot_state(&jumper), read_robot_state(&wanderer)});
+            writer.begin_round(round, arena.m_board, arena.m_robots);
+
+            for (int index = 0; index < 2; ++index)
+            {
+                ReplayTurn turn;
+                turn.robot = index;
+                writer.begin_turn(index, arena.m_robots);
+                arena.handle_move(arena.m_robots[index]);
+                if (index == 1)
+                    jumper.take_damage(3); // shows up as a change to another robot
+                turn.action = ReplayAction::Move;
+                writer.end_turn(turn, arena.m_robots);
+            }
+        }
+        boards.push_back(arena.m_board);
+        states.push_back({read_robot_state(&jumper), read_robot_state(&wanderer)});
+        writer.end_game(rounds, -1, arena.m_board, arena.m_robots);
+        arena.m_replay = nullptr;
+    }
+
+    ReplayReader reader;
+    bool opened = reader.open(path);
+    module_passed &= print_test_result("Replay opens", opened);
+
+    if (opened)
+    {
+        module_passed &= print_test_result("Header round trips",
+                                           reader.rows() == 10 && reader.cols() == 10 && reader.seed() == 42 &&
+                                           reader.rounds() == rounds && reader.roster().size() == 2 &&
+                                           reader.roster()[1].name == "Wanderer" && reader.roster()[1].tag == '@');
+
+        // every round, including ones between keyframes, comes back as it was
+        bool seeks = true;
+        for (int round = 0; round <= rounds; ++round)
+        {
+            ReplayFrame frame;
+            seeks &= reader.seek(round, frame) && frame.board == boards[round] && frame.robots == states[round] &&
+                     frame.hash == replay_state_hash(boards[round], states[round]);
+        }
+        module_passed &= print_test_result("Seek rebuilds every round and its state hash", seeks);
+
+        // reading forward gives the same frames as seeking
+        ReplayFrame frame;
+        std::vector<ReplayTurn> turns;
+        bool forward = reader.seek(0, frame);
+        for (int round = 0; round < rounds && forward; ++round)
+        {
+            forward &= reader.next_round(frame, &turns) && turns.size() == 2 &&
+                       frame.board == boards[round + 1] && frame.robots == states[round + 1];
+        }
+        module_passed &= print_test_result("Reading forward matches the game", forward);
+
+        ReplayFrame past_end;
+        module_passed &= print_test_result("Seek past the end fails", !reader.seek(rounds + 1, past_end));
+    }
+
+    {
+        // an index count big enough to wrap offset + count * 16 back inside the file
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        uint64_t count = (UINT64_MAX / 16) + 2;
+        std::memcpy(&bytes[64], &count, sizeof(count)); // index_count in the header
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+        ReplayReader corrupt;
+        module_passed &= print_test_result("An index running past the file is refused", !corrupt.open(path));
+    }
+
+    std::remove(path.c_str());
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_replay_playback()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Replay Playback----------------\n";
+
+    const std::string path = "test_playback.replay";
+
+    // record a short fight between two robots standing next to each other
+    {
+        Arena arena(6, 6);
+        arena.initialize_board(true);
+        arena.set_seed(7);
+        arena.m_max_rounds = 15;
+        arena.m_replay_path = path;
+
+        ShooterRobot railer(railgun, "Railer");
+        ShooterRobot lobber(grenade, "Lobber");
+        railer.set_boundaries(6, 6);
+        lobber.set_boundaries(6, 6);
+        railer.move_to(2, 2);
+        lobber.move_to(2, 3);
+        arena.m_board[2][2] = 'R';
+        arena.m_board[2][3] = 'R';
+        arena.m_robots.push_back(&railer);
+        arena.m_robots.push_back(&lobber);
+        arena.run_simulation();
+    }
+
+    // play it back with stand-ins and a different seed: the recorded draws win
+    Arena replayed(6, 6);
+    bool loaded = replayed.load_replay(path);
+    module_passed &= print_test_result("Recorded game loads without robot code", loaded);
+    if (loaded)
+    {
+        replayed.set_seed(12345);
+        replayed.run_simulation();
+        module_passed &= print_test_result("Playback matches the recording", replayed.replay_matched());
+    }
+
+    // an engine change (here: a mound that wasn't there) is caught in the round it shows up
+    Arena changed(6, 6);
+    if (changed.load_replay(path))
+    {
+        changed.m_board[0][0] = 'M';
+        changed.run_simulation();
+        module_passed &= print_test_result("A changed board is reported as a divergence",
+                                           !changed.replay_matched() && changed.m_playback->divergence_round() == 0);
+    }
+
+    std::remove(path.c_str());
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+// always shoots at the first robot on its radar, otherwise walks right
+class LockstepTestBrain : public LockstepBrain
+{
+public:
+    int radar_direction(int robot) override { return robot % 2 == 0 ? 3 : 0; }
+
+    ReplayDecision decide(int robot, int radar_direction, const std::vector<RadarObj>& radar_results) override
+    {
+        (void)robot;
+        (void)radar_direction;
+        ReplayDecision decision;
+        for (const RadarObj& obj : radar_results)
+        {
+            if (obj.m_type == 'R')
+            {
+                decision.shoot = true;
+                decision.param1 = obj.m_row;
+                decision.param2 = obj.m_col;
+                return decision;
+            }
+        }
+        decision.param1 = 3;
+        decision.param2 = 1;
+        return decision;
+    }
+};
+
+void TestArena::test_lockstep()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Lockstep Engines----------------\n";
+
+    // the engines agree on a batch of random games
+    bool agree = true;
+    std::string report;
+    for (uint64_t seed = 1; seed <= 25 && agree; ++seed)
+    {
+        agree = run_lockstep_fuzz_game(seed, 100, report);
+    }
+    if (!agree)
+        std::cout << report;
+    module_passed &= print_test_result("Arena and ReferenceArena agree on random games", agree);
+
+    // a difference between them is caught and both sides are dumped
+    Lockstep game(5, 8, 3);
+    game.add_robot("Left", railgun, 3, 4, 2, 0);
+    game.add_robot("Right", hammer, 3, 4, 2, 7);
+    game.m_reference.m_board[2][4] = 'M';
+    LockstepTestBrain brain;
+    bool caught = !game.play(brain, 10);
+    module_passed &= print_test_result("A board difference stops the game", caught);
+    module_passed &= print_test_result("The report has both radars and both boards",
+                                       game.report().find("arena radar:") != std::string::npos &&
+                                       game.report().find("reference board:") != std::string::npos);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_snapshot()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Snapshots----------------\n";
+
+    Arena arena(20, 20);
+    arena.set_seed(99);
+    arena.initialize_board();
+
+    MemoryRobot thinker;
+    ShooterRobot shooter(grenade, "Lobber");
+    thinker.set_boundaries(20, 20);
+    shooter.set_boundaries(20, 20);
+    arena.m_board[3][3] = '.';
+    arena.m_board[15][15] = '.';
+    thinker.move_to(3, 3);
+    shooter.move_to(15, 15);
+    arena.set_cell(3, 3, 'R');
+    arena.set_cell(15, 15, 'R');
+    arena.m_robots.push_back(&thinker);
+    arena.m_robots.push_back(&shooter);
+    thinker.memory = 7;
+
+    auto board_before = arena.m_board;
+    auto flames_before = arena.m_flamethrowers;
+    RobotState thinker_before = read_robot_state(&thinker);
+    RobotState shooter_before = read_robot_state(&shooter);
+    uint64_t rng_before = arena.m_rng.state();
+    std::srand(17);
+    std::rand();
+
+    ArenaSnapshot first = arena.snapshot(5);
+    int next_rand = std::rand();
+    ArenaSnapshot again = arena.snapshot(5);
+    module_passed &= print_test_result("Unchanged board is shared between snapshots", first.board == again.board);
+    module_passed &= print_test_result("Board is packed 16 cells to a word", first.board->words.size() == 25);
+
+    // play on a bit: damage, a move, a random draw and something remembered
+    shooter.take_damage(40);
+    shooter.reduce_armor(1);
+    shooter.decrement_grenades();
+    arena.set_cell(3, 3, '.');
+    thinker.move_to(3, 4);
+    arena.set_cell(3, 4, 'R');
+    arena.m_rng.next();
+    thinker.memory = 8;
+
+    ArenaSnapshot later = arena.snapshot(6);
+    module_passed &= print_test_result("A changed board gets its own packed copy", later.board != first.board);
+
+    bool restored = arena.restore(first);
+    module_passed &= print_test_result("Restore puts the board back",
+                                       restored && arena.m_board == board_before &&
+                                       arena.m_flamethrowers == flames_before);
+    module_passed &= print_test_result("Restore puts the robots back",
+                                       read_robot_state(&thinker) == thinker_before &&
+                                       read_robot_state(&shooter) == shooter_before);
+    module_passed &= print_test_result("Restore puts the random numbers back", arena.m_rng.state() == rng_before);
+    module_passed &= print_test_result("Restore puts the robots' rand() back", std::rand() == next_rand);
+    module_passed &= print_test_result("Robot memory comes back through SerializableRobot", thinker.memory == 7);
+    module_passed &= print_test_result("The game carries on from the snapshot's round", arena.m_start_round == 5);
+    arena.m_start_round = 0;
+
+    // branching: restore, change something, snapshot the branch
+    const int branches = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < branches; ++i)
+    {
+        arena.restore(first);
+        arena.set_cell(i % 20, 0, 'X');
+        ArenaSnapshot branch = arena.snapshot(5);
+        (void)branch;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << static_cast<int>(branches / seconds) << " restore + snapshot per second, "
+              << first.bytes() + first.board->bytes() << " bytes per snapshot\n";
+    module_passed &= print_test_result("Thousands of branches per second", branches / seconds > 1000);
+
+    // a restored game that plays on without snapshots doesn't keep every change
+    arena.restore(first);
+    for (int i = 0; i < 1000; ++i)
+    {
+        arena.set_cell(i % 20, (i / 20) % 20, i % 2 ? 'X' : '.');
+    }
+    module_passed &= print_test_result("Changes stop being listed past the packed board's size",
+                                       arena.m_board_dirty && arena.m_dirty_cells.empty());
+    std::vector<std::vector<char>> unpacked;
+    std::set<std::pair<int,int>> unpacked_flames;
+    arena.snapshot(5).board->unpack(unpacked, unpacked_flames);
+    module_passed &= print_test_result("The next snapshot packs the board again", unpacked == arena.m_board);
+    arena.m_start_round = 0;
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_checkpoint()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Checkpoints----------------\n";
+
+    const std::string path = "test_checkpoint.tmp";
+
+    Arena arena(15, 25);
+    arena.set_seed(4242);
+    arena.initialize_board();
+    arena.m_max_rounds = 777;
+
+    MemoryRobot thinker;
+    ShooterRobot shooter(railgun, "Sniper");
+    thinker.m_name = "Thinker";
+    for (RobotBase* robot : std::vector<RobotBase*>{&thinker, &shooter})
+    {
+        robot->set_boundaries(15, 25);
+    }
+    arena.m_board[2][2] = '.';
+    arena.m_board[12][20] = '.';
+    thinker.move_to(2, 2);
+    shooter.move_to(12, 20);
+    arena.set_cell(2, 2, 'R');
+    arena.set_cell(12, 20, 'R');
+    arena.m_robots.push_back(&thinker);
+    arena.m_robots.push_back(&shooter);
+    shooter.take_damage(25);
+    thinker.memory = 31;
+    arena.m_rng.next();
+    std::srand(23);
+    std::rand();
+    RobotRandom rand_at_checkpoint = thread_robot_random();
+
+    {
+        CheckpointWriter writer(path);
+        writer.submit(Checkpoint{arena.snapshot(300), arena.m_max_rounds, {"Thinker", "Sniper"}});
+        writer.flush();
+        module_passed &= print_test_result("Checkpoint written in the background", writer.written() == 1);
+    }
+
+    Checkpoint loaded;
+    bool ok = load_checkpoint(path, loaded);
+    module_passed &= print_test_result("Checkpoint reads back",
+                                       ok && loaded.snapshot.round == 300 && loaded.max_rounds == 777 &&
+                                       loaded.robot_names == std::vector<std::string>{"Thinker", "Sniper"} &&
+                                       loaded.snapshot.robot_data[0] == "31");
+
+    // a fresh arena, robots loaded in a different order and wiped
+    Arena resumed(15, 25);
+    MemoryRobot thinker_again;
+    ShooterRobot shooter_again(railgun, "Sniper");
+    thinker_again.m_name = "Thinker";
+    resumed.m_robots.push_back(&shooter_again);
+    resumed.m_robots.push_back(&thinker_again);
+
+    std::srand(1);
+    ok = resumed.resume(path);
+    module_passed &= print_test_result("Resume puts the robots back in turn order",
+                                       ok && resumed.m_robots[0] == &thinker_again && resumed.m_robots[1] == &shooter_again);
+    module_passed &= print_test_result("Resume puts the game back",
+                                       resumed.m_board == arena.m_board &&
+                                       resumed.m_flamethrowers == arena.m_flamethrowers &&
+                                       resumed.m_rng.state() == arena.m_rng.state() &&
+                                       thread_robot_random() == rand_at_checkpoint &&
+                                       resumed.m_max_rounds == 777 && resumed.m_start_round == 300 &&
+                                       read_robot_state(&shooter_again) == read_robot_state(&shooter) &&
+                                       thinker_again.memory == 31);
+
+    // a checkpoint cut off half way, as a crash mid-write without the rename would leave it
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fclose(file);
+        std::filesystem::resize_file(path, size / 2);
+    }
+    module_passed &= print_test_result("A damaged checkpoint is refused", !load_checkpoint(path, loaded));
+    std::remove(path.c_str());
+
+    // the simulation thread only packs the board and hands it over. time that on
+    // a big board that changes every round.
+    Arena big(1000, 1000);
+    big.set_seed(8);
+    big.initialize_board();
+    big.snapshot(0); // run_simulation() packs the whole board once at the start
+    double worst_ms = 0;
+    {
+        CheckpointWriter writer(path);
+        for (int i = 0; i < 20; ++i)
+        {
+            big.set_cell(i, i, 'X');
+            auto start = std::chrono::steady_clock::now();
+            writer.submit(Checkpoint{big.snapshot(i), 1000, {}});
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            worst_ms = std::max(worst_ms, ms);
+        }
+        writer.flush();
+    }
+    std::cout << "    1000x1000 board: the game waits at most " << worst_ms << " ms per checkpoint\n";
+    module_passed &= print_test_result("Checkpoints don't stall the game", worst_ms < 20);
+    std::remove(path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_repetition()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Repetition Draws----------------\n";
+
+    RepetitionTable table(2);
+    table.record(1);
+    table.record(2);
+    module_passed &= print_test_result("Repetitions are counted", table.record(2) == 2);
+    module_passed &= print_test_result("Rounds older than the window are forgotten", table.record(1) == 1 && table.size() == 2);
+
+    // two robots pacing back and forth at opposite ends of an empty board
+    auto pacing_game = [](int repeat_limit, int max_rounds, Arena& arena, PacerRobot& left, PacerRobot& right) {
+        arena.set_seed(3);
+        arena.initialize_board(true);
+        arena.m_max_rounds = max_rounds;
+        arena.m_repeat_limit = repeat_limit;
+        arena.set_quiet(true);
+        left.set_boundaries(12, 12);
+        right.set_boundaries(12, 12);
+        left.move_to(1, 1);
+        right.move_to(10, 9);
+        arena.m_board[1][1] = 'R';
+        arena.m_board[10][9] = 'R';
+        arena.m_robots = {&left, &right};
+        arena.run_simulation();
+    };
+
+    Arena endless(12, 12);
+    PacerRobot a("PacerA"), b("PacerB");
+    pacing_game(0, 60, endless, a, b);
+    module_passed &= print_test_result("Without the rule the pacers play to MaxRounds", endless.m_game_over.empty());
+
+    Arena drawn(12, 12);
+    PacerRobot c("PacerA"), d("PacerB");
+    pacing_game(3, 100000, drawn, c, d);
+    module_passed &= print_test_result("With it the game is drawn after a few rounds",
+                                       !drawn.m_game_over.empty() && drawn.m_repetitions.size() == 5);
+    module_passed &= print_test_result("The incremental hash matches one worked out from scratch",
+                                       drawn.m_zobrist == zobrist_hash(drawn.m_board, drawn.m_robots));
+
+    c.take_damage(10);
+    module_passed &= print_test_result("Tiebreak goes to the healthier robot", drawn.tiebreak_index() == 1);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_stalemate()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Stalemate Prover----------------\n";
+
+    // rows of a board, robots go on the 'R's in reading order. an 'f' is a robot
+    // standing on a flamethrower, which the board shows as an 'R'.
+    struct Case
+    {
+        const char* name;
+        std::vector<std::string> rows;
+        std::vector<WeaponType> weapons;
+        std::vector<bool> stuck;
+        bool expected;
+    };
+
+    const std::vector<Case> cases = {
+        {"Hammers stuck far apart can't meet",
+         {"R.........", "..........", "........PR"}, {hammer, hammer}, {true, true}, true},
+        {"Hammers stuck next to each other can",
+         {"RR........", "..........", ".........."}, {hammer, hammer}, {true, true}, false},
+        {"A railgun reaches everything",
+         {"R.........", "..........", ".........R"}, {railgun, hammer}, {true, true}, false},
+        {"Grenades reach 14 cells",
+         {"R.........", "..........", "..........", "..........", "..........",
+          "..........", "..........", "..........", ".....R...."}, {grenade, hammer}, {true, true}, false},
+        {"Robots walled off out of range of each other can't meet",
+         {"R...MMMMM..R", "....MMMMM...", "....MMMMM..."}, {flamethrower, hammer}, {false, false}, true},
+        {"Flames go over walls",
+         {"R...M......R", "....M.......", "....M......."}, {flamethrower, hammer}, {false, false}, false},
+        {"A gap in the wall lets them meet",
+         {"R...MMMMM..R", "............", "....MMMMM..."}, {hammer, hammer}, {false, false}, false},
+        {"A flamethrower cell in reach can still kill",
+         {"R..FM.....", "....M.....", "....M....R"}, {hammer, hammer}, {false, false}, false},
+        {"A robot parked on a flamethrower can step back onto it",
+         {"R...MMMMM..f", "....MMMMM...", "....MMMMM..."}, {hammer, hammer}, {false, false}, false},
+        {"A stuck one on a flamethrower is no danger to itself",
+         {"R...MMMMM..f", "....MMMMM...", "....MMMMM..."}, {hammer, hammer}, {false, true}, true},
+    };
+
+    for (const Case& test : cases)
+    {
+        std::vector<std::vector<char>> board;
+        std::set<std::pair<int,int>> flamethrowers;
+        for (const std::string& row : test.rows)
+        {
+            board.emplace_back(row.begin(), row.end());
+            for (std::size_t col = 0; col < row.size(); ++col)
+            {
+                if (row[col] == 'f')
+                {
+                    flamethrowers.insert({static_cast<int>(board.size()) - 1, static_cast<int>(col)});
+                    board.back()[col] = 'R';
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<ShooterRobot>> owned;
+        std::vector<RobotBase*> robots;
+        for (std::size_t row = 0; row < board.size(); ++row)
+        {
+            for (std::size_t col = 0; col < board[row].size(); ++col)
+            {
+                if (board[row][col] != 'R')
+                    continue;
+                std::size_t i = owned.size();
+                owned.push_back(std::make_unique<ShooterRobot>(test.weapons[i], "Bot" + std::to_string(i)));
+                owned.back()->set_boundaries(static_cast<int>(board.size()), static_cast<int>(board[0].size()));
+                owned.back()->move_to(static_cast<int>(row), static_cast<int>(col));
+                if (test.stuck[i])
+                    owned.back()->disable_movement();
+                robots.push_back(owned.back().get());
+            }
+        }
+
+        std::string reason;
+        module_passed &= print_test_result(test.name, prove_stalemate(board, robots, flamethrowers, reason) == test.expected);
+    }
+
+    // the whole game: two hammers stuck in opposite corners end at the first check
+    Arena arena(10, 10);
+    arena.initialize_board(true);
+    arena.m_stalemate_every = 10;
+    arena.m_max_rounds = 100000;
+    arena.set_quiet(true);
+    ShooterRobot first(hammer, "StuckA"), second(hammer, "StuckB");
+    first.set_boundaries(10, 10);
+    second.set_boundaries(10, 10);
+    first.move_to(0, 0);
+    second.move_to(9, 9);
+    first.disable_movement();
+    second.disable_movement();
+    second.take_damage(5);
+    arena.m_board[0][0] = 'R';
+    arena.m_board[9][9] = 'R';
+    arena.m_robots = {&first, &second};
+    arena.run_simulation();
+    module_passed &= print_test_result("The game ends as soon as it is proven", !arena.m_game_over.empty());
+    module_passed &= print_test_result("And goes to the healthier robot", arena.tiebreak_index() == 0);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_tracer()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Tracer----------------\n";
+
+    TraceBuffer ring(4, 1);
+    for (int i = 0; i < 10; ++i)
+    {
+        ring.push({"span", "test", i, static_cast<uint64_t>(i), 1});
+    }
+    std::vector<TraceEvent> kept = ring.events();
+    module_passed &= print_test_result("A full ring keeps the newest spans",
+                                       kept.size() == 4 && kept.front().arg == 6 && ring.dropped() == 6);
+
+    const std::string path = "test_trace.tmp";
+    Arena arena(12, 12);
+    PacerRobot left("PacerA"), right("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 20;
+    arena.m_trace_path = path;
+    arena.m_trace_sample_every = 5;
+    arena.set_quiet(true);
+    left.set_boundaries(12, 12);
+    right.set_boundaries(12, 12);
+    left.move_to(1, 1);
+    right.move_to(10, 9);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[10][9] = 'R';
+    arena.m_robots = {&left, &right};
+    arena.run_simulation();
+
+    std::ifstream in(path);
+    std::stringstream trace;
+    trace << in.rdbuf();
+    std::string json = trace.str();
+#ifdef ROBOTWARZ_NO_TRACE
+    module_passed &= print_test_result("Compiled out, nothing is traced", json.empty());
+#else
+    auto count = [&json](const std::string& text) {
+        int n = 0;
+        for (std::size_t at = json.find(text); at != std::string::npos; at = json.find(text, at + 1))
+            ++n;
+        return n;
+    };
+    module_passed &= print_test_result("Trace is Chrome trace event JSON",
+                                       json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+    module_passed &= print_test_result("Every callback and phase is in it",
+                                       count("\"get_radar_direction\"") > 0 && count("\"process_radar_results\"") > 0 &&
+                                       count("\"get_shot_location\"") > 0 && count("\"get_move_direction\"") > 0 &&
+                                       count("\"radar scan\"") > 0 && count("\"move\"") > 0 &&
+                                       count("\"print board\"") > 0 && count("\"PacerA\"") > 0);
+    module_passed &= print_test_result("Only every 5th round is sampled", count("\"name\":\"round\"") == 4);
+#endif
+    std::remove(path.c_str());
+
+    // a game with no robots stops before anything is started
+    Arena empty(12, 12);
+    empty.m_trace_path = path;
+    empty.set_quiet(true);
+    empty.run_simulation();
+    module_passed &= print_test_result("A game with no robots leaves the tracer and the text alone",
+                                       !Tracer::instance().enabled() && empty.m_text_sink == LogWriter::Both &&
+                                       !std::filesystem::exists(path));
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_robot_timing()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing RobotTiming----------------\n";
+
+    LatencyHistogram small;
+    for (uint64_t ns = 0; ns < 16; ++ns)
+    {
+        small.record(ns);
+    }
+    module_passed &= print_test_result("Below 16ns every value has its own bucket",
+                                       small.percentile(0.5) == 7 && small.percentile(1.0) == 15);
+
+    LatencyHistogram uniform;
+    for (uint64_t ns = 1; ns <= 100000; ++ns)
+    {
+        uniform.record(ns * 1000);
+    }
+    auto close = [](uint64_t got, uint64_t want) { return got >= want && got <= want + want / 16; };
+    module_passed &= print_test_result("Percentiles are within 1/16",
+                                       close(uniform.percentile(0.5), 50000000) &&
+                                       close(uniform.percentile(0.99), 99000000));
+    module_passed &= print_test_result("Max and count are exact",
+                                       uniform.max() == 100000000 && uniform.count() == 100000 &&
+                                       uniform.percentile(1.0) == 100000000);
+
+    LatencyHistogram slow;
+    slow.record(1ULL << 40);
+    slow.merge(uniform);
+    module_passed &= print_test_result("Merged histograms keep both",
+                                       slow.count() == 100001 && slow.max() == (1ULL << 40) &&
+                                       close(slow.percentile(0.5), 50000000));
+
+    // two pacers never shoot, so every turn is radar, shot and then a move
+    Arena arena(12, 12);
+    PacerRobot left("PacerA"), right("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 50;
+    arena.set_quiet(true);
+    left.set_boundaries(12, 12);
+    right.set_boundaries(12, 12);
+    left.move_to(1, 1);
+    right.move_to(10, 9);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[10][9] = 'R';
+    arena.m_robots = {&left, &right};
+    arena.m_robot_timing_mode = RobotTimingMode::Cpu;
+    arena.run_simulation();
+
+    const std::vector<RobotTiming>& timing = arena.robot_timing();
+    bool counted = timing.size() == 2 && timing[0].name == "PacerA" && timing[1].name == "PacerB";
+    for (const RobotTiming& robot : timing)
+    {
+        for (const CallTiming& call : robot.calls)
+        {
+            counted &= call.wall.count() == 50;
+        }
+        counted &= robot.cpu && robot.cpu_ns() > 0;
+    }
+    module_passed &= print_test_result("Every callback of every robot is timed", counted);
+
+    std::vector<RobotTiming> total = timing;
+    merge_robot_timing(total, {timing[1], timing[0]});
+    module_passed &= print_test_result("Timings merge by robot name",
+                                       total.size() == 2 && total[0].name == "PacerA" &&
+                                       total[0].calls[0].wall.count() == 100 &&
+                                       total[1].cpu_ns() == 2 * timing[1].cpu_ns());
+    module_passed &= print_test_result("The table names each robot and callback",
+                                       format_robot_timing(timing).find("PacerB") != std::string::npos &&
+                                       format_robot_timing(timing).find("process_radar_results") != std::string::npos);
+
+    arena.m_robot_timing_mode = RobotTimingMode::Wall;
+    arena.m_max_rounds = 10;
+    arena.run_simulation();
+    module_passed &= print_test_result("Wall mode leaves CPU time out",
+                                       arena.robot_timing().size() == 2 && !arena.robot_timing()[0].cpu &&
+                                       arena.robot_timing()[0].cpu_ns() == 0 &&
+                                       format_robot_timing(arena.robot_timing()).find("(cpu") == std::string::npos);
+
+    arena.m_robot_timing_mode = RobotTimingMode::Off;
+    arena.run_simulation();
+    module_passed &= print_test_result("Off times nothing", arena.robot_timing().empty());
+
+    arena.m_call_budget_ns = 1000000000;
+    arena.run_simulation();
+    module_passed &= print_test_result("A call budget times the calls anyway",
+                                       arena.robot_timing().size() == 2 && arena.robot_timing()[0].calls[0].wall.count() > 0);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_phase_profile()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing PhaseProfile----------------\n";
+
+    // counters or not depends on the machine, either way it has to say which
+    PerfCounters perf;
+    bool opened = perf.open();
+    module_passed &= print_test_result("Missing counters come with a reason", opened || !perf.error().empty());
+    CounterValues before, after;
+    perf.read(before);
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        sum = sum + i;
+    }
+    perf.read(after);
+    module_passed &= print_test_result("Open counters count",
+                                       !perf.has(PerfCounter::Instructions) ||
+                                       after[static_cast<int>(PerfCounter::Instructions)] >
+                                       before[static_cast<int>(PerfCounter::Instructions)]);
+
+    // two pacers never shoot: a radar scan and a move every turn
+    Arena arena(12, 12);
+    PacerRobot left("PacerA"), right("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 20;
+    arena.set_quiet(true);
+    arena.set_silent(true);
+    left.set_boundaries(12, 12);
+    right.set_boundaries(12, 12);
+    left.move_to(1, 1);
+    right.move_to(10, 9);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[10][9] = 'R';
+    arena.m_robots = {&left, &right};
+
+    PhaseProfile profile;
+    profile.counters = perf.any() ? &perf : nullptr;
+    arena.set_phase_profile(&profile);
+    arena.run_simulation();
+    arena.set_phase_profile(nullptr);
+
+    module_passed &= print_test_result("Every turn is counted", profile.turns == 40);
+    module_passed &= print_test_result("Each phase counts its calls",
+                                       profile[EnginePhase::Radar].calls == 40 &&
+                                       profile[EnginePhase::Move].calls == 40 &&
+                                       profile[EnginePhase::Weapon].calls == 0 &&
+                                       profile[EnginePhase::Render].calls == 20);
+    module_passed &= print_test_result("Phases are timed", profile[EnginePhase::Radar].wall_ns > 0);
+
+    PhaseProfile twice = profile;
+    twice.merge(profile);
+    module_passed &= print_test_result("Merged profiles add up",
+                                       twice.turns == 80 && twice[EnginePhase::Move].calls == 80);
+
+    std::string table = format_phase_profile(profile);
+    module_passed &= print_test_result("The table has a line per phase",
+                                       table.find("radar") != std::string::npos &&
+                                       table.find("render") != std::string::npos &&
+                                       (profile.counters || table.find("n/a") != std::string::npos));
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_robot_memory()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing RobotMemory----------------\n";
+
+    int slot = RobotMemory::acquire(0);
+    std::vector<int>* kept = nullptr;
+    {
+        RobotMemoryScope scope(slot);
+        kept = new std::vector<int>(1000);
+        delete new std::vector<int>(500);
+    }
+    std::vector<int> engine(2000); // outside the scope, not the robot's
+    RobotMemoryStats stats = RobotMemory::stats(slot);
+    module_passed &= print_test_result("Allocations in scope are the robot's",
+                                       stats.allocations == 4 && stats.frees == 2 &&
+                                       stats.live == static_cast<int64_t>(sizeof(std::vector<int>) + 4000));
+    module_passed &= print_test_result("Peak remembers the most held at once",
+                                       stats.peak >= stats.live + 2000);
+
+    delete kept; // outside the scope, still the robot's block
+    module_passed &= print_test_result("Frees count wherever they happen", RobotMemory::stats(slot).live == 0);
+
+    {
+        RobotMemoryScope scope(slot);
+        kept = new std::vector<int>(1000);
+    }
+    RobotMemory::release(slot);
+    int reused = RobotMemory::acquire(0);
+    delete kept;
+    module_passed &= print_test_result("A released slot ignores its old blocks",
+                                       reused == slot && RobotMemory::stats(reused).frees == 0 &&
+                                       RobotMemory::stats(reused).live == 0);
+    RobotMemory::release(reused);
+
+    struct alignas(64) Wide
+    {
+        char bytes[64];
+    };
+    Wide* wide = new Wide;
+    module_passed &= print_test_result("Over aligned blocks stay aligned", reinterpret_cast<uintptr_t>(wide) % 64 == 0);
+    delete wide;
+
+    // four threads filling one slot at once: the peak is never lowered by a
+    // thread that saw less
+    int shared = RobotMemory::acquire(0);
+    std::atomic<int64_t> most_seen{0};
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&]() {
+                RobotMemoryScope scope(shared);
+                std::vector<std::unique_ptr<char[]>> blocks;
+                for (int round = 0; round < 20; ++round)
+                {
+                    for (int i = 0; i < 200; ++i)
+                        blocks.emplace_back(new char[1024]);
+                    int64_t seen = RobotMemory::stats(shared).live;
+                    int64_t most = most_seen.load();
+                    while (seen > most && !most_seen.compare_exchange_weak(most, seen))
+                    {
+                    }
+                    blocks.clear();
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+    module_passed &= print_test_result("The peak holds up with threads freeing at once",
+                                       RobotMemory::stats(shared).peak >= most_seen.load() &&
+                                       RobotMemory::stats(shared).live == 0);
+    RobotMemory::release(shared);
+
+    // a block that never came from operator new stops the process, it isn't freed
+    pid_t child = fork();
+    if (child == 0)
+    {
+        rlimit no_core = {0, 0};
+        setrlimit(RLIMIT_CORE, &no_core);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDERR_FILENO);
+        void* volatile foreign = std::malloc(64);
+        ::operator delete(foreign);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    module_passed &= print_test_result("Deleting a block new didn't make aborts",
+                                       WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+    // a megabyte a move against a 4MB cap
+    Arena arena(12, 12);
+    HoarderRobot hoarder;
+    PacerRobot pacer("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 20;
+    arena.m_memory_cap = 4 * 1024 * 1024;
+    arena.set_quiet(true);
+    arena.set_silent(true);
+    hoarder.set_boundaries(12, 12);
+    pacer.set_boundaries(12, 12);
+    hoarder.move_to(1, 1);
+    pacer.move_to(10, 9);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[10][9] = 'R';
+    arena.m_robots = {&hoarder, &pacer};
+    arena.run_simulation();
+
+    const std::vector<RobotMemoryStats>& memory = arena.robot_memory();
+    module_passed &= print_test_result("A robot over its cap is disqualified",
+                                       hoarder.get_health() == 0 && pacer.get_health() > 0 &&
+                                       hoarder.hoard.size() == 3);
+    module_passed &= print_test_result("Its memory stayed under the cap",
+                                       memory.size() == 2 && memory[0].over_cap && !memory[1].over_cap &&
+                                       memory[0].peak <= arena.m_memory_cap && memory[0].peak >= 3 * (1 << 20));
+
+    const GameResult& result = arena.game_result();
+    module_passed &= print_test_result("A disqualified robot places behind the winner",
+                                       result.winner == 1 && result.placement == std::vector<int>({2, 1}) &&
+                                       result.damage_taken[0] > 0 && result.damage_dealt == std::vector<int>({0, 0}));
+
+    // the memory table only comes out with a cap, or a robot that allocated
+    auto console_of = [](int64_t cap) {
+        Arena quiet(12, 12);
+        PacerRobot left("PacerA");
+        PacerRobot right("PacerB");
+        quiet.initialize_board(true);
+        quiet.m_max_rounds = 5;
+        quiet.m_memory_cap = cap;
+        quiet.set_quiet(true);
+        left.set_boundaries(12, 12);
+        right.set_boundaries(12, 12);
+        left.move_to(1, 1);
+        right.move_to(10, 9);
+        quiet.m_board[1][1] = 'R';
+        quiet.m_board[10][9] = 'R';
+        quiet.m_robots = {&left, &right};
+
+        const std::string path = "test_console.tmp";
+        std::cout.flush();
+        int saved = dup(STDOUT_FILENO);
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        quiet.run_simulation();
+        std::cout.flush();
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        std::ifstream in(path);
+        std::stringstream text;
+        text << in.rdbuf();
+        std::remove(path.c_str());
+        return text.str();
+    };
+    module_passed &= print_test_result("No memory table for robots that never allocate",
+                                       console_of(0).find("Robot memory") == std::string::npos &&
+                                       console_of(1 << 20).find("Robot memory") != std::string::npos);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_flight_recorder()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing FlightRecorder----------------\n";
+
+    const std::string path = "test_crash.tmp";
+    auto read_file = [](const std::string& name) {
+        std::ifstream in(name);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    };
+
+    // a full ring keeps the newest events
+    {
+        std::vector<std::vector<char>> board(2, std::vector<char>(3, '.'));
+        FlightRecorder recorder;
+        recorder.begin_game(path, 7, 100, {"Alpha", "Beta"}, &board);
+        for (int i = 0; i < 5000; ++i)
+        {
+            recorder.begin_turn(i, i % 2);
+            recorder.record(FlightKind::Move, 0, 3, i);
+        }
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        recorder.dump(fd, SIGSEGV);
+        close(fd);
+        recorder.end_game();
+    }
+    std::string report = read_file(path);
+    module_passed &= print_test_result("The ring keeps the last events",
+                                       report.find("Last 4096 events") != std::string::npos &&
+                                       report.find("distance 4999") != std::string::npos &&
+                                       report.find("distance 903\n") == std::string::npos &&
+                                       report.find("distance 904\n") != std::string::npos);
+    std::remove(path.c_str());
+
+    // a robot that crashes the process, in a child so the tests carry on
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0)
+    {
+        rlimit no_core = {0, 0};
+        setrlimit(RLIMIT_CORE, &no_core);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDERR_FILENO);
+
+        Arena arena(12, 12);
+        CrasherRobot crasher;
+        PacerRobot pacer("PacerB");
+        arena.initialize_board(true);
+        arena.set_seed(42);
+        arena.m_max_rounds = 20;
+        arena.m_crash_path = path;
+        arena.set_quiet(true);
+        arena.set_silent(true);
+        crasher.set_boundaries(12, 12);
+        pacer.set_boundaries(12, 12);
+        crasher.move_to(1, 1);
+        pacer.move_to(10, 9);
+        arena.m_board[1][1] = 'R';
+        arena.m_board[10][9] = 'R';
+        arena.m_robots = {&pacer, &crasher};
+        arena.run_simulation();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    module_passed &= print_test_result("The crash still kills the process",
+                                       WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+
+    report = read_file(path);
+    module_passed &= print_test_result("The report says where and when",
+                                       report.find("RobotWarz crashed: SIGSEGV") != std::string::npos &&
+                                       report.find("in CrasherBot's get_move_direction") != std::string::npos &&
+                                       report.find("round 2 of 20") != std::string::npos &&
+                                       report.find("Seed = 42") != std::string::npos);
+    module_passed &= print_test_result("It has the last turns and the board",
+                                       report.find("PacerB  moves 3, distance 1") != std::string::npos &&
+                                       report.find("CrasherBot  radar 0") != std::string::npos &&
+                                       report.find("is now R") != std::string::npos &&
+                                       report.find("Board:\n............\n") != std::string::npos);
+    std::remove(path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_game_stats()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing GameStats----------------\n";
+
+    const std::string path = "test_stats.tmp";
+    const std::string csv_path = "test_stats.csv";
+    std::remove(path.c_str());
+    std::remove(csv_path.c_str());
+
+    // a sniper that never moves, next to a pacer walking in and out of its radar
+    Arena arena(12, 12);
+    ShooterRobot sniper(railgun, "Sniper");
+    PacerRobot pacer("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 6;
+    arena.m_stats_path = path;
+    arena.set_quiet(true);
+    arena.set_silent(true);
+    sniper.set_boundaries(12, 12);
+    pacer.set_boundaries(12, 12);
+    sniper.move_to(1, 1);
+    pacer.move_to(2, 2);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[2][2] = 'R';
+    arena.m_robots = {&sniper, &pacer};
+    arena.run_simulation();
+
+    const GameStats& stats = arena.game_stats();
+    const WeaponStats& shots = stats.weapon(railgun);
+    uint64_t taken = 0;
+    uint64_t occupancy = 0;
+    for (int row = 0; row < 12; ++row)
+    {
+        for (int col = 0; col < 12; ++col)
+        {
+            taken += stats.at(HeatLayer::DamageTaken, row, col);
+            occupancy += stats.at(HeatLayer::Occupancy, row, col);
+        }
+    }
+    module_passed &= print_test_result("One game is counted",
+                                       stats.games() == 1 && stats.rounds() > 0 && stats.rows() == 12);
+    module_passed &= print_test_result("Occupancy counts the sniper every round",
+                                       stats.at(HeatLayer::Occupancy, 1, 1) == stats.rounds() &&
+                                       occupancy > stats.rounds() && occupancy <= 2 * stats.rounds());
+    module_passed &= print_test_result("Radar looks around the sniper",
+                                       stats.at(HeatLayer::Radar, 0, 0) >= stats.rounds() &&
+                                       stats.at(HeatLayer::Radar, 11, 11) == 0);
+    module_passed &= print_test_result("Railgun shots are hits or misses",
+                                       shots.shots > 0 && shots.hits > 0 && shots.hits + shots.misses == shots.shots &&
+                                       stats.weapon(grenade).shots == 0);
+    module_passed &= print_test_result("Damage dealt from the sniper's cell is damage taken",
+                                       shots.damage > 0 && stats.at(HeatLayer::DamageDealt, 1, 1) == shots.damage &&
+                                       taken == shots.damage);
+
+    // the game added itself to the file, a second merge doubles it
+    merge_stats_file(path, stats);
+    GameStats total;
+    module_passed &= print_test_result("Games add up in the stats file",
+                                       total.load(path) && total.games() == 2 && total.rounds() == 2 * stats.rounds() &&
+                                       total.at(HeatLayer::Occupancy, 1, 1) == 2 * stats.at(HeatLayer::Occupancy, 1, 1) &&
+                                       total.weapon(railgun).hits == 2 * shots.hits);
+
+    std::ifstream csv(csv_path);
+    std::stringstream text;
+    text << csv.rdbuf();
+    module_passed &= print_test_result("The CSV has the weapons and the layers",
+                                       text.str().find("games,2\n") != std::string::npos &&
+                                       text.str().find("railgun," + std::to_string(2 * shots.shots) + ",") != std::string::npos &&
+                                       text.str().find("\noccupancy\n") != std::string::npos &&
+                                       text.str().find("\nradar\n") != std::string::npos);
+
+    GameStats other;
+    other.reset(10, 10);
+    module_passed &= print_test_result("Boards of different sizes don't merge", !total.merge(other));
+
+    std::remove(path.c_str());
+    std::remove(csv_path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_batch_metrics()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing BatchMetrics----------------\n";
+
+    // the queue hands out each game once
+    BatchMetrics metrics(2, {"Alpha", "Beta \"B\""}, 3);
+    uint64_t game = 0;
+    std::vector<uint64_t> taken;
+    while (metrics.take_game(game))
+    {
+        taken.push_back(game);
+    }
+    module_passed &= print_test_result("The queue hands out every game once",
+                                       taken == std::vector<uint64_t>{0, 1, 2} && !metrics.take_game(game));
+
+    metrics.finish_game(0, 1, 40, false, false);
+    metrics.finish_game(1, -1, 100, true, false);
+    metrics.finish_game(1, 1, 20, false, false);
+    metrics.worker(0).rounds += 60;
+    metrics.worker(1).busy = true;
+    std::string text = metrics.format(true);
+    module_passed &= print_test_result("Workers add up",
+                                       text.find("\nrobotwarz_games_total 3\n") != std::string::npos &&
+                                       text.find("\nrobotwarz_rounds_total 60\n") != std::string::npos &&
+                                       text.find("\nrobotwarz_workers_active 1\n") != std::string::npos &&
+                                       text.find("\nrobotwarz_queue_depth 0\n") != std::string::npos &&
+                                       text.find("\nrobotwarz_game_rounds_average 53.33333333\n") != std::string::npos &&
+                                       text.find("\nrobotwarz_max_rounds_games_total 1\n") != std::string::npos);
+    module_passed &= print_test_result("Wins per robot, with the name escaped",
+                                       text.find("robotwarz_wins_total{robot=\"Alpha\"} 0\n") != std::string::npos &&
+                                       text.find("robotwarz_wins_total{robot=\"Beta \\\"B\\\"\"} 2\n") != std::string::npos &&
+                                       text.find("robotwarz_win_rate{robot=\"Beta \\\"B\\\"\"} 0.666667\n") != std::string::npos);
+    module_passed &= print_test_result("Every metric has a type",
+                                       text.find("# TYPE robotwarz_games_total counter\n") != std::string::npos &&
+                                       text.find("# TYPE robotwarz_win_rate gauge\n") != std::string::npos);
+
+    // the socket answers plain and HTTP clients
+    const std::string socket_path = "test_metrics.sock";
+    const std::string file_path = "test_metrics.tmp";
+    {
+        MetricsExporter exporter(metrics, "", socket_path);
+        bool started = exporter.start();
+        auto ask = [&](const std::string& request) {
+            std::string reply;
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, socket_path.c_str());
+            if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+            {
+                if (!request.empty())
+                    send(fd, request.data(), request.size(), 0);
+                char buffer[4096];
+                ssize_t n;
+                while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+                    reply.append(buffer, static_cast<std::size_t>(n));
+            }
+            close(fd);
+            return reply;
+        };
+        std::string plain = ask("");
+        std::string http = ask("GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+        module_passed &= print_test_result("The socket answers with the metrics",
+                                           started && plain.rfind("# HELP robotwarz_games_total", 0) == 0 &&
+                                           http.rfind("HTTP/1.0 200 OK\r\n", 0) == 0 &&
+                                           http.find("\r\n\r\n# HELP robotwarz_games_total") != std::string::npos);
+    }
+    module_passed &= print_test_result("The socket is gone afterwards", !std::filesystem::exists(socket_path));
+
+    // a small batch of pacers that never finish each other off
+    const std::string config_path = "test_batch.tmp";
+    {
+        std::ofstream config(config_path);
+        config << "ArenaSize = 12, 12\nMaxRounds = 30\nObstacleDensity = low\nSeed = 5\nCrashFile =\n";
+    }
+    std::vector<RobotEntry> robots = {
+        {"PacerA", []() -> RobotBase* { return new PacerRobot("PacerA"); }},
+        {"PacerB", []() -> RobotBase* { return new PacerRobot("PacerB"); }},
+    };
+    BatchOptions options;
+    options.config_path = config_path;
+    options.games = 6;
+    options.jobs = 3;
+    options.metrics_path = file_path;
+    std::stringstream summary;
+    std::streambuf* before = std::cout.rdbuf(summary.rdbuf());
+    bool ran = run_batch(options, robots);
+    std::cout.rdbuf(before);
+    std::cout << summary.str();
+
+    std::ifstream in(file_path);
+    std::stringstream file;
+    file << in.rdbuf();
+    module_passed &= print_test_result("A batch writes its final counts",
+                                       ran && file.str().find("\nrobotwarz_games_total 6\n") != std::string::npos &&
+                                       file.str().find("\nrobotwarz_rounds_total 180\n") != std::string::npos &&
+                                       file.str().find("\nrobotwarz_max_rounds_games_total 6\n") != std::string::npos &&
+                                       file.str().find("\nrobotwarz_workers 3\n") != std::string::npos &&
+                                       !std::filesystem::exists(file_path + ".tmp"));
+    // 30 rounds in each of the 6 games, every call timed on whichever worker played it
+    std::size_t table = summary.str().find("Robot call times");
+    module_passed &= print_test_result("A batch prints the call times of all its games",
+                                       table != std::string::npos &&
+                                       summary.str().find("PacerB", table) != std::string::npos &&
+                                       summary.str().find("       180 ", table) != std::string::npos);
+
+    // the config is read once and every game's arena set up from that, and a
+    // quiet, silent game prints nothing even with no log writer to stop it
+    ArenaConfig settings(config_path);
+    Arena from_settings(settings);
+    Arena from_file(config_path);
+    module_passed &= print_test_result("A config read once sets up arenas like the file",
+                                       settings.loaded && settings.settings.size() == 5 &&
+                                       from_settings.m_size_row == 12 && from_settings.m_max_rounds == 30 &&
+                                       from_settings.get_seed() == from_file.get_seed() &&
+                                       from_settings.m_obstacle_density == from_file.m_obstacle_density);
+    std::stringstream captured;
+    std::streambuf* console = std::cout.rdbuf(captured.rdbuf());
+    from_settings.set_quiet(true);
+    from_settings.set_silent(true);
+    from_settings.set_batch_game();
+    from_settings.initialize_board();
+    from_settings.add_robots(robots);
+    from_settings.run_simulation();
+    std::cout.rdbuf(console);
+    module_passed &= print_test_result("A quiet, silent game prints nothing",
+                                       captured.str().empty() && from_settings.game_result().rounds == 30);
+
+    // a batch killed after 4 of its 6 games carries on to what the whole batch gets
+    const std::string resume_config_path = "test_batch_resume.tmp";
+    const std::string checkpoint_path = "test_batch.checkpoint";
+    {
+        std::ofstream config(resume_config_path);
+        config << "ArenaSize = 12, 12\nMaxRounds = 30\nObstacleDensity = low\nSeed = 5\nCrashFile =\n"
+               << "CheckpointFile = " << checkpoint_path << "\n";
+    }
+    std::vector<RobotEntry> fighters = {
+        {"Lobber", []() -> RobotBase* { return new ShooterRobot(grenade, "Lobber"); }},
+        {"Sniper", []() -> RobotBase* { return new ShooterRobot(railgun, "Sniper"); }},
+    };
+    BatchOptions whole;
+    whole.config_path = resume_config_path;
+    whole.games = 6;
+    whole.jobs = 2;
+    BatchCheckpoint everything;
+    bool whole_ran = run_batch(whole, fighters) && load_batch_checkpoint(checkpoint_path, everything);
+
+    BatchOptions first_four = whole;
+    first_four.games = 4;
+    BatchCheckpoint killed;
+    bool killed_ran = run_batch(first_four, fighters) && load_batch_checkpoint(checkpoint_path, killed);
+    killed.games = 6;
+    save_batch_checkpoint(checkpoint_path, killed);
+
+    BatchOptions resume;
+    resume.resume_path = checkpoint_path;
+    resume.jobs = 3;
+    std::vector<RobotEntry> swapped = {fighters[1], fighters[0]};
+    BatchCheckpoint resumed;
+    bool resumed_ran = run_batch(resume, swapped) && load_batch_checkpoint(checkpoint_path, resumed);
+    module_passed &= print_test_result("A batch checkpoint reads back",
+                                       whole_ran && killed_ran && everything.done == 6 && killed.done == 4 &&
+                                       everything.base_seed == 5 && everything.config_path == resume_config_path);
+    module_passed &= print_test_result("A resumed batch adds up to the whole batch",
+                                       resumed_ran && resumed.done == 6 && resumed.games == 6 &&
+                                       resumed.game_rounds == everything.game_rounds &&
+                                       resumed.max_rounds == everything.max_rounds &&
+                                       resumed.draws == everything.draws &&
+                                       resumed.robots == std::vector<std::string>{"Sniper", "Lobber"} &&
+                                       resumed.wins == std::vector<uint64_t>{everything.wins[1], everything.wins[0]});
+    module_passed &= print_test_result("A batch checkpoint is told apart from a game's",
+                                       is_batch_checkpoint(checkpoint_path) && !is_batch_checkpoint(config_path));
+
+    // the workers add up their games' stats, the file is read and written once
+    const std::string stats_config_path = "test_batch_stats.cfg";
+    const std::string stats_path = "test_batch_stats.tmp";
+    const std::string stats_csv_path = "test_batch_stats.csv";
+    {
+        std::ofstream config(stats_config_path);
+        config << "ArenaSize = 12, 12\nMaxRounds = 30\nObstacleDensity = low\nSeed = 5\nCrashFile =\n"
+               << "StatsFile = " << stats_path << "\n";
+    }
+    BatchOptions with_stats;
+    with_stats.config_path = stats_config_path;
+    with_stats.games = 6;
+    with_stats.jobs = 3;
+    GameStats batch_stats;
+    bool stats_ran = run_batch(with_stats, robots) && batch_stats.load(stats_path);
+    module_passed &= print_test_result("A batch's stats are every game's",
+                                       stats_ran && batch_stats.games() == 6 && batch_stats.rounds() == 180);
+
+    {
+        std::ofstream damaged(stats_path, std::ios::trunc);
+        damaged << "not stats";
+    }
+    bool refused = !run_batch(with_stats, robots);
+    std::ifstream kept(stats_path);
+    std::stringstream kept_text;
+    kept_text << kept.rdbuf();
+    module_passed &= print_test_result("A stats file that can't be read is left alone",
+                                       refused && kept_text.str() == "not stats");
+
+    std::remove(config_path.c_str());
+    std::remove(file_path.c_str());
+    std::remove(resume_config_path.c_str());
+    std::remove(checkpoint_path.c_str());
+    std::remove(stats_config_path.c_str());
+    std::remove(stats_path.c_str());
+    std::remove(stats_csv_path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_bench_history()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing BenchHistory----------------\n";
+
+    BenchRun run;
+    run.revision = "abc1234";
+    run.dirty = true;
+    run.compiler = "g++ 12";
+    run.flags = "-O2 -DNAME=\"x\"";
+    run.date = "2026-01-02T03:04:05Z";
+    run.runs = 3;
+    run.metrics["tiny/round_ns"] = {100.5, 99.0, 101.25};
+    run.metrics["tiny/radar_ns"] = {};
+
+    BenchRun parsed;
+    std::string error;
+    bool ok = parse_bench_run(bench_run_json(run), parsed, error);
+    module_passed &= print_test_result("A run goes to JSON and back",
+                                       ok && parsed.revision == run.revision && parsed.dirty && parsed.flags == run.flags &&
+                                       parsed.date == run.date && parsed.runs == 3 && parsed.metrics == std::map<std::string, std::vector<double>>{
+                                           {"tiny/round_ns", {100.5, 99.0, 101.2}}, {"tiny/radar_ns", {}}});
+    module_passed &= print_test_result("Unknown keys are skipped",
+                                       parse_bench_run("{\"extra\": {\"a\": [1, \"b\", null, true]}, \"metrics\": {\"x\": [1]}}",
+                                                       parsed, error) && parsed.metrics["x"] == std::vector<double>{1});
+    module_passed &= print_test_result("Broken JSON is refused",
+                                       !parse_bench_run("{\"metrics\": {\"x\": [1,]}}", parsed, error) && !error.empty() &&
+                                       !parse_bench_run("{\"revision\": \"a\"}", parsed, error) &&
+                                       !parse_bench_run("{\"metrics\": {}} extra", parsed, error));
+
+    module_passed &= print_test_result("Median and MAD",
+                                       median({5, 1, 3}) == 3 && median({4, 1, 3, 2}) == 2.5 &&
+                                       std::fabs(median_absolute_deviation({1, 2, 3, 4, 100}) - 1.4826) < 1e-9);
+
+    // five earlier runs around 100ns, one of them slow
+    std::vector<BenchRun> history;
+    for (double value : {100.0, 101.0, 99.0, 140.0, 100.0})
+    {
+        BenchRun old;
+        old.compiler = "g++ 12";
+        old.flags = "-O2";
+        old.metrics["game/round_ns"] = {value, value + 1, value - 1};
+        history.push_back(old);
+    }
+    BenchRun other_build = history.back();
+    other_build.flags = "-O0";
+    other_build.metrics["game/round_ns"] = {500, 500, 500};
+    history.push_back(other_build);
+
+    BenchRun now;
+    now.compiler = "g++ 12";
+    now.flags = "-O2";
+    now.metrics["game/round_ns"] = {102, 103, 101};
+    now.metrics["game/weapon_ns"] = {50};
+    std::vector<BenchComparison> same = compare_bench_run(history, now, 10, 0.05);
+    module_passed &= print_test_result("Noise and other builds are no regression",
+                                       same.size() == 2 && same[0].metric == "game/round_ns" && same[0].baseline == 100 &&
+                                       same[0].baseline_runs == 5 && !same[0].regressed && !same[0].improved &&
+                                       same[1].baseline_runs == 0 && !same[1].regressed);
+
+    now.metrics["game/round_ns"] = {112, 111, 113};
+    std::vector<BenchComparison> slower = compare_bench_run(history, now, 10, 0.05);
+    module_passed &= print_test_result("A slowdown past the threshold is",
+                                       slower[0].regressed && slower[0].now == 112 &&
+                                       format_bench_comparison(slower).find("SLOWER") != std::string::npos);
+
+    std::vector<BenchRun> short_history(history.end() - 3, history.end());
+    module_passed &= print_test_result("Too little history never fails",
+                                       !compare_bench_run(short_history, now, 10, 0.05)[0].regressed &&
+                                       !compare_bench_run(history, now, 1, 0.05)[0].regressed);
+
+    const std::string path = "test_bench_history.tmp";
+    std::remove(path.c_str());
+    std::vector<BenchRun> loaded;
+    bool empty = load_bench_history(path, loaded) && loaded.empty();
+    append_bench_history(path, run);
+    append_bench_history(path, now);
+    module_passed &= print_test_result("The history file keeps runs in order",
+                                       empty && load_bench_history(path, loaded) && loaded.size() == 2 &&
+                                       loaded[0].revision == "abc1234" && loaded[1].metrics.size() == 2);
+    std::remove(path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_robot_harness()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing RobotHarness----------------\n";
+
+    std::istringstream text(
+        "# an enemy next door\n"
+        "turns 2\n"
+        "board\n"
+        "......\n"
+        "..SR.M   # with a mound\n"
+        "end\n"
+        "turn 1\n"
+        "expect shot 1 3\n"
+        "expect radar 0\n"
+        "turn 2\n"
+        "radar X 0 0\n"
+        "expect no_shot\n");
+    Scenario next_door;
+    bool parsed = parse_scenario(text, "next_door", next_door);
+    module_passed &= print_test_result("A scenario is read",
+                                       parsed && next_door.turns == 2 && next_door.board.size() == 2 &&
+                                       next_door.start_row == 1 && next_door.start_col == 2 &&
+                                       next_door.board[1][2] == '.' && next_door.board[1][5] == 'M' &&
+                                       next_door.turn[1].expects.size() == 2 && !next_door.turn[1].scripted_radar &&
+                                       next_door.turn[1].expects[0].kind == ExpectKind::ShotAt &&
+                                       next_door.turn[2].scripted_radar && next_door.turn[2].radar.size() == 1);
+
+    std::istringstream ragged("board\n..S\n....\nend\n"), no_start("size 5 5\n"), stray("turn 1\nexpect fly\n");
+    Scenario broken;
+    module_passed &= print_test_result("A broken scenario is refused",
+                                       !parse_scenario(ragged, "ragged", broken) &&
+                                       !parse_scenario(no_start, "no_start", broken) &&
+                                       !parse_scenario(stray, "stray", broken));
+
+    // shooter sees the enemy on local radar on turn 1, the dead robot on turn 2
+    RobotFactory shooter = []() -> RobotBase* { return new ShooterRobot(railgun, "ShooterBot"); };
+    RobotHarness met(shooter, "ShooterBot", 0, 0);
+    met.run_scenario(next_door, false);
+    next_door.turn[1].expects.push_back({ExpectKind::ShotAt, 0, 0});
+    next_door.turn[1].expects.push_back({ExpectKind::Move, 0, 0});
+    RobotHarness missed(shooter, "ShooterBot", 0, 0);
+    missed.run_scenario(next_door, false);
+    module_passed &= print_test_result("Expectations are checked",
+                                       met.problem_count() == 1 && missed.problem_count() == 3 &&
+                                       missed.report().find("was expected to move") != std::string::npos);
+
+    Scenario off_board;
+    std::istringstream off_board_text("size 4 4\nstart 0 0\nturns 1\nturn 1\nradar R 9 9\n");
+    parse_scenario(off_board_text, "off_board", off_board);
+    RobotHarness wild(shooter, "ShooterBot", 0, 0);
+    wild.run_scenario(off_board, false);
+    RobotHarness thrower([]() -> RobotBase* { return new ThrowerRobot(); }, "ThrowerBot", 0, 0);
+    thrower.run_random(1, 7);
+    module_passed &= print_test_result("Rule breaks and exceptions are problems",
+                                       wild.problem_count() == 1 && wild.report().find("off the board") != std::string::npos &&
+                                       thrower.problem_count() == 1 && thrower.report().find("lost its footing") != std::string::npos);
+
+    // the arena lets a robot ask for any move, so the harness does too
+    RobotHarness bad_moves([]() -> RobotBase* { return new BadMovesRobot(); }, "BadMovesBot", 0, 0);
+    bad_moves.run_random(300, 1);
+    module_passed &= print_test_result("Random boards are played like the arena",
+                                       bad_moves.problem_count() == 0 && bad_moves.timing().calls[0].wall.count() == 900 &&
+                                       bad_moves.memory().live == 0);
+
+    RobotHarness hoarder([]() -> RobotBase* { return new HoarderRobot(); }, "HoarderBot", 0, 3 << 19);
+    hoarder.run_random(20, 1);
+    module_passed &= print_test_result("Memory over the cap is caught",
+                                       hoarder.memory().over_cap && hoarder.problem_count() > 0 &&
+                                       hoarder.report().find("OVER its") != std::string::npos);
+
+    RobotHarness slow(shooter, "ShooterBot", 1, 0);
+    slow.run_random(10, 1);
+    module_passed &= print_test_result("Calls over the budget are flagged",
+                                       slow.over_budget() && !bad_moves.over_budget() &&
+                                       slow.report().find("OVER BUDGET") != std::string::npos);
+
+    const std::string path = "test_robot_harness.cfg";
+    {
+        std::ofstream config(path);
+        config << "RobotCallBudgetMs = 2.5\nRobotMemoryCapMB = 3\n";
+    }
+    Arena arena(10, 10);
+    bool loaded = arena.load_config(path);
+    module_passed &= print_test_result("The arena reads the call budget",
+                                       loaded && arena.call_budget_ns() == 2500000 && arena.memory_cap() == 3 << 20);
+    std::remove(path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_robot_profiler()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing RobotProfiler----------------\n";
+
+    // a robot that burns a few ms a turn next to one that hardly does anything
+    const std::string path = "test_profile.tmp";
+    Arena arena(12, 12);
+    BusyRobot busy;
+    PacerRobot pacer("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 60;
+    arena.m_profile_path = path;
+    arena.m_profile_hz = 1000;
+    arena.set_quiet(true);
+    arena.set_silent(true);
+    busy.set_boundaries(12, 12);
+    pacer.set_boundaries(12, 12);
+    busy.move_to(1, 1);
+    pacer.move_to(10, 9);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[10][9] = 'R';
+    arena.m_robots = {&busy, &pacer};
+    arena.run_simulation();
+
+    const RobotProfile& profile = arena.robot_profile();
+    bool spun = false, other = true;
+    for (const auto& [stack, count] : profile.folded)
+    {
+        if (stack.rfind("BusyBot;", 0) == 0 && stack.find("BusyRobot::spin") != std::string::npos)
+            spun = true;
+        other &= stack.rfind("BusyBot;", 0) == 0 || stack.rfind("PacerB;", 0) == 0;
+    }
+#ifdef __linux__
+    module_passed &= print_test_result("Samples go to the robot whose call it was",
+                                       profile.robots.size() == 2 && profile.samples[0] >= 10 &&
+                                       profile.samples[1] * 10 < profile.samples[0] && other);
+    module_passed &= print_test_result("Stacks are symbolised down to the function", spun);
+
+    std::ifstream folded(path);
+    std::string line;
+    uint64_t lines = 0, total = 0;
+    while (std::getline(folded, line))
+    {
+        ++lines;
+        total += std::stoull(line.substr(line.rfind(' ') + 1));
+    }
+    module_passed &= print_test_result("The folded stacks file adds up",
+                                       lines == profile.folded.size() && total == profile.samples[0] + profile.samples[1]);
+#endif
+    std::remove(path.c_str());
+
+    RobotProfile twice = profile;
+    twice.merge(profile);
+    std::string flat = format_robot_profile(twice, 5);
+    module_passed &= print_test_result("Profiles add up",
+                                       twice.samples[0] == 2 * profile.samples[0] &&
+                                       twice.engine_samples == 2 * profile.engine_samples &&
+                                       twice.folded.size() == profile.folded.size() &&
+                                       flat.find("BusyBot: " + std::to_string(twice.samples[0]) + " samples") != std::string::npos);
+
+    RobotProfile made_up;
+    made_up.hz = 100;
+    made_up.robots = {"A"};
+    made_up.samples = {4};
+    made_up.folded = {{"A;lib.so`outer;lib.so`inner", 3}, {"A;lib.so`outer", 1}};
+    flat = format_robot_profile(made_up, 5);
+    module_passed &= print_test_result("Self and total per function",
+                                       flat.find("75.0%  100.0%  lib.so`inner") == std::string::npos &&
+                                       flat.find("   75.0%   75.0%  lib.so`inner") != std::string::npos &&
+                                       flat.find("   25.0%  100.0%  lib.so`outer") != std::string::npos);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_tournament()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing Tournament----------------\n";
+
+    // a million games of nothing on 4 threads: each number handed out once,
+    // and the handing out costs next to nothing
+    const int jobs = 4;
+    const uint64_t million = 1000000;
+    GameQueue queue(jobs);
+    queue.reset(million);
+    std::vector<std::atomic<uint8_t>> taken(million);
+    std::vector<uint64_t> per_worker(jobs, 0);
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::thread> threads;
+        for (int worker = 0; worker < jobs; ++worker)
+        {
+            threads.emplace_back([&, worker]() {
+                uint64_t game;
+                while (queue.next(worker, game))
+                {
+                    taken[game].fetch_add(1, std::memory_order_relaxed);
+                    ++per_worker[worker];
+                    // worker 0's games are slow, so the others have to steal them
+                    if (worker == 0)
+                        std::this_thread::sleep_for(std::chrono::microseconds(game % 64 == 0 ? 50 : 0));
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool once = std::all_of(taken.begin(), taken.end(), [](const std::atomic<uint8_t>& n) { return n == 1; });
+    std::cout << "1M games handed out in " << seconds * 1000 << "ms, worker 0 played " << per_worker[0] << "\n";
+    module_passed &= print_test_result("Every game of a million handed out exactly once", once);
+    module_passed &= print_test_result("Slow workers' games get stolen", per_worker[0] < million / jobs);
+
+    // more than a queue can hold is refused, not cut short
+    uint64_t game = 0;
+    std::cerr.setstate(std::ios::failbit);
+    bool too_many = !queue.reset(GameQueue::max_games + 1) && !queue.next(0, game);
+    std::cerr.clear();
+    bool fits = queue.reset(GameQueue::max_games) && queue.next(jobs - 1, game) &&
+                game == GameQueue::max_games * (jobs - 1) / jobs;
+    module_passed &= print_test_result("A queue refuses more games than it can hold", too_many && fits);
+
+    // the same million through a round robin, with a play that does nothing
+    TournamentOptions options;
+    options.jobs = jobs;
+    options.maps = {"a", "b"};
+    options.repeats = million / 90; // 45 pairings of 10 robots on 2 maps
+    Tournament big(options, 10, {0, 0});
+    start = std::chrono::steady_clock::now();
+    big.run([](const TournamentGame& game, int) {
+        GameOutcome outcome;
+        outcome.winner = game.seed % 3 == 0 ? -1 : 0;
+        outcome.rounds = 1;
+        return outcome;
+    });
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << big.results().games() << " empty round robin games in " << seconds * 1000 << "ms\n";
+    const TournamentResults& all = big.results();
+    const uint64_t repeats = options.repeats;
+    bool pairs = true;
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int j = 0; j < 10; ++j)
+        {
+            if (i != j)
+                pairs &= all.met(i, j) == 2 * repeats && all.met(i, j) == all.met(j, i) &&
+                         all.wins(i, j) + all.wins(j, i) + all.draws(i, j) == all.met(i, j);
+        }
+        pairs &= all.played(i) == 9 * 2 * repeats;
+    }
+    module_passed &= print_test_result("A round robin plays every pair on every map",
+                                       all.games() == 45 * 2 * repeats && all.rounds() == all.games() &&
+                                       big.games_played() == all.games() && pairs);
+    module_passed &= print_test_result("Scheduling a million games takes under a few seconds", seconds < 5.0);
+
+    // 3 player round robin, and ffa
+    TournamentOptions triples;
+    triples.players = 3;
+    Tournament threes(triples, 5, {0});
+    threes.run([](const TournamentGame&, int) { return GameOutcome(); });
+    TournamentOptions everyone;
+    everyone.format = TournamentFormat::FreeForAll;
+    everyone.repeats = 4;
+    Tournament ffa(everyone, 6, {0});
+    int most = 0;
+    ffa.run([&](const TournamentGame& game, int) {
+        most = std::max(most, game.player_count);
+        GameOutcome outcome;
+        outcome.winner = 5;
+        return outcome;
+    });
+    module_passed &= print_test_result("Groups of 3 are every combination once",
+                                       threes.results().games() == 10 && threes.results().met(0, 4) == 3 &&
+                                       threes.results().drawn(2) == 6);
+    module_passed &= print_test_result("Free for all has everyone in every game",
+                                       ffa.results().games() == 4 && most == 6 && ffa.results().won(5) == 4 &&
+                                       ffa.results().wins(5, 0) == 4 && ffa.results().standings()[0] == 5);
+
+    // swiss: the lower numbered robot always wins, 7 robots so someone sits out
+    TournamentOptions swiss_options;
+    swiss_options.format = TournamentFormat::Swiss;
+    swiss_options.jobs = 2;
+    Tournament swiss(swiss_options, 7, {100});
+    std::vector<uint64_t> seeds;
+    std::mutex seeds_lock;
+    swiss.run([&](const TournamentGame& game, int) {
+        {
+            std::lock_guard<std::mutex> lock(seeds_lock);
+            seeds.push_back(game.seed);
+        }
+        GameOutcome outcome;
+        outcome.winner = game.players[0] < game.players[1] ? 0 : 1;
+        return outcome;
+    });
+    const TournamentResults& standings = swiss.results();
+    bool no_rematch = true;
+    uint64_t byes = 0;
+    for (int i = 0; i < 7; ++i)
+    {
+        for (int j = 0; j < 7; ++j)
+        {
+            no_rematch &= standings.met(i, j) <= 1;
+        }
+        no_rematch &= standings.byes(i) <= 1;
+        byes += standings.byes(i);
+    }
+    std::sort(seeds.begin(), seeds.end());
+    module_passed &= print_test_result("Swiss plays log2 rounds with no rematches and one bye a round",
+                                       standings.games() == 9 && byes == 3 && no_rematch);
+    module_passed &= print_test_result("Swiss puts the unbeaten robot on top",
+                                       standings.standings()[0] == 0 && standings.won(0) == 3);
+    module_passed &= print_test_result("Every pairing in a swiss round plays the same seed, each round its own",
+                                       seeds == std::vector<uint64_t>{100, 100, 100, 101, 101, 101, 102, 102, 102});
+
+    // each map plays from its own seed
+    TournamentOptions two_maps;
+    two_maps.maps = {"a", "b"};
+    two_maps.repeats = 2;
+    Tournament mapped(two_maps, 3, {10, 500});
+    std::vector<std::pair<int, uint64_t>> map_seeds;
+    mapped.run([&](const TournamentGame& game, int) {
+        map_seeds.emplace_back(game.map, game.seed);
+        return GameOutcome();
+    });
+    bool own_seeds = map_seeds.size() == 12;
+    for (const auto& [map, seed] : map_seeds)
+    {
+        uint64_t first = map == 0 ? 10 : 500;
+        own_seeds &= seed == first || seed == first + 1;
+    }
+    module_passed &= print_test_result("Each map plays with its own seed", own_seeds);
+
+    // robots' rand() is each game's own: games drawing from it on 4 threads get
+    // the numbers they get on one
+    auto draw = [](int jobs) {
+        TournamentOptions options;
+        options.jobs = jobs;
+        options.repeats = 50;
+        std::vector<int> draws(6 * 50);
+        Tournament drawing(options, 4, {9});
+        drawing.run([&](const TournamentGame& game, int) {
+            std::srand(static_cast<unsigned>(game.seed));
+            int value = 0;
+            for (int i = 0; i < 1000; ++i)
+            {
+                value ^= std::rand();
+                if (i % 100 == 0)
+                    std::this_thread::yield();
+            }
+            draws[game.number] = value;
+            return GameOutcome();
+        });
+        return draws;
+    };
+    std::vector<int> one_thread = draw(1);
+    std::vector<int> four_threads = draw(4);
+    std::srand(1);
+    RobotRandom reference(1);
+    module_passed &= print_test_result("Robots' rand() is the game's own on every thread",
+                                       four_threads == one_thread && one_thread[0] != one_thread[1] &&
+                                       std::rand() == reference.next());
+
+    // the matrix and the CSV
+    std::vector<std::string> names = {"Zero", "One", "Two", "Three", "Four", "Five", "Six"};
+    std::string matrix = format_results_matrix(standings, names);
+    std::string table = format_standings(standings, names);
+    const std::string csv_path = "test_tournament.tmp";
+    write_results_csv(csv_path, standings, names);
+    std::ifstream csv(csv_path);
+    std::string line;
+    int lines = 0;
+    bool zero_beat_one = false;
+    while (std::getline(csv, line))
+    {
+        ++lines;
+        zero_beat_one |= line == "Zero,One,1,1,0,0";
+    }
+    std::remove(csv_path.c_str());
+    module_passed &= print_test_result("The standings and matrix name everyone",
+                                       table.find("  1. Zero") != std::string::npos &&
+                                       matrix.find("  7. Six") != std::string::npos);
+    module_passed &= print_test_result("The CSV has a line per robot and opponent", lines == 19 && zero_beat_one);
+
+    // and real games between pacers, which never finish each other off
+    const std::string config_path = "test_tournament_map.tmp";
+    {
+        std::ofstream config(config_path);
+        config << "ArenaSize = 12, 12\nMaxRounds = 20\nObstacleDensity = low\nSeed = 5\nCrashFile =\n";
+    }
+    std::vector<RobotEntry> robots = {
+        {"PacerA", []() -> RobotBase* { return new PacerRobot("PacerA"); }},
+        {"PacerB", []() -> RobotBase* { return new PacerRobot("PacerB"); }},
+        {"PacerC", []() -> RobotBase* { return new PacerRobot("PacerC"); }},
+    };
+    TournamentOptions real;
+    real.maps = {config_path};
+    real.repeats = 2;
+    real.jobs = 2;
+    real.results_path = csv_path;
+    std::cout.setstate(std::ios::failbit);
+    bool ran = run_tournament(real, robots);
+    std::cout.clear();
+    std::ifstream real_csv(csv_path);
+    std::stringstream real_file;
+    real_file << real_csv.rdbuf();
+    module_passed &= print_test_result("A tournament of real games",
+                                       ran && real_file.str().find("PacerA,PacerC,2,0,0,2\n") != std::string::npos);
+    std::remove(csv_path.c_str());
+    std::remove(config_path.c_str());
+
+    real.players = 4;
+    std::cerr.setstate(std::ios::failbit);
+    ran = run_tournament(real, robots);
+    std::cerr.clear();
+    module_passed &= print_test_result("Groups bigger than the field are refused", !ran);
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_results_store()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing ResultsStore----------------\n";
+
+    const std::string path = "test_results.tmp";
+    std::remove(path.c_str());
+
+    // a sniper that finishes off a pacer next to it
+    Arena arena(12, 12);
+    ShooterRobot sniper(railgun, "Sniper");
+    PacerRobot pacer("PacerB");
+    arena.initialize_board(true);
+    arena.m_max_rounds = 500;
+    arena.m_results_path = path;
+    arena.set_quiet(true);
+    arena.set_silent(true);
+    sniper.set_boundaries(12, 12);
+    pacer.set_boundaries(12, 12);
+    sniper.move_to(1, 1);
+    pacer.move_to(2, 2);
+    arena.m_board[1][1] = 'R';
+    arena.m_board[2][2] = 'R';
+    arena.m_robots = {&sniper, &pacer};
+    arena.run_simulation();
+
+    const GameResult& result = arena.game_result();
+    module_passed &= print_test_result("The winner places first and the dead second",
+                                       result.winner == 0 && result.placement == std::vector<int>({1, 2}));
+    module_passed &= print_test_result("Damage dealt is damage taken",
+                                       result.damage_dealt[0] > 0 && result.damage_dealt[0] == result.damage_taken[1] &&
+                                       result.damage_taken[0] == 0 && result.damage_dealt[1] == 0);
+
+    ResultsStore* shared = shared_results_store(path);
+    bool stored = shared && shared->game_count() == 1 && shared->robot_count() == 2;
+    if (stored)
+    {
+        shared->flush();
+        int winner = shared->find_robot("Sniper");
+        GameRecord game = shared->game(0);
+        stored = winner >= 0 && shared->robot_record(winner).rating > ResultsStore::initial_rating &&
+                 shared->robot_record(winner).source == text_hash("Sniper") &&
+                 game.rows == 12 && game.rounds == result.rounds && game.robots.size() == 2 && game.winner == 0 &&
+                 game.robots[0].damage_dealt == result.damage_dealt[0];
+    }
+    module_passed &= print_test_result("The game goes in the store with the robots by hash", stored);
+
+    // two thousand more, then read back: the same ratings and indexes
+    std::remove(path.c_str());
+    std::vector<double> ratings;
+    std::vector<uint64_t> wins;
+    std::size_t bytes = 0;
+    {
+        ResultsStore store;
+        store.open(path);
+        std::vector<int> robots;
+        for (int i = 0; i < 5; ++i)
+        {
+            robots.push_back(store.robot(1000 + i, "Bot" + std::to_string(i)));
+        }
+        for (int game = 0; game < 2000; ++game)
+        {
+            GameRecord record;
+            record.seed = 7 + game;
+            record.rows = record.cols = 20;
+            record.max_rounds = 100;
+            record.rounds = 10 + game % 50;
+            int a = game % 5, b = (game / 5 + 1 + a) % 5;
+            if (a == b)
+                b = (b + 1) % 5;
+            // the lower numbered bot wins 3 times in 4
+            bool upset = game % 4 == 0;
+            GamePlacement first, second;
+            first.robot = robots[std::min(a, b)];
+            second.robot = robots[std::max(a, b)];
+            first.placement = upset ? 2 : 1;
+            second.placement = upset ? 1 : 2;
+            first.damage_dealt = second.damage_taken = 40;
+            record.robots = {first, second};
+            // now and then both die, the one that lasted longer placing first
+            record.winner = game % 10 == 5 ? -1 : upset ? 1 : 0;
+            store.add(record);
+        }
+        for (int robot : robots)
+        {
+            ratings.push_back(store.robot_record(robot).rating);
+            wins.push_back(store.robot_record(robot).wins);
+        }
+        module_passed &= print_test_result("Ratings follow who wins",
+                                           store.ladder() == std::vector<int>({0, 1, 2, 3, 4}) &&
+                                           std::abs(std::accumulate(ratings.begin(), ratings.end(), 0.0) - 5 * 1500) < 1e-6);
+        HeadToHead between = store.head_to_head(0, 1);
+        module_passed &= print_test_result("Indexed by robot and by opponent",
+                                           store.games_of(0).size() == store.robot_record(0).games &&
+                                           between.games == store.games_between(1, 0).size() && between.games > 0 &&
+                                           between.wins + between.losses + between.draws == between.games &&
+                                           between.wins > between.losses);
+    }
+    bytes = std::filesystem::file_size(path);
+    {
+        ResultsStore again;
+        bool opened = again.open(path);
+        bool same = opened && again.game_count() == 2000 && again.robot_count() == 5;
+        for (int robot = 0; same && robot < 5; ++robot)
+        {
+            same = std::abs(again.robot_record(robot).rating - ratings[robot]) < 1e-9 &&
+                   again.robot_record(robot).wins == wins[robot];
+        }
+        module_passed &= print_test_result("Reading the file back rates it the same", same);
+        module_passed &= print_test_result("A game nobody won keeps no winner",
+                                           again.game(5).winner == -1 && again.game(4).winner == 1 &&
+                                           again.game(6).winner == 0);
+        module_passed &= print_test_result("A two robot game is a few bytes", bytes < 2000 * 32);
+    }
+
+    // the tail of a record that never got written is cut off, a bad byte is refused
+    {
+        std::ofstream tail(path, std::ios::binary | std::ios::app);
+        tail.write("\x30GA", 3);
+    }
+    {
+        ResultsStore torn;
+        std::cerr.setstate(std::ios::failbit);
+        bool opened = torn.open(path);
+        std::cerr.clear();
+        module_passed &= print_test_result("A torn last record is cut off",
+                                           opened && torn.game_count() == 2000 &&
+                                           std::filesystem::file_size(path) == bytes);
+    }
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(bytes / 2);
+        file.put('\xff');
+    }
+    {
+        ResultsStore corrupt;
+        std::cerr.setstate(std::ios::failbit);
+        bool opened = corrupt.open(path);
+        std::cerr.clear();
+        module_passed &= print_test_result("A corrupt record is refused", !opened);
+    }
+    std::remove(path.c_str());
+
+    // a free for all: the survivor beats both, the two that died together draw
+    {
+        ResultsStore store;
+        GameRecord record;
+        for (int i = 0; i < 3; ++i)
+        {
+            GamePlacement placement;
+            placement.robot = store.robot(i + 1, "Ffa" + std::to_string(i));
+            placement.placement = i == 0 ? 1 : 2;
+            record.robots.push_back(placement);
+        }
+        record.winner = 0;
+        store.add(record);
+        module_passed &= print_test_result("Placements rate every pair",
+                                           std::abs(store.robot_record(0).rating - 1508) < 1e-9 &&
+                                           std::abs(store.robot_record(1).rating - 1496) < 1e-9 &&
+                                           store.robot_record(0).wins == 1 && store.robot_record(1).wins == 0 &&
+                                           store.head_to_head(1, 2).draws == 1);
+    }
+
+    // rating a big ladder from scratch is quick
+    {
+        ResultsStore store;
+        std::vector<int> robots;
+        for (int i = 0; i < 20; ++i)
+        {
+            robots.push_back(store.robot(i, "Bot"));
+        }
+        auto start = std::chrono::steady_clock::now();
+        GameRecord record;
+        record.robots.resize(2);
+        for (int game = 0; game < 200000; ++game)
+        {
+            record.robots[0].robot = robots[game % 20];
+            record.robots[1].robot = robots[(game / 20 + 1 + game % 20) % 20];
+            record.robots[0].placement = 1;
+            record.robots[1].placement = 2;
+            if (record.robots[0].robot != record.robots[1].robot)
+                store.add(record);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // how long it took is only printed, a busy machine is no failure
+        std::cout << store.game_count() << " games rated and indexed in " << seconds * 1000 << "ms\n";
+        module_passed &= print_test_result("Rating a big ladder counts every game",
+                                           store.game_count() == 190000 &&
+                                           store.robot_record(robots[0]).games == store.games_of(robots[0]).size());
+    }
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
+
+void TestArena::test_incremental_tournament()
+{
+    bool module_passed = true;
+
+    std::cout << "\n----------------Testing incremental tournaments----------------\n";
+
+    const std::string results_path = "test_incremental.tmp";
+    const std::string config_path = "test_incremental_map.tmp";
+    std::remove(results_path.c_str());
+    auto write_config = [&](int repetition_draw) {
+        std::ofstream config(config_path);
+        config << "ArenaSize = 12, 12\nMaxRounds = 20\nObstacleDensity = low\nSeed = 5\nCrashFile =\n"
+               << "RepetitionDraw = " << repetition_draw << "\nResultsFile = " << results_path << "\n";
+    };
+    write_config(0);
+
+    // the robots' sources stand in for Robot_<name>.cpp
+    std::vector<RobotEntry> robots = {
+        {"PacerC", []() -> RobotBase* { return new PacerRobot("PacerC"); }, 3},
+        {"PacerA", []() -> RobotBase* { return new PacerRobot("PacerA"); }, 1},
+        {"PacerB", []() -> RobotBase* { return new PacerRobot("PacerB"); }, 2},
+    };
+    TournamentOptions options;
+    options.maps = {config_path};
+    options.repeats = 2;
+    options.jobs = 2;
+
+    // the summary line and the standings of one tournament
+    auto play = [&](std::string& summary) {
+        std::stringstream out;
+        std::streambuf* console = std::cout.rdbuf(out.rdbuf());
+        bool ran = run_tournament(options, robots);
+        std::cout.rdbuf(console);
+        std::string line;
+        while (std::getline(out, line))
+        {
+            if (line.find(" games, ") != std::string::npos)
+                summary = line;
+        }
+        return ran;
+    };
+
+    std::string first, again, changed, fresh, rules;
+    bool ran = play(first);
+    ran &= play(again);
+    module_passed &= print_test_result("The first run plays every game",
+                                       ran && first.rfind("6 games, 0 from the results store and 6 played", 0) == 0);
+    module_passed &= print_test_result("The same robots again play nothing",
+                                       again.rfind("6 games, 6 from the results store and 0 played", 0) == 0);
+
+    // PacerB has a new source: its 2 pairings are played, PacerA against PacerC isn't
+    robots[2].source_hash = 22;
+    play(changed);
+    module_passed &= print_test_result("A changed robot's games are played again",
+                                       changed.rfind("6 games, 2 from the results store and 4 played", 0) == 0);
+
+    options.reuse = false;
+    play(fresh);
+    options.reuse = true;
+    module_passed &= print_test_result("Reuse can be turned off",
+                                       fresh.rfind("6 games, 0 from the results store and 6 played", 0) == 0);
+
+    // a rule that changes how games end makes them all new games
+    write_config(3);
+    play(rules);
+    module_passed &= print_test_result("Changed rules play everything again",
+                                       rules.rfind("6 games, 0 from the results store and 6 played", 0) == 0);
+
+    // and the store knows them all: 6 + 4 + 6 + 6 played, robots by source
+    ResultsStore store;
+    bool opened = store.open(results_path);
+    module_passed &= print_test_result("Every game played went in the store",
+                                       opened && store.game_count() == 22 && store.robot_count() == 4 &&
+                                       store.find_robot(22) >= 0 && store.find_robot(2) >= 0);
+
+    std::remove(results_path.c_str());
+    std::remove(config_path.c_str());
+
+    test_log.push_back(std::string(__FUNCTION__) + ": " + (module_passed ? "passed" : "failed"));
+}
@@ -3,9 +3,12 @@
 
 #include "Arena.h"
 #include "RobotBase.h"
+#include "SerializableRobot.h"
 #include <vector>
 #include <string>
 #include <iostream>
+#include <csignal>
+#include <stdexcept>
 
 class TestArena {
 public:
@@ -18,6 +21,28 @@ public:
     void test_grenade_damage();
     void test_radar();
     void test_radar_local();
+    void test_board_renderer();
+    void test_board_views();
+    void test_replay();
+    void test_replay_playback();
+    void test_lockstep();
+    void test_snapshot();
+    void test_checkpoint();
+    void test_repetition();
+    void test_stalemate();
+    void test_tracer();
+    void test_robot_timing();
+    void test_phase_profile();
+    void test_robot_memory();
+    void test_flight_recorder();
+    void test_game_stats();
+    void test_batch_metrics();
+    void test_bench_history();
+    void test_robot_harness();
+    void test_robot_profiler();
+    void test_tournament();
+    void test_results_store();
+    void test_incremental_tournament();
 	void print_summary();
 
 private:
@@ -198,4 +223,111 @@ private:
     bool m_has_target = false;
 };
 
+// walks one step right, then one step left, forever
+class PacerRobot : public RobotBase {
+public:
+    PacerRobot(const std::string& name) : RobotBase(2, 3, railgun) {
+        m_name = name;
+    }
+
+    void get_radar_direction(int& radar_direction) override {
+        radar_direction = 0;
+    }
+
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        (void)radar_results;
+    }
+
+    bool get_shot_location(int& shot_row, int& shot_col) override {
+        shot_row = shot_col = 0;
+        return false;
+    }
+
+    void get_move_direction(int& direction, int& distance) override {
+        direction = m_right ? 3 : 7;
+        distance = 1;
+        m_right = !m_right;
+    }
+
+private:
+    bool m_right = true;
+};
+
+// keeps another megabyte every time it moves, and a scratch buffer it frees again
+class HoarderRobot : public PacerRobot {
+public:
+    std::vector<std::vector<char>> hoard;
+
+    HoarderRobot() : PacerRobot("HoarderBot") {}
+
+    void get_move_direction(int& direction, int& distance) override {
+        std::vector<int> scratch(1000);
+        hoard.emplace_back(1 << 20, 'x');
+        PacerRobot::get_move_direction(direction, distance);
+    }
+};
+
+// crashes the process on its third move
+class CrasherRobot : public PacerRobot {
+public:
+    int moves = 0;
+
+    CrasherRobot() : PacerRobot("CrasherBot") {}
+
+    void get_move_direction(int& direction, int& distance) override {
+        if (++moves == 3)
+            std::raise(SIGSEGV);
+        PacerRobot::get_move_direction(direction, distance);
+    }
+};
+
+// throws on its second move
+class ThrowerRobot : public PacerRobot {
+public:
+    int moves = 0;
+
+    ThrowerRobot() : PacerRobot("ThrowerBot") {}
+
+    void get_move_direction(int& direction, int& distance) override {
+        if (++moves == 2)
+            throw std::runtime_error("lost its footing");
+        PacerRobot::get_move_direction(direction, distance);
+    }
+};
+
+// burns CPU in a function of its own every time it looks at its radar
+class BusyRobot : public PacerRobot {
+public:
+    volatile uint64_t sum = 0;
+
+    BusyRobot() : PacerRobot("BusyBot") {}
+
+    void spin() {
+        for (uint64_t i = 0; i < 1000000; ++i)
+            sum = sum + i * i;
+    }
+
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override {
+        (void)radar_results;
+        spin();
+    }
+};
+
+// remembers a number between turns and lets snapshots save it
+class MemoryRobot : public TestRobot, public SerializableRobot {
+public:
+    int memory = 0;
+
+    MemoryRobot() : TestRobot(3, 4, hammer, "MemoryBot") {}
+
+    std::string save_state() const override {
+        return std::to_string(memory);
+    }
+
+    bool load_state(std::string_view state) override {
+        memory = std::stoi(std::string(state));
+        return true;
+    }
+};
+
 #endif // TESTARENA_H
@@ -0,0 +1,596 @@
+#include "Tournament.h"
+#include "ResultsStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+bool parse_tournament_format(const std::string& text, TournamentFormat& format)
+{
+    if (text == "roundrobin" || text == "round-robin")
+        format = TournamentFormat::RoundRobin;
+    else if (text == "swiss")
+        format = TournamentFormat::Swiss;
+    else if (text == "ffa")
+        format = TournamentFormat::FreeForAll;
+    else
+        return false;
+    return true;
+}
+
+const char* tournament_format_name(TournamentFormat format)
+{
+    switch (format)
+    {
+        case TournamentFormat::RoundRobin: return "round robin";
+        case TournamentFormat::Swiss:      return "swiss";
+        default:                           return "free for all";
+    }
+}
+
+TournamentResults::TournamentResults(int robots)
+    : m_robots(robots), m_games(0), m_rounds(0),
+      m_played(robots, 0), m_won(robots, 0), m_drawn(robots, 0), m_byes(robots, 0),
+      m_met(robots * robots, 0), m_wins(robots * robots, 0), m_draws(robots * robots, 0)
+{
+}
+
+void TournamentResults::add(const TournamentGame& game, const GameOutcome& outcome)
+{
+    ++m_games;
+    m_rounds += outcome.rounds;
+    int winner = outcome.winner >= 0 && outcome.winner < game.player_count ? game.players[outcome.winner] : -1;
+    for (int i = 0; i < game.player_count; ++i)
+    {
+        int robot = game.players[i];
+        ++m_played[robot];
+        if (winner < 0)
+            ++m_drawn[robot];
+        else if (winner == robot)
+            ++m_won[robot];
+
+        for (int j = 0; j < game.player_count; ++j)
+        {
+            if (i == j)
+                continue;
+            std::size_t cell = static_cast<std::size_t>(robot) * m_robots + game.players[j];
+            ++m_met[cell];
+            if (winner < 0)
+                ++m_draws[cell];
+            else if (winner == robot)
+                ++m_wins[cell];
+        }
+    }
+}
+
+void TournamentResults::add_bye(int robot)
+{
+    ++m_byes[robot];
+}
+
+void TournamentResults::merge(const TournamentResults& other)
+{
+    m_games += other.m_games;
+    m_rounds += other.m_rounds;
+    auto add = [](std::vector<uint64_t>& into, const std::vector<uint64_t>& from) {
+        for (std::size_t i = 0; i < into.size() && i < from.size(); ++i)
+            into[i] += from[i];
+    };
+    add(m_played, other.m_played);
+    add(m_won, other.m_won);
+    add(m_drawn, other.m_drawn);
+    add(m_byes, other.m_byes);
+    add(m_met, other.m_met);
+    add(m_wins, other.m_wins);
+    add(m_draws, other.m_draws);
+}
+
+double TournamentResults::points(int robot) const
+{
+    return m_won[robot] + m_byes[robot] + 0.5 * m_drawn[robot];
+}
+
+std::vector<int> TournamentResults::standings() const
+{
+    std::vector<int> order(m_robots);
+    for (int i = 0; i < m_robots; ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        if (points(a) != points(b))
+            return points(a) > points(b);
+        return m_won[a] > m_won[b];
+    });
+    return order;
+}
+
+std::string format_standings(const TournamentResults& results, const std::vector<std::string>& names)
+{
+    std::ostringstream out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-28s %8s %8s %8s %8s %6s %9s\n", "Standings", "games", "wins", "draws",
+                  "losses", "byes", "points");
+    out << line;
+    int rank = 0;
+    for (int robot : results.standings())
+    {
+        uint64_t played = results.played(robot);
+        std::snprintf(line, sizeof(line), "%3d. %-23s %8llu %8llu %8llu %8llu %6llu %9.1f\n", ++rank, names[robot].c_str(),
+                      static_cast<unsigned long long>(played), static_cast<unsigned long long>(results.won(robot)),
+                      static_cast<unsigned long long>(results.drawn(robot)),
+                      static_cast<unsigned long long>(played - results.won(robot) - results.drawn(robot)),
+                      static_cast<unsigned long long>(results.byes(robot)), results.points(robot));
+        out << line;
+    }
+    return out.str();
+}
+
+std::string format_results_matrix(const TournamentResults& results, const std::vector<std::string>& names)
+{
+    std::ostringstream out;
+    char cell[32];
+    out << "Wins of each row against each column, out of the games they met in\n";
+    out << "                          ";
+    for (int column = 0; column < results.robots(); ++column)
+    {
+        std::snprintf(cell, sizeof(cell), " %11d", column + 1);
+        out << cell;
+    }
+    out << "\n";
+    for (int row = 0; row < results.robots(); ++row)
+    {
+        std::snprintf(cell, sizeof(cell), "%3d. ", row + 1);
+        out << cell;
+        std::string name = names[row].substr(0, 20);
+        out << name << std::string(21 - name.size(), ' ');
+        for (int column = 0; column < results.robots(); ++column)
+        {
+            if (row == column || results.met(row, column) == 0)
+                std::snprintf(cell, sizeof(cell), " %11s", "-");
+            else
+                std::snprintf(cell, sizeof(cell), " %11s",
+                              (std::to_string(results.wins(row, column)) + "/" +
+                               std::to_string(results.met(row, column))).c_str());
+            out << cell;
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+bool write_results_csv(const std::string& path, const TournamentResults& results,
+                       const std::vector<std::string>& names)
+{
+    std::ofstream out(path);
+    out << "robot,opponent,games,wins,losses,draws\n";
+    for (int robot = 0; robot < results.robots(); ++robot)
+    {
+        for (int other = 0; other < results.robots(); ++other)
+        {
+            if (robot == other || results.met(robot, other) == 0)
+                continue;
+            out << names[robot] << "," << names[other] << "," << results.met(robot, other) << ","
+                << results.wins(robot, other) << "," << results.wins(other, robot) << ","
+                << results.draws(robot, other) << "\n";
+        }
+    }
+    if (!out.flush())
+    {
+        std::cerr << "Failed to write tournament results: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static uint64_t range_begin(uint64_t bounds) { return bounds >> 32; }
+static uint64_t range_end(uint64_t bounds) { return bounds & 0xffffffffu; }
+static uint64_t make_range(uint64_t begin, uint64_t end) { return begin << 32 | end; }
+
+GameQueue::GameQueue(int workers)
+    : m_workers(std::max(1, workers)), m_ranges(new Range[std::max(1, workers)])
+{
+    reset(0);
+}
+
+bool GameQueue::reset(uint64_t count)
+{
+    bool fits = count <= max_games;
+    if (!fits)
+    {
+        std::cerr << "Can't hand out " << count << " games at once, the most is " << max_games << std::endl;
+        count = 0;
+    }
+    for (int i = 0; i < m_workers; ++i)
+    {
+        m_ranges[i].bounds.store(make_range(count * i / m_workers, count * (i + 1) / m_workers),
+                                 std::memory_order_relaxed);
+    }
+    return fits;
+}
+
+bool GameQueue::next(int worker, uint64_t& game)
+{
+    std::atomic<uint64_t>& own = m_ranges[worker].bounds;
+    uint64_t bounds = own.load(std::memory_order_acquire);
+    while (range_begin(bounds) < range_end(bounds))
+    {
+        if (own.compare_exchange_weak(bounds, make_range(range_begin(bounds) + 1, range_end(bounds)),
+                                      std::memory_order_acq_rel))
+        {
+            game = range_begin(bounds);
+            return true;
+        }
+    }
+
+    // ours is empty: half of whoever has the most left, from the back
+    for (;;)
+    {
+        int victim = -1;
+        uint64_t victim_bounds = 0, most = 0;
+        for (int i = 0; i < m_workers; ++i)
+        {
+            uint64_t theirs = m_ranges[i].bounds.load(std::memory_order_acquire);
+            if (i != worker && range_end(theirs) > range_begin(theirs) &&
+                range_end(theirs) - range_begin(theirs) > most)
+            {
+                victim = i;
+                victim_bounds = theirs;
+                most = range_end(theirs) - range_begin(theirs);
+            }
+        }
+        if (victim < 0)
+        {
+            return false;
+        }
+
+        uint64_t end = range_end(victim_bounds);
+        uint64_t split = end - (most + 1) / 2;
+        if (m_ranges[victim].bounds.compare_exchange_strong(victim_bounds, make_range(range_begin(victim_bounds), split),
+                                                            std::memory_order_acq_rel))
+        {
+            // nobody steals from an empty range, so ours is safe to set
+            own.store(make_range(split + 1, end), std::memory_order_release);
+            game = split;
+            return true;
+        }
+    }
+}
+
+Tournament::Tournament(const TournamentOptions& options, int robots, const std::vector<uint64_t>& map_seeds)
+    : m_options(options), m_robots(robots), m_map_seeds(map_seeds), m_round(0), m_group_size(0), m_next_number(0),
+      m_results(robots)
+{
+    m_options.jobs = std::max(1, m_options.jobs);
+    m_options.repeats = std::max(1, m_options.repeats);
+    m_options.players = std::clamp(m_options.players, 1, std::max(1, robots));
+    if (m_options.maps.empty())
+    {
+        m_options.maps.push_back("RobotWarz.cfg");
+    }
+    m_map_seeds.resize(m_options.maps.size(), 0);
+}
+
+void Tournament::run(const PlayGame& play)
+{
+    if (m_options.format == TournamentFormat::Swiss)
+    {
+        int rounds = m_options.rounds;
+        if (rounds <= 0)
+        {
+            // enough for one robot to be left unbeaten, log2 of the robots
+            rounds = 1;
+            while ((1 << rounds) < m_robots)
+            {
+                ++rounds;
+            }
+        }
+        std::vector<int> sitting_out;
+        for (int round = 0; round < rounds; ++round)
+        {
+            plan_swiss_round(sitting_out);
+            for (int robot : sitting_out)
+            {
+                m_results.add_bye(robot);
+            }
+            play_round(play);
+        }
+        return;
+    }
+
+    if (m_options.format == TournamentFormat::FreeForAll)
+    {
+        m_group_size = m_robots;
+        m_groups.clear();
+        for (int robot = 0; robot < m_robots; ++robot)
+        {
+            m_groups.push_back(robot);
+        }
+    }
+    else
+    {
+        plan_round_robin();
+    }
+    play_round(play);
+}
+
+void Tournament::plan_round_robin()
+{
+    // every combination of players robots, in order
+    int k = m_options.players;
+    m_group_size = k;
+    m_groups.clear();
+    std::vector<int> group(k);
+    for (int i = 0; i < k; ++i)
+    {
+        group[i] = i;
+    }
+    while (k <= m_robots)
+    {
+        m_groups.insert(m_groups.end(), group.begin(), group.end());
+        int i = k - 1;
+        while (i >= 0 && group[i] == m_robots - k + i)
+        {
+            --i;
+        }
+        if (i < 0)
+            break;
+        ++group[i];
+        for (int j = i + 1; j < k; ++j)
+        {
+            group[j] = group[j - 1] + 1;
+        }
+    }
+}
+
+void Tournament::plan_swiss_round(std::vector<int>& sitting_out)
+{
+    int k = m_options.players;
+    m_group_size = k;
+    m_groups.clear();
+    sitting_out.clear();
+
+    // whoever is left over sits out: the lowest in the standings that has sat
+    // out the fewest times
+    std::vector<int> order = m_results.standings();
+    int extra = k > 0 ? m_robots % k : 0;
+    while (extra-- > 0)
+    {
+        std::size_t pick = order.size() - 1;
+        for (std::size_t i = order.size(); i-- > 0;)
+        {
+            if (m_results.byes(order[i]) < m_results.byes(order[pick]))
+                pick = i;
+        }
+        sitting_out.push_back(order[pick]);
+        order.erase(order.begin() + pick);
+    }
+
+    if (k != 2)
+    {
+        m_groups = order;
+        return;
+    }
+
+    // top down, each with the next robot it hasn't met yet if there is one
+    std::vector<bool> paired(order.size(), false);
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        if (paired[i])
+            continue;
+        std::size_t partner = order.size();
+        for (std::size_t j = i + 1; j < order.size(); ++j)
+        {
+            if (paired[j])
+                continue;
+            if (partner == order.size())
+                partner = j;
+            if (m_results.met(order[i], order[j]) == 0)
+            {
+                partner = j;
+                break;
+            }
+        }
+        if (partner == order.size())
+            break;
+        paired[i] = paired[partner] = true;
+        m_groups.push_back(order[i]);
+        m_groups.push_back(order[partner]);
+    }
+}
+
+void Tournament::play_round(const PlayGame& play)
+{
+    if (m_group_size <= 0 || m_groups.empty())
+    {
+        return;
+    }
+    const uint64_t groups = m_groups.size() / m_group_size;
+    const uint64_t maps = m_options.maps.size();
+    const uint64_t repeats = m_options.repeats;
+    const uint64_t count = groups * maps * repeats;
+    const int jobs = m_options.jobs;
+    const uint64_t round_seed = static_cast<uint64_t>(m_round) * repeats;
+
+    // the queue takes 2^32 games at a time, so a bigger round goes in pieces
+    GameQueue queue(jobs);
+    std::vector<TournamentResults> results(jobs, TournamentResults(m_robots));
+    uint64_t first = 0;
+    auto worker = [&](int index) {
+        uint64_t n;
+        while (queue.next(index, n))
+        {
+            n += first;
+            TournamentGame game;
+            game.number = m_next_number + n;
+            game.repeat = static_cast<int>(n % repeats);
+            game.map = static_cast<int>(n / repeats % maps);
+            game.seed = m_map_seeds[game.map] + round_seed + game.repeat;
+            game.players = &m_groups[n / repeats / maps * m_group_size];
+            game.player_count = m_group_size;
+            results[index].add(game, play(game, index));
+        }
+    };
+
+    for (; first < count; first += GameQueue::max_games)
+    {
+        queue.reset(std::min(count - first, GameQueue::max_games));
+        std::vector<std::thread> threads;
+        for (int i = 1; i < jobs; ++i)
+        {
+            threads.emplace_back(worker, i);
+        }
+        worker(0);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    for (const TournamentResults& worker_results : results)
+    {
+        m_results.merge(worker_results);
+    }
+    m_next_number += count;
+    ++m_round;
+}
+
+bool run_tournament(const TournamentOptions& options, const std::vector<RobotEntry>& entries)
+{
+    int count = static_cast<int>(entries.size());
+    if (options.format != TournamentFormat::FreeForAll && (options.players < 2 || options.players > count))
+    {
+        std::cerr << "A " << tournament_format_name(options.format) << " of " << options.players
+                  << " player games needs at least that many robots, there are " << count << "." << std::endl;
+        return false;
+    }
+    std::vector<std::string> maps = options.maps.empty() ? std::vector<std::string>{"RobotWarz.cfg"} : options.maps;
+
+    // in name order, so the pairings and turn orders are the same from one run
+    // to the next whatever order robots/ lists them in
+    std::vector<RobotEntry> robots = entries;
+    std::sort(robots.begin(), robots.end(),
+              [](const RobotEntry& a, const RobotEntry& b) { return a.name < b.name; });
+
+    // each map's config, read once for all its games
+    std::vector<ArenaConfig> map_settings;
+    for (const std::string& map : maps)
+    {
+        map_settings.emplace_back(map);
+    }
+
+    // the first map's ResultsFile gets the ratings
+    Arena config(map_settings[0]);
+
+    std::vector<std::string> names;
+    for (const RobotEntry& robot : robots)
+    {
+        names.push_back(robot.name);
+    }
+
+    // each map's board, rules and seed (the one it asks for, or the clock's),
+    // and its results store to take games from
+    std::vector<GameRecord> setups(maps.size());
+    std::vector<ResultsStore*> stores(maps.size(), nullptr);
+    std::vector<uint64_t> map_seeds;
+    std::vector<uint64_t> sources;
+    for (std::size_t map = 0; map < maps.size(); ++map)
+    {
+        Arena map_config(map_settings[map]);
+        map_config.describe_game(setups[map]);
+        map_seeds.push_back(map_config.get_seed());
+        if (options.reuse && !map_config.results_path().empty())
+            stores[map] = shared_results_store(map_config.results_path());
+    }
+    for (const RobotEntry& robot : robots)
+    {
+        sources.push_back(robot.source_hash ? robot.source_hash : text_hash(robot.name));
+    }
+
+    std::cout << "Tournament: " << tournament_format_name(options.format) << " of " << count << " robots";
+    if (options.format != TournamentFormat::FreeForAll)
+        std::cout << ", " << options.players << " a game";
+    std::cout << ", " << maps.size() << " map" << (maps.size() == 1 ? "" : "s") << " x " << std::max(1, options.repeats)
+              << " repeat" << (options.repeats > 1 ? "s" : "") << ", " << std::max(1, options.jobs)
+              << " threads, seeds from";
+    for (std::size_t map = 0; map < map_seeds.size(); ++map)
+        std::cout << (map ? ", " : " ") << map_seeds[map];
+    std::cout << std::endl;
+
+    TournamentOptions plan = options;
+    plan.maps = maps;
+    Tournament tournament(plan, count, map_seeds);
+    std::atomic<uint64_t> reused{0};
+
+    auto start = std::chrono::steady_clock::now();
+    tournament.run([&](const TournamentGame& game, int) {
+        GameOutcome outcome;
+
+        // the same robots on the same board under the same rules: that game is done
+        if (stores[game.map])
+        {
+            GameRecord key = setups[game.map];
+            key.seed = game.seed;
+            std::vector<uint64_t> players;
+            for (int i = 0; i < game.player_count; ++i)
+            {
+                players.push_back(sources[game.players[i]]);
+            }
+            GameRecord cached;
+            if (stores[game.map]->find_game(ResultsStore::game_key(key, players), cached) &&
+                static_cast<int>(cached.robots.size()) == game.player_count)
+            {
+                // the same winner the game had when it was played
+                outcome.winner = cached.winner;
+                outcome.rounds = cached.rounds;
+                reused.fetch_add(1, std::memory_order_relaxed);
+                return outcome;
+            }
+        }
+
+        std::vector<RobotEntry> players;
+        for (int i = 0; i < game.player_count; ++i)
+        {
+            players.push_back(robots[game.players[i]]);
+        }
+
+        Arena arena(map_settings[game.map]);
+        arena.set_quiet(true);
+        arena.set_silent(true);
+        arena.set_batch_game();
+        arena.set_seed(game.seed);
+        arena.initialize_board();
+        arena.add_robots(players);
+        arena.run_simulation();
+
+        outcome.winner = arena.game_result().winner;
+        outcome.rounds = arena.game_result().rounds;
+        return outcome;
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const TournamentResults& results = tournament.results();
+    uint64_t played = results.games() - reused.load();
+    char line[200];
+    std::snprintf(line, sizeof(line), "%llu games, %llu from the results store and %llu played in %.1fs (%.1f games/s), %.1f rounds a game\n\n",
+                  static_cast<unsigned long long>(results.games()), static_cast<unsigned long long>(reused.load()),
+                  static_cast<unsigned long long>(played), seconds, seconds > 0 ? played / seconds : 0.0,
+                  results.games() ? static_cast<double>(results.rounds()) / results.games() : 0.0);
+    std::cout << line << format_standings(results, names) << "\n" << format_results_matrix(results, names);
+
+    if (!options.results_path.empty() && write_results_csv(options.results_path, results, names))
+    {
+        std::cout << "Results written to " << options.results_path << "\n";
+    }
+    if (!config.results_path().empty())
+    {
+        if (ResultsStore* store = shared_results_store(config.results_path()))
+        {
+            store->flush();
+            std::cout << "\n" << format_ratings(*store, 20);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,200 @@
+#ifndef __TOURNAMENT_H__
+#define __TOURNAMENT_H__
+
+#include "Arena.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Ladders of games between the robots rather than one free-for-all.
+//
+//   round robin  every group of `players` robots (every pair by default) meets
+//   swiss        `rounds` rounds, each pairing robots close in the standings
+//                that haven't met yet, the lowest without one sitting out
+//   ffa          everyone in every game
+//
+// Each pairing is played on every map (a config file: board size, obstacles,
+// MaxRounds) `repeats` times. Repeat r plays with the map's seed plus r (in
+// swiss round n plus n * repeats too, so a rematch isn't the same game again),
+// so every pairing gets the same boards and any single game can be played again
+// on its own, with any number of jobs: robots' rand() is seeded per game on the
+// thread playing it (RobotRandom.h). The robots are put in name order, which is
+// also the turn order.
+//
+// That makes a game the same game from one tournament to the next, as long as
+// the config has a Seed (not the clock's). With a ResultsFile, games already
+// in the store (same robot sources, rules, seed and board, see
+// ResultsStore::game_key) are taken from it instead of played, so when one
+// robot changes only the games it is in are played again, and when the
+// engine's rules change (engine_rules_version) all of them are. It is also how
+// a killed tournament carries on: run it again and only the games that weren't
+// in the store yet (the store writes 64KB at a time) are played.
+//
+// Games are never listed up front: a game's number is decoded into its
+// pairing, map and repeat when a worker gets to it, so a million games cost a
+// small table of pairings. Workers take game numbers from ranges of their own
+// and steal half of the biggest other range when theirs runs out, since one
+// game can last a few rounds and the next MaxRounds. Results are added up per
+// worker and merged at the end.
+
+enum class TournamentFormat
+{
+    RoundRobin,
+    Swiss,
+    FreeForAll
+};
+
+// "roundrobin", "swiss" or "ffa"
+bool parse_tournament_format(const std::string& text, TournamentFormat& format);
+const char* tournament_format_name(TournamentFormat format);
+
+struct TournamentOptions
+{
+    TournamentFormat format = TournamentFormat::RoundRobin;
+    int players = 2;                // per game, round robin and swiss
+    int repeats = 1;                // games per pairing and map
+    int rounds = 0;                 // swiss, 0 for log2 of the robots rounded up
+    std::vector<std::string> maps;  // configs, RobotWarz.cfg if empty
+    int jobs = 1;
+    std::string results_path;       // the results matrix as CSV, none if empty
+    bool reuse = true;              // take games already in the ResultsFile from it
+};
+
+// one game, as a worker sees it. players are tournament robot indices.
+struct TournamentGame
+{
+    uint64_t number;
+    uint64_t seed;
+    int map;
+    int repeat;
+    const int* players;
+    int player_count;
+};
+
+struct GameOutcome
+{
+    int winner = -1; // a position in TournamentGame::players, -1 for nobody
+    int rounds = 0;
+};
+
+// who beat whom. wins(i, j) is games robot i won with robot j in them.
+class TournamentResults
+{
+public:
+
+    explicit TournamentResults(int robots = 0);
+
+    void add(const TournamentGame& game, const GameOutcome& outcome);
+    void add_bye(int robot);
+    void merge(const TournamentResults& other);
+
+    int robots() const { return m_robots; }
+    uint64_t games() const { return m_games; }
+    uint64_t rounds() const { return m_rounds; }
+
+    uint64_t played(int robot) const { return m_played[robot]; }
+    uint64_t won(int robot) const { return m_won[robot]; }
+    uint64_t drawn(int robot) const { return m_drawn[robot]; }
+    uint64_t byes(int robot) const { return m_byes[robot]; }
+    double points(int robot) const; // a win or a bye 1, a game nobody won 1/2
+
+    uint64_t met(int robot, int other) const { return m_met[robot * m_robots + other]; }
+    uint64_t wins(int robot, int other) const { return m_wins[robot * m_robots + other]; }
+    uint64_t draws(int robot, int other) const { return m_draws[robot * m_robots + other]; }
+
+    // robot indices, most points first
+    std::vector<int> standings() const;
+
+private:
+
+    int m_robots;
+    uint64_t m_games;
+    uint64_t m_rounds;
+    std::vector<uint64_t> m_played, m_won, m_drawn, m_byes;
+    std::vector<uint64_t> m_met, m_wins, m_draws;
+};
+
+std::string format_standings(const TournamentResults& results, const std::vector<std::string>& names);
+
+// wins of each row against each column, out of the games they met in
+std::string format_results_matrix(const TournamentResults& results, const std::vector<std::string>& names);
+
+// robot,opponent,games,wins,losses,draws for every pair that met
+bool write_results_csv(const std::string& path, const TournamentResults& results,
+                       const std::vector<std::string>& names);
+
+// game numbers [0, count) shared out between workers, who take from the front
+// of their own range and steal from the back of others'. a range is one 64 bit
+// word, begin and end 32 bits each, so taking a game is one compare and swap
+// on a cache line nobody else is usually touching.
+class GameQueue
+{
+public:
+
+    static constexpr uint64_t max_games = 0xffffffffu;
+
+    explicit GameQueue(int workers);
+
+    // up to max_games at a time. false, with nothing to hand out and why on
+    // stderr, for more.
+    bool reset(uint64_t count);
+
+    // false when there is nothing left anywhere
+    bool next(int worker, uint64_t& game);
+
+private:
+
+    struct alignas(64) Range
+    {
+        std::atomic<uint64_t> bounds;
+    };
+
+    int m_workers;
+    std::unique_ptr<Range[]> m_ranges;
+};
+
+class Tournament
+{
+public:
+
+    using PlayGame = std::function<GameOutcome(const TournamentGame& game, int worker)>;
+
+    // map_seeds: each map's seed, one for every one in options.maps
+    Tournament(const TournamentOptions& options, int robots, const std::vector<uint64_t>& map_seeds);
+
+    // every game, on options.jobs threads. play is called from all of them.
+    void run(const PlayGame& play);
+
+    const TournamentResults& results() const { return m_results; }
+
+    // games handed out so far
+    uint64_t games_played() const { return m_next_number; }
+
+private:
+
+    void plan_round_robin();
+    void plan_swiss_round(std::vector<int>& sitting_out);
+    void play_round(const PlayGame& play);
+
+    TournamentOptions m_options;
+    int m_robots;
+    std::vector<uint64_t> m_map_seeds;
+    int m_round; // swiss rounds played so far
+
+    // the pairings of the round being played, player_count robots each
+    std::vector<int> m_groups;
+    int m_group_size;
+    uint64_t m_next_number;
+
+    TournamentResults m_results;
+};
+
+// plays the tournament with the robots in Arena games, or takes the games from
+// the results store, prints the standings and the matrix, and the ratings if
+// the first map has a ResultsFile. false if it can't be played.
+bool run_tournament(const TournamentOptions& options, const std::vector<RobotEntry>& entries);
+
+#endif
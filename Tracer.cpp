@@ -0,0 +1,177 @@
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+std::atomic<bool> Tracer::s_recording{false};
+
+static thread_local std::string t_thread_name;
+
+TraceBuffer::TraceBuffer(std::size_t capacity, int thread_id)
+    : m_mask(capacity - 1), m_written(0), m_thread_id(thread_id)
+{
+    m_events.resize(capacity);
+}
+
+std::vector<TraceEvent> TraceBuffer::events() const
+{
+    uint64_t written = m_written.load(std::memory_order_acquire);
+    uint64_t first = written > m_events.size() ? written - m_events.size() : 0;
+
+    std::vector<TraceEvent> out;
+    out.reserve(static_cast<std::size_t>(written - first));
+    for (uint64_t i = first; i < written; ++i)
+    {
+        out.push_back(m_events[i & m_mask]);
+    }
+    return out;
+}
+
+uint64_t TraceBuffer::dropped() const
+{
+    uint64_t written = m_written.load(std::memory_order_acquire);
+    return written > m_events.size() ? written - m_events.size() : 0;
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+uint64_t Tracer::now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::start(std::size_t events_per_thread, int sample_every)
+{
+    std::size_t capacity = 1;
+    while (capacity < events_per_thread)
+        capacity <<= 1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    m_sample_every = sample_every > 0 ? sample_every : 1;
+    m_buffers.clear();
+    ++m_generation;
+    m_enabled = true;
+}
+
+void Tracer::stop()
+{
+    m_enabled = false;
+    s_recording.store(false, std::memory_order_relaxed);
+}
+
+// each thread finds its own buffer through a thread_local, and only takes the
+// lock the first time (or after start() threw the old buffers away)
+TraceBuffer& Tracer::buffer()
+{
+    thread_local std::shared_ptr<TraceBuffer> mine;
+    thread_local uint64_t generation = 0;
+
+    if (!mine || generation != m_generation.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        mine = std::make_shared<TraceBuffer>(m_capacity, m_next_thread_id++);
+        mine->thread_name = t_thread_name.empty() ? "thread " + std::to_string(mine->thread_id()) : t_thread_name;
+        generation = m_generation;
+        m_buffers.push_back(mine);
+    }
+    return *mine;
+}
+
+void Tracer::record(const TraceEvent& event)
+{
+    buffer().push(event);
+}
+
+// the name shows up in the trace viewer; the buffer itself is made on the
+// thread's first span
+void Tracer::name_thread(const std::string& name)
+{
+    t_thread_name = name;
+}
+
+std::size_t Tracer::event_count() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t total = 0;
+    for (const auto& buffer : m_buffers)
+    {
+        total += buffer->events().size();
+    }
+    return total;
+}
+
+static void write_json_string(std::ostream& out, const char* text)
+{
+    out << '"';
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            out << '\\' << *c;
+        else if (static_cast<unsigned char>(*c) < 0x20)
+            out << ' ';
+        else
+            out << *c;
+    }
+    out << '"';
+}
+
+// the Trace Event Format: complete ("X") events, times in microseconds
+bool Tracer::write_json(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t origin = UINT64_MAX;
+    for (const auto& buffer : m_buffers)
+    {
+        for (const TraceEvent& event : buffer->events())
+            origin = std::min(origin, event.start_ns);
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    char number[64];
+    for (const auto& buffer : m_buffers)
+    {
+        out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+            << buffer->thread_id() << ",\"args\":{\"name\":";
+        write_json_string(out, buffer->thread_name.c_str());
+        out << "}}";
+        first = false;
+
+        for (const TraceEvent& event : buffer->events())
+        {
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id() << ",\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"cat\":";
+            write_json_string(out, event.category);
+            std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f",
+                          (event.start_ns - origin) / 1000.0, event.duration_ns / 1000.0);
+            out << number;
+            if (event.arg >= 0)
+                out << ",\"args\":{\"n\":" << event.arg << "}";
+            out << "}";
+        }
+        if (buffer->dropped() > 0)
+        {
+            std::cerr << "Trace: " << buffer->thread_name << " dropped its " << buffer->dropped()
+                      << " oldest spans, raise TraceBufferEvents to keep them" << std::endl;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,142 @@
+#ifndef __TRACER_H__
+#define __TRACER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timings of a game as a Chrome trace (chrome://tracing or ui.perfetto.dev):
+// a span for every round, every robot turn, every call into robot code and the
+// engine's radar, shot, move and board printing work.
+//
+// Each thread records into its own ring buffer. Only that thread writes to it,
+// so recording a span is two clock reads and a store, no locks. When a buffer
+// is full the oldest spans go. write_json() is called once the game is over.
+//
+// Sampling: only every Nth round is recorded, which keeps the cost down on long
+// games. Building with ROBOTWARZ_NO_TRACE (make TRACE=0) compiles every
+// TRACE_SCOPE out altogether.
+
+struct TraceEvent
+{
+    const char* name;       // must outlive the tracer: literals, or names of live robots
+    const char* category;
+    int64_t arg;            // shown as "n" in the trace, -1 for none
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+class TraceBuffer
+{
+public:
+
+    TraceBuffer(std::size_t capacity, int thread_id);
+
+    // only ever called by the thread that owns the buffer
+    void push(const TraceEvent& event)
+    {
+        uint64_t index = m_written.load(std::memory_order_relaxed);
+        m_events[index & m_mask] = event;
+        m_written.store(index + 1, std::memory_order_release);
+    }
+
+    int thread_id() const { return m_thread_id; }
+    std::string thread_name;
+
+    // the events still in the ring, oldest first
+    std::vector<TraceEvent> events() const;
+    uint64_t dropped() const;
+
+private:
+    std::vector<TraceEvent> m_events;
+    uint64_t m_mask;
+    std::atomic<uint64_t> m_written;
+    int m_thread_id;
+};
+
+class Tracer
+{
+public:
+
+    static Tracer& instance();
+
+    // events_per_thread is rounded up to a power of two
+    void start(std::size_t events_per_thread, int sample_every);
+    void stop();
+    bool enabled() const { return m_enabled; }
+
+    // called by the game at the top of every round: sampled rounds are recorded
+    void begin_round(int round)
+    {
+        s_recording.store(m_enabled && round % m_sample_every == 0, std::memory_order_relaxed);
+    }
+
+    static bool recording() { return s_recording.load(std::memory_order_relaxed); }
+    static uint64_t now_ns();
+
+    void record(const TraceEvent& event);
+    void name_thread(const std::string& name);
+
+    bool write_json(const std::string& path) const;
+    std::size_t event_count() const;
+
+private:
+
+    Tracer() : m_enabled(false), m_sample_every(1), m_capacity(1 << 16), m_next_thread_id(1) {}
+    TraceBuffer& buffer();
+
+    static std::atomic<bool> s_recording;
+
+    bool m_enabled;
+    int m_sample_every;
+    std::size_t m_capacity;
+    int m_next_thread_id;
+    std::atomic<uint64_t> m_generation{0}; // start() drops the buffers of the last run
+
+    mutable std::mutex m_mutex; // only for the buffer list, never while recording
+    std::vector<std::shared_ptr<TraceBuffer>> m_buffers;
+};
+
+// times the enclosing scope, if this round is being recorded
+class TraceScope
+{
+public:
+
+    TraceScope(const char* name, const char* category, int64_t arg = -1)
+        : m_name(name), m_category(category), m_arg(arg), m_start(Tracer::recording() ? Tracer::now_ns() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_start != 0)
+        {
+            Tracer::instance().record({m_name, m_category, m_arg, m_start, Tracer::now_ns() - m_start});
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_category;
+    int64_t m_arg;
+    uint64_t m_start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef ROBOTWARZ_NO_TRACE
+#define TRACE_SCOPE(...) ((void)0)
+#define TRACE_ROUND(round) ((void)0)
+#else
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+#define TRACE_ROUND(round) Tracer::instance().begin_round(round)
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#include "Zobrist.h"
+#include "Snapshot.h"
+
+// splitmix64's finaliser: every input bit flips about half the output bits
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t zobrist_cell_key(std::size_t cell, char value)
+{
+    // an empty cell is 0, so only the occupied cells of a big board cost anything
+    if (value == '.')
+        return 0;
+    return mix(static_cast<uint64_t>(cell) << 8 | static_cast<unsigned char>(value));
+}
+
+uint64_t zobrist_robot_key(std::size_t robot, const RobotState& state)
+{
+    return mix(pack_robot_state(state) ^ mix(0x5a0b7157ULL + robot));
+}
+
+uint64_t zobrist_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots)
+{
+    uint64_t hash = 0;
+    std::size_t cell = 0;
+    for (const auto& row : board)
+    {
+        for (char value : row)
+        {
+            hash ^= zobrist_cell_key(cell++, value);
+        }
+    }
+    for (std::size_t i = 0; i < robots.size(); ++i)
+    {
+        hash ^= zobrist_robot_key(i, read_robot_state(robots[i]));
+    }
+    return hash;
+}
+
+int RepetitionTable::record(uint64_t hash)
+{
+    if (static_cast<int>(m_order.size()) >= m_window && !m_order.empty())
+    {
+        auto oldest = m_counts.find(m_order.front());
+        if (--oldest->second == 0)
+            m_counts.erase(oldest);
+        m_order.pop_front();
+    }
+    m_order.push_back(hash);
+    return ++m_counts[hash];
+}
+
+void RepetitionTable::clear()
+{
+    m_order.clear();
+    m_counts.clear();
+}
@@ -0,0 +1,52 @@
+#ifndef __ZOBRIST_H__
+#define __ZOBRIST_H__
+
+#include "RobotBase.h"
+#include "Replay.h"
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// Zobrist hashing of the game state: the board and every robot's engine state.
+// The hash is the XOR of one key per cell (for what is in it) and one key per
+// robot (for its health, armor, moves, grenades and position), so a change only
+// has to XOR the old key out and the new one in. Arena keeps it up to date in
+// set_cell(), handle_move(), on damage and when a grenade is thrown.
+//
+// The keys are worked out from the cell or robot with a mixing function rather
+// than looked up in a table, so a 1000x1000 board doesn't need 8 MB of keys per
+// possible cell value.
+//
+// The robots' own memory and the random numbers are not in the hash. Two equal
+// hashes mean the arena looks the same, not that the robots will do the same
+// thing next; that is what the repetition limit is for.
+
+uint64_t zobrist_cell_key(std::size_t cell, char value);
+uint64_t zobrist_robot_key(std::size_t robot, const RobotState& state);
+
+// from scratch, to start the incremental hash and to check it
+uint64_t zobrist_hash(const std::vector<std::vector<char>>& board, const std::vector<RobotBase*>& robots);
+
+// How often each state came up in the last `window` rounds.
+class RepetitionTable
+{
+public:
+
+    explicit RepetitionTable(int window = 1000) : m_window(window) {}
+
+    void set_window(int window) { m_window = window; clear(); }
+
+    // remember hash for this round, returns how many times it is in the window now
+    int record(uint64_t hash);
+    void clear();
+
+    std::size_t size() const { return m_order.size(); }
+
+private:
+    int m_window;
+    std::deque<uint64_t> m_order;               // oldest first
+    std::unordered_map<uint64_t, int> m_counts;
+};
+
+#endif
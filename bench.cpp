@@ -0,0 +1,232 @@
+#include "Arena.h"
+#include "BenchHistory.h"
+#include "PerfCounters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times the engine on recorded games. Replays stand in for the robots, so what
+// is measured is the engine alone and every run plays exactly the same turns.
+//
+//     bench [--runs N] [--counters] [--json FILE] [replay ...]
+//
+// With no replays it plays the golden games. --counters adds hardware counters
+// (cycles, instructions, cache and branch misses) per engine phase, see
+// PerfCounters.h. They cost a system call at every phase boundary, so compare
+// times from runs without them.
+//
+// --json writes the samples for bench_compare (see BenchHistory.h): per game
+// the time per round, and the time per call of each engine phase. The phases
+// are timed in runs of their own after the timed runs, so the clock reads they
+// take don't show up in the round times.
+
+#ifndef BENCH_BUILD_FLAGS
+#define BENCH_BUILD_FLAGS "unknown"
+#endif
+
+// the first line a command prints, empty if it fails
+static std::string command_output(const char* command)
+{
+    std::string output;
+    if (FILE* pipe = popen(command, "r"))
+    {
+        char line[256];
+        if (std::fgets(line, sizeof(line), pipe))
+            output = line;
+        pclose(pipe);
+    }
+    while (!output.empty() && (output.back() == '\n' || output.back() == '\r'))
+        output.pop_back();
+    return output;
+}
+
+static void describe_build(BenchRun& run)
+{
+    run.revision = command_output("git rev-parse --short HEAD 2>/dev/null");
+    if (run.revision.empty())
+        run.revision = "unknown";
+    run.dirty = !command_output("git status --porcelain --untracked-files=no 2>/dev/null").empty();
+#if defined(__clang__)
+    run.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    run.compiler = "g++ " __VERSION__;
+#else
+    run.compiler = "unknown";
+#endif
+    run.flags = BENCH_BUILD_FLAGS;
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    run.date = date;
+}
+
+static const char* phase_metric(EnginePhase phase)
+{
+    switch (phase)
+    {
+        case EnginePhase::Radar:  return "radar_ns";
+        case EnginePhase::Weapon: return "weapon_ns";
+        case EnginePhase::Move:   return "move_ns";
+        case EnginePhase::Render: return "render_ns";
+        default:                  return "?";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int runs = 5;
+    bool counters = false;
+    std::string json_path;
+    std::vector<std::string> replays;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--counters")
+            counters = true;
+        else if (arg == "--json" && i + 1 < argc)
+            json_path = argv[++i];
+        else if (arg.rfind("--", 0) == 0)
+        {
+            std::cerr << "Usage: " << argv[0] << " [--runs N] [--counters] [--json FILE] [replay ...]\n";
+            return 1;
+        }
+        else
+            replays.push_back(arg);
+    }
+
+    if (replays.empty())
+    {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator("golden", error))
+        {
+            if (entry.path().extension() == ".replay")
+                replays.push_back(entry.path().string());
+        }
+        std::sort(replays.begin(), replays.end());
+        if (replays.empty())
+        {
+            std::cerr << "No replays given and none in golden/\n";
+            return 1;
+        }
+    }
+
+    PerfCounters perf;
+    if (counters && !perf.open())
+    {
+        std::cout << "No hardware counters, timing phases on the wall clock only: " << perf.error() << "\n";
+    }
+
+    PhaseProfile total;
+    total.counters = perf.any() ? &perf : nullptr;
+
+    BenchRun record;
+    describe_build(record);
+    record.runs = runs;
+
+    for (const std::string& path : replays)
+    {
+        std::vector<double> seconds;
+        int rounds = 1;
+        PhaseProfile profile;
+        profile.counters = total.counters;
+
+        // run 0 warms up and fills in the phase profile, the others are timed
+        for (int run = 0; run <= runs; ++run)
+        {
+            Arena arena(20, 20);
+            arena.set_quiet(true);
+            arena.set_silent(true);
+            if (!arena.load_replay(path))
+            {
+                return 1;
+            }
+            if (run == 0)
+            {
+                arena.set_phase_profile(&profile);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            arena.run_simulation();
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+            if (!arena.replay_matched())
+            {
+                std::cerr << path << ": the engine no longer plays this game the same way\n";
+                return 1;
+            }
+            if (run > 0)
+            {
+                seconds.push_back(elapsed.count());
+                rounds = std::max(1, arena.game_result().rounds);
+            }
+        }
+
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds[seconds.size() / 2];
+        std::cout << path << ": median " << median * 1000 << " ms, min " << seconds.front() * 1000
+                  << " ms, max " << seconds.back() * 1000 << " ms over " << runs << " runs, "
+                  << (profile.turns ? median * 1e9 / profile.turns : 0.0) << " ns per robot turn\n";
+        if (counters)
+        {
+            std::cout << format_phase_profile(profile);
+        }
+        total.merge(profile);
+
+        if (!json_path.empty())
+        {
+            std::string game = std::filesystem::path(path).stem().string();
+            std::vector<double>& round_ns = record.metrics[game + "/round_ns"];
+            for (double run_seconds : seconds)
+            {
+                round_ns.push_back(run_seconds * 1e9 / rounds);
+            }
+
+            for (int run = 0; run < runs; ++run)
+            {
+                Arena arena(20, 20);
+                arena.set_quiet(true);
+                arena.set_silent(true);
+                arena.load_replay(path);
+                PhaseProfile phases;
+                arena.set_phase_profile(&phases);
+                arena.run_simulation();
+                for (int phase = 0; phase < engine_phase_count; ++phase)
+                {
+                    const PhaseTotals& totals = phases.phases[phase];
+                    if (totals.calls)
+                    {
+                        record.metrics[game + "/" + phase_metric(static_cast<EnginePhase>(phase))].push_back(
+                            static_cast<double>(totals.wall_ns) / totals.calls);
+                    }
+                }
+            }
+        }
+    }
+
+    if (counters && replays.size() > 1)
+    {
+        std::cout << "All games:\n" << format_phase_profile(total);
+    }
+    if (!json_path.empty())
+    {
+        std::ofstream out(json_path, std::ios::trunc);
+        if (!(out << bench_run_json(record) << "\n"))
+        {
+            std::cerr << "Failed to write " << json_path << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
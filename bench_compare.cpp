@@ -0,0 +1,106 @@
+#include "BenchHistory.h"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Holds a bench --json run up against the history of earlier runs, then adds
+// it to the history. See BenchHistory.h for how the baseline is worked out.
+//
+//     bench_compare [--history FILE] [--window N] [--threshold PCT] [--dry-run] run.json
+//
+//   --history    one run per line, bench_history.jsonl by default
+//   --window     how many earlier runs make the baseline, 10 by default
+//   --threshold  percent slower that counts as a regression, 5 by default
+//   --dry-run    compare only, leave the history alone
+//
+// Exits 1 if any metric got slower, 2 if something went wrong.
+int main(int argc, char* argv[])
+{
+    std::string history_path = "bench_history.jsonl";
+    std::string run_path;
+    int window = 10;
+    double threshold = 5;
+    bool dry_run = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        try
+        {
+            if (arg == "--history" && i + 1 < argc)
+                history_path = argv[++i];
+            else if (arg == "--window" && i + 1 < argc)
+                window = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--threshold" && i + 1 < argc)
+                threshold = std::stod(argv[++i]);
+            else if (arg == "--dry-run")
+                dry_run = true;
+            else if (arg.rfind("--", 0) != 0 && run_path.empty())
+                run_path = arg;
+            else
+            {
+                run_path.clear();
+                break;
+            }
+        }
+        catch (const std::exception&)
+        {
+            // stoi and stod throw on text that isn't a number, or one out of range
+            std::cerr << arg << " needs a number, not " << argv[i] << "\n";
+            return 2;
+        }
+    }
+    if (run_path.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--history FILE] [--window N] [--threshold PCT] [--dry-run] run.json\n";
+        return 2;
+    }
+
+    std::ifstream in(run_path);
+    if (!in)
+    {
+        std::cerr << "Failed to open " << run_path << "\n";
+        return 2;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    BenchRun run;
+    std::string error;
+    if (!parse_bench_run(text.str(), run, error))
+    {
+        std::cerr << run_path << ": " << error << "\n";
+        return 2;
+    }
+
+    std::vector<BenchRun> history;
+    if (!load_bench_history(history_path, history))
+    {
+        return 2;
+    }
+
+    std::vector<BenchComparison> comparisons = compare_bench_run(history, run, window, threshold / 100);
+    std::cout << "Revision " << run.revision << (run.dirty ? " (with changes)" : "") << ", " << run.compiler << "\n";
+    std::cout << format_bench_comparison(comparisons);
+
+    int regressions = 0;
+    for (const BenchComparison& comparison : comparisons)
+    {
+        regressions += comparison.regressed ? 1 : 0;
+    }
+    if (regressions)
+    {
+        std::cout << regressions << " of " << comparisons.size() << " metrics are more than " << threshold
+                  << "% slower than the last runs.\n";
+    }
+
+    if (!dry_run && !append_bench_history(history_path, run))
+    {
+        return 2;
+    }
+    return regressions ? 1 : 0;
+}
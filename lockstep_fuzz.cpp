@@ -0,0 +1,32 @@
+#include "Lockstep.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Plays random games on Arena and ReferenceArena in lockstep and stops at the
+// first one where they disagree.
+//
+//     lockstep_fuzz [games] [first seed] [max rounds]
+int main(int argc, char* argv[])
+{
+    int games = argc > 1 ? std::stoi(argv[1]) : 1000;
+    uint64_t first_seed = argc > 2 ? std::stoull(argv[2]) : 1;
+    int max_rounds = argc > 3 ? std::stoi(argv[3]) : 300;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < games; ++game)
+    {
+        std::string report;
+        if (!run_lockstep_fuzz_game(first_seed + game, max_rounds, report))
+        {
+            std::cout << report;
+            std::cout << "Rerun with: lockstep_fuzz 1 " << first_seed + game << " " << max_rounds << "\n";
+            return 1;
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    std::cout << games << " games (seeds " << first_seed << " - " << first_seed + games - 1
+              << ") played the same on both engines in " << elapsed.count() << " s\n";
+    return 0;
+}
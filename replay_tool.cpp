@@ -0,0 +1,253 @@
+#include "Replay.h"
+#include "BoardRenderer.h"
+#include "RobotBase.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Looks at binary replays written with ReplayFile = <path> in RobotWarz.cfg.
+//
+//     replay_tool info <replay>                  what is in the file
+//     replay_tool seek <replay> <round>          print the board at the start of a round
+//     replay_tool log  <replay> [log file]       regenerate the text log
+
+// stands in for a robot so the board renderer can show where it is
+class ReplayViewRobot : public RobotBase
+{
+public:
+    ReplayViewRobot(const ReplayRobotInfo& info) : RobotBase(2, 5, info.weapon)
+    {
+        m_name = info.name;
+    }
+
+    void sync(const RobotState& state)
+    {
+        move_to(state.row, state.col);
+        if (state.health < get_health())
+            take_damage(get_health() - state.health);
+    }
+
+    void get_radar_direction(int& radar_direction) override { radar_direction = 0; }
+    void process_radar_results(const std::vector<RadarObj>& radar_results) override { (void)radar_results; }
+    bool get_shot_location(int& shot_row, int& shot_col) override { shot_row = shot_col = 0; return false; }
+    void get_move_direction(int& direction, int& distance) override { direction = distance = 0; }
+};
+
+static const char* weapon_name(WeaponType weapon)
+{
+    switch (weapon)
+    {
+        case flamethrower: return "flamethrower";
+        case railgun:      return "railgun";
+        case grenade:      return "grenade";
+        case hammer:       return "hammer";
+        default:           return "unknown";
+    }
+}
+
+static const char* weapon_action(WeaponType weapon)
+{
+    switch (weapon)
+    {
+        case flamethrower: return " firing flamethrower... ";
+        case railgun:      return " shooting railgun... ";
+        case grenade:      return " launching grenade... ";
+        case hammer:       return " pounding with the hammer...";
+        default:           return "strange weapon? ";
+    }
+}
+
+struct ReplayView
+{
+    std::vector<std::unique_ptr<ReplayViewRobot>> robots;
+    std::vector<RobotBase*> robot_list;
+    std::string tags;
+
+    explicit ReplayView(const ReplayReader& reader)
+    {
+        for (const ReplayRobotInfo& info : reader.roster())
+        {
+            robots.push_back(std::make_unique<ReplayViewRobot>(info));
+            robot_list.push_back(robots.back().get());
+            tags += info.tag;
+        }
+    }
+
+    void sync(const ReplayFrame& frame)
+    {
+        for (std::size_t i = 0; i < robots.size() && i < frame.robots.size(); ++i)
+            robots[i]->sync(frame.robots[i]);
+    }
+};
+
+static int show_info(const ReplayReader& reader)
+{
+    std::cout << "arena:     " << reader.rows() << " x " << reader.cols() << "\n";
+    std::cout << "seed:      " << reader.seed() << "\n";
+    std::cout << "rounds:    " << reader.rounds() << "\n";
+    std::cout << "keyframes: every " << reader.keyframe_every() << " rounds\n";
+    std::cout << "size:      " << reader.file_size() << " bytes\n";
+    std::cout << "robots:\n";
+    for (std::size_t i = 0; i < reader.roster().size(); ++i)
+    {
+        const ReplayRobotInfo& info = reader.roster()[i];
+        std::cout << "  " << info.tag << " " << info.name << " (" << weapon_name(info.weapon) << ")"
+                  << (static_cast<int>(i) == reader.winner() ? "  winner" : "") << "\n";
+    }
+    return 0;
+}
+
+static int show_round(const ReplayReader& reader, int round)
+{
+    ReplayFrame frame;
+    auto start = std::chrono::steady_clock::now();
+    if (!reader.seek(round, frame))
+    {
+        std::cerr << "Round " << round << " is not in the replay (0 - " << reader.rounds() << ")\n";
+        return 1;
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    ReplayView view(reader);
+    view.sync(frame);
+    BoardRenderer renderer;
+    std::cout << renderer.render(round, frame.board, view.robot_list, view.tags.c_str());
+    std::cout << "(seek took " << elapsed.count() << " ms)\n";
+    return 0;
+}
+
+// The classic log, rebuilt from the replay. Board frames are identical. The turn
+// lines carry the same facts (stats, radar, shot or move, damage) though the flavour
+// text of collisions and misses isn't stored, so it is not repeated word for word.
+static int write_log(const ReplayReader& reader, std::ostream& out)
+{
+    ReplayFrame frame;
+    if (!reader.seek(0, frame))
+    {
+        std::cerr << "Replay has no rounds\n";
+        return 1;
+    }
+
+    ReplayView view(reader);
+    BoardRenderer renderer;
+    std::vector<ReplayTurn> turns;
+    const auto& roster = reader.roster();
+
+    out << "Game seed: " << reader.seed() << "\n";
+
+    while (frame.round < reader.rounds())
+    {
+        view.sync(frame);
+        out << renderer.render(frame.round, frame.board, view.robot_list, view.tags.c_str());
+
+        // stats are printed as they were when each robot's turn started
+        std::vector<RobotState> states = frame.robots;
+        if (!reader.next_round(frame, &turns))
+        {
+            std::cerr << "Replay is damaged at round " << frame.round << "\n";
+            return 1;
+        }
+
+        for (const ReplayTurn& turn : turns)
+        {
+            const ReplayRobotInfo& info = roster[turn.robot];
+            const RobotState& state = states[turn.robot];
+
+            if (turn.action == ReplayAction::Out)
+            {
+                out << info.name << " " << info.tag << " is out.\n";
+                continue;
+            }
+
+            out << info.tag << info.name << ":   H: " << state.health << "  W: " << weapon_name(info.weapon)
+                << "  A: " << state.armor << "  M: " << state.move
+                << "  at: (" << state.row << "," << state.col << ") ";
+            out << "  checking radar, direction: " << turn.radar_direction << " ... ";
+            if (turn.radar_hits == 0)
+                out << " found nothing. ";
+            else
+                out << " found '" << turn.first_hit.m_type << "' at (" << turn.first_hit.m_row
+                    << "," << turn.first_hit.m_col << ") ";
+
+            if (turn.action == ReplayAction::Shot)
+            {
+                out << "Shooting: " << weapon_action(info.weapon);
+            }
+            else
+            {
+                out << "Moving: ";
+            }
+
+            for (const auto& [index, after] : turn.robots)
+            {
+                const RobotState& before = states[index];
+                if (after.health < before.health)
+                {
+                    out << roster[index].name << " takes " << (before.health - after.health)
+                        << " damage. Health: " << after.health << "\n";
+                }
+                if (index == turn.robot && (after.row != before.row || after.col != before.col))
+                {
+                    out << info.name << " moves to (" << after.row << "," << after.col << ") ";
+                }
+                states[index] = after;
+            }
+            out << "\n";
+        }
+    }
+
+    for (std::size_t i = 0; i < roster.size(); ++i)
+    {
+        if (static_cast<int>(i) == reader.winner())
+            out << roster[i].name << " is the winner.\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " info <replay>\n"
+                  << "       " << argv[0] << " seek <replay> <round>\n"
+                  << "       " << argv[0] << " log <replay> [log file]\n";
+        return 1;
+    }
+
+    std::string command = argv[1];
+    ReplayReader reader;
+    if (!reader.open(argv[2]))
+    {
+        return 1;
+    }
+
+    if (command == "info")
+    {
+        return show_info(reader);
+    }
+    if (command == "seek" && argc >= 4)
+    {
+        return show_round(reader, std::stoi(argv[3]));
+    }
+    if (command == "log")
+    {
+        if (argc >= 4)
+        {
+            std::ofstream out(argv[3]);
+            if (!out)
+            {
+                std::cerr << "Failed to open " << argv[3] << "\n";
+                return 1;
+            }
+            return write_log(reader, out);
+        }
+        return write_log(reader, std::cout);
+    }
+
+    std::cerr << "Unknown command: " << command << "\n";
+    return 1;
+}
@@ -24,6 +24,30 @@ int main() {
     tester.test_radar();
     tester.test_radar_local();
 
+    // board output
+    tester.test_board_renderer();
+    tester.test_board_views();
+    tester.test_replay();
+    tester.test_replay_playback();
+    tester.test_lockstep();
+    tester.test_snapshot();
+    tester.test_checkpoint();
+    tester.test_repetition();
+    tester.test_stalemate();
+    tester.test_tracer();
+    tester.test_robot_timing();
+    tester.test_phase_profile();
+    tester.test_robot_memory();
+    tester.test_flight_recorder();
+    tester.test_game_stats();
+    tester.test_batch_metrics();
+    tester.test_bench_history();
+    tester.test_robot_harness();
+    tester.test_robot_profiler();
+    tester.test_tournament();
+    tester.test_results_store();
+    tester.test_incremental_tournament();
+
     // Test BadRobot with all weapon configurations
     std::cout << "\n=== Testing Weapons ===\n";
     tester.test_handle_shot_with_fake_radar();
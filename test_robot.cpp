@@ -1,180 +1,131 @@
 #include "RobotBase.h"
+#include "Arena.h"
+#include "RobotHarness.h"
 #include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <vector>
 #include <algorithm>
 #include <dlfcn.h>
 
-RobotBase* load_robot(const std::string& shared_lib, void* &handle) 
+RobotFactory load_robot(const std::string& shared_lib, void* &handle)
 {
     std::cout << "Testing robot from " << shared_lib << "...\n";
 
     // Dynamically load the shared library
-    handle = dlopen(shared_lib.c_str(), RTLD_LAZY);
-    if (!handle) 
+    handle = dlopen(("./" + shared_lib).c_str(), RTLD_LAZY);
+    if (!handle)
     {
         std::cerr << "Failed to load " << shared_lib << ": " << dlerror() << '\n';
         return nullptr;
     }
 
     // Locate the create function to create the robot and 'assign' the function to this 'create_robot' function.
-    // RobotFactory is a function pointer type 'typedef'ed in RobotBase.h
+    // RobotFactory is a function pointer type 'typedef'ed in RobotBase.h. The harness calls it for a fresh
+    // robot on every board - it calls the function at the bottom of the Robot where it says extern "C"
     RobotFactory create_robot = (RobotFactory)dlsym(handle, "create_robot");
-    if (!create_robot) 
+    if (!create_robot)
     {
         std::cerr << "Failed to find create_robot in " << shared_lib << ": " << dlerror() << '\n';
         dlclose(handle);
         return nullptr;
     }
 
-    // Instantiate the robot - it will need to be deleted later. This actually calls the function that exists
-    // in the ROBOT code! Cool huh! It's in the bottom of the Robot where it says extern "C"
-    RobotBase* robot = create_robot();
-    if (!robot) 
-    {
-        std::cerr << "Failed to create robot instance from " << shared_lib << '\n';
-        dlclose(handle);
-        return nullptr;
-    }
-
-    return robot;
+    return create_robot;
 }
 
-// you can add or remove behaviors here if you like.
-// make a custom version of this tester, so that it tests YOUR robot...
-void test_robot_behavior(RobotBase* robot) 
+// the old ten turn walkthrough: a 20x20 arena, the robot in the middle and an
+// enemy turning up right next to it on turn 2. add your own scenarios to
+// scenarios/ (see RobotHarness.h for the format) to test YOUR robot...
+static const char* walkthrough =
+    "size 20 20\n"
+    "start 10 10\n"
+    "turns 10\n"
+    "turn 2\n"
+    "radar R 10 11\n";
+
+static void usage(const char* program)
 {
-    // Set up the robot
-    robot->set_boundaries(20, 20);
-    robot->move_to(10, 10); // Start in the middle of the arena
-
-    // Print robot stats
-    std::cout << "Robot Stats:" << std::endl;
-    std::cout << robot->print_stats() << std::endl;
-
-    int inactive_turns = 0;
-
-    for (int turn = 1; turn <= 10; ++turn) {
-        std::cout << "\nSimulating turn " << turn << ":\n";
-
-        bool took_action = false;
-
-        // Validate radar direction before using it
-        // Valid values are 0-8 (0 = local scan, 1-8 = directions)
-
-        // Simulate radar results
-        std::vector<RadarObj> radar_results;
-        int radar_direction = 0;
+    std::cerr << "Usage: " << program
+              << " [--config FILE] [--scenario FILE]... [--random N] [--seed S] [--quiet] Robot_X.cpp\n"
+              << "  --config    the arena config for the call budget and memory cap, RobotWarz.cfg by default\n"
+              << "  --scenario  a scenario file, as many as you like. without one, the walkthrough and scenarios/*.scn\n"
+              << "  --random    how many random boards to play, 2000 by default\n"
+              << "  --seed      for the random boards, 1 by default\n"
+              << "  --quiet     don't print every turn of the scenarios\n";
+}
 
-        // Call get_radar_direction and simulate radar scanning
-        robot->get_radar_direction(radar_direction);
-        std::cout << "Radar direction chosen: " << radar_direction << std::endl;
-        if (radar_direction < 0 || radar_direction > 8)
+int main(int argc, char* argv[])
+{
+    std::string config_path = "RobotWarz.cfg";
+    std::vector<std::string> scenario_paths;
+    int random_boards = 2000;
+    uint64_t seed = 1;
+    bool quiet = false;
+    std::string robot_file;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc)
+            config_path = argv[++i];
+        else if (arg == "--scenario" && i + 1 < argc)
+            scenario_paths.push_back(argv[++i]);
+        else if (arg == "--random" && i + 1 < argc)
+            random_boards = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::stoull(argv[++i]);
+        else if (arg == "--quiet")
+            quiet = true;
+        else if (arg.rfind("--", 0) != 0 && robot_file.empty())
+            robot_file = arg;
+        else
         {
-            std::cerr << "Warning: invalid radar direction " << radar_direction
-                      << " (expected 0-8)." << std::endl;
-        }
-
-        if (turn == 2) {
-            // Simulate detecting an enemy on turn 2
-            RadarObj enemy('R', 10, 11);
-            radar_results.push_back(enemy);
-        }
-
-        // Pass radar results to the robot
-        robot->process_radar_results(radar_results);
-
-        int shot_row = 0, shot_col = 0;
-        if (robot->get_shot_location(shot_row, shot_col)) {
-            std::cout << "Robot shoots at (" << shot_row << ", " << shot_col << ").\n";
-
-            // Bounds check on requested shot
-            if (shot_row < 0 || shot_row >= 20 || shot_col < 0 || shot_col >= 20) {
-                std::cerr << "Warning: shot location (" << shot_row << ", " << shot_col
-                          << ") is outside the 20x20 arena bounds used by this tester." << std::endl;
-            }
-
-            if (!radar_results.empty()) {
-                const auto& enemy = radar_results[0];
-                if (shot_row == enemy.m_row && shot_col == enemy.m_col) {
-                    std::cout << "Shot location matches radar target: (" << enemy.m_row << ", " << enemy.m_col << ").\n";
-                } else {
-                    std::cerr << "Note: shot location (" << shot_row << ", " << shot_col
-                              << ") does not match first radar target (" << enemy.m_row << ", " << enemy.m_col
-                              << ") — robot may be aiming elsewhere.\n";
-                }
-            }
-            took_action = true;
-        } else {
-            std::cout << "No shooting this turn.\n";
+            usage(argv[0]);
+            return 1;
         }
+    }
+    if (robot_file.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
 
-        // Simulate movement
-        int move_direction = 0, move_distance = 0;
-        robot->get_move_direction(move_direction, move_distance);
-
-        // If the robot is immobilized (e.g., in a pit), mimic the Arena behavior
-        if (robot->get_move_speed() == 0) {
-            std::cout << "Robot cannot move (move_speed == 0).\n";
-        } else {
-            if (move_direction < 1 || move_direction > 8 || move_distance <= 0) {
-                std::cout << "Robot chooses not to move.\n";
-            } else {
-                // Cap requested distance by the robot's allowed move speed
-                move_distance = std::clamp(move_distance, 0, robot->get_move_speed());
-
-                // Predefined directional increments for movement (1-8, clock directions) come from RobotBase
-                int delta_row = directions[move_direction].first;
-                int delta_col = directions[move_direction].second;
-
-                // Calculate new position within a 20x20 test arena
-                int current_row, current_col;
-                robot->get_current_location(current_row, current_col);
-                int target_row = std::clamp(current_row + delta_row * move_distance, 0, 19);
-                int target_col = std::clamp(current_col + delta_col * move_distance, 0, 19);
-
-                // Move the robot
-                robot->move_to(target_row, target_col);
-
-                std::cout << "Robot moves to (" << target_row << ", " << target_col << ").\n";
-
-                // Verify the movement
-                int verify_row, verify_col;
-                robot->get_current_location(verify_row, verify_col);
-                if (verify_row == target_row && verify_col == target_col) {
-                    std::cout << "Movement verified!\n";
-                } else {
-                    std::cerr << "Error: Robot did not move to the expected location!\n";
-                }
-
-                took_action = true;
-            }
-        }
+    // the same budget and cap the arena holds robots to
+    uint64_t budget_ns = 0;
+    int64_t memory_cap = 0;
+    if (std::ifstream(config_path))
+    {
+        Arena config(config_path);
+        budget_ns = config.call_budget_ns();
+        memory_cap = config.memory_cap();
+    }
 
-        // Check for inactivity
-        if (took_action) {
-            inactive_turns = 0; // Reset inactivity counter
-        } else {
-            ++inactive_turns;
-            if (inactive_turns >= 5) {
-                std::cerr << "Warning: Robot has not moved or shot for " << inactive_turns << " consecutive turns.\n";
-            }
+    std::vector<Scenario> scenarios(1);
+    std::istringstream built_in(walkthrough);
+    parse_scenario(built_in, "walkthrough", scenarios[0]);
+    if (scenario_paths.empty() && std::filesystem::is_directory("scenarios"))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator("scenarios"))
+        {
+            if (entry.path().extension() == ".scn")
+                scenario_paths.push_back(entry.path().string());
         }
+        std::sort(scenario_paths.begin(), scenario_paths.end());
     }
-}
-
-
-
-int main(int argc, char* argv[]) 
-{
-    //argv[1] should contain the name of the Robot_.cpp file to load.
-
-    if (argc != 2) 
+    else if (!scenario_paths.empty())
     {
-        std::cerr << "Usage: " << argv[0] << " <robot_library>\n";
-        return 1;
+        scenarios.clear();
+    }
+    for (const std::string& path : scenario_paths)
+    {
+        Scenario scenario;
+        if (!load_scenario(path, scenario))
+            return 1;
+        scenarios.push_back(scenario);
     }
 
-    const std::string robot_file = argv[1];
     const std::string shared_lib = "lib" + robot_file.substr(0, robot_file.find(".cpp")) + ".so";
 
     // Compile the robot into a shared library -fPIC is Position Independant Code - look it up!
@@ -189,17 +140,52 @@ int main(int argc, char* argv[])
 
     std::cout << "Success!" << std::endl;
 
-    RobotBase *robot;
     void *handle;
+    RobotFactory create_robot = load_robot(shared_lib, handle);
+    if (!create_robot)
+    {
+        return 1;
+    }
 
-    robot = load_robot(shared_lib, handle);
-    test_robot_behavior(robot);
-
-    // Cleanup
+    // Print robot stats
+    RobotBase* robot = create_robot();
+    if (!robot)
+    {
+        std::cerr << "Failed to create robot instance from " << shared_lib << '\n';
+        dlclose(handle);
+        return 1;
+    }
+    // named the way the arena names it, Robot_<name>.cpp
+    std::string name = std::filesystem::path(robot_file).stem().string();
+    if (name.rfind("Robot_", 0) == 0)
+        name = name.substr(6);
+    robot->m_name = name;
+    std::cout << "Robot Stats:" << std::endl;
+    std::cout << robot->print_stats() << std::endl;
     delete robot;
+
+    int failed = 0;
+    {
+        RobotHarness harness(create_robot, name, budget_ns, memory_cap);
+        for (const Scenario& scenario : scenarios)
+        {
+            std::cout << "\nScenario " << scenario.name << ":\n";
+            harness.run_scenario(scenario, !quiet);
+        }
+        if (random_boards)
+        {
+            std::cout << "\n" << random_boards << " random boards (seed " << seed << ")...\n";
+            harness.run_random(random_boards, seed);
+        }
+
+        std::cout << "\n" << harness.report();
+        failed = harness.problem_count() + (harness.over_budget() ? 1 : 0) + (harness.memory().over_cap ? 1 : 0);
+    }
+
+    // Cleanup - the robots are gone, their code can go too
     dlclose(handle);
 
-    std::cout << "Robot testing complete.\n";
+    std::cout << (failed ? "Robot testing FAILED.\n" : "Robot testing complete.\n");
 
-    return 0;
-}
\ No newline at end of file
+    return failed ? 1 : 0;
+}